@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+
+// walker/vose alias table for O(1) draws from a fixed discrete distribution
+class AliasTable {
+private:
+	std::vector<float> probability;
+	std::vector<uint32_t> alias;
+
+
+public:
+	AliasTable() = default;
+	explicit AliasTable(const std::vector<float>& weights) { build(weights); }
+
+	void build(const std::vector<float>& weights) {
+		probability.clear();
+		alias.clear();
+
+		float total = 0.0f;
+		for (float weight : weights) {
+			total += weight > 0.0f ? weight : 0.0f;
+		}
+
+		if (total <= 0.0f) {
+			return;
+		}
+
+		size_t count = weights.size();
+		probability.resize(count);
+		alias.resize(count);
+
+		// scale so the average column holds exactly 1
+		std::vector<float> scaled(count);
+		std::vector<uint32_t> small;
+		std::vector<uint32_t> large;
+		for (size_t i = 0; i < count; i++) {
+			scaled[i] = (weights[i] > 0.0f ? weights[i] : 0.0f) * count / total;
+			if (scaled[i] < 1.0f) {
+				small.push_back(static_cast<uint32_t>(i));
+			} else {
+				large.push_back(static_cast<uint32_t>(i));
+			}
+		}
+
+		// pair each under-full column with an over-full one
+		while (!small.empty() && !large.empty()) {
+			uint32_t less = small.back();
+			uint32_t more = large.back();
+			small.pop_back();
+
+			probability[less] = scaled[less];
+			alias[less] = more;
+
+			scaled[more] = (scaled[more] + scaled[less]) - 1.0f;
+			if (scaled[more] < 1.0f) {
+				large.pop_back();
+				small.push_back(more);
+			}
+		}
+
+		// leftovers are full columns (up to rounding error)
+		for (uint32_t i : large) {
+			probability[i] = 1.0f;
+			alias[i] = i;
+		}
+		for (uint32_t i : small) {
+			probability[i] = 1.0f;
+			alias[i] = i;
+		}
+	}
+
+	bool empty() const { return probability.empty(); }
+	size_t size() const { return probability.size(); }
+
+	template <typename Generator>
+	int sample(Generator& gen) const {
+		std::uniform_int_distribution<uint32_t> columnDist(0, static_cast<uint32_t>(probability.size() - 1));
+		std::uniform_real_distribution<float> coinDist(0.0f, 1.0f);
+
+		uint32_t column = columnDist(gen);
+		return static_cast<int>(coinDist(gen) < probability[column] ? column : alias[column]);
+	}
+};
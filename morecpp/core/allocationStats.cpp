@@ -0,0 +1,30 @@
+#include "allocationStats.h"
+
+#include <cstdlib>
+#include <new>
+
+
+std::atomic<uint64_t> AllocationStats::allocations[AllocationCounts::subsystemCount];
+std::atomic<uint64_t> AllocationStats::bytes[AllocationCounts::subsystemCount];
+
+
+// replacing the global operators is the only way to see every allocation, including the ones
+// made inside the standard library. array and nothrow forms fall through to these
+void* operator new(size_t size) {
+	AllocationStats::record(size);
+
+	if (void* memory = std::malloc(size ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+
+void operator delete(void* memory, size_t) noexcept {
+	std::free(memory);
+}
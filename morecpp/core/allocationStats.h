@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+
+// parts of the program heap allocations are charged to, set per thread by AllocationScope
+enum class AllocationSubsystem {
+	OTHER,
+	EDITS,
+	INCIDENTS,
+	SEGMENTS,
+	JUNCTIONS,
+	DEMAND,
+	SPAWNING,
+	RENDER,
+	COUNT
+};
+
+
+struct AllocationCounts {
+	static constexpr int subsystemCount = static_cast<int>(AllocationSubsystem::COUNT);
+
+	uint64_t allocations[subsystemCount] = {};
+	uint64_t bytes[subsystemCount] = {};
+
+	uint64_t getTotalAllocations() const {
+		uint64_t total = 0;
+		for (uint64_t count : allocations) total += count;
+		return total;
+	}
+
+	uint64_t getTotalBytes() const {
+		uint64_t total = 0;
+		for (uint64_t count : bytes) total += count;
+		return total;
+	}
+
+	AllocationCounts operator+(const AllocationCounts& other) const {
+		AllocationCounts sum;
+		for (int i = 0; i < subsystemCount; i++) {
+			sum.allocations[i] = allocations[i] + other.allocations[i];
+			sum.bytes[i] = bytes[i] + other.bytes[i];
+		}
+		return sum;
+	}
+
+	AllocationCounts operator-(const AllocationCounts& other) const {
+		AllocationCounts difference;
+		for (int i = 0; i < subsystemCount; i++) {
+			difference.allocations[i] = allocations[i] - other.allocations[i];
+			difference.bytes[i] = bytes[i] - other.bytes[i];
+		}
+		return difference;
+	}
+
+	static const char* getName(int subsystem) {
+		static const char* names[subsystemCount] = { "other", "edits", "incidents", "segments", "junctions", "demand", "spawning", "render" };
+		return subsystem >= 0 && subsystem < subsystemCount ? names[subsystem] : "?";
+	}
+
+	// only the subsystems that allocated
+	void print(std::ostream& out) const {
+		bool any = false;
+		for (int i = 0; i < subsystemCount; i++) {
+			if (allocations[i] == 0) continue;
+			out << (any ? ", " : "") << getName(i) << " " << allocations[i] << " (" << bytes[i] << " bytes)";
+			any = true;
+		}
+		if (!any) out << "none";
+	}
+};
+
+
+// counts every global operator new (see allocationStats.cpp), charged to the thread's current subsystem
+class AllocationStats {
+private:
+	static std::atomic<uint64_t> allocations[AllocationCounts::subsystemCount];
+	static std::atomic<uint64_t> bytes[AllocationCounts::subsystemCount];
+
+	static AllocationSubsystem& currentSubsystem() {
+		static thread_local AllocationSubsystem subsystem = AllocationSubsystem::OTHER;
+		return subsystem;
+	}
+
+	friend class AllocationScope;
+
+
+public:
+	static void record(size_t size) {
+		int subsystem = static_cast<int>(currentSubsystem());
+		allocations[subsystem].fetch_add(1, std::memory_order_relaxed);
+		bytes[subsystem].fetch_add(size, std::memory_order_relaxed);
+	}
+
+	// totals since start, subtract two snapshots for a tick or a frame
+	static AllocationCounts snapshot() {
+		AllocationCounts counts;
+		for (int i = 0; i < AllocationCounts::subsystemCount; i++) {
+			counts.allocations[i] = allocations[i].load(std::memory_order_relaxed);
+			counts.bytes[i] = bytes[i].load(std::memory_order_relaxed);
+		}
+		return counts;
+	}
+};
+
+
+// charges allocations on this thread to a subsystem until it goes out of scope
+class AllocationScope {
+private:
+	AllocationSubsystem previous;
+
+
+public:
+	explicit AllocationScope(AllocationSubsystem subsystem) : previous(AllocationStats::currentSubsystem()) {
+		AllocationStats::currentSubsystem() = subsystem;
+	}
+	~AllocationScope() { AllocationStats::currentSubsystem() = previous; }
+
+	AllocationScope(const AllocationScope&) = delete;
+	AllocationScope& operator=(const AllocationScope&) = delete;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+
+
+// axis aligned box on the ground plane
+struct Bounds2D {
+	float minX = std::numeric_limits<float>::max();
+	float minZ = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxZ = std::numeric_limits<float>::lowest();
+
+	void grow(const Bounds2D& other) {
+		minX = std::min(minX, other.minX);
+		minZ = std::min(minZ, other.minZ);
+		maxX = std::max(maxX, other.maxX);
+		maxZ = std::max(maxZ, other.maxZ);
+	}
+
+	bool overlaps(float x, float z, float radius) const {
+		return x + radius >= minX && x - radius <= maxX && z + radius >= minZ && z - radius <= maxZ;
+	}
+
+	float centerX() const { return (minX + maxX) / 2.0f; }
+	float centerZ() const { return (minZ + maxZ) / 2.0f; }
+};
+
+
+// bounding volume hierarchy over static boxes, items are reported by their index in the build input.
+// nodes are stored depth first, so a node's left child follows it directly
+class BoundingVolumeHierarchy {
+private:
+	struct Node {
+		Bounds2D bounds;
+
+		// leaves hold items [first, first + count), inner nodes hold the right child in first
+		uint32_t first;
+		uint32_t count;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> items;
+
+	static constexpr uint32_t leafSize = 4;
+	static constexpr int maxDepth = 64;
+
+	uint32_t build(const std::vector<Bounds2D>& boxes, uint32_t begin, uint32_t end, int depth) {
+		uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+		nodes.push_back({});
+
+		Bounds2D bounds;
+		Bounds2D centers;
+		for (uint32_t i = begin; i < end; i++) {
+			const Bounds2D& box = boxes[items[i]];
+			bounds.grow(box);
+			centers.grow({ box.centerX(), box.centerZ(), box.centerX(), box.centerZ() });
+		}
+		nodes[nodeIndex].bounds = bounds;
+
+		if (end - begin <= leafSize || depth >= maxDepth - 1) {
+			nodes[nodeIndex].first = begin;
+			nodes[nodeIndex].count = end - begin;
+			return nodeIndex;
+		}
+
+		// median split on the wider spread of centres
+		bool splitX = centers.maxX - centers.minX >= centers.maxZ - centers.minZ;
+		uint32_t middle = begin + (end - begin) / 2;
+		std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end, [&](uint32_t a, uint32_t b) {
+			return splitX ? boxes[a].centerX() < boxes[b].centerX() : boxes[a].centerZ() < boxes[b].centerZ();
+		});
+
+		build(boxes, begin, middle, depth + 1);
+		uint32_t right = build(boxes, middle, end, depth + 1);
+
+		nodes[nodeIndex].first = right;
+		nodes[nodeIndex].count = 0;
+		return nodeIndex;
+	}
+
+
+public:
+	void build(const std::vector<Bounds2D>& boxes) {
+		nodes.clear();
+		items.resize(boxes.size());
+		for (uint32_t i = 0; i < items.size(); i++) {
+			items[i] = i;
+		}
+
+		if (!boxes.empty()) {
+			nodes.reserve(2 * boxes.size() / leafSize + 1);
+			build(boxes, 0, static_cast<uint32_t>(boxes.size()), 0);
+		}
+	}
+
+	// visits every item whose box comes within radius of the point
+	template <typename Visitor>
+	void query(float x, float z, float radius, Visitor&& visit) const {
+		if (nodes.empty()) return;
+
+		uint32_t stack[maxDepth];
+		int top = 0;
+		stack[top++] = 0;
+
+		while (top > 0) {
+			const Node& node = nodes[stack[--top]];
+			if (!node.bounds.overlaps(x, z, radius)) continue;
+
+			if (node.count > 0) {
+				for (uint32_t i = node.first; i < node.first + node.count; i++) {
+					visit(items[i]);
+				}
+				continue;
+			}
+
+			uint32_t left = static_cast<uint32_t>(&node - nodes.data()) + 1;
+			stack[top++] = node.first;
+			stack[top++] = left;
+		}
+	}
+
+	bool empty() const { return nodes.empty(); }
+	size_t getNodeCount() const { return nodes.size(); }
+};
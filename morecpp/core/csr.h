@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "frameArena.h"
+
+
+// compressed sparse rows: the entries of row i are targets[offsets[i], offsets[i + 1]), so walking
+// a row is one contiguous read instead of a vector per row
+class CsrAdjacency {
+private:
+	std::vector<uint32_t> offsets = { 0 };
+	std::vector<int> targets;
+
+
+public:
+	void clear() { offsets.assign(1, 0); targets.clear(); }
+
+	// rows are appended in order, each entry lands in the last row started
+	void startRow() { offsets.push_back(offsets.back()); }
+	void add(int target) { targets.push_back(target); offsets.back()++; }
+
+	void assign(const std::vector<std::vector<int>>& rows) {
+		clear();
+		offsets.reserve(rows.size() + 1);
+		for (const auto& row : rows) {
+			startRow();
+			for (int target : row) add(target);
+		}
+	}
+
+	size_t getRowCount() const { return offsets.size() - 1; }
+	size_t getEntryCount() const { return targets.size(); }
+
+	Span<const int> row(size_t index) const {
+		if (index + 1 >= offsets.size()) return {};
+		return Span<const int>(targets.data() + offsets[index], offsets[index + 1] - offsets[index]);
+	}
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+
+// view over contiguous elements owned by someone else (an arena, a vector)
+template <typename T>
+class Span {
+private:
+	T* first = nullptr;
+	size_t count = 0;
+
+
+public:
+	Span() = default;
+	Span(T* first, size_t count) : first(first), count(count) {}
+
+	T* begin() const { return first; }
+	T* end() const { return first + count; }
+	T& operator[](size_t index) const { return first[index]; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+};
+
+
+// bump allocator for scratch data that lives at most one tick. blocks are kept across resets,
+// so once the largest tick has been seen nothing touches the heap again.
+// only trivially destructible types, nothing is destroyed
+class FrameArena {
+private:
+	struct Block {
+		std::unique_ptr<uint8_t[]> data;
+		size_t size;
+	};
+
+	std::vector<Block> blocks;
+	size_t blockIndex = 0;
+	size_t offset = 0;
+	size_t used = 0;
+	size_t highWater = 0;
+
+	static constexpr size_t minBlockSize = 64 * 1024;
+
+	static FrameArena*& bound() {
+		static thread_local FrameArena* arena = nullptr;
+		return arena;
+	}
+
+
+public:
+	// position to rewind to, scratch used inside one call is handed back when it returns
+	struct Marker {
+		size_t blockIndex;
+		size_t offset;
+		size_t used;
+	};
+
+	// makes an arena the current one on this thread for the lifetime of the binding
+	class Binding {
+	private:
+		FrameArena* previous;
+
+	public:
+		explicit Binding(FrameArena& arena) : previous(bound()) { bound() = &arena; }
+		~Binding() { bound() = previous; }
+		Binding(const Binding&) = delete;
+		Binding& operator=(const Binding&) = delete;
+	};
+
+	// releases everything allocated after construction when it goes out of scope
+	class Scope {
+	private:
+		FrameArena& arena;
+		Marker marker;
+
+	public:
+		explicit Scope(FrameArena& arena) : arena(arena), marker(arena.mark()) {}
+		~Scope() { arena.rewind(marker); }
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	FrameArena() = default;
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+	FrameArena(FrameArena&&) = default;
+	FrameArena& operator=(FrameArena&&) = default;
+
+	// the arena bound to this thread, or a per thread fallback outside of a tick
+	static FrameArena& current() {
+		if (FrameArena* arena = bound()) {
+			return *arena;
+		}
+		static thread_local FrameArena fallback;
+		return fallback;
+	}
+
+	void* allocate(size_t bytes, size_t alignment) {
+		while (blockIndex < blocks.size()) {
+			Block& block = blocks[blockIndex];
+			size_t start = (offset + alignment - 1) & ~(alignment - 1);
+			if (start + bytes <= block.size) {
+				offset = start + bytes;
+				used += bytes;
+				highWater = used > highWater ? used : highWater;
+				return block.data.get() + start;
+			}
+			blockIndex++;
+			offset = 0;
+		}
+
+		// only grows until the largest tick fits
+		size_t size = bytes + alignment > minBlockSize ? bytes + alignment : minBlockSize;
+		blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[size]), size });
+		blockIndex = blocks.size() - 1;
+		offset = 0;
+		return allocate(bytes, alignment);
+	}
+
+	template <typename T>
+	T* allocateArray(size_t count) {
+		static_assert(std::is_trivially_destructible<T>::value, "frame arena never runs destructors");
+		return count == 0 ? nullptr : static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	Marker mark() const { return { blockIndex, offset, used }; }
+	void rewind(const Marker& marker) { blockIndex = marker.blockIndex; offset = marker.offset; used = marker.used; }
+
+	// start of a tick, keeps the blocks
+	void reset() { blockIndex = 0; offset = 0; used = 0; }
+
+	size_t getHighWater() const { return highWater; }
+	size_t getCapacity() const {
+		size_t capacity = 0;
+		for (const auto& block : blocks) capacity += block.size;
+		return capacity;
+	}
+};
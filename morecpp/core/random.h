@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+
+// splitmix64 generator. its whole position is one word, so every vehicle can own a stream
+// and the state hash can include where each stream is
+class Random {
+private:
+	uint64_t state;
+
+
+public:
+	using result_type = uint64_t;
+
+	explicit Random(uint64_t seed = 0) : state(seed) {}
+
+	void seed(uint64_t value) { state = value; }
+	uint64_t getState() const { return state; }
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	result_type operator()() {
+		uint64_t value = (state += 0x9e3779b97f4a7c15ull);
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+		return value ^ (value >> 31);
+	}
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cmath>
+
+
+// order dependent hash over the canonical form of the simulation state.
+// floats are quantized first so they compare as the values the simulation cares about
+class StateHasher {
+private:
+	uint64_t value = 0xcbf29ce484222325ull;
+
+
+public:
+	static uint64_t mix(uint64_t x) {
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return x ^ (x >> 31);
+	}
+
+	void add(uint64_t x) { value = mix(value ^ (x + 0x9e3779b97f4a7c15ull)); }
+	void add(int x) { add(static_cast<uint64_t>(static_cast<int64_t>(x))); }
+	void add(uint32_t x) { add(static_cast<uint64_t>(x)); }
+
+	// step is the resolution kept, e.g. 0.001 for millimetres
+	void add(double x, double step) { add(static_cast<uint64_t>(std::llround(x / step))); }
+
+	void add(const std::string& text) {
+		add(static_cast<uint64_t>(text.size()));
+		for (char c : text) {
+			add(static_cast<uint64_t>(static_cast<unsigned char>(c)));
+		}
+	}
+
+	uint64_t get() const { return value; }
+};
+
+
+// hash of one entity, only collected when a divergence has to be located
+struct EntityDigest {
+	std::string entity;
+	uint64_t hash;
+};
@@ -0,0 +1,101 @@
+#include "determinismHarness.h"
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+
+void DeterminismHarness::setup(SimulationModel& model, const DeterminismVariant& variant) const {
+	model.setSeed(seed);
+	if (variant.configure) {
+		variant.configure(model);
+	}
+	scenario(model);
+}
+
+
+DeterminismReport DeterminismHarness::runLockstep(const DeterminismVariant& reference, const DeterminismVariant& candidate, uint64_t ticks, int interval) const {
+	SimulationModel referenceModel;
+	SimulationModel candidateModel;
+	setup(referenceModel, reference);
+	setup(candidateModel, candidate);
+
+	DeterminismReport report;
+	interval = std::max(1, interval);
+
+	for (uint64_t tick = 1; tick <= ticks; tick++) {
+		referenceModel.update(deltaTime);
+		candidateModel.update(deltaTime);
+		report.ticks = tick;
+
+		if (tick % interval != 0 && tick != ticks) continue;
+
+		uint64_t referenceHash = referenceModel.hashState();
+		uint64_t candidateHash = candidateModel.hashState();
+		if (referenceHash == candidateHash) continue;
+
+		report.matched = false;
+		report.divergentTick = tick;
+		report.referenceHash = referenceHash;
+		report.candidateHash = candidateHash;
+
+		// per entity hashes only once something differs
+		std::vector<EntityDigest> referenceEntities;
+		std::vector<EntityDigest> candidateEntities;
+		referenceModel.hashState(&referenceEntities);
+		candidateModel.hashState(&candidateEntities);
+
+		std::unordered_map<std::string, uint64_t> candidateHashes;
+		for (const auto& digest : candidateEntities) {
+			candidateHashes[digest.entity] = digest.hash;
+		}
+
+		for (const auto& digest : referenceEntities) {
+			auto it = candidateHashes.find(digest.entity);
+			if (it == candidateHashes.end() || it->second != digest.hash) {
+				report.divergentEntity = digest.entity + (it == candidateHashes.end() ? " (missing from candidate)" : "");
+				return report;
+			}
+			candidateHashes.erase(it);
+		}
+
+		// everything in the reference matched, so the candidate has extra entities
+		for (const auto& digest : candidateEntities) {
+			if (candidateHashes.count(digest.entity)) {
+				report.divergentEntity = digest.entity + " (missing from reference)";
+				return report;
+			}
+		}
+		return report;
+	}
+
+	return report;
+}
+
+
+DeterminismReport DeterminismHarness::compare(const DeterminismVariant& reference, const DeterminismVariant& candidate, uint64_t ticks, int interval) const {
+	DeterminismReport report = runLockstep(reference, candidate, ticks, interval);
+
+	// the hashes only say the runs split somewhere in the last interval, replay it tick by tick
+	if (!report.matched && interval > 1) {
+		DeterminismReport exact = runLockstep(reference, candidate, report.divergentTick, 1);
+
+		// a split that does not come back on replay is run to run noise, keep what was seen
+		if (!exact.matched) {
+			report = exact;
+		}
+	}
+	return report;
+}
+
+
+void DeterminismHarness::printReport(const DeterminismReport& report, const DeterminismVariant& reference, const DeterminismVariant& candidate) {
+	if (report.matched) {
+		std::cout << "Determinism: " << reference.name << " and " << candidate.name << " match over " << report.ticks << " ticks" << std::endl;
+		return;
+	}
+
+	std::cout << "Determinism: " << reference.name << " and " << candidate.name << " diverge at tick " << report.divergentTick
+		<< " (" << std::hex << report.referenceHash << " vs " << report.candidateHash << std::dec << "), first differing entity: "
+		<< report.divergentEntity << std::endl;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "simulationModel.h"
+
+
+// one way of running a scenario, e.g. another engine or thread count. applied after seeding,
+// before the scenario builds its network
+struct DeterminismVariant {
+	std::string name;
+	std::function<void(SimulationModel&)> configure;
+};
+
+
+struct DeterminismReport {
+	bool matched = true;
+	uint64_t ticks = 0;
+
+	// first tick whose state hashes differ and the first entity (in canonical order) that differs there
+	uint64_t divergentTick = 0;
+	std::string divergentEntity;
+	uint64_t referenceHash = 0;
+	uint64_t candidateHash = 0;
+};
+
+
+// steps two copies of a seeded scenario in lockstep and compares their state hashes.
+// comparing a variant with itself catches run to run nondeterminism
+class DeterminismHarness {
+private:
+	std::function<void(SimulationModel&)> scenario;
+	uint64_t seed;
+	float deltaTime;
+
+	void setup(SimulationModel& model, const DeterminismVariant& variant) const;
+	DeterminismReport runLockstep(const DeterminismVariant& reference, const DeterminismVariant& candidate, uint64_t ticks, int interval) const;
+
+
+public:
+	DeterminismHarness(std::function<void(SimulationModel&)> scenario, uint64_t seed, float deltaTime = 1.0f / 30.0f)
+		: scenario(std::move(scenario)), seed(seed), deltaTime(deltaTime) {}
+
+	// hashes every interval ticks, a mismatch is narrowed down to the exact tick by replaying
+	DeterminismReport compare(const DeterminismVariant& reference, const DeterminismVariant& candidate, uint64_t ticks, int interval = 1) const;
+
+	static void printReport(const DeterminismReport& report, const DeterminismVariant& reference, const DeterminismVariant& candidate);
+};
@@ -0,0 +1,274 @@
+#include "entityPicker.h"
+
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+#include "../road/trafficLightJunction.h"
+#include "../traffic/vehicle.h"
+
+
+static const char* getStateName(VehicleState state) {
+	switch (state) {
+	case VehicleState::CRUISING: return "cruising";
+	case VehicleState::FOLLOWING: return "following";
+	case VehicleState::LANE_CHANGING: return "changing lane";
+	case VehicleState::MERGING: return "merging";
+	case VehicleState::TURNING: return "turning";
+	case VehicleState::STOPPED: return "stopped";
+	}
+	return "?";
+}
+
+
+bool Selection::isValid() const {
+	switch (kind) {
+	case PickKind::VEHICLE: {
+		auto selected = vehicle.lock();
+		return selected && selected->getId() == vehicleId && selected->getCurrentRoad() && !selected->hasArrived();
+	}
+	case PickKind::ROAD: return !road.expired();
+	case PickKind::JUNCTION: return !junction.expired();
+	default: return false;
+	}
+}
+
+
+std::string Selection::describe() const {
+	if (!isValid()) return "";
+
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(1);
+
+	if (kind == PickKind::VEHICLE) {
+		auto selected = vehicle.lock();
+		auto currentRoad = selected->getCurrentRoad();
+
+		out << "vehicle " << selected->getId()
+			<< " | road " << currentRoad->getId() << (selected->getTravelDirection() == TravelDirection::FORWARD ? " forward" : " reverse")
+			<< " lane " << selected->getCurrentLane() << " at " << selected->getDistanceAlongRoad() << "/" << currentRoad->getLength()
+			<< " | speed " << selected->getCurrentSpeed() << " (prefers " << selected->getPreferredSpeed() << ", limit " << currentRoad->getSpeedLimit() << ")"
+			<< " | " << getStateName(selected->getState());
+
+		if (auto destination = selected->getDestination()) {
+			out << " | to " << destination->getName() << ", " << selected->getRouteSegmentsLeft() << " segments left";
+		}
+	}
+
+	else if (kind == PickKind::ROAD) {
+		auto selected = road.lock();
+		TravelDirection forward = TravelDirection::FORWARD;
+		TravelDirection reverse = TravelDirection::REVERSE;
+
+		out << "road " << selected->getId()
+			<< " | length " << selected->getLength()
+			<< " | lanes " << selected->getOpenLaneCount(forward) << "/" << selected->getTravelLaneCount(forward);
+		if (selected->isBidirectional()) {
+			out << " + " << selected->getOpenLaneCount(reverse) << "/" << selected->getTravelLaneCount(reverse);
+		}
+		out << " open | vehicles " << selected->getVehicles().size()
+			<< " | mean speed " << selected->getMeanSpeed() << " of " << selected->getSpeedLimit()
+			<< " | density " << std::setprecision(2) << selected->getDensity();
+	}
+
+	else if (kind == PickKind::JUNCTION) {
+		auto selected = junction.lock();
+
+		out << "junction " << selected->getId() << " | " << selected->getConnectedRoads().size() << " roads";
+		if (auto lights = std::dynamic_pointer_cast<TrafficLightJunction>(selected)) {
+			out << " | phase " << lights->getCurrentPhase() + 1 << " of " << lights->getPhaseCount()
+				<< ", " << lights->getPhaseTimer() << "/" << lights->getPhaseDuration() << "s";
+		}
+	}
+
+	return out.str();
+}
+
+
+void EntityPicker::rebuildStatic(const RoadNetwork& network) {
+	roads = network.getAllRoadSegments();
+	junctions = network.getAllJunctions();
+	staticRevision = network.getRevision();
+	staticValid = true;
+
+	// roads run between junction centres, like the view draws them
+	bounds.clear();
+	for (const auto& road : roads) {
+		Vector3 start = road->getStartPosition();
+		Vector3 end = road->getEndPosition();
+		float halfWidth = road->getDimensions().z / 2.0f;
+		bounds.push_back({ std::min(start.x, end.x) - halfWidth, std::min(start.z, end.z) - halfWidth, std::max(start.x, end.x) + halfWidth, std::max(start.z, end.z) + halfWidth });
+	}
+	roadTree.build(bounds);
+
+	bounds.clear();
+	for (const auto& junction : junctions) {
+		const Vector3& center = junction->getPosition();
+		float radius = junction->getRadius();
+		bounds.push_back({ center.x - radius, center.z - radius, center.x + radius, center.z + radius });
+	}
+	junctionTree.build(bounds);
+}
+
+
+void EntityPicker::rebuildVehicles(const SimulationModel& model) {
+	vehicleTick = model.getTick();
+	vehiclesValid = true;
+
+	vehicles.clear();
+	maxVehicleRadius = 0.0f;
+	Bounds2D extent;
+
+	model.getGridNetwork().forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& road) {
+		for (const auto& vehicle : road->getVehicles()) {
+			const Vector3& position = vehicle->getPosition();
+			extent.grow({ position.x, position.z, position.x, position.z });
+			maxVehicleRadius = std::max(maxVehicleRadius, std::max(vehicle->getDimensions().x, vehicle->getDimensions().z) / 2.0f);
+			vehicles.push_back(&vehicle);
+		}
+	});
+
+	gridColumns = 0;
+	gridRows = 0;
+	if (vehicles.empty()) return;
+
+	// cells grow on sparse, spread out traffic so the grid stays about one cell per vehicle
+	gridMinX = extent.minX;
+	gridMinZ = extent.minZ;
+	float width = extent.maxX - extent.minX;
+	float depth = extent.maxZ - extent.minZ;
+	cellSize = std::max(vehicleCellSize, std::sqrt(width * depth / vehicles.size()));
+	gridColumns = static_cast<int>(width / cellSize) + 1;
+	gridRows = static_cast<int>(depth / cellSize) + 1;
+
+	auto cellOf = [&](const Vector3& position) {
+		int column = std::min(gridColumns - 1, static_cast<int>((position.x - gridMinX) / cellSize));
+		int row = std::min(gridRows - 1, static_cast<int>((position.z - gridMinZ) / cellSize));
+		return row * gridColumns + column;
+	};
+
+	// counting sort into one array, cellStart[c] .. cellStart[c + 1] are the vehicles of cell c
+	cellStart.assign(gridColumns * gridRows + 1, 0);
+	for (const auto* vehicle : vehicles) {
+		cellStart[cellOf((*vehicle)->getPosition()) + 1]++;
+	}
+	for (size_t i = 1; i < cellStart.size(); i++) {
+		cellStart[i] += cellStart[i - 1];
+	}
+
+	cellVehicles.resize(vehicles.size());
+	for (const auto* vehicle : vehicles) {
+		cellVehicles[cellStart[cellOf((*vehicle)->getPosition())]++] = vehicle;
+	}
+
+	// the fill pass moved every start one cell on
+	for (size_t i = cellStart.size() - 1; i > 0; i--) {
+		cellStart[i] = cellStart[i - 1];
+	}
+	cellStart[0] = 0;
+}
+
+
+std::shared_ptr<Vehicle> EntityPicker::pickVehicle(float x, float z, float tolerance) const {
+	if (gridColumns == 0) return nullptr;
+
+	float reach = maxVehicleRadius + tolerance;
+	int minColumn = std::max(0, static_cast<int>(std::floor((x - reach - gridMinX) / cellSize)));
+	int maxColumn = std::min(gridColumns - 1, static_cast<int>(std::floor((x + reach - gridMinX) / cellSize)));
+	int minRow = std::max(0, static_cast<int>(std::floor((z - reach - gridMinZ) / cellSize)));
+	int maxRow = std::min(gridRows - 1, static_cast<int>(std::floor((z + reach - gridMinZ) / cellSize)));
+
+	const std::shared_ptr<Vehicle>* closest = nullptr;
+	float closestDistance = std::numeric_limits<float>::max();
+
+	for (int row = minRow; row <= maxRow; row++) {
+		for (int column = minColumn; column <= maxColumn; column++) {
+			int cell = row * gridColumns + column;
+			for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+				const auto& vehicle = *cellVehicles[i];
+				const Vector3& position = vehicle->getPosition();
+				float radius = std::max(vehicle->getDimensions().x, vehicle->getDimensions().z) / 2.0f;
+
+				float distance = std::hypot(position.x - x, position.z - z);
+				if (distance <= radius + tolerance && distance < closestDistance) {
+					closest = &vehicle;
+					closestDistance = distance;
+				}
+			}
+		}
+	}
+
+	return closest ? *closest : nullptr;
+}
+
+
+std::shared_ptr<Junction> EntityPicker::pickJunction(float x, float z, float tolerance) const {
+	std::shared_ptr<Junction> closest;
+	float closestDistance = std::numeric_limits<float>::max();
+
+	junctionTree.query(x, z, tolerance, [&](uint32_t index) {
+		const Vector3& center = junctions[index]->getPosition();
+		float distance = std::max(std::abs(center.x - x), std::abs(center.z - z)) - junctions[index]->getRadius();
+		if (distance <= tolerance && distance < closestDistance) {
+			closest = junctions[index];
+			closestDistance = distance;
+		}
+	});
+
+	return closest;
+}
+
+
+std::shared_ptr<RoadSegment> EntityPicker::pickRoad(float x, float z, float tolerance) const {
+	std::shared_ptr<RoadSegment> closest;
+	float closestDistance = std::numeric_limits<float>::max();
+
+	roadTree.query(x, z, tolerance, [&](uint32_t index) {
+		const auto& road = roads[index];
+		Vector3 start = road->getStartPosition();
+		Vector3 end = road->getEndPosition();
+
+		// distance from the centre line, past the road's edge by this much
+		float dirX = end.x - start.x;
+		float dirZ = end.z - start.z;
+		float lengthSquared = dirX * dirX + dirZ * dirZ;
+		float along = lengthSquared > 0.0f ? std::clamp(((x - start.x) * dirX + (z - start.z) * dirZ) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+		float distance = std::hypot(start.x + dirX * along - x, start.z + dirZ * along - z) - road->getDimensions().z / 2.0f;
+
+		if (distance <= tolerance && distance < closestDistance) {
+			closest = road;
+			closestDistance = distance;
+		}
+	});
+
+	return closest;
+}
+
+
+Selection EntityPicker::pick(const SimulationModel& model, float x, float z, float tolerance) {
+	const RoadNetwork& network = model.getGridNetwork();
+	if (!staticValid || staticRevision != network.getRevision()) {
+		rebuildStatic(network);
+	}
+	if (!vehiclesValid || vehicleTick != model.getTick()) {
+		rebuildVehicles(model);
+	}
+
+	Selection selection;
+
+	if (auto vehicle = pickVehicle(x, z, tolerance)) {
+		selection.kind = PickKind::VEHICLE;
+		selection.vehicle = vehicle;
+		selection.vehicleId = vehicle->getId();
+	}
+	else if (auto junction = pickJunction(x, z, tolerance)) {
+		selection.kind = PickKind::JUNCTION;
+		selection.junction = junction;
+	}
+	else if (auto road = pickRoad(x, z, tolerance)) {
+		selection.kind = PickKind::ROAD;
+		selection.road = road;
+	}
+
+	return selection;
+}
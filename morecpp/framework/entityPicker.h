@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../core/bvh.h"
+#include "simulationModel.h"
+
+
+enum class PickKind {
+	NONE,
+	VEHICLE,
+	ROAD,
+	JUNCTION
+};
+
+
+// what the user clicked on. held weakly so removed roads and junctions drop out,
+// vehicles are also matched by id since arrived ones are reused for new trips
+struct Selection {
+	PickKind kind = PickKind::NONE;
+	std::weak_ptr<Vehicle> vehicle;
+	uint32_t vehicleId = 0;
+	std::weak_ptr<RoadSegment> road;
+	std::weak_ptr<Junction> junction;
+
+	bool isValid() const;
+
+	// one line of live state for the overlay, empty when nothing valid is selected
+	std::string describe() const;
+};
+
+
+// finds the entity under a point on the ground plane. roads and junctions sit in a bvh rebuilt
+// when the network changes, vehicles in a uniform grid rebuilt when the model has stepped
+class EntityPicker {
+private:
+	std::vector<std::shared_ptr<RoadSegment>> roads;
+	std::vector<std::shared_ptr<Junction>> junctions;
+	std::vector<Bounds2D> bounds;
+	BoundingVolumeHierarchy roadTree;
+	BoundingVolumeHierarchy junctionTree;
+	uint32_t staticRevision = 0;
+	bool staticValid = false;
+
+	// vehicles bucketed by cell with a counting sort, entries point into the segments' vehicle lists
+	// and are only valid until the model steps again
+	static constexpr float vehicleCellSize = 20.0f;
+	std::vector<const std::shared_ptr<Vehicle>*> vehicles;
+	std::vector<uint32_t> cellStart;
+	std::vector<const std::shared_ptr<Vehicle>*> cellVehicles;
+	float gridMinX = 0.0f, gridMinZ = 0.0f;
+	float cellSize = vehicleCellSize;
+	int gridColumns = 0, gridRows = 0;
+	float maxVehicleRadius = 0.0f;
+	uint64_t vehicleTick = 0;
+	bool vehiclesValid = false;
+
+	void rebuildStatic(const RoadNetwork& network);
+	void rebuildVehicles(const SimulationModel& model);
+
+	std::shared_ptr<Vehicle> pickVehicle(float x, float z, float tolerance) const;
+	std::shared_ptr<Junction> pickJunction(float x, float z, float tolerance) const;
+	std::shared_ptr<RoadSegment> pickRoad(float x, float z, float tolerance) const;
+
+
+public:
+	// vehicles are drawn on top, so they win over junctions, which win over roads
+	Selection pick(const SimulationModel& model, float x, float z, float tolerance);
+};
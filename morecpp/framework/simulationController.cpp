@@ -1,46 +1,105 @@
 #include "simulationController.h"
 
+#include <algorithm>
 #include <iostream>
+#include <chrono>
+#include <fstream>
+#include <cmath>
+#include <thread>
 
 #include <glfw/glfw3.h>
 
+#include "../render/sceneRenderer.h"
+#include "../render/softwareRasterizer.h"
+#include "determinismHarness.h"
+#include "../net/sharedStateReader.h"
+#include "../road/scenarioParser.h"
+#include "../road/scenarioBinary.h"
+#include "../road/highwayRamp.h"
+#include "../traffic/vehicle.h"
 
-SimulationController::SimulationController() : running(false), lastFrameTime(0.0f), frameCount(0) {
-	view.setSimulationModel(&model);
-}
+
+SimulationController::SimulationController() : running(false), lastFrameTime(0.0f), frameCount(0) {}
 
 
 void SimulationController::init() {
-	return;
+	if (view) return;
+
+	view = std::make_unique<ViewController>();
+	view->setSimulationModel(&model);
 }
 
 
 void SimulationController::run(int maxIterations) {
+	init();
+
 	running = true;
 	maxFrames = maxIterations;
 	lastFrameTime = static_cast<float>(glfwGetTime());
 	frameCount = 0;
 
 	// main loop
-	while (running && view.isOpen() && (maxFrames == 0 || frameCount < maxFrames)) {
+	while (running && view->isOpen() && (maxFrames == 0 || frameCount < maxFrames)) {
 		float currentTime = static_cast<float>(glfwGetTime());
 		float deltaTime = currentTime - lastFrameTime;
 		lastFrameTime = currentTime;
 
-		if (!view.processEvents()) {
+		if (!view->processEvents()) {
 			running = false;
 			break;
 		}
 
-		model.update(deltaTime);
+		if (model.isFastForwarding() && !model.isSimulationPaused()) {
+			stepFastForward();
+		} else {
+			model.update(deltaTime);
+		}
+		publishState();
 
-		view.render();
+		view->render();
 
 		frameCount++;
 	}
 }
 
 
+void SimulationController::stepFastForward() {
+	auto start = std::chrono::steady_clock::now();
+
+	// step until the frame's budget is spent, checking the clock every few steps
+	for (int steps = 1; ; steps++) {
+		model.step();
+
+		if (fastForward.renderEverySteps > 0 && steps >= fastForward.renderEverySteps) break;
+		if ((steps & 15) == 0 && std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() >= fastForward.renderBudget) break;
+	}
+}
+
+
+void SimulationController::runFastForward(float simulatedSeconds) {
+	auto start = std::chrono::steady_clock::now();
+	double startTime = model.getSimulationTime();
+	uint64_t startTick = model.getTick();
+
+	running = true;
+	while (running && model.getSimulationTime() - startTime < simulatedSeconds) {
+		model.step();
+		publishState();
+	}
+
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	double simulated = model.getSimulationTime() - startTime;
+	std::cout << "Simulated " << simulated << "s in " << (model.getTick() - startTick) << " steps, " << seconds << "s wall clock ("
+		<< (seconds > 0.0f ? simulated / seconds : 0.0f) << "x real time)" << std::endl;
+}
+
+
+void SimulationController::fastForwardGridNetworkSimulation(int width, int height, int numLanes, float simulatedSeconds) {
+	model.buildGridNetwork(width, height, numLanes);
+	runFastForward(simulatedSeconds);
+}
+
+
 void SimulationController::runCustomNetworkSimulation() {
 	model.buildCustomNetwork();
 	run();
@@ -50,4 +109,696 @@ void SimulationController::runCustomNetworkSimulation() {
 void SimulationController::runGridNetwrokSimulation(int width, int height, int numLanes) {
 	model.buildGridNetwork(width, height, numLanes);
 	run();
-}
\ No newline at end of file
+}
+
+
+void SimulationController::runHighwayCorridorSimulation(const HighwayCorridorConfig& config) {
+	model.buildHighwayCorridor(config);
+	run();
+}
+
+
+bool SimulationController::runScenarioSimulation(const std::string& path) {
+	// loaded before the window opens, so a bad file fails without one
+	if (!model.loadScenario(path)) {
+		return false;
+	}
+	init();
+	run();
+	return true;
+}
+
+
+bool SimulationController::compileScenario(const std::string& inputPath, const std::string& outputPath) {
+	ScenarioDescription scenario;
+	std::string error;
+
+	auto start = std::chrono::steady_clock::now();
+	if (!ScenarioParser::parseFile(inputPath, scenario, error)) {
+		std::cerr << error << std::endl;
+		return false;
+	}
+	double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (!ScenarioBinary::writeFile(scenario, outputPath)) {
+		std::cerr << "Failed to write compiled scenario: " << outputPath << std::endl;
+		return false;
+	}
+
+	std::cout << "Compiled " << scenario.junctions.size() << " junctions, " << scenario.segments.size() << " roads, "
+		<< scenario.spawns.size() << " spawn points and " << scenario.demand.size() << " demand rows in "
+		<< parseSeconds * 1000.0 << " ms" << std::endl;
+	return true;
+}
+
+
+bool SimulationController::recordDetectors(const std::string& scenarioPath, float simulatedSeconds, const std::string& outputPath) {
+	if (!model.loadScenario(scenarioPath)) {
+		return false;
+	}
+	if (model.getDetectors().getDetectorCount() == 0) {
+		std::cerr << "Scenario has no detectors: " << scenarioPath << std::endl;
+		return false;
+	}
+
+	runFastForward(simulatedSeconds);
+
+	const DetectorBank& detectors = model.getDetectors();
+	bool binary = outputPath.size() >= 4 && outputPath.compare(outputPath.size() - 4, 4, ".bin") == 0;
+	if (!(binary ? detectors.writeBinaryFile(outputPath) : detectors.writeCsv(outputPath))) {
+		std::cerr << "Failed to write detector data: " << outputPath << std::endl;
+		return false;
+	}
+
+	std::cout << "Wrote " << detectors.getDetectorCount() << " detectors, " << detectors.getBinCount(DetectorResolution::SECOND) << " second, "
+		<< detectors.getBinCount(DetectorResolution::MINUTE) << " minute and " << detectors.getBinCount(DetectorResolution::QUARTER_HOUR)
+		<< " quarter hour bins each" << std::endl;
+	return true;
+}
+
+
+void SimulationController::runHeadless(int frames, const FrameExportConfig& config, float deltaTime) {
+	SoftwareRasterizer rasterizer(config.width, config.height, config.renderThreads);
+	rasterizer.setClearColor(0.1f, 0.1f, 0.1f);
+
+	FrameWriter writer(config);
+	if (!writer.isOpen()) {
+		return;
+	}
+
+	SceneRenderer scene;
+	RenderView frameView = SceneRenderer::fitView(model, static_cast<float>(config.width) / config.height);
+
+	auto start = std::chrono::steady_clock::now();
+	running = true;
+
+	// encoding runs behind on the writer's threads while the next frame is simulated and drawn
+	for (frameCount = 0; running && frameCount < frames; frameCount++) {
+		model.update(deltaTime);
+		publishState();
+
+		rasterizer.beginFrame(frameView);
+		scene.render(model, frameView, rasterizer);
+		rasterizer.endFrame();
+
+		writer.submit(rasterizer.getPixels());
+	}
+
+	writer.close();
+
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Exported " << writer.getFrameCount() << " frames in " << seconds << "s" << std::endl;
+}
+
+
+void SimulationController::exportGridNetworkSimulation(int width, int height, int numLanes, int frames, const FrameExportConfig& config) {
+	model.buildGridNetwork(width, height, numLanes);
+	runHeadless(frames, config);
+}
+
+
+bool SimulationController::serveTelemetry(const SocketEndpoint& endpoint, const TelemetryConfig& config) {
+	telemetry = std::make_unique<TelemetryServer>(config);
+	if (!telemetry->start(endpoint)) {
+		telemetry.reset();
+		return false;
+	}
+	return true;
+}
+
+
+bool SimulationController::publishSharedState(const std::string& name, const SharedStateConfig& config) {
+	sharedState = std::make_unique<SharedStatePublisher>(config);
+	if (!sharedState->open(name)) {
+		sharedState.reset();
+		return false;
+	}
+	return true;
+}
+
+
+void SimulationController::publishState() {
+	if (telemetry) {
+		telemetry->publish(model);
+	}
+	if (sharedState) {
+		sharedState->publish(model);
+	}
+}
+
+
+void SimulationController::runServer(float deltaTime) {
+	auto frameTime = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(deltaTime));
+	auto next = std::chrono::steady_clock::now();
+	uint64_t lastDropped = 0;
+
+	running = true;
+	while (running) {
+		model.update(deltaTime);
+		publishState();
+
+		if (telemetry && telemetry->getDroppedClientCount() != lastDropped) {
+			lastDropped = telemetry->getDroppedClientCount();
+			std::cout << lastDropped << " slow telemetry clients dropped so far" << std::endl;
+		}
+
+		// paced to the wall clock, a late tick is not made up for with a burst
+		next += frameTime;
+		auto now = std::chrono::steady_clock::now();
+		if (next > now) std::this_thread::sleep_until(next);
+		else next = now;
+	}
+}
+
+
+void SimulationController::serveGridNetworkSimulation(int width, int height, int numLanes, const SocketEndpoint& endpoint) {
+	model.buildGridNetwork(width, height, numLanes);
+	if (serveTelemetry(endpoint)) {
+		runServer();
+	}
+}
+
+
+void SimulationController::publishGridNetworkSimulation(int width, int height, int numLanes, const std::string& sharedStateName) {
+	model.buildGridNetwork(width, height, numLanes);
+	if (publishSharedState(sharedStateName)) {
+		runServer();
+	}
+}
+
+
+void SimulationController::runTelemetryViewer(const SocketEndpoint& endpoint) {
+	TelemetryClient client;
+	if (!client.connect(endpoint)) {
+		return;
+	}
+
+	view = std::make_unique<ViewController>();
+	view->setTelemetryClient(&client);
+
+	// the remote side keeps time, the window only draws what has arrived
+	running = true;
+	while (running && view->isOpen() && view->processEvents()) {
+		client.poll();
+		view->render();
+	}
+
+	view.reset();
+}
+
+
+bool SimulationController::checkTelemetryLoopback(const SocketEndpoint& endpoint, int ticks) {
+	const float deltaTime = 1.0f / 60.0f;
+
+	model.setSeed(1);
+	model.buildGridNetwork(4, 4, 3);
+
+	// a small queue and send buffer so the stalled viewer below is dropped within a short run
+	TelemetryConfig config;
+	config.maxQueuedBytes = 16 * 1024;
+	config.sendBufferBytes = 4 * 1024;
+	if (!serveTelemetry(endpoint, config)) {
+		return false;
+	}
+
+	TelemetryClient client;
+	if (!client.connect(endpoint)) {
+		return false;
+	}
+
+	// a second viewer that never reads, it must be dropped rather than hold the model up
+	TelemetryClient stalled;
+	stalled.connect(endpoint);
+
+	// nothing goes out to a client until the io thread has accepted it
+	auto acceptDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (telemetry->getClientCount() < 2 && std::chrono::steady_clock::now() < acceptDeadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	bool matched = true;
+	int checkedTicks = 0;
+
+	for (int i = 0; i < ticks && matched; i++) {
+		model.update(deltaTime);
+		publishState();
+
+		const TelemetryState& published = telemetry->getPublishedState();
+
+		// the io thread sends in the background, wait until this tick has arrived
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (client.poll() && client.getState().tick != published.tick && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+
+		const TelemetryState& received = client.getState();
+		bool sameVehicles = received.vehicles.size() == published.vehicles.size() && std::equal(received.vehicles.begin(), received.vehicles.end(), published.vehicles.begin(),
+			[](const TelemetryVehicle& a, const TelemetryVehicle& b) {
+				return a.id == b.id && a.x == b.x && a.z == b.z && a.heading == b.heading && a.speed == b.speed && a.length == b.length && a.width == b.width;
+			});
+
+		if (received.tick != published.tick || received.roads.size() != published.roads.size() || received.signals != published.signals || !sameVehicles) {
+			std::cout << "tick " << published.tick << ": client diverged (received tick " << received.tick << ", "
+				<< received.vehicles.size() << " of " << published.vehicles.size() << " vehicles)" << std::endl;
+			matched = false;
+		}
+		checkedTicks++;
+	}
+
+	// keep publishing until the stalled viewer falls far enough behind to be dropped, and
+	// the io thread has closed it. the reading viewer stays current meanwhile
+	auto dropDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	int drainTicks = 0;
+	while (matched && (telemetry->getDroppedClientCount() == 0 || telemetry->getClientCount() != 1) && std::chrono::steady_clock::now() < dropDeadline) {
+		if (telemetry->getDroppedClientCount() > 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		model.update(deltaTime);
+		publishState();
+		drainTicks++;
+
+		uint64_t publishedTick = telemetry->getPublishedState().tick;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (client.poll() && client.getState().tick != publishedTick && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+
+	bool stalledDropped = telemetry->getDroppedClientCount() == 1 && telemetry->getClientCount() == 1 && client.isConnected();
+	if (!stalledDropped) {
+		std::cout << "stalled client was not dropped (" << telemetry->getDroppedClientCount() << " dropped, "
+			<< telemetry->getClientCount() << " clients left)" << std::endl;
+	}
+
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	std::cout << checkedTicks << " of " << ticks << " ticks matched over " << endpoint.toString() << ", "
+		<< telemetry->getBytesPublished() << " bytes published, " << telemetry->getDroppedClientCount() << " slow clients dropped after "
+		<< drainTicks << " more ticks, " << seconds << "s" << std::endl;
+
+	telemetry->stop();
+	telemetry.reset();
+	return matched && checkedTicks > 0 && stalledDropped;
+}
+
+
+bool SimulationController::checkSharedState(const std::string& name, int ticks, bool compact) {
+	const float deltaTime = 1.0f / 60.0f;
+
+	model.setSeed(1);
+	model.buildGridNetwork(4, 4, 3);
+	SharedStateConfig config;
+	config.compactVehicles = compact;
+	if (!publishSharedState(name, config)) {
+		return false;
+	}
+
+	SharedStateReader reader;
+	if (!reader.open(name)) {
+		return false;
+	}
+
+	// compact frames must come back within the quantization bounds (a little slack for float rounding
+	// on decode), the float columns exactly
+	struct VehicleSample { uint32_t id; float distance; float speed; };
+	std::vector<VehicleSample> expected, received;
+	auto byId = [](const VehicleSample& a, const VehicleSample& b) { return a.id < b.id; };
+	float distanceTolerance = compact ? CompactQuantization::maxDistanceError * 1.01f : 0.0f;
+	float speedTolerance = compact ? CompactQuantization::maxSpeedError * 1.01f : 0.0f;
+	float maxDistanceError = 0.0f;
+	float maxSpeedError = 0.0f;
+	float publishSeconds = 0.0f;
+	bool matched = true;
+	uint64_t lastFrame = 0;
+	int checkedFrames = 0;
+
+	for (int i = 0; i < ticks && matched; i++) {
+		model.update(deltaTime);
+
+		auto start = std::chrono::steady_clock::now();
+		publishState();
+		publishSeconds += std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+		SharedStateFrame frame;
+		if (!reader.acquire(frame, lastFrame)) {
+			std::cout << "tick " << model.getTick() << ": no new frame" << std::endl;
+			matched = false;
+			break;
+		}
+		lastFrame = frame.number;
+
+		// the frame lists vehicles segment by segment, compare as sets of id, distance and speed
+		expected.clear();
+		model.getGridNetwork().forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& road) {
+			for (const auto& vehicle : road->getVehicles()) {
+				expected.push_back({ vehicle->getId(), vehicle->getDistanceAlongRoad(), vehicle->getCurrentSpeed() });
+			}
+		});
+		received.clear();
+		for (uint32_t v = 0; v < frame.vehicleCount; v++) {
+			if (frame.compactStates) {
+				const CompactVehicleState& state = frame.compactStates[v];
+				received.push_back({ state.id, state.getDistance(), state.getSpeed() });
+			} else {
+				received.push_back({ frame.ids[v], frame.distances[v], frame.speeds[v] });
+			}
+		}
+		std::sort(expected.begin(), expected.end(), byId);
+		std::sort(received.begin(), received.end(), byId);
+
+		bool same = expected.size() == received.size();
+		for (size_t v = 0; same && v < expected.size(); v++) {
+			float distanceError = std::fabs(expected[v].distance - received[v].distance);
+			float speedError = std::fabs(expected[v].speed - received[v].speed);
+			maxDistanceError = std::max(maxDistanceError, distanceError);
+			maxSpeedError = std::max(maxSpeedError, speedError);
+			same = expected[v].id == received[v].id && distanceError <= distanceTolerance && speedError <= speedTolerance;
+		}
+
+		if (!frame.isValid() || frame.tick != model.getTick() || frame.truncated || frame.clampedVehicles > 0 || !same) {
+			std::cout << "tick " << model.getTick() << ": frame " << frame.number << " does not match the model (tick " << frame.tick << ", "
+				<< frame.vehicleCount << " of " << expected.size() << " vehicles)" << std::endl;
+			matched = false;
+		}
+		checkedFrames++;
+	}
+
+	std::cout << checkedFrames << " of " << ticks << " frames matched, " << (checkedFrames > 0 ? publishSeconds / checkedFrames * 1e6f : 0.0f)
+		<< "us per publish" << std::endl;
+	if (compact) {
+		std::cout << "largest errors " << maxDistanceError << " m, " << maxSpeedError << " m/s (bounds " << CompactQuantization::maxDistanceError
+			<< " m, " << CompactQuantization::maxSpeedError << " m/s)" << std::endl;
+	}
+
+	sharedState.reset();
+	return matched && checkedFrames > 0;
+}
+
+
+bool SimulationController::verifyDeterminism(int ticks, int hashInterval, uint64_t seed) {
+	std::vector<std::pair<std::string, std::function<void(SimulationModel&)>>> scenarios = {
+		{ "grid", [](SimulationModel& model) { model.buildGridNetwork(4, 4, 3); } },
+		{ "custom", [](SimulationModel& model) { model.buildCustomNetwork(); } },
+		{ "highway", [](SimulationModel& model) { model.buildHighwayCorridor(HighwayCorridorConfig()); } },
+	};
+
+	// the active set and the full sweep must agree to the bit. decision rates change the traffic,
+	// so every tick decisions are only checked run to run, as is the default engine
+	DecisionRates everyTick;
+	everyTick.laneChange = 0.0f;
+	everyTick.laneDrop = 0.0f;
+	everyTick.merge = 0.0f;
+
+	DeterminismVariant serial{ "serial", nullptr };
+	DeterminismVariant fullSweep{ "full sweep", [](SimulationModel& model) { model.setFullSweep(true); } };
+	DeterminismVariant everyTickDecisions{ "every tick decisions", [everyTick](SimulationModel& model) { model.setDecisionRates(everyTick); } };
+
+	std::vector<std::pair<const DeterminismVariant*, const DeterminismVariant*>> comparisons = {
+		{ &serial, &serial },
+		{ &serial, &fullSweep },
+		{ &everyTickDecisions, &everyTickDecisions },
+	};
+	bool matched = true;
+
+	for (const auto& [name, build] : scenarios) {
+		DeterminismHarness harness(build, seed);
+
+		for (const auto& [reference, candidate] : comparisons) {
+			auto start = std::chrono::steady_clock::now();
+			DeterminismReport report = harness.compare(*reference, *candidate, ticks, hashInterval);
+
+			float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+			std::cout << name << ": ";
+			DeterminismHarness::printReport(report, *reference, *candidate);
+			std::cout << name << ": " << seconds << "s" << std::endl;
+
+			matched = matched && report.matched;
+		}
+	}
+	return matched;
+}
+
+
+bool SimulationController::checkAllocations(int ticks, int warmupTicks, uint64_t seed) {
+	const float deltaTime = 1.0f / 60.0f;
+
+	// draws nothing, the frames are only rendered to count what they allocate
+	class DiscardBackend : public RenderBackend {
+	public:
+		void beginFrame(const RenderView& frameView) override {}
+		void drawRect(const RenderRect& rect) override {}
+		void endFrame() override {}
+	};
+
+	model.setSeed(seed);
+	model.buildGridNetwork(4, 4, 3, 400.0f, 32.0f, 10.0f, true, true);
+	model.reserveVehicles(4096);
+
+	// one frame over the whole network and one close in on the middle at full detail,
+	// so the signal heads are drawn too
+	SceneRenderer scene;
+	DiscardBackend backend;
+	RenderView overview = SceneRenderer::fitView(model, 16.0f / 9.0f);
+	RenderView closeUp;
+	closeUp.centerX = overview.centerX;
+	closeUp.centerZ = overview.centerZ;
+
+	auto renderFrames = [&]() {
+		for (const RenderView& frameView : { overview, closeUp }) {
+			backend.beginFrame(frameView);
+			scene.render(model, frameView, backend);
+			backend.endFrame();
+		}
+	};
+
+	// pools, scratch and queues grow to their working size during warm up
+	for (int i = 0; i < warmupTicks; i++) {
+		model.update(deltaTime);
+		renderFrames();
+	}
+
+	AllocationCounts total;
+	int allocatingTicks = 0;
+
+	for (int i = 0; i < ticks; i++) {
+		model.update(deltaTime);
+
+		AllocationCounts before = AllocationStats::snapshot();
+		renderFrames();
+		AllocationCounts counts = model.getTickAllocations() + (AllocationStats::snapshot() - before);
+		if (counts.getTotalAllocations() == 0) continue;
+
+		// only the first few offenders are printed in full
+		if (allocatingTicks < 10) {
+			std::cout << "tick " << model.getTick() << ": ";
+			counts.print(std::cout);
+			std::cout << std::endl;
+		}
+		allocatingTicks++;
+
+		total = total + counts;
+	}
+
+	const FrameArena& arena = model.getGridNetwork().getFrameArena();
+	std::cout << "frame arena: " << arena.getHighWater() << " of " << arena.getCapacity() << " bytes" << std::endl;
+	std::cout << allocatingTicks << " of " << ticks << " ticks allocated" << std::endl;
+	if (allocatingTicks > 0) total.print(std::cout);
+
+	return allocatingTicks == 0;
+}
+
+
+
+
+
+bool SimulationController::checkRampMerges(int ticks) {
+	const float deltaTime = 1.0f / 30.0f;
+
+	// a little over the distance a vehicle waits short of the ramp end, it merges from there
+	const float holdSlack = 0.5f;
+
+	model.setSeed(1);
+	model.buildHighwayCorridor(HighwayCorridorConfig());
+
+	struct RampVehicle {
+		std::shared_ptr<Vehicle> vehicle;
+		uint32_t id;
+		const RoadSegment* mainRoad;
+		float along;
+		float speed;
+	};
+	std::vector<RampVehicle> onRamps;
+
+	float largestJump = 0.0f;
+	int merges = 0;
+	bool continuous = true;
+
+	for (int i = 0; i < ticks && continuous; i++) {
+		// where each entrance ramp vehicle is along its main road before the step
+		onRamps.clear();
+		model.getGridNetwork().forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& road) {
+			if (road->getKind() != SegmentKind::RAMP) return;
+			auto ramp = std::static_pointer_cast<HighwayRamp>(road);
+			auto mainRoad = ramp->getMainRoad().lock();
+			if (ramp->getType() != RampType::ENTRANCE || !mainRoad) return;
+
+			for (const auto& vehicle : ramp->getVehicles()) {
+				Vector3 onRamp = ramp->getPositionAlongRoad(vehicle->getDistanceAlongRoad());
+				float along = (onRamp - mainRoad->getStartPosition()).dot(mainRoad->getDirectionVector());
+				onRamps.push_back({ vehicle, vehicle->getId(), mainRoad.get(), along, vehicle->getCurrentSpeed() });
+			}
+		});
+
+		model.update(deltaTime);
+
+		// a merge may move a vehicle as far as the step carries it at either speed, no further
+		for (const auto& entry : onRamps) {
+			if (entry.vehicle->getId() != entry.id || entry.vehicle->getCurrentRoad().get() != entry.mainRoad) continue;
+
+			float jump = entry.vehicle->getDistanceAlongRoad() - entry.along;
+			float allowed = (entry.speed + entry.vehicle->getCurrentSpeed()) * deltaTime + holdSlack;
+			largestJump = std::max(largestJump, std::fabs(jump));
+			merges++;
+
+			if (std::fabs(jump) > allowed) {
+				std::cout << "tick " << model.getTick() << ": vehicle " << entry.id << " moved " << jump << " m along the main road merging, at most "
+					<< allowed << " m allowed" << std::endl;
+				continuous = false;
+			}
+		}
+	}
+
+	std::cout << merges << " ramp merges, largest move along the main road " << largestJump << " m" << std::endl;
+	return continuous && merges > 0;
+}
+
+bool SimulationController::checkDemandFile(const std::string& path) {
+	const float deltaTime = 1.0f / 30.0f;
+	const int trips = 40;
+
+	// time, origin, destination, one trip a second spread over the first spawn points
+	{
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			std::cerr << "Failed to write demand file: " << path << std::endl;
+			return false;
+		}
+		file << "# time,origin,destination\n";
+		for (int i = 0; i < trips; i++) {
+			file << (i + 1) << ',' << i % 8 << ',' << i % 2 << '\n';
+		}
+	}
+
+	model.setSeed(1);
+	model.buildGridNetwork(4, 4, 3);
+	model.getDemandModel().clearOrigins();
+	if (!model.loadDemandFile(path)) {
+		return false;
+	}
+
+	// blocked trips wait at their spawn point, so give them a while past the last one
+	std::vector<uint32_t> seen;
+	for (int i = 0; i < static_cast<int>((trips + 30) / deltaTime); i++) {
+		model.update(deltaTime);
+		model.getGridNetwork().forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& road) {
+			for (const auto& vehicle : road->getVehicles()) {
+				if (std::find(seen.begin(), seen.end(), vehicle->getId()) == seen.end()) seen.push_back(vehicle->getId());
+			}
+		});
+	}
+
+	std::cout << seen.size() << " of " << trips << " demand file trips entered the network" << std::endl;
+	return static_cast<int>(seen.size()) == trips;
+}
+
+bool SimulationController::checkIncidentClosure(int ticks) {
+	const float deltaTime = 1.0f / 30.0f;
+	const TravelDirection direction = TravelDirection::FORWARD;
+
+	model.setSeed(1);
+	model.buildGridNetwork(4, 4, 3);
+
+	std::shared_ptr<RoadSegment> road;
+	model.getGridNetwork().forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& candidate) {
+		if (candidate->getId() == "road_h_1_1") road = candidate;
+	});
+	if (!road) return false;
+
+	// every regular lane closes a minute in, once traffic has reached the road. the shoulders stay open
+	const auto& lanes = road->getLanes(direction);
+	for (size_t lane = 0; lane < lanes.size(); lane++) {
+		if (!lanes[lane].isTravelLane()) continue;
+
+		Incident incident;
+		incident.roadId = road->getId();
+		incident.type = IncidentType::LANE_CLOSURE;
+		incident.startTime = model.getGridNetwork().getIncidents().getClock() + 60.0;
+		incident.duration = ticks * deltaTime;
+		incident.direction = direction;
+		incident.laneIndex = static_cast<int>(lane);
+		model.scheduleIncident(incident);
+	}
+
+	for (int i = 0; i < 3000 && !road->isClosed(direction); i++) {
+		model.update(deltaTime);
+	}
+	if (!road->isClosed(direction)) {
+		std::cout << road->getId() << " did not close with every regular lane closed" << std::endl;
+		return false;
+	}
+
+	// vehicles already on the road may leave, nobody may join it
+	std::vector<uint32_t> onRoad;
+	for (const auto& vehicle : road->getVehicles()) {
+		if (vehicle->getTravelDirection() == direction) onRoad.push_back(vehicle->getId());
+	}
+
+	bool held = true;
+	int closedTicks = 0;
+	for (; closedTicks < ticks && road->isClosed(direction) && held; closedTicks++) {
+		if (road->findOpenLane(0, direction) >= 0) {
+			std::cout << "tick " << model.getTick() << ": closed road offered lane " << road->findOpenLane(0, direction) << std::endl;
+			held = false;
+		}
+		for (const auto& vehicle : road->getVehicles()) {
+			if (vehicle->getTravelDirection() == direction && std::find(onRoad.begin(), onRoad.end(), vehicle->getId()) == onRoad.end()) {
+				std::cout << "tick " << model.getTick() << ": vehicle " << vehicle->getId() << " entered the closed road" << std::endl;
+				held = false;
+			}
+		}
+		model.update(deltaTime);
+	}
+
+	for (int i = 0; i < 10 && road->isClosed(direction); i++) {
+		model.update(deltaTime);
+	}
+	bool reopened = !road->isClosed(direction) && road->findOpenLane(0, direction) >= 0;
+
+	std::cout << road->getId() << " held closed for " << closedTicks << " of " << ticks << " ticks with " << onRoad.size()
+		<< " vehicles left on it, " << (reopened ? "reopened" : "did not reopen") << std::endl;
+	return held && closedTicks > 0 && reopened;
+}
+
+bool SimulationController::checkFastForward(float simulatedSeconds) {
+	model.setSeed(1);
+	model.buildGridNetwork(2, 2, 3);
+	model.getDemandModel().clearOrigins();
+
+	double startTime = model.getSimulationTime();
+	uint64_t startTick = model.getTick();
+	float stepTime = model.getStableStep();
+
+	runFastForward(simulatedSeconds);
+
+	// the last step may carry the clock past the target, never by a whole step
+	double simulated = model.getSimulationTime() - startTime;
+	double overshoot = simulated - simulatedSeconds;
+	double drift = std::fabs(simulated - static_cast<double>(model.getTick() - startTick) * stepTime);
+	bool ended = overshoot >= 0.0 && overshoot < stepTime;
+	bool accurate = drift <= simulated * 1e-9;
+
+	std::cout << "ended " << overshoot << "s past the target, clock " << drift << "s off the sum of its steps" << std::endl;
+	return ended && accurate;
+}
@@ -1,13 +1,35 @@
 #pragma once
 
+#include <memory>
+
 #include "simulationModel.h"
 #include "viewController.h"
+#include "../render/frameWriter.h"
+#include "../net/telemetryServer.h"
+#include "../net/sharedStatePublisher.h"
+
+
+// a fast forwarding model is stepped flat out and only some frames are drawn
+struct FastForwardConfig {
+	// draw after this many steps, 0 to go by the time budget alone
+	int renderEverySteps = 0;
+
+	// wall clock seconds spent stepping before a frame is drawn
+	float renderBudget = 1.0f / 30.0f;
+};
 
 
 class SimulationController {
 private:
 	SimulationModel model;
-	ViewController view;
+	FastForwardConfig fastForward;
+
+	// only created by init, headless export never opens a window
+	std::unique_ptr<ViewController> view;
+
+	// only created by serveTelemetry and publishSharedState, published to after every update
+	std::unique_ptr<TelemetryServer> telemetry;
+	std::unique_ptr<SharedStatePublisher> sharedState;
 
 	bool running = false;
 	float lastFrameTime = 0.0f;
@@ -22,4 +44,76 @@ public:
 	void stop() { running = false; }
 	void runCustomNetworkSimulation();
 	void runGridNetwrokSimulation(int width, int height, int numLanes);
+	void runHighwayCorridorSimulation(const HighwayCorridorConfig& config = HighwayCorridorConfig());
+	bool runScenarioSimulation(const std::string& path);
+
+	// parses a text scenario and writes it in the compiled format, false if either step failed
+	bool compileScenario(const std::string& inputPath, const std::string& outputPath);
+
+	// fast forwards a scenario without a window and writes its detector series, as csv unless the
+	// output ends in .bin. false if the scenario did not load or the file could not be written
+	bool recordDetectors(const std::string& scenarioPath, float simulatedSeconds, const std::string& outputPath);
+
+	// how often frames are drawn while the model fast forwards
+	void setFastForwardConfig(const FastForwardConfig& config) { fastForward = config; }
+	void stepFastForward();
+
+	// pushes simulated time through without a window and reports how much faster than real time it ran
+	void runFastForward(float simulatedSeconds);
+	void fastForwardGridNetworkSimulation(int width, int height, int numLanes, float simulatedSeconds);
+
+	// steps the simulation at a fixed rate and writes every frame through the software rasterizer
+	void runHeadless(int frames, const FrameExportConfig& config, float deltaTime = 1.0f / 30.0f);
+	void exportGridNetworkSimulation(int width, int height, int numLanes, int frames, const FrameExportConfig& config);
+
+	// streams the model to remote viewers from now on, false if the endpoint can not be listened on
+	bool serveTelemetry(const SocketEndpoint& endpoint, const TelemetryConfig& config = TelemetryConfig());
+
+	// writes every tick into a named shared memory ring for SharedStateReaders on this host
+	bool publishSharedState(const std::string& name, const SharedStateConfig& config = SharedStateConfig());
+
+	// hands the current tick to the telemetry server and shared state, whichever are on
+	void publishState();
+
+	// steps the model in real time without a window, for a server that only has remote viewers
+	void runServer(float deltaTime = 1.0f / 60.0f);
+	void serveGridNetworkSimulation(int width, int height, int numLanes, const SocketEndpoint& endpoint);
+	void publishGridNetworkSimulation(int width, int height, int numLanes, const std::string& sharedStateName);
+
+	// opens a window that draws a remote simulation instead of a local model
+	void runTelemetryViewer(const SocketEndpoint& endpoint);
+
+	// serves the grid scenario on a loopback endpoint and checks that a client rebuilds every
+	// published tick exactly and that a client which never reads is dropped, false if not
+	bool checkTelemetryLoopback(const SocketEndpoint& endpoint, int ticks);
+
+	// publishes the grid scenario to shared memory and reads every frame back through a
+	// SharedStateReader, false if a frame did not match the model. compact frames may be off by
+	// the compact format's quantization bounds, no more
+	bool checkSharedState(const std::string& name, int ticks, bool compact = false);
+
+	// runs the built in scenarios from the same seed under each engine variant (the active set
+	// against a full sweep, scheduled decisions against every tick ones) and compares their
+	// state hashes, false if any pair diverged
+	bool verifyDeterminism(int ticks, int hashInterval = 1, uint64_t seed = 1);
+
+	// runs the signalized grid past warm up, rendering it each tick, and reports every tick
+	// whose update or frames still touched the heap, false if any did
+	bool checkAllocations(int ticks, int warmupTicks = 2000, uint64_t seed = 1);
+
+	// runs the highway corridor and follows every vehicle leaving an entrance ramp, false if one
+	// moved further along the main road in its merge step than its speed carries it
+	bool checkRampMerges(int ticks);
+
+	// writes a demand file of trips without the optional lane column, replays it on the grid with
+	// no other demand and checks that every trip entered the network, false if any did not
+	bool checkDemandFile(const std::string& path);
+
+	// closes every regular lane of one grid road for the given ticks and checks that the road counts
+	// as closed, offers no lane and takes no new vehicles until it reopens, false if any of it did not
+	bool checkIncidentClosure(int ticks);
+
+	// fast forwards an empty grid, where every step is the longest, and checks that the run ends
+	// on the requested time and the clock is the sum of its steps. false if either is off
+	bool checkFastForward(float simulatedSeconds);
 };
@@ -2,22 +2,82 @@
 
 #include <random>
 #include <iostream>
+#include <algorithm>
 
 #include "../road/intersection.h"
+#include "../road/scenarioParser.h"
+#include "../road/scenarioBinary.h"
 
 
 void SimulationModel::update(float deltaTime) {
 	if (isPaused) return;
 
-	float scaledTime = deltaTime * timeScale;
-	simulationTime += scaledTime;
+	AllocationCounts before = AllocationStats::snapshot();
 
-	roadNetwork.update(scaledTime);
+	advance(deltaTime * timeScale);
+
+	tickAllocations = AllocationStats::snapshot() - before;
 }
 
 
-void SimulationModel::buildCustomNetwork() {
+void SimulationModel::advance(float seconds) {
+	lastStepCount = 0;
+
+	float remaining = seconds;
+	while (remaining > 0.0f) {
+		float stepTime = std::min(remaining, getStableStep());
+
+		// take a sliver left at the end with this step rather than as a step of its own
+		if (remaining - stepTime < minStepTime * 0.5f) {
+			stepTime = remaining;
+		}
+
+		simulationTime += stepTime;
+		tick++;
+		roadNetwork.update(stepTime);
+
+		remaining -= stepTime;
+		lastStepCount++;
+	}
+}
+
+
+void SimulationModel::step() {
+	lastStepCount = 1;
+
+	float stepTime = getStableStep();
+	simulationTime += stepTime;
+	tick++;
+	roadNetwork.update(stepTime);
+}
+
+
+float SimulationModel::getStableStep() const {
+	const StepLimits& limits = roadNetwork.getStepLimits();
+	float stepTime = maxStepTime;
+
+	// the fastest vehicle moves at most maxStepTravel, nobody covers more than part of a closing gap
+	if (limits.maxSpeed > 0.0f) {
+		stepTime = std::min(stepTime, maxStepTravel / limits.maxSpeed);
+	}
+	stepTime = std::min(stepTime, closingFraction * limits.closingTime);
+
+	return std::max(stepTime, minStepTime);
+}
+
+
+void SimulationModel::resetNetwork() {
     roadNetwork = RoadNetwork();
+    if (seeded) {
+        roadNetwork.setSeed(seed);
+    }
+    roadNetwork.setDecisionRates(decisionRates);
+    roadNetwork.setFullSweep(fullSweep);
+}
+
+
+void SimulationModel::buildCustomNetwork() {
+    resetNetwork();
 
     // T-junction 
     std::cout << "Creating T-Junction..." << std::endl;
@@ -93,21 +153,51 @@ void SimulationModel::buildCustomNetwork() {
     std::cout << "Adding spawn points..." << std::endl;
 
     auto roadSegments = roadNetwork.getAllRoadSegments();
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_real_distribution<> spawnRateDist(5.0f, 15.0f);
 
     for (const auto& road : roadSegments) {
         if (road) {
-            auto spawnPoint = std::make_shared<SpawnPoint>(road, 10.0f, spawnRateDist(gen));
+            auto spawnPoint = std::make_shared<SpawnPoint>(road, 10.0f, spawnRateDist(roadNetwork.getRandom()));
             roadNetwork.addSpawnPoint(spawnPoint);
         }
     }
 
+    roadNetwork.compile();
     std::cout << "Network built with " << roadSegments.size() << " road segments and " << roadNetwork.getAllJunctions().size() << " junctions" << std::endl;
 };
 
 
-void SimulationModel::buildGridNetwork(int width, int height, int numLanes, float roadLength, float roadWidth, float speedLimit) {
-    roadNetwork.buildNetwork(width, height, numLanes, roadLength, roadWidth, speedLimit);
-}
\ No newline at end of file
+void SimulationModel::buildGridNetwork(int width, int height, int numLanes, float roadLength, float roadWidth, float speedLimit, bool twoWay, bool signalized) {
+    roadNetwork.buildNetwork(width, height, numLanes, roadLength, roadWidth, speedLimit, twoWay, signalized);
+    roadNetwork.compile();
+}
+
+
+void SimulationModel::buildHighwayCorridor(const HighwayCorridorConfig& config) {
+    resetNetwork();
+
+    std::cout << "Creating highway corridor..." << std::endl;
+    HighwayCorridor::create(roadNetwork, config);
+    roadNetwork.compile();
+
+    std::cout << "Network built with " << roadNetwork.getAllRoadSegments().size() << " road segments and " << roadNetwork.getAllJunctions().size() << " junctions" << std::endl;
+}
+
+
+bool SimulationModel::loadScenario(const std::string& path) {
+    ScenarioDescription scenario;
+    std::string error;
+
+    bool loaded = ScenarioBinary::isBinaryFile(path) ? ScenarioBinary::readFile(path, scenario, error) : ScenarioParser::parseFile(path, scenario, error);
+    if (!loaded) {
+        std::cerr << "Failed to load scenario: " << error << std::endl;
+        return false;
+    }
+
+    resetNetwork();
+    ScenarioBuilder::build(scenario, roadNetwork);
+    roadNetwork.compile();
+
+    std::cout << "Network built with " << roadNetwork.getAllRoadSegments().size() << " road segments and " << roadNetwork.getAllJunctions().size() << " junctions" << std::endl;
+    return true;
+}
@@ -1,32 +1,72 @@
 #pragma once
 
 #include "../road/roadNetwork.h"
+#include "../road/highwayCorridor.h"
+#include "../road/scenario.h"
 
 
 class SimulationModel {
 private:
 	RoadNetwork roadNetwork;
-	float simulationTime = 0.0f;
+	uint64_t tick = 0;
+	// double so short steps still move the clock days into a run, a float stops after about a day and a half
+	double simulationTime = 0.0;
 	float timeScale = 1.0f;
 	bool isPaused = false;
+	bool fastForward = false;
+
+	// heap allocations made during the last update, by subsystem
+	AllocationCounts tickAllocations;
+
+	// an update is split into steps no longer than these allow, so scaled time cannot carry
+	// a vehicle through its leader, a segment end or a stop line in one step
+	static constexpr float maxStepTime = 1.0f / 30.0f;
+	static constexpr float minStepTime = 1.0f / 240.0f;
+	static constexpr float maxStepTravel = 1.0f;
+	static constexpr float closingFraction = 0.5f;
+	int lastStepCount = 0;
+
+	// kept so networks rebuilt from scratch are seeded too
+	uint64_t seed = 0;
+	bool seeded = false;
+	DecisionRates decisionRates;
+	bool fullSweep = false;
+
+	void resetNetwork();
 
 public:
 	SimulationModel() = default;
 	
 	void update(float deltaTime);
+
+	// simulation time forward in stable steps, ignores the time scale
+	void advance(float seconds);
+
+	// one step of the longest length the current traffic allows
+	void step();
+	float getStableStep() const;
 	
 	// generate different networks
 	void buildCustomNetwork();
-	void buildGridNetwork(int width, int height, int numLanes, float roadLength = 400.0f, float roadWidth = 32.0f, float speedLimit = 10.0f);
+	void buildGridNetwork(int width, int height, int numLanes, float roadLength = 400.0f, float roadWidth = 32.0f, float speedLimit = 10.0f, bool twoWay = true, bool signalized = false);
+	void buildHighwayCorridor(const HighwayCorridorConfig& config);
+
+	// scenario file in the text format or compiled, false with the reason printed if it did not load
+	bool loadScenario(const std::string& path);
 
 
 	// getters
 	const RoadNetwork& getGridNetwork() const { return roadNetwork; }
 	std::vector<std::shared_ptr<RoadSegment>> getAllRoadSegments() const { return roadNetwork.getAllRoadSegments(); }
 	std::vector<std::shared_ptr<Junction>> getAllJunctions() const { return roadNetwork.getAllJunctions(); }
+	uint64_t getTick() const { return tick; }
+	void reserveVehicles(size_t count) { roadNetwork.reserveVehicles(count); }
+	const AllocationCounts& getTickAllocations() const { return tickAllocations; }
+	int getLastStepCount() const { return lastStepCount; }
+	bool isFastForwarding() const { return fastForward; }
 	bool isSimulationPaused() const { return isPaused; }
 	float getTimeScale() const { return timeScale; }
-	float getSimulationTime() const { return simulationTime; }
+	double getSimulationTime() const { return simulationTime; }
 
 
 	// controls
@@ -35,9 +75,35 @@ public:
 	void togglePause() { isPaused = !isPaused; }
 	void setTimeScale(float scale) { timeScale = scale; }
 
+	// the controller steps a fast forwarding model as fast as it can instead of by frame time
+	void setFastForward(bool enabled) { fastForward = enabled; }
+	void toggleFastForward() { fastForward = !fastForward; }
+
+	// call before building a network to make the whole run reproducible
+	void setSeed(uint64_t newSeed) { seed = newSeed; seeded = true; roadNetwork.setSeed(newSeed); }
+	// how often drivers reconsider lanes and merges, kept across rebuilt networks
+	void setDecisionRates(const DecisionRates& rates) { decisionRates = rates; roadNetwork.setDecisionRates(rates); }
+	const DecisionRates& getDecisionRates() const { return decisionRates; }
+	// update every segment and junction each tick instead of the active set, kept across rebuilt networks
+	void setFullSweep(bool enabled) { fullSweep = enabled; roadNetwork.setFullSweep(enabled); }
+
+	uint64_t hashState(std::vector<EntityDigest>* entities = nullptr) const { return roadNetwork.hashState(entities); }
+
 	void addRoadSegment(std::shared_ptr<RoadSegment> roadSegment) { roadNetwork.addRoadSegment(roadSegment); }
 	void addJunction(std::shared_ptr<Junction> junction) { roadNetwork.addJunction(junction); }
 	void addSpawnPoint(std::shared_ptr<SpawnPoint> spawnPoint) { roadNetwork.addSpawnPoint(spawnPoint); }
 	void addDestination(std::shared_ptr<Destination> destination) { roadNetwork.addDestination(destination); }
 
+	// structural edits are applied between ticks
+	void submitEdit(NetworkEdit edit) { roadNetwork.submitEdit(std::move(edit)); }
+	int scheduleIncident(const Incident& incident) { return roadNetwork.scheduleIncident(incident); }
+
+	// loop detectors, placed after the network is built
+	int addDetector(const LoopDetector& detector) { return roadNetwork.addDetector(detector); }
+	const DetectorBank& getDetectors() const { return roadNetwork.getDetectors(); }
+
+	// demand
+	DemandModel& getDemandModel() { return roadNetwork.getDemandModel(); }
+	bool loadDemandFile(const std::string& path) { return roadNetwork.getDemandModel().openDemandFile(path); }
+
 };
\ No newline at end of file
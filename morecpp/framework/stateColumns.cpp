@@ -0,0 +1,99 @@
+#include "stateColumns.h"
+
+#include <algorithm>
+
+#include "../road/trafficLightJunction.h"
+#include "../traffic/vehicle.h"
+
+
+// slower than this counts as queued
+static constexpr float queuedSpeed = 0.5f;
+
+
+const std::vector<std::shared_ptr<TrafficLightJunction>>& SignalIndex::get(const RoadNetwork& network) {
+	if (valid && revision == network.getRevision()) {
+		return junctions;
+	}
+
+	junctions.clear();
+	network.forEachJunction([&](const std::shared_ptr<Junction>& junction) {
+		if (auto lights = std::dynamic_pointer_cast<TrafficLightJunction>(junction)) {
+			junctions.push_back(lights);
+		}
+	});
+	std::sort(junctions.begin(), junctions.end(), [](const auto& a, const auto& b) { return a->getId() < b->getId(); });
+
+	lookup.clear();
+	for (size_t i = 0; i < junctions.size(); i++) {
+		lookup.push_back({ junctions[i].get(), static_cast<int32_t>(i) });
+	}
+	std::sort(lookup.begin(), lookup.end());
+
+	revision = network.getRevision();
+	valid = true;
+	return junctions;
+}
+
+
+int32_t SignalIndex::find(const Junction* junction) const {
+	auto it = std::lower_bound(lookup.begin(), lookup.end(), std::make_pair(junction, static_cast<int32_t>(-1)));
+	return it != lookup.end() && it->first == junction ? it->second : -1;
+}
+
+
+StateColumns::StateColumns(size_t rows, size_t vehicleCapacity, size_t junctionCapacity) :
+	rows(rows), vehicleCapacity(vehicleCapacity), junctionCapacity(junctionCapacity),
+	vehicleCounts(rows), junctionCounts(rows), ticks(rows), simulationTimes(rows),
+	ids(rows * vehicleCapacity), segments(rows * vehicleCapacity), lanes(rows * vehicleCapacity), directions(rows * vehicleCapacity),
+	distances(rows * vehicleCapacity), speeds(rows * vehicleCapacity), x(rows * vehicleCapacity), z(rows * vehicleCapacity),
+	phases(rows * junctionCapacity), phaseCounts(rows * junctionCapacity), phaseTimers(rows * junctionCapacity), queuedVehicles(rows * junctionCapacity) {}
+
+
+void StateColumns::gather(size_t row, const SimulationModel& model, SignalIndex& signals) {
+	const RoadNetwork& network = model.getGridNetwork();
+	const auto& junctions = signals.get(network);
+
+	ticks[row] = model.getTick();
+	simulationTimes[row] = static_cast<float>(model.getSimulationTime());
+
+	size_t junctionCount = std::min(junctions.size(), junctionCapacity);
+	size_t junctionBase = row * junctionCapacity;
+	for (size_t j = 0; j < junctionCount; j++) {
+		phases[junctionBase + j] = junctions[j]->getCurrentPhase();
+		phaseCounts[junctionBase + j] = junctions[j]->getPhaseCount();
+		phaseTimers[junctionBase + j] = junctions[j]->getPhaseTimer();
+		queuedVehicles[junctionBase + j] = 0;
+	}
+	junctionCounts[row] = static_cast<uint32_t>(junctionCount);
+
+	size_t base = row * vehicleCapacity;
+	size_t count = 0;
+	network.forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& road) {
+		int32_t segment = road->getIndex();
+
+		for (const auto& vehicle : road->getVehicles()) {
+			// queues are counted for every vehicle, even past the column capacity
+			if (vehicle->getCurrentSpeed() < queuedSpeed && junctionCount > 0) {
+				auto exit = road->getExitJunction(vehicle->getTravelDirection());
+				int32_t junction = exit ? signals.find(exit.get()) : -1;
+				if (junction >= 0 && static_cast<size_t>(junction) < junctionCount) {
+					queuedVehicles[junctionBase + junction]++;
+				}
+			}
+
+			if (count == vehicleCapacity) continue;
+
+			const Vector3& position = vehicle->getPosition();
+			ids[base + count] = vehicle->getId();
+			segments[base + count] = segment;
+			lanes[base + count] = vehicle->getCurrentLane();
+			directions[base + count] = static_cast<uint8_t>(vehicle->getTravelDirection());
+			distances[base + count] = vehicle->getDistanceAlongRoad();
+			speeds[base + count] = vehicle->getCurrentSpeed();
+			x[base + count] = position.x;
+			z[base + count] = position.z;
+			count++;
+		}
+	});
+	vehicleCounts[row] = static_cast<uint32_t>(count);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "simulationModel.h"
+
+
+class TrafficLightJunction;
+
+
+// traffic light junctions of a network in id order, the order junction columns and phase
+// actions use. refreshed when the network's revision changes
+class SignalIndex {
+private:
+	std::vector<std::shared_ptr<TrafficLightJunction>> junctions;
+
+	// junction to its position in junctions, sorted by address
+	std::vector<std::pair<const Junction*, int32_t>> lookup;
+	uint32_t revision = 0;
+	bool valid = false;
+
+
+public:
+	const std::vector<std::shared_ptr<TrafficLightJunction>>& get(const RoadNetwork& network);
+
+	// position of the junction in the last get, -1 if it has no lights
+	int32_t find(const Junction* junction) const;
+};
+
+
+// vehicle and junction state of one or more models as flat columns, row r holds model r.
+// sized once up front so views into the columns stay valid from step to step, a row with
+// more vehicles than vehicleCapacity only lists the first ones
+struct StateColumns {
+	size_t rows = 0;
+	size_t vehicleCapacity = 0;
+	size_t junctionCapacity = 0;
+
+	// per row
+	std::vector<uint32_t> vehicleCounts;
+	std::vector<uint32_t> junctionCounts;
+	std::vector<uint64_t> ticks;
+	std::vector<float> simulationTimes;
+
+	// rows x vehicleCapacity
+	std::vector<uint32_t> ids;
+	std::vector<int32_t> segments;
+	std::vector<int32_t> lanes;
+	std::vector<uint8_t> directions;
+	std::vector<float> distances;
+	std::vector<float> speeds;
+	std::vector<float> x;
+	std::vector<float> z;
+
+	// rows x junctionCapacity, traffic light junctions in SignalIndex order
+	std::vector<int32_t> phases;
+	std::vector<int32_t> phaseCounts;
+	std::vector<float> phaseTimers;
+
+	// vehicles standing still on the roads into each junction
+	std::vector<int32_t> queuedVehicles;
+
+	StateColumns() = default;
+	StateColumns(size_t rows, size_t vehicleCapacity, size_t junctionCapacity);
+
+	// refreshes signals first if the network changed
+	void gather(size_t row, const SimulationModel& model, SignalIndex& signals);
+};
@@ -0,0 +1,134 @@
+#include "vectorEnvironment.h"
+
+#include <algorithm>
+
+#include "../road/trafficLightJunction.h"
+
+
+VectorEnvironment::VectorEnvironment(size_t count, const VectorEnvironmentConfig& newConfig) :
+	config(newConfig), signals(count), seeds(count, 0), columns(count, newConfig.vehicleCapacity, newConfig.junctionCapacity), nextEnvironment(0) {
+
+	for (size_t i = 0; i < count; i++) {
+		models.push_back(std::make_unique<SimulationModel>());
+	}
+
+	int threads = config.threads;
+	if (threads <= 0) {
+		threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	// the calling thread steps environments as well, and there is no use for more threads than environments
+	threads = std::min(threads, static_cast<int>(std::max<size_t>(1, count)));
+	for (int i = 1; i < threads; i++) {
+		workers.emplace_back(&VectorEnvironment::workerLoop, this);
+	}
+}
+
+
+VectorEnvironment::~VectorEnvironment() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	batchReady.notify_all();
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+
+void VectorEnvironment::reset(uint64_t seed) {
+	for (size_t i = 0; i < seeds.size(); i++) {
+		seeds[i] = seed + i;
+	}
+	actions = nullptr;
+	runBatch(true);
+}
+
+
+void VectorEnvironment::step(const int32_t* phaseActions) {
+	actions = phaseActions;
+	runBatch(false);
+	actions = nullptr;
+}
+
+
+void VectorEnvironment::runBatch(bool reset) {
+	nextEnvironment = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		resetting = reset;
+		batchNumber++;
+		busyWorkers = static_cast<int>(workers.size());
+	}
+	batchReady.notify_all();
+
+	for (size_t index = nextEnvironment++; index < models.size(); index = nextEnvironment++) {
+		runEnvironment(index, reset);
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	batchDone.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+
+void VectorEnvironment::workerLoop() {
+	uint64_t seenBatch = 0;
+
+	while (true) {
+		bool reset;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			batchReady.wait(lock, [&] { return stopping || batchNumber != seenBatch; });
+			if (stopping) return;
+			seenBatch = batchNumber;
+			reset = resetting;
+		}
+
+		for (size_t index = nextEnvironment++; index < models.size(); index = nextEnvironment++) {
+			runEnvironment(index, reset);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busyWorkers == 0) {
+			batchDone.notify_one();
+		}
+	}
+}
+
+
+void VectorEnvironment::runEnvironment(size_t index, bool reset) {
+	if (reset) {
+		models[index] = std::make_unique<SimulationModel>();
+		signals[index] = SignalIndex();
+	}
+	SimulationModel& model = *models[index];
+
+	if (reset) {
+		model.setSeed(seeds[index]);
+		model.buildGridNetwork(config.gridWidth, config.gridHeight, config.numLanes, 400.0f, 32.0f, 10.0f, true, true);
+
+		for (const auto& junction : signals[index].get(model.getGridNetwork())) {
+			junction->setAutoAdvance(!config.externalSignalControl);
+		}
+	}
+
+	else {
+		const auto& junctions = signals[index].get(model.getGridNetwork());
+
+		if (actions) {
+			const int32_t* row = actions + index * config.junctionCapacity;
+			size_t count = std::min(junctions.size(), config.junctionCapacity);
+			for (size_t j = 0; j < count; j++) {
+				if (row[j] >= 0) junctions[j]->setPhase(row[j]);
+			}
+		}
+
+		for (int i = 0; i < config.updatesPerStep; i++) {
+			model.update(config.deltaTime);
+		}
+	}
+
+	columns.gather(index, model, signals[index]);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+
+#include "simulationModel.h"
+#include "stateColumns.h"
+
+
+struct VectorEnvironmentConfig {
+	int gridWidth = 4;
+	int gridHeight = 4;
+	int numLanes = 3;
+
+	float deltaTime = 1.0f / 10.0f;
+
+	// model updates per step, actions hold for all of them
+	int updatesPerStep = 1;
+
+	// signals only change phase through actions, instead of on their own timers
+	bool externalSignalControl = true;
+
+	size_t vehicleCapacity = 8192;
+	size_t junctionCapacity = 256;
+
+	// 0 uses every hardware thread
+	int threads = 0;
+};
+
+
+// a batch of independent signalized grid simulations stepped together for control experiments. each step
+// applies phase actions, advances every model and gathers their state into one set of columns,
+// environments are claimed by a pool of worker threads so the batch scales with cores
+class VectorEnvironment {
+private:
+	VectorEnvironmentConfig config;
+	std::vector<std::unique_ptr<SimulationModel>> models;
+	std::vector<SignalIndex> signals;
+	std::vector<uint64_t> seeds;
+	StateColumns columns;
+
+	// rows x junctionCapacity, -1 leaves a junction's phase alone
+	const int32_t* actions = nullptr;
+
+	// workers wait for a new batch number, then claim environments until none are left
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable batchReady;
+	std::condition_variable batchDone;
+	uint64_t batchNumber = 0;
+	int busyWorkers = 0;
+	bool stopping = false;
+	bool resetting = false;
+	std::atomic<size_t> nextEnvironment;
+
+	void workerLoop();
+	void runBatch(bool reset);
+	void runEnvironment(size_t index, bool reset);
+
+
+public:
+	VectorEnvironment(size_t count, const VectorEnvironmentConfig& config = VectorEnvironmentConfig());
+	~VectorEnvironment();
+
+	VectorEnvironment(const VectorEnvironment&) = delete;
+	VectorEnvironment& operator=(const VectorEnvironment&) = delete;
+
+	// rebuilds every environment, environment i seeded with seed + i
+	void reset(uint64_t seed);
+
+	// phaseActions is rows x junctionCapacity or null for no actions. blocks until every
+	// environment has stepped and its columns are gathered
+	void step(const int32_t* phaseActions);
+
+	size_t getCount() const { return models.size(); }
+	const StateColumns& getColumns() const { return columns; }
+	const VectorEnvironmentConfig& getConfig() const { return config; }
+	SimulationModel& getModel(size_t index) { return *models[index]; }
+};
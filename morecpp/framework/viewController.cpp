@@ -43,11 +43,9 @@ ViewController::ViewController(int width, int height) : simulationModel(nullptr)
     glEnable(GL_DEPTH_TEST);
     glViewport(0, 0, width, height);
 
-    // load shaders
-    shaderProgram = ShaderLoader::loadShaders("shaders/default.vert", "shaders/default.frag");
-
-    // setup verts
-    setupRectangleVerticies();
+    // scene is drawn through the gl backend, the heatmap is a gl only overlay
+    backend = std::make_unique<GLRenderBackend>();
+    setupHeatmap();
 
     // set up camera
     cameraPos = glm::vec3(0.0f, 100.0f, 0.0f);
@@ -57,9 +55,11 @@ ViewController::ViewController(int width, int height) : simulationModel(nullptr)
 
 
 ViewController::~ViewController() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
+    backend.reset();
+    glDeleteVertexArrays(1, &heatmapVAO);
+    glDeleteBuffers(1, &heatmapVBO);
+    glDeleteTextures(1, &trafficTexture);
+    glDeleteProgram(heatmapProgram);
 
     if (window) {
         glfwDestroyWindow(window);
@@ -96,50 +96,120 @@ void ViewController::processScroll(double yOffset) {
 }
 
 
-void ViewController::setupRectangleVerticies() {
-    float vertices[] = {
-        0.5f, 0.0f,  0.5f,  // top right
-        0.5f, 0.0f, -0.5f,  // bottom right
-       -0.5f, 0.0f,  0.5f,  // top left
-
-        0.5f, 0.0f, -0.5f,  // bottom right
-       -0.5f, 0.0f, -0.5f,  // bottom left
-       -0.5f, 0.0f,  0.5f   // top left
-    };
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+void ViewController::setupHeatmap() {
+    heatmapProgram = ShaderLoader::loadShaders("shaders/heatmap.vert", "shaders/heatmap.frag");
 
-    glBindVertexArray(VAO);
+    glGenVertexArrays(1, &heatmapVAO);
+    glGenBuffers(1, &heatmapVBO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindVertexArray(heatmapVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, heatmapVBO);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    // centre line point, unit side vector (x, z), half width, segment index
+    GLsizei stride = 7 * sizeof(float);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
     glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(5 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(3);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+
+    glGenTextures(1, &trafficTexture);
+    glBindTexture(GL_TEXTURE_2D, trafficTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+void ViewController::buildHeatmapMesh() {
+    const RoadNetwork& network = simulationModel->getGridNetwork();
+    std::vector<float> vertices;
+
+    for (const auto& road : network.getAllRoadSegments()) {
+        auto startJunction = road->getStartJunction();
+        auto endJunction = road->getEndJunction();
+        if (!startJunction || !endJunction || road->getIndex() < 0) continue;
+
+        // run from junction centre to junction centre so junctions are covered too
+        Vector3 startPos = startJunction->getPosition();
+        Vector3 endPos = endJunction->getPosition();
+        Vector3 roadDir = (endPos - startPos).normalized();
+        float halfWidth = road->getDimensions().z / 2.0f;
+        float segment = static_cast<float>(road->getIndex());
+
+        // two triangles, corners given as (end, side)
+        const int corners[6][2] = { {1, 1}, {1, -1}, {0, 1}, {1, -1}, {0, -1}, {0, 1} };
+        for (const auto& corner : corners) {
+            const Vector3& point = corner[0] ? endPos : startPos;
+            float side = static_cast<float>(corner[1]);
+            vertices.insert(vertices.end(), { point.x, 0.01f, point.z, -roadDir.z * side, roadDir.x * side, halfWidth, segment });
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, heatmapVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    heatmapVertexCount = static_cast<GLsizei>(vertices.size() / 7);
+    heatmapRevision = network.getRevision();
+    heatmapMeshValid = true;
 }
 
 
-void ViewController::drawRectangle(const glm::vec3& position, const glm::vec3& scale, const glm::vec3 & color) {
-    // tranformation
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, position);
-    model = glm::scale(model, scale);
+void ViewController::uploadSegmentTraffic() {
+    const auto& traffic = simulationModel->getGridNetwork().getSegmentTraffic();
+    if (traffic.empty()) return;
+
+    glBindTexture(GL_TEXTURE_2D, trafficTexture);
+
+    // segments are laid out row by row, the texture only grows
+    int rows = static_cast<int>((traffic.size() + trafficTextureWidth - 1) / trafficTextureWidth);
+    if (rows > trafficTextureHeight) {
+        trafficTextureHeight = rows;
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, trafficTextureWidth, trafficTextureHeight, 0, GL_RG, GL_FLOAT, nullptr);
+    }
+
+    int fullRows = static_cast<int>(traffic.size() / trafficTextureWidth);
+    int remainder = static_cast<int>(traffic.size() % trafficTextureWidth);
+    if (fullRows > 0) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, trafficTextureWidth, fullRows, GL_RG, GL_FLOAT, traffic.data());
+    }
+    if (remainder > 0) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, fullRows, remainder, 1, GL_RG, GL_FLOAT, traffic.data() + fullRows * trafficTextureWidth);
+    }
+}
+
+
+void ViewController::renderHeatmap(const glm::mat4& view, const glm::mat4& projection) {
+
+    // the mesh only changes when the network is edited
+    if (!heatmapMeshValid || heatmapRevision != simulationModel->getGridNetwork().getRevision()) {
+        buildHeatmapMesh();
+    }
+
+    glUseProgram(heatmapProgram);
+    glActiveTexture(GL_TEXTURE0);
+    uploadSegmentTraffic();
 
-    // set uniforms
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glUniformMatrix4fv(glGetUniformLocation(heatmapProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(heatmapProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1i(glGetUniformLocation(heatmapProgram, "trafficData"), 0);
+    glUniform1i(glGetUniformLocation(heatmapProgram, "trafficWidth"), trafficTextureWidth);
 
-    GLuint colorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-    glUniform3fv(colorLoc, 1, glm::value_ptr(color));
+    // about two pixels at the current zoom
+    float minHalfWidth = (orthographicRight - orthographicLeft) / 1920.0f * 2.0f;
+    glUniform1f(glGetUniformLocation(heatmapProgram, "minHalfWidth"), minHalfWidth);
 
-    // draw rectangle
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(heatmapVAO);
+    glDrawArrays(GL_TRIANGLES, 0, heatmapVertexCount);
     glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 
@@ -180,6 +250,31 @@ bool ViewController::processEvents() {
     cameraTarget.z = cameraPos.z;
     cameraTarget.y = 0.0f;
 
+    // toggle the congestion heatmap on key press
+    bool heatmapKey = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+    if (heatmapKey && !heatmapKeyDown) {
+        showHeatmap = !showHeatmap;
+    }
+    heatmapKeyDown = heatmapKey;
+
+    // fast forward on key press, frames are then drawn on the controller's budget
+    bool fastForwardKey = glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS;
+    if (fastForwardKey && !fastForwardKeyDown && simulationModel) {
+        simulationModel->toggleFastForward();
+    }
+    fastForwardKeyDown = fastForwardKey;
+
+    // left click selects what is under the cursor, right click clears
+    bool selectButton = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    if (selectButton && !selectButtonDown) {
+        selectAtCursor();
+    }
+    selectButtonDown = selectButton;
+
+    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) {
+        clearSelection();
+    }
+
     return true;
 }
 
@@ -195,270 +290,141 @@ void ViewController::moveCamera(float deltaX, float deltaY) {
 }
 
 
+RenderView ViewController::getRenderView() const {
+    RenderView frame;
+    frame.centerX = cameraPos.x;
+    frame.centerZ = cameraPos.z;
+    frame.left = orthographicLeft;
+    frame.right = orthographicRight;
+    frame.bottom = orthographicBottom;
+    frame.top = orthographicTop;
+    return frame;
+}
+
+
 void ViewController::render() {
-    if (!simulationModel) {
+    if (!simulationModel && !telemetryClient) {
         std::cerr << "No simulation model set for rendering" << std::endl;
         return;
     }
 
+    if (!backend) {
+        return;
+    }
+
     // clear the screen
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glUseProgram(shaderProgram);
-
-    glm::mat4 view = glm::lookAt(
-        cameraPos,
-        cameraTarget,
-        cameraUp
-    );
-
-    glm::mat4 projection = glm::ortho(
-        orthographicLeft, orthographicRight,
-        orthographicBottom, orthographicTop,
-        0.1f, 200.0f
-    );
+    RenderView frame = getRenderView();
 
-    GLint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-    auto roadSegments = simulationModel->getAllRoadSegments();
-    for (const auto& road : roadSegments) {
-        renderRoadSegment(*road);
+    if (!simulationModel) {
+        renderTelemetry(frame);
+        return;
     }
 
-    auto junctions = simulationModel->getAllJunctions();
-    for (const auto& junction : junctions) {
-        renderJunction(*junction);
+    // the heatmap replaces per road, junction and vehicle drawing with a single draw call
+    if (showHeatmap) {
+        renderHeatmap(GLRenderBackend::getViewMatrix(frame), GLRenderBackend::getProjectionMatrix(frame));
+        updateOverlay();
+        glfwSwapBuffers(window);
+        return;
     }
 
+    backend->beginFrame(frame);
+    scene.render(*simulationModel, frame, *backend);
+    renderSelection();
+    backend->endFrame();
+
+    updateOverlay();
     glfwSwapBuffers(window);
 }
 
 
+void ViewController::renderTelemetry(const RenderView& frame) {
+    backend->beginFrame(frame);
+    telemetryScene.render(telemetryClient->getState(), frame, *backend);
+    backend->endFrame();
 
-void ViewController::renderJunction(const Junction& junction) {
-    const Vector3& junctionPos = junction.getPosition();
-    float radius = junction.getRadius();
-
-    glm::vec3 position(junctionPos.x, 0.01f, junctionPos.z);
-    glm::vec3 scale(radius * 2, 0.5f, radius * 2);
-
-    glm::vec3 color(0.4f, 0.4f, 0.4f);
-
-    // color for traffic light
-    const TrafficLightJunction* trafficJunction = dynamic_cast<const TrafficLightJunction*>(&junction);
-    if (trafficJunction) {
-        color = glm::vec3(0.5f, 0.5f, 0.6f);
-    }
-
-    drawRectangle(position, scale, color);
-
-    // render traffic lights
-    if (trafficJunction) {
-        renderTrafficLights(*trafficJunction);
+    // picking and the heatmap need the model, the title only shows how far the stream is
+    double now = glfwGetTime();
+    if (now - overlayTime >= overlayInterval) {
+        overlayTime = now;
+        const TelemetryState& state = telemetryClient->getState();
+        std::string title = "Traffic Simulator - " + std::string(telemetryClient->isConnected() ? "remote" : "disconnected") +
+            ", tick " + std::to_string(state.tick) + ", " + std::to_string(state.vehicles.size()) + " vehicles";
+        glfwSetWindowTitle(window, title.c_str());
     }
-}
-
-
-void ViewController::renderTrafficLights(const TrafficLightJunction& junction) {
-    // loop through roads in junction
-    for (const auto& road : junction.getConnectedRoads()) {
-
-        // get entry poiint
-        Vector3 entryPoint = junction.getEntryPoint(road);
-
-        // get traffic light state
-        LightState state = junction.getLightState(road);
-
-        // set color
-        glm::vec3 lightColor;
-        switch (state) {
-        case LightState::GREEN:
-            lightColor = glm::vec3(0.0f, 1.0f, 0.0f);
-            break;
-        case LightState::YELLOW:
-            lightColor = glm::vec3(1.0f, 1.0f, 0.0f);
-            break;
-        case LightState::RED:
-            lightColor = glm::vec3(1.0f, 0.0f, 0.0f);
-            break;
-        }
 
-        // draw the traffic light
-        glm::vec3 lightPos(entryPoint.x, 0.5f, entryPoint.z);
-        glm::vec3 lightScale(2.0f, 2.0f, 2.0f);
-        drawRectangle(lightPos, lightScale, lightColor);
-    }
+    glfwSwapBuffers(window);
 }
 
 
-void ViewController::renderRoadSegment(const RoadSegment& road) {
+void ViewController::selectAtCursor() {
+    if (!simulationModel) return;
 
-    float zoomFactor = (orthographicRight - orthographicLeft) / 240.0f;
-    float minLineThickness = 0.2f * zoomFactor;
-    float minLineWidth = 0.5f * zoomFactor;
+    double cursorX, cursorY;
+    int width, height;
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+    glfwGetWindowSize(window, &width, &height);
+    if (width <= 0 || height <= 0) return;
 
-    auto startJunction = road.getStartJunction();
-    auto endJunction = road.getEndJunction();
+    // the ortho camera maps the window straight onto the view rectangle
+    RenderView frame = getRenderView();
+    float x = frame.getWorldX(static_cast<float>(cursorX / width));
+    float z = frame.getWorldZ(static_cast<float>(cursorY / height));
+    float tolerance = pickPixels * (frame.right - frame.left) / width;
 
-    // return if no start or end junction
-    if (!startJunction || !endJunction) {
-        return;
-    }
+    selection = picker.pick(*simulationModel, x, z, tolerance);
+    overlayTime = 0.0;
+}
 
-    // get start/end positions
-    Vector3 startPos = startJunction->getPosition();
-    Vector3 endPos = endJunction->getPosition();
-    float junctionRadius = startJunction->getRadius();
 
-    // get direction and length
-    Vector3 roadDir = endPos - startPos;
-    roadDir = roadDir.normalized();
-    float fullLength = roadDir.length();
+void ViewController::renderSelection() {
+    if (!selection.isValid()) return;
 
-    Vector3 adjustedStartPos = startPos + roadDir * junctionRadius;
-    Vector3 adjustedEndPos = endPos - roadDir * junctionRadius;
+    // an outline drawn as a slightly larger rectangle just underneath the entity
+    float border = 0.6f * getCurrentZoomLevel();
 
-    Vector3 adjustedRoadDir = adjustedEndPos - adjustedStartPos;
-    float adjustedLength = adjustedRoadDir.length();
-   
-    if (adjustedLength <= 0.001f) {
-        return;
+    if (selection.kind == PickKind::VEHICLE) {
+        auto vehicle = selection.vehicle.lock();
+        const Vector3& position = vehicle->getPosition();
+        Vector3 heading = vehicle->getCurrentRoad()->getTravelVector(vehicle->getTravelDirection());
+        backend->drawRect({ position.x, position.z, heading.x, heading.z, vehicle->getDimensions().x + border * 2, vehicle->getDimensions().z + border * 2, 0.015f, 1.0f, 0.9f, 0.1f });
     }
 
-    // get center of road
-    glm::vec3 roadCenter(
-        (adjustedStartPos.x + adjustedEndPos.x) / 2.0f,
-        0.01f,
-        (adjustedStartPos.z + adjustedEndPos.z) / 2.0f
-    );
-
-    // get road width
-    float roadWidth = road.getDimensions().z;
-
-    // get orientation
-    float angle = atan2(roadDir.z, roadDir.x) * 180.0f / 3.14159f;
-
-
-    // transformation matrix
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, roadCenter);
-    model = glm::rotate(model, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(adjustedLength, 1.0f, roadWidth));
-
-    // draw road
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    glm::vec3 roadColor(0.3f, 0.3f, 0.3f);
-    GLuint colorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-    glUniform3fv(colorLoc, 1, glm::value_ptr(roadColor));
-
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
-
-    // draw lane markings
-    const auto& lanes = road.getLanes();
-    int laneCount = road.getLaneCount();
-    float laneWidth = roadWidth / laneCount;
-
-    for (size_t i = 1; i < laneCount; i++) {
-        bool isShoulderBoundary = (lanes[i - 1].getType() != lanes[i].getType());
-
-        float lanePosition = -roadWidth / 2.0f + i * laneWidth;
-
-        glm::vec3 lineColor(1.0f, 1.0f, 1.0f);
-
-        if (isShoulderBoundary) {
-            // solid white (shoulder)
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, roadCenter);
-            model = glm::rotate(model, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::translate(model, glm::vec3(0.0f, 0.05f, lanePosition));
-            model = glm::scale(model, glm::vec3(adjustedLength, std::max(0.2f, minLineThickness), std::max(0.2f, minLineWidth)));
-
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform3fv(colorLoc, 1, glm::value_ptr(lineColor));
-
-            glBindVertexArray(VAO);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            glBindVertexArray(0);
-
-        } else {
-            // dotted white (regular)
-            float dashLength = 3.0f;
-            float gapLength = 7.0f;
-            float spacing = dashLength + gapLength;
-
-            int dashCount = static_cast<int>(adjustedLength / spacing) + 1;
-
-            // draw lines
-            for (int dashIdx = 0; dashIdx < dashCount; dashIdx++) {
-                float dashOffset = -adjustedLength / 2 + dashIdx * spacing + dashLength / 2;
-
-                model = glm::mat4(1.0f);
-                model = glm::translate(model, roadCenter);
-                model = glm::rotate(model, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
-                model = glm::translate(model, glm::vec3(dashOffset, 0.05f, lanePosition));
-                model = glm::scale(model, glm::vec3(dashLength, std::max(0.1f, minLineThickness), std::max(0.5f, minLineWidth)));
+    else if (selection.kind == PickKind::ROAD) {
+        auto road = selection.road.lock();
+        Vector3 start = road->getStartPosition();
+        Vector3 end = road->getEndPosition();
+        Vector3 direction = end - start;
+        float length = direction.length();
+        if (length <= 0.0f) return;
 
-                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-                glUniform3fv(colorLoc, 1, glm::value_ptr(lineColor));
-
-                glBindVertexArray(VAO);
-                glDrawArrays(GL_TRIANGLES, 0, 6);
-                glBindVertexArray(0);
-            }
-        }
+        direction = direction * (1.0f / length);
+        backend->drawRect({ (start.x + end.x) / 2.0f, (start.z + end.z) / 2.0f, direction.x, direction.z, length, road->getDimensions().z + border * 2, 0.005f, 1.0f, 0.9f, 0.1f });
     }
 
-    // Draw vehicles
-    for (const auto& vehicle : road.getVehicles()) {
-        if (vehicle) {
-            renderVehicle(*vehicle, road);
-        }
+    else if (selection.kind == PickKind::JUNCTION) {
+        auto junction = selection.junction.lock();
+        const Vector3& position = junction->getPosition();
+        float size = junction->getRadius() * 2 + border * 2;
+        backend->drawRect({ position.x, position.z, 1.0f, 0.0f, size, size, 0.005f, 1.0f, 0.9f, 0.1f });
     }
 }
 
 
-void ViewController::renderVehicle(const Vehicle& vehicle, const RoadSegment& road) {
-    int lane = vehicle.getCurrentLane();
-    float distance = vehicle.getDistanceAlongRoad();
-
-    // get vehicle position
-    Vector3 vehiclePos = road.getLanePositionAlongRoad(lane, distance);
-
-    const Vector3& vehicleDim = vehicle.getDimensions();
-    const Color& vehicleColor = vehicle.getColor();
-
-    // get road direction for orientation
-    Vector3 roadDir = road.getDirection();
-    float angle = atan2(roadDir.z, roadDir.x) * 180.0f / 3.14159f;
+void ViewController::updateOverlay() {
+    double now = glfwGetTime();
+    if (now - overlayTime < overlayInterval) return;
+    overlayTime = now;
 
-    // transformation matrix
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(vehiclePos.x, 0.02f, vehiclePos.z));
-    model = glm::rotate(model, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(vehicleDim.x, 1.0f, vehicleDim.z));
-
-    GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    // set vehicle color
-    glm::vec3 vehColor(vehicleColor.r / 255.0f, vehicleColor.g / 255.0f, vehicleColor.b / 255.0f);
-    GLuint colorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-    glUniform3fv(colorLoc, 1, glm::value_ptr(vehColor));
-
-    // draw vehicle
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    // no text rendering in the view yet, the title bar carries the inspected state
+    std::string state = selection.describe();
+    glfwSetWindowTitle(window, state.empty() ? "Traffic Simulator" : ("Traffic Simulator - " + state).c_str());
 }
 
+
 float ViewController::getCurrentZoomLevel() const {
-    return (orthographicRight - orthographicLeft) / 200.0f;
+    return getRenderView().getZoomLevel();
 }
\ No newline at end of file
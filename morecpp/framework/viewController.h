@@ -1,19 +1,24 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
 #include "simulationModel.h"
-#include "../road/trafficLightJunction.h"
+#include "../render/glRenderBackend.h"
+#include "../render/sceneRenderer.h"
+#include "../render/telemetryRenderer.h"
+#include "../net/telemetryClient.h"
+#include "entityPicker.h"
 
 class ViewController {
 private:
 	GLFWwindow* window;
-	GLuint shaderProgram;
-	GLuint VAO, VBO;
+	std::unique_ptr<GLRenderBackend> backend;
+	SceneRenderer scene;
 
 	glm::vec3 cameraPos;
 	glm::vec3 cameraTarget;
@@ -24,21 +29,49 @@ private:
 	float orthographicTop = 60.0f;
 	float zoom = 40.0f;
 
+	// congestion overlay: one cached mesh for every road plus a texture of per segment traffic
+	GLuint heatmapProgram = 0;
+	GLuint heatmapVAO = 0, heatmapVBO = 0;
+	GLuint trafficTexture = 0;
+	GLsizei heatmapVertexCount = 0;
+	int trafficTextureHeight = 0;
+	uint32_t heatmapRevision = 0;
+	bool heatmapMeshValid = false;
+	bool showHeatmap = false;
+	bool heatmapKeyDown = false;
+	bool fastForwardKeyDown = false;
+
+	// click to inspect, the selection's live state goes in the window title a few times a second
+	EntityPicker picker;
+	Selection selection;
+	bool selectButtonDown = false;
+	double overlayTime = 0.0;
+	static constexpr double overlayInterval = 0.2;
+	static constexpr float pickPixels = 4.0f;
+
+	void selectAtCursor();
+	void renderSelection();
+	void updateOverlay();
+	static constexpr int trafficTextureWidth = 1024;
+
 	SimulationModel* simulationModel;
 
-	static ViewController* currentInstance;
+	// client mode: the scene comes from a remote simulation's telemetry instead of a model
+	TelemetryClient* telemetryClient = nullptr;
+	TelemetryRenderer telemetryScene;
+	void renderTelemetry(const RenderView& frame);
 
-	void setupRectangleVerticies();
-	void drawRectangle(const glm::vec3& position, const glm::vec3& scale, const glm::vec3& color);
+	static ViewController* currentInstance;
 
-	void renderRoadSegment(const RoadSegment& road);
-	void renderJunction(const Junction& junction);
-	void renderTrafficLights(const TrafficLightJunction& junction);
-	void renderVehicle(const Vehicle& vehicle, const RoadSegment& road);
+	void setupHeatmap();
+	void buildHeatmapMesh();
+	void uploadSegmentTraffic();
+	void renderHeatmap(const glm::mat4& view, const glm::mat4& projection);
 
 	static void scrollCallBack(GLFWwindow* window, double xOffset, double yOffset);
 	void processScroll(double yOffset);
 	float getCurrentZoomLevel() const;
+	RenderView getRenderView() const;
 
 
 public:
@@ -46,11 +79,18 @@ public:
 	~ViewController();
 
 	void setSimulationModel(SimulationModel* model) { simulationModel = model; }
+	void setTelemetryClient(TelemetryClient* client) { telemetryClient = client; }
 	void render();
 	bool processEvents();
 	bool isOpen() const { return window && !glfwWindowShouldClose(window); }
 
 	void moveCamera(float deltaX, float deltaY);
 	void zoomCamera(float zoomFactor) { processScroll(zoomFactor); }
+
+	const Selection& getSelection() const { return selection; }
+	void clearSelection() { selection = Selection(); }
+
+	void setHeatmapVisible(bool visible) { showHeatmap = visible; }
+	bool isHeatmapVisible() const { return showHeatmap; }
 };
 
@@ -1,10 +1,112 @@
 #include <iostream>
+#include <string>
+#include <cstdlib>
 
 #include "framework/simulationController.h"
 
 
-int main() {
+int main(int argc, char** argv) {
     SimulationController controller;
+
+    // headless export: --export <frames> <output path> [png|raw]
+    if (argc > 3 && std::string(argv[1]) == "--export") {
+        FrameExportConfig config;
+        config.path = argv[3];
+        config.format = argc > 4 && std::string(argv[4]) == "raw" ? FrameFormat::RAW : FrameFormat::PNG;
+
+        controller.exportGridNetworkSimulation(2, 2, 3, std::atoi(argv[2]), config);
+        return 0;
+    }
+
+    // fast forward without a window: --fast-forward <simulated seconds>
+    if (argc > 2 && std::string(argv[1]) == "--fast-forward") {
+        controller.fastForwardGridNetworkSimulation(2, 2, 3, static_cast<float>(std::atof(argv[2])));
+        return 0;
+    }
+
+    // ramp merge check: --check-merges <ticks>, exits non zero if a merging vehicle jumped along the main road
+    if (argc > 2 && std::string(argv[1]) == "--check-merges") {
+        return controller.checkRampMerges(std::atoi(argv[2])) ? 0 : 1;
+    }
+
+    // demand file check: --check-demand-file [path], exits non zero if trips without a lane did not spawn
+    if (argc > 1 && std::string(argv[1]) == "--check-demand-file") {
+        return controller.checkDemandFile(argc > 2 ? argv[2] : "morecpp_demand_check.csv") ? 0 : 1;
+    }
+
+    // lane closure check: --check-incidents <ticks>, exits non zero if a road with every regular lane closed took traffic
+    if (argc > 2 && std::string(argv[1]) == "--check-incidents") {
+        return controller.checkIncidentClosure(std::atoi(argv[2])) ? 0 : 1;
+    }
+
+    // multi day fast forward check: --check-fast-forward <simulated seconds>, exits non zero if the run did not end on time
+    if (argc > 2 && std::string(argv[1]) == "--check-fast-forward") {
+        return controller.checkFastForward(static_cast<float>(std::atof(argv[2]))) ? 0 : 1;
+    }
+
+    // run to run determinism check: --verify <ticks> [hash interval], exits non zero on divergence
+    if (argc > 2 && std::string(argv[1]) == "--verify") {
+        int interval = argc > 3 ? std::atoi(argv[3]) : 1;
+        return controller.verifyDeterminism(std::atoi(argv[2]), interval) ? 0 : 1;
+    }
+
+    // steady state allocation check: --check-allocations <ticks> [warm up ticks], exits non zero if a tick allocated
+    if (argc > 2 && std::string(argv[1]) == "--check-allocations") {
+        int warmup = argc > 3 ? std::atoi(argv[3]) : 2000;
+        return controller.checkAllocations(std::atoi(argv[2]), warmup) ? 0 : 1;
+    }
+
+    // headless server for remote viewers: --serve <tcp:host:port | unix:path>
+    if (argc > 2 && std::string(argv[1]) == "--serve") {
+        SocketEndpoint endpoint;
+        if (!SocketEndpoint::parse(argv[2], endpoint)) return 1;
+        controller.serveGridNetworkSimulation(2, 2, 3, endpoint);
+        return 0;
+    }
+
+    // headless, every tick written to shared memory for readers on this host: --publish-shm <name>
+    if (argc > 2 && std::string(argv[1]) == "--publish-shm") {
+        controller.publishGridNetworkSimulation(2, 2, 3, argv[2]);
+        return 0;
+    }
+
+    // shared memory round trip: --check-shared-state <ticks> [name] [compact], exits non zero if a frame did not match.
+    // compact checks the 16 byte vehicle format against its error bounds
+    if (argc > 2 && std::string(argv[1]) == "--check-shared-state") {
+        bool compact = argc > 4 && std::string(argv[4]) == "compact";
+        return controller.checkSharedState(argc > 3 ? argv[3] : "morecpp_state_check", std::atoi(argv[2]), compact) ? 0 : 1;
+    }
+
+    // window drawing a remote simulation: --connect <tcp:host:port | unix:path>
+    if (argc > 2 && std::string(argv[1]) == "--connect") {
+        SocketEndpoint endpoint;
+        if (!SocketEndpoint::parse(argv[2], endpoint)) return 1;
+        controller.runTelemetryViewer(endpoint);
+        return 0;
+    }
+
+    // stream round trip over loopback: --check-telemetry <ticks> [endpoint], exits non zero if the client diverged
+    if (argc > 2 && std::string(argv[1]) == "--check-telemetry") {
+        SocketEndpoint endpoint;
+        if (!SocketEndpoint::parse(argc > 3 ? argv[3] : "tcp:127.0.0.1:47311", endpoint)) return 1;
+        return controller.checkTelemetryLoopback(endpoint, std::atoi(argv[2])) ? 0 : 1;
+    }
+
+    // text scenario to the compiled format: --compile-scenario <scenario> <output>
+    if (argc > 3 && std::string(argv[1]) == "--compile-scenario") {
+        return controller.compileScenario(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    // headless scenario run with its loop detectors written out: --detect <scenario> <simulated seconds> <output.csv | output.bin>
+    if (argc > 4 && std::string(argv[1]) == "--detect") {
+        return controller.recordDetectors(argv[2], static_cast<float>(std::atof(argv[3])), argv[4]) ? 0 : 1;
+    }
+
+    // windowed run of a scenario file, text or compiled: --scenario <path>
+    if (argc > 2 && std::string(argv[1]) == "--scenario") {
+        return controller.runScenarioSimulation(argv[2]) ? 0 : 1;
+    }
+
     controller.init();
     controller.runGridNetwrokSimulation(2, 2, 3);
 
@@ -0,0 +1,339 @@
+#include "routeManager.h"
+
+#include <queue>
+#include <algorithm>
+#include <limits>
+#include <functional>
+
+#include "../road/junction.h"
+
+
+void RouteManager::addRoadSegment(std::shared_ptr<RoadSegment> roadSegment) {
+    if (roadSegment->getIndex() >= 0) {
+        return;
+    }
+
+    roadSegment->setIndex(static_cast<int>(segments.size()));
+    segments.push_back(roadSegment);
+
+    // before the first route the first compile links everything at once
+    if (routeTrees.empty()) {
+        return;
+    }
+
+    std::vector<int> nodes = segmentNodes(*roadSegment);
+    pendingNodes.insert(pendingNodes.end(), nodes.begin(), nodes.end());
+}
+
+
+void RouteManager::removeRoadSegment(std::shared_ptr<RoadSegment> roadSegment) {
+    int index = roadSegment->getIndex();
+    if (index < 0 || index >= static_cast<int>(segments.size()) || segments[index] != roadSegment) {
+        return;
+    }
+
+    // with the segment gone its nodes cost infinity, repair while the compiled links still exist
+    segments[index] = nullptr;
+    if (!routeTrees.empty()) {
+        repairTrees(segmentNodes(*roadSegment));
+    }
+
+    // indices are never reused, pooled routes may still name this segment
+    roadSegment->setIndex(-1);
+}
+
+
+void RouteManager::updateRoadSegment(std::shared_ptr<RoadSegment> roadSegment) {
+    if (!routeTrees.empty() && roadSegment->getIndex() >= 0) {
+        repairTrees(segmentNodes(*roadSegment));
+    }
+}
+
+
+void RouteManager::setNetwork(const CompiledNetwork& compiled) {
+    network = &compiled;
+    packedDirty = true;
+
+    // segments added since the last compile are linked in now, a repair gives their nodes a cost
+    // and lets the nodes leading into them take them
+    if (!pendingNodes.empty()) {
+        std::vector<int> added;
+        added.swap(pendingNodes);
+        repairTrees(added);
+    }
+}
+
+
+std::vector<int> RouteManager::segmentNodes(const RoadSegment& segment) const {
+    std::vector<int> nodes;
+    for (TravelDirection direction : { TravelDirection::FORWARD, TravelDirection::REVERSE }) {
+        if (segment.hasDirection(direction)) {
+            nodes.push_back(toNode(segment.getIndex(), direction));
+        }
+    }
+    return nodes;
+}
+
+
+float RouteManager::getTravelTime(int node) const {
+    const auto& segment = segments[nodeSegment(node)];
+    if (!segment) {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    TravelDirection direction = nodeDirection(node);
+    int openLanes = segment->getOpenLaneCount(direction);
+    if (openLanes == 0) {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    // closed lanes cut capacity, so the time is scaled by the share of regular lanes left open
+    float travelTime = segment->getActualLength() / segment->getSpeedLimit();
+    return travelTime * segment->getTravelLaneCount(direction) / openLanes;
+}
+
+
+bool RouteManager::propagate(RouteTree& tree, RouteQueue& open) {
+    bool rerouted = false;
+
+    // reverse dijkstra on travel time
+    while (!open.empty()) {
+        QueueEntry entry = open.top();
+        open.pop();
+
+        int current = entry.second;
+        if (entry.first > tree.cost[current]) continue;
+
+        for (int previous : packedPredecessors.row(current)) {
+            float cost = entry.first + travelTimes[previous];
+
+            if (cost < tree.cost[previous]) {
+                // nodes the current repair reset are compared by the repair itself
+                bool outsideRepair = previous >= static_cast<int>(affectedStamp.size()) || affectedStamp[previous] != stamp;
+                rerouted = rerouted || (outsideRepair && tree.nextHop[previous] != current);
+                tree.cost[previous] = cost;
+                tree.nextHop[previous] = current;
+                tree.routes[previous] = unplannedRoute;
+                open.push({ cost, previous });
+            }
+        }
+    }
+    return rerouted;
+}
+
+
+void RouteManager::repairTrees(const std::vector<int>& changed) {
+    revision++;
+
+    if (packedDirty) {
+        packGraph();
+    } else {
+        for (int node : changed) {
+            travelTimes[node] = getTravelTime(node);
+        }
+    }
+
+    size_t nodeCount = segments.size() * 2;
+    if (affectedStamp.size() < nodeCount) {
+        affectedStamp.resize(nodeCount, 0);
+    }
+
+    std::vector<int> previousHops;
+    for (auto& [destination, tree] : routeTrees) {
+        if (tree.cost.size() < nodeCount) {
+            tree.cost.resize(nodeCount, std::numeric_limits<float>::infinity());
+            tree.nextHop.resize(nodeCount, -1);
+            tree.routes.resize(nodeCount, unplannedRoute);
+        }
+
+        // everything whose path runs through a changed node loses its cost
+        stamp++;
+        std::vector<int> affected;
+        for (int node : changed) {
+            if (affectedStamp[node] != stamp) {
+                affectedStamp[node] = stamp;
+                affected.push_back(node);
+            }
+        }
+
+        for (size_t i = 0; i < affected.size(); i++) {
+            for (int previous : packedPredecessors.row(affected[i])) {
+                if (tree.nextHop[previous] == affected[i] && affectedStamp[previous] != stamp) {
+                    affectedStamp[previous] = stamp;
+                    affected.push_back(previous);
+                }
+            }
+        }
+
+        previousHops.clear();
+        for (int node : affected) {
+            previousHops.push_back(tree.nextHop[node]);
+            tree.cost[node] = std::numeric_limits<float>::infinity();
+            tree.nextHop[node] = -1;
+            tree.routes[node] = unplannedRoute;
+        }
+
+        // restart the affected nodes from their best settled successor
+        RouteQueue open;
+        for (int node : affected) {
+            int exit = network->getExit(node);
+            if (!segments[nodeSegment(node)] || exit < 0) continue;
+
+            float travelTime = travelTimes[node];
+            if (destination->isInRange(network->getJunctionPosition(exit))) {
+                tree.cost[node] = travelTime;
+            }
+
+            for (int next : network->getDepartures(exit)) {
+                if (nodeSegment(next) == nodeSegment(node) || affectedStamp[next] == stamp) continue;
+
+                float cost = travelTime + tree.cost[next];
+                if (cost < tree.cost[node]) {
+                    tree.cost[node] = cost;
+                    tree.nextHop[node] = next;
+                }
+            }
+
+            if (tree.cost[node] != std::numeric_limits<float>::infinity()) {
+                open.push({ tree.cost[node], node });
+            }
+        }
+
+        // only trees that now send some node another way count as changed, vehicles bound
+        // for the others keep their routes
+        bool rerouted = propagate(tree, open);
+        for (size_t i = 0; i < affected.size() && !rerouted; i++) {
+            rerouted = tree.nextHop[affected[i]] != previousHops[i];
+        }
+        if (rerouted) {
+            tree.changedRevision = revision;
+        }
+    }
+}
+
+
+void RouteManager::packGraph() {
+    size_t nodeCount = segments.size() * 2;
+
+    // nodes compiled after the network was are left without links until the next compile
+    packedPredecessors.clear();
+    for (size_t node = 0; node < nodeCount; node++) {
+        packedPredecessors.startRow();
+
+        // no u-turns back along the same segment
+        for (int previous : network->getArrivals(network->getEntry(static_cast<int>(node)))) {
+            if (nodeSegment(previous) != nodeSegment(static_cast<int>(node))) {
+                packedPredecessors.add(previous);
+            }
+        }
+    }
+
+    travelTimes.resize(nodeCount);
+    for (size_t node = 0; node < travelTimes.size(); node++) {
+        travelTimes[node] = getTravelTime(static_cast<int>(node));
+    }
+    packedDirty = false;
+}
+
+
+bool RouteManager::renumberSegments(const std::vector<std::shared_ptr<RoadSegment>>& order) {
+    if (!routeTrees.empty() || routePool.getRouteCount() > 0) {
+        return false;
+    }
+
+    size_t live = std::count_if(segments.begin(), segments.end(), [](const auto& segment) { return segment != nullptr; });
+    if (order.size() != live) {
+        return false;
+    }
+
+    segments = order;
+    for (size_t i = 0; i < segments.size(); i++) {
+        segments[i]->setIndex(static_cast<int>(i));
+    }
+    return true;
+}
+
+
+RouteManager::RouteTree& RouteManager::getRouteTree(const Destination& destination) {
+    auto found = routeTrees.find(&destination);
+    if (found != routeTrees.end()) {
+        return found->second;
+    }
+
+    if (packedDirty) {
+        packGraph();
+    }
+
+    size_t nodeCount = segments.size() * 2;
+    RouteTree& tree = routeTrees[&destination];
+    tree.cost.assign(nodeCount, std::numeric_limits<float>::infinity());
+    tree.nextHop.assign(nodeCount, -1);
+    tree.routes.assign(nodeCount, unplannedRoute);
+
+    RouteQueue open;
+
+    // seed with nodes that finish at the destination
+    for (int node = 0; node < static_cast<int>(nodeCount); node++) {
+        int exit = network->getExit(node);
+        if (segments[nodeSegment(node)] && exit >= 0 && destination.isInRange(network->getJunctionPosition(exit))) {
+            float travelTime = travelTimes[node];
+            tree.cost[node] = travelTime;
+            open.push({ travelTime, node });
+        }
+    }
+
+    propagate(tree, open);
+    return tree;
+}
+
+
+RouteId RouteManager::planRoute(int originNode, const std::shared_ptr<Destination>& destination) {
+    // nothing is linked before the network's first compile
+    if (!network || !destination || originNode < 0 || originNode >= static_cast<int>(segments.size() * 2)) {
+        return RoutePool::invalidRoute;
+    }
+
+    // routes are extracted once per origin and destination, then reused
+    RouteTree& tree = getRouteTree(*destination);
+
+    // segments added after the tree was built could not reach the destination
+    if (originNode >= static_cast<int>(tree.cost.size())) {
+        tree.cost.resize(segments.size() * 2, std::numeric_limits<float>::infinity());
+        tree.nextHop.resize(segments.size() * 2, -1);
+        tree.routes.resize(segments.size() * 2, unplannedRoute);
+    }
+
+    RouteId& route = tree.routes[originNode];
+    if (route != unplannedRoute) {
+        return route;
+    }
+
+    route = RoutePool::invalidRoute;
+    if (tree.cost[originNode] != std::numeric_limits<float>::infinity()) {
+        std::vector<int> path;
+        for (int node = originNode; node >= 0; node = tree.nextHop[node]) {
+            path.push_back(node);
+        }
+        route = routePool.intern(path);
+    }
+
+    return route;
+}
+
+
+bool RouteManager::isRouteCurrent(int node, int nextNode, const Destination& destination, uint32_t plannedRevision) const {
+    if (plannedRevision == revision) {
+        return true;
+    }
+
+    auto found = routeTrees.find(&destination);
+    if (found == routeTrees.end()) {
+        return false;
+    }
+
+    const RouteTree& tree = found->second;
+    if (tree.changedRevision <= plannedRevision) {
+        return true;
+    }
+    return node >= 0 && node < static_cast<int>(tree.nextHop.size()) && tree.nextHop[node] == nextNode;
+}
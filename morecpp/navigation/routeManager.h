@@ -5,14 +5,68 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <queue>
+#include <functional>
+#include "../road/junction.h"
 #include "../road/roadSegment.h"
+#include "../road/compiledNetwork.h"
 #include "../navigation/destination.h"
+#include "routePool.h"
+#include "../core/csr.h"
 
 
 class RouteManager {
 private:
+    // shortest path tree towards one destination (indexed by node)
+    struct RouteTree {
+        std::vector<float> cost;
+        std::vector<int> nextHop;
+        std::vector<RouteId> routes;
+
+        // revision of the last repair that sent some node out along another next hop
+        uint32_t changedRevision = 0;
+    };
+
+    // marks an origin whose route has not been extracted from the tree yet
+    static constexpr RouteId unplannedRoute = RoutePool::invalidRoute - 1;
+
     std::unordered_map<std::string, std::shared_ptr<Junction>> junctions;
-    std::unordered_map<std::string, std::shared_ptr<RoadSegment>> roadSegments;
+    std::vector<std::shared_ptr<RoadSegment>> segments;
+
+    // the network's compiled arrays, where the searches find each node's junctions and the nodes
+    // around a junction. set by every compile, segments added since wait in pendingNodes
+    const CompiledNetwork* network = nullptr;
+    std::vector<int> pendingNodes;
+
+    // what the searches read: the nodes leading into the junction each node starts from, packed
+    // into rows, and each node's travel time. repacked after a compile and refreshed for nodes a
+    // repair is told about
+    CsrAdjacency packedPredecessors;
+    std::vector<float> travelTimes;
+    bool packedDirty = true;
+
+    std::unordered_map<const Destination*, RouteTree> routeTrees;
+
+    // marks nodes visited by the current repair without clearing between repairs
+    std::vector<uint32_t> affectedStamp;
+    uint32_t stamp = 0;
+
+    // bumped whenever routes may have changed
+    uint32_t revision = 0;
+    RoutePool routePool;
+
+    void packGraph();
+    std::vector<int> segmentNodes(const RoadSegment& segment) const;
+    float getTravelTime(int node) const;
+    RouteTree& getRouteTree(const Destination& destination);
+
+    typedef std::pair<float, int> QueueEntry;
+    typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> RouteQueue;
+    // true if a node outside the current repair was given another next hop
+    bool propagate(RouteTree& tree, RouteQueue& open);
+
+    // dynamic shortest paths: only the part of each tree routed through a changed node is recomputed
+    void repairTrees(const std::vector<int>& changed);
 
 
 public:
@@ -20,7 +74,44 @@ public:
         junctions[junction->getId()] = junction;
     }
 
-    void addRoadSegment(std::shared_ptr<RoadSegment> roadSegment) {
-        roadSegments[roadSegment->getId()] = roadSegment;
+    void removeJunction(const std::shared_ptr<Junction>& junction) {
+        junctions.erase(junction->getId());
     }
+
+    // once routes exist, trees are repaired around the segment rather than rebuilt. a removal is
+    // repaired straight away while the compiled links still include the segment, an addition
+    // once the next compile links it in
+    void addRoadSegment(std::shared_ptr<RoadSegment> roadSegment);
+    void removeRoadSegment(std::shared_ptr<RoadSegment> roadSegment);
+    void updateRoadSegment(std::shared_ptr<RoadSegment> roadSegment);
+
+    // the routing graph has one node per direction of travel on a segment,
+    // pooled routes are sequences of these nodes
+    static int toNode(int segmentIndex, TravelDirection direction) { return CompiledNetwork::toNode(segmentIndex, direction); }
+    static int nodeSegment(int node) { return node / 2; }
+    static TravelDirection nodeDirection(int node) { return node % 2 ? TravelDirection::REVERSE : TravelDirection::FORWARD; }
+
+    // segments take new indices in the given order (a memory locality order), only possible
+    // before the first route is planned. false once anything may hold an index
+    bool renumberSegments(const std::vector<std::shared_ptr<RoadSegment>>& order);
+
+    // called after every compile of the network, which must outlive this manager's use of it
+    void setNetwork(const CompiledNetwork& compiled);
+
+    // plan (or reuse) a route from a node to a destination
+    RouteId planRoute(int originNode, const std::shared_ptr<Destination>& destination);
+
+    std::shared_ptr<RoadSegment> getSegment(int index) const {
+        return index >= 0 && index < static_cast<int>(segments.size()) ? segments[index] : nullptr;
+    }
+
+    const RoutePool& getRoutePool() const { return routePool; }
+
+    // bumped by every repair, whether or not any tree changed
+    uint32_t getRevision() const { return revision; }
+
+    // whether a route planned at the given revision still leaves node for nextNode. true straight
+    // away when the destination's tree has not changed since, otherwise only if the repaired tree
+    // still takes that next hop. vehicles ask at each junction and re-plan only when this fails
+    bool isRouteCurrent(int node, int nextNode, const Destination& destination, uint32_t plannedRevision) const;
 };
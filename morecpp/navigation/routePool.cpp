@@ -0,0 +1,52 @@
+#include "routePool.h"
+
+#include <algorithm>
+
+
+size_t RoutePool::hashSegments(const int* segments, size_t count) {
+	// FNV-1a over the segment indices
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < count; i++) {
+		hash ^= static_cast<uint32_t>(segments[i]);
+		hash *= 1099511628211ull;
+	}
+	return static_cast<size_t>(hash);
+}
+
+
+RouteId RoutePool::intern(const std::vector<int>& segments) {
+	if (segments.empty()) {
+		return invalidRoute;
+	}
+
+	size_t hash = hashSegments(segments.data(), segments.size());
+
+	// return the existing route if this sequence was seen before
+	auto range = lookup.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		const RouteEntry& entry = routes[it->second];
+		if (entry.length == segments.size() && std::equal(segments.begin(), segments.end(), segmentData.begin() + entry.offset)) {
+			return it->second;
+		}
+	}
+
+	RouteEntry entry;
+	entry.hash = hash;
+	entry.offset = static_cast<uint32_t>(segmentData.size());
+	entry.length = static_cast<uint32_t>(segments.size());
+
+	segmentData.insert(segmentData.end(), segments.begin(), segments.end());
+
+	RouteId id = static_cast<RouteId>(routes.size());
+	routes.push_back(entry);
+	lookup.emplace(hash, id);
+
+	return id;
+}
+
+
+void RoutePool::clear() {
+	segmentData.clear();
+	routes.clear();
+	lookup.clear();
+}
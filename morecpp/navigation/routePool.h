@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+
+typedef uint32_t RouteId;
+
+
+// hash-consed store of immutable routes
+// each distinct sequence of route nodes is stored once and shared by every vehicle
+// following it, routes live as long as the pool (the pool is rebuilt with the network)
+class RoutePool {
+private:
+	struct RouteEntry {
+		size_t hash;
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	std::vector<int> segmentData;
+	std::vector<RouteEntry> routes;
+	std::unordered_multimap<size_t, RouteId> lookup;
+
+	static size_t hashSegments(const int* segments, size_t count);
+
+
+public:
+	static constexpr RouteId invalidRoute = UINT32_MAX;
+
+	RouteId intern(const std::vector<int>& segments);
+	void clear();
+
+	size_t getLength(RouteId route) const { return routes[route].length; }
+	int getSegment(RouteId route, size_t index) const { return segmentData[routes[route].offset + index]; }
+	const int* getSegments(RouteId route) const { return segmentData.data() + routes[route].offset; }
+
+	size_t getRouteCount() const { return routes.size(); }
+	size_t getMemoryUsage() const { return segmentData.size() * sizeof(int) + routes.size() * sizeof(RouteEntry); }
+};
@@ -0,0 +1,171 @@
+#include "sharedMemory.h"
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+SharedMemoryRegion::~SharedMemoryRegion() {
+	close();
+}
+
+
+#ifdef _WIN32
+
+bool SharedMemoryRegion::create(const std::string& newName, size_t newSize) {
+	close();
+
+	uint64_t size64 = newSize;
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), newName.c_str());
+	if (!mapping) {
+		std::cerr << "Could not create shared memory " << newName << ": error " << GetLastError() << std::endl;
+		return false;
+	}
+
+	data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, newSize);
+	if (!data) {
+		std::cerr << "Could not map shared memory " << newName << ": error " << GetLastError() << std::endl;
+		close();
+		return false;
+	}
+
+	std::memset(data, 0, newSize);
+	name = newName;
+	size = newSize;
+	owner = true;
+	return true;
+}
+
+
+bool SharedMemoryRegion::open(const std::string& newName) {
+	close();
+
+	mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, newName.c_str());
+	if (!mapping) {
+		std::cerr << "Could not open shared memory " << newName << ": error " << GetLastError() << std::endl;
+		return false;
+	}
+
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	MEMORY_BASIC_INFORMATION info;
+	if (!data || !VirtualQuery(data, &info, sizeof(info))) {
+		std::cerr << "Could not map shared memory " << newName << ": error " << GetLastError() << std::endl;
+		close();
+		return false;
+	}
+
+	name = newName;
+	size = info.RegionSize;
+	owner = false;
+	return true;
+}
+
+
+void SharedMemoryRegion::close() {
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	data = nullptr;
+	mapping = nullptr;
+	size = 0;
+	owner = false;
+}
+
+#else
+
+// posix names are a single path component with a leading slash
+static std::string posixName(const std::string& name) {
+	return name.empty() || name[0] == '/' ? name : "/" + name;
+}
+
+
+bool SharedMemoryRegion::create(const std::string& newName, size_t newSize) {
+	close();
+
+	// a region left by an earlier run may have another size, and readers must not see a half built one
+	shm_unlink(posixName(newName).c_str());
+
+	int descriptor = shm_open(posixName(newName).c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (descriptor < 0) {
+		std::cerr << "Could not create shared memory " << newName << ": " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	if (ftruncate(descriptor, static_cast<off_t>(newSize)) != 0) {
+		std::cerr << "Could not size shared memory " << newName << ": " << std::strerror(errno) << std::endl;
+		::close(descriptor);
+		shm_unlink(posixName(newName).c_str());
+		return false;
+	}
+
+	// a fresh region is already zero filled
+	void* mapped = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	::close(descriptor);
+	if (mapped == MAP_FAILED) {
+		std::cerr << "Could not map shared memory " << newName << ": " << std::strerror(errno) << std::endl;
+		shm_unlink(posixName(newName).c_str());
+		return false;
+	}
+
+	name = newName;
+	data = mapped;
+	size = newSize;
+	owner = true;
+	return true;
+}
+
+
+bool SharedMemoryRegion::open(const std::string& newName) {
+	close();
+
+	int descriptor = shm_open(posixName(newName).c_str(), O_RDONLY, 0);
+	if (descriptor < 0) {
+		std::cerr << "Could not open shared memory " << newName << ": " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	struct stat status;
+	void* mapped = MAP_FAILED;
+	if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+		mapped = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+	}
+	::close(descriptor);
+
+	if (mapped == MAP_FAILED) {
+		std::cerr << "Could not map shared memory " << newName << ": " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	name = newName;
+	data = mapped;
+	size = static_cast<size_t>(status.st_size);
+	owner = false;
+	return true;
+}
+
+
+void SharedMemoryRegion::close() {
+	if (data) {
+		munmap(data, size);
+	}
+
+	// readers that still have it mapped keep their view until they let go
+	if (owner) {
+		shm_unlink(posixName(name).c_str());
+	}
+
+	data = nullptr;
+	size = 0;
+	owner = false;
+}
+
+#endif
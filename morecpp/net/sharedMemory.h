@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+
+// a named block of memory shared between processes on the same host, mapped read write by the
+// creator and read only by everyone who opens it
+class SharedMemoryRegion {
+private:
+	std::string name;
+	void* data = nullptr;
+	size_t size = 0;
+	bool owner = false;
+
+#ifdef _WIN32
+	void* mapping = nullptr;
+#endif
+
+
+public:
+	SharedMemoryRegion() = default;
+	~SharedMemoryRegion();
+
+	SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+	SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+	// replaces any region of the same name, zero filled
+	bool create(const std::string& name, size_t size);
+
+	// maps an existing region, its size comes from the region itself
+	bool open(const std::string& name);
+	void close();
+
+	bool isOpen() const { return data != nullptr; }
+	void* getData() const { return data; }
+	size_t getSize() const { return size; }
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+
+// layout of the shared state region, used by the publisher in the simulation and by readers in
+// other processes. the region is a header followed by a ring of frames of a fixed stride. each
+// frame is a small header and then one column per field, every column 64 byte aligned:
+//
+//   vehicle id (u32), segment index (i32), lane (i32), direction (u8), distance (f32), speed (f32)
+//   signal road index (i32), signal state (u8, see LightState)
+//
+// with the compact vehicle format the six vehicle columns are replaced by one column of
+// CompactVehicleState, 16 bytes a vehicle instead of 21, so about a quarter less to copy and read
+// per frame. it only changes what is published, not what the simulation holds
+//
+// frames are guarded by a sequence counter. the writer makes it odd before touching a frame and
+// even again once the frame is complete, a reader that sees the same even value before and after
+// reading has a consistent frame and never holds the writer up
+struct SharedStateLayout {
+
+	static constexpr uint32_t magic = 0x54534d53;	// "SMST"
+	static constexpr uint32_t version = 2;
+	static constexpr size_t alignment = 64;
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared state needs lock free 64 bit atomics");
+
+	enum VehicleFormat : uint32_t {
+		COLUMNS = 0,
+		COMPACT = 1
+	};
+
+	struct RegionHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t frameCount;
+		uint32_t vehicleCapacity;
+		uint32_t signalCapacity;
+		uint32_t vehicleFormat;
+		uint64_t frameStride;
+
+		// number of the newest complete frame, 0 before the first one. frame n lives in slot n % frameCount
+		std::atomic<uint64_t> latestFrame;
+	};
+
+	struct FrameHeader {
+		// 2n + 1 while frame n is written, 2n + 2 once it is complete
+		std::atomic<uint64_t> sequence;
+
+		uint64_t tick;
+		float simulationTime;
+		uint32_t networkRevision;
+		uint32_t vehicleCount;
+		uint32_t signalCount;
+
+		// more vehicles or signals were out than the columns hold, the rest are missing
+		uint32_t truncated;
+
+		// compact vehicles with a field clamped to its range, always 0 for the columns format
+		uint32_t clampedVehicles;
+	};
+
+
+	// sizeof(CompactVehicleState), checked where the publisher writes them
+	static constexpr size_t compactVehicleSize = 16;
+
+	static size_t alignUp(size_t value) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// byte offsets of a frame's columns from the start of the frame
+	// the columns a format does not use are 0
+	struct FrameColumns {
+		size_t ids = 0, segments = 0, lanes = 0, directions = 0, distances = 0, speeds = 0;
+		size_t states = 0;
+		size_t signalRoads, signalStates;
+		size_t stride;
+
+		FrameColumns(uint32_t vehicleCapacity, uint32_t signalCapacity, uint32_t vehicleFormat = COLUMNS) {
+			size_t offset = alignUp(sizeof(FrameHeader));
+			if (vehicleFormat == COMPACT) {
+				states = offset; offset = alignUp(offset + vehicleCapacity * compactVehicleSize);
+				signalRoads = offset; offset = alignUp(offset + signalCapacity * sizeof(int32_t));
+				signalStates = offset; offset = alignUp(offset + signalCapacity * sizeof(uint8_t));
+				stride = offset;
+				return;
+			}
+
+			ids = offset; offset = alignUp(offset + vehicleCapacity * sizeof(uint32_t));
+			segments = offset; offset = alignUp(offset + vehicleCapacity * sizeof(int32_t));
+			lanes = offset; offset = alignUp(offset + vehicleCapacity * sizeof(int32_t));
+			directions = offset; offset = alignUp(offset + vehicleCapacity * sizeof(uint8_t));
+			distances = offset; offset = alignUp(offset + vehicleCapacity * sizeof(float));
+			speeds = offset; offset = alignUp(offset + vehicleCapacity * sizeof(float));
+			signalRoads = offset; offset = alignUp(offset + signalCapacity * sizeof(int32_t));
+			signalStates = offset; offset = alignUp(offset + signalCapacity * sizeof(uint8_t));
+			stride = offset;
+		}
+	};
+
+	static size_t getRegionSize(uint32_t frameCount, uint32_t vehicleCapacity, uint32_t signalCapacity, uint32_t vehicleFormat = COLUMNS) {
+		return alignUp(sizeof(RegionHeader)) + frameCount * FrameColumns(vehicleCapacity, signalCapacity, vehicleFormat).stride;
+	}
+};
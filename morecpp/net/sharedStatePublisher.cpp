@@ -0,0 +1,173 @@
+#include "sharedStatePublisher.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "../road/trafficLightJunction.h"
+#include "../traffic/vehicle.h"
+#include "../traffic/compactVehicleState.h"
+
+
+static_assert(sizeof(CompactVehicleState) == SharedStateLayout::compactVehicleSize, "shared state layout out of step with the compact vehicle state");
+
+
+bool SharedStatePublisher::open(const std::string& name) {
+	close();
+
+	config.frameCount = std::max<uint32_t>(2, config.frameCount);
+	uint32_t format = config.compactVehicles ? SharedStateLayout::COMPACT : SharedStateLayout::COLUMNS;
+	if (!region.create(name, SharedStateLayout::getRegionSize(config.frameCount, config.vehicleCapacity, config.signalCapacity, format))) {
+		return false;
+	}
+
+	columns = SharedStateLayout::FrameColumns(config.vehicleCapacity, config.signalCapacity, format);
+	header = static_cast<SharedStateLayout::RegionHeader*>(region.getData());
+	header->frameCount = config.frameCount;
+	header->vehicleCapacity = config.vehicleCapacity;
+	header->signalCapacity = config.signalCapacity;
+	header->vehicleFormat = format;
+	header->frameStride = columns.stride;
+	header->version = SharedStateLayout::version;
+	header->latestFrame.store(0, std::memory_order_relaxed);
+
+	// readers check the magic last, once it is there the rest of the header is too
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic = SharedStateLayout::magic;
+
+	frameNumber = 0;
+	networkCaptured = false;
+	std::cout << "Publishing shared state as " << name << ", " << region.getSize() / (1024 * 1024) << " MB" << std::endl;
+	return true;
+}
+
+
+void SharedStatePublisher::close() {
+	region.close();
+	header = nullptr;
+	signalSources.clear();
+}
+
+
+void SharedStatePublisher::captureSignals(const RoadNetwork& network) {
+	signalSources.clear();
+
+	// junctions by id so the signal columns keep their order from run to run
+	std::vector<std::shared_ptr<Junction>> junctions;
+	network.forEachJunction([&](const std::shared_ptr<Junction>& junction) { junctions.push_back(junction); });
+	std::sort(junctions.begin(), junctions.end(), [](const std::shared_ptr<Junction>& a, const std::shared_ptr<Junction>& b) { return a->getId() < b->getId(); });
+
+	for (const auto& junction : junctions) {
+		auto lights = std::dynamic_pointer_cast<TrafficLightJunction>(junction);
+		if (!lights) continue;
+
+		for (const auto& road : junction->getConnectedRoads()) {
+			if (road && road->getIndex() >= 0) {
+				signalSources.push_back({ lights, road, road->getIndex() });
+			}
+		}
+	}
+
+	networkRevision = network.getRevision();
+	networkCaptured = true;
+}
+
+
+void SharedStatePublisher::publish(const SimulationModel& model) {
+	if (!header) return;
+
+	const RoadNetwork& network = model.getGridNetwork();
+	if (!networkCaptured || networkRevision != network.getRevision()) {
+		captureSignals(network);
+	}
+
+	uint64_t number = frameNumber + 1;
+	uint8_t* frame = static_cast<uint8_t*>(region.getData()) + SharedStateLayout::alignUp(sizeof(SharedStateLayout::RegionHeader)) + (number % config.frameCount) * columns.stride;
+	auto* frameHeader = reinterpret_cast<SharedStateLayout::FrameHeader*>(frame);
+
+	// odd while written, a reader part way through this slot sees the change and drops what it read
+	frameHeader->sequence.store(number * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	uint32_t count = 0;
+	uint32_t clamped = 0;
+	bool truncated = false;
+
+	if (config.compactVehicles) {
+		// a current lane index already holds these records, copy them and stamp the current segment
+		// index, which a recompile may have changed for a segment whose vehicles are all parked.
+		// segments that took spawns or woke vehicles since their rebuild are encoded here
+		auto* states = reinterpret_cast<CompactVehicleState*>(frame + columns.states);
+		network.forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& road) {
+			int32_t segment = road->getIndex();
+			if (!road->isLaneIndexCurrent()) {
+				for (const auto& vehicle : road->getVehicles()) {
+					if (count == config.vehicleCapacity) {
+						truncated = true;
+						return;
+					}
+
+					if (!states[count].encode(*vehicle, segment)) {
+						clamped++;
+					}
+					count++;
+				}
+				return;
+			}
+
+			Span<const CompactVehicleState> records = road->getCompactVehicles();
+			size_t copied = std::min<size_t>(records.size(), config.vehicleCapacity - count);
+			truncated |= copied < records.size();
+			std::copy(records.begin(), records.begin() + copied, states + count);
+			for (size_t v = 0; v < copied; v++) {
+				states[count + v].segment = segment;
+			}
+			count += static_cast<uint32_t>(copied);
+			clamped += road->getClampedVehicleCount();
+		});
+	} else {
+		uint32_t* ids = reinterpret_cast<uint32_t*>(frame + columns.ids);
+		int32_t* segments = reinterpret_cast<int32_t*>(frame + columns.segments);
+		int32_t* lanes = reinterpret_cast<int32_t*>(frame + columns.lanes);
+		uint8_t* directions = frame + columns.directions;
+		float* distances = reinterpret_cast<float*>(frame + columns.distances);
+		float* speeds = reinterpret_cast<float*>(frame + columns.speeds);
+
+		network.forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& road) {
+			int32_t segment = road->getIndex();
+			for (const auto& vehicle : road->getVehicles()) {
+				if (count == config.vehicleCapacity) {
+					truncated = true;
+					return;
+				}
+
+				ids[count] = vehicle->getId();
+				segments[count] = segment;
+				lanes[count] = vehicle->getCurrentLane();
+				directions[count] = static_cast<uint8_t>(vehicle->getTravelDirection());
+				distances[count] = vehicle->getDistanceAlongRoad();
+				speeds[count] = vehicle->getCurrentSpeed();
+				count++;
+			}
+		});
+	}
+
+	int32_t* signalRoads = reinterpret_cast<int32_t*>(frame + columns.signalRoads);
+	uint8_t* signalStates = frame + columns.signalStates;
+	uint32_t signalCount = static_cast<uint32_t>(std::min<size_t>(signalSources.size(), config.signalCapacity));
+	for (uint32_t i = 0; i < signalCount; i++) {
+		signalRoads[i] = signalSources[i].roadIndex;
+		signalStates[i] = static_cast<uint8_t>(signalSources[i].junction->getLightState(signalSources[i].road));
+	}
+
+	frameHeader->tick = model.getTick();
+	frameHeader->simulationTime = static_cast<float>(model.getSimulationTime());
+	frameHeader->networkRevision = network.getRevision();
+	frameHeader->vehicleCount = count;
+	frameHeader->signalCount = signalCount;
+	frameHeader->truncated = truncated || signalCount < signalSources.size();
+	frameHeader->clampedVehicles = clamped;
+
+	frameHeader->sequence.store(number * 2 + 2, std::memory_order_release);
+	header->latestFrame.store(number, std::memory_order_release);
+	frameNumber = number;
+}
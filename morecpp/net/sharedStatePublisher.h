@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "sharedMemory.h"
+#include "sharedStateLayout.h"
+#include "../framework/simulationModel.h"
+
+
+class TrafficLightJunction;
+
+
+struct SharedStateConfig {
+	// frames in the ring, a reader has frameCount - 1 ticks to finish with a frame before it is reused
+	uint32_t frameCount = 4;
+
+	uint32_t vehicleCapacity = 128 * 1024;
+	uint32_t signalCapacity = 16 * 1024;
+
+	// one CompactVehicleState per vehicle in place of the float columns
+	bool compactVehicles = false;
+};
+
+
+// publishes every tick into a shared memory ring for readers in other processes (SharedStateReader).
+// vehicles are written straight from the road segments into the frame's columns, there is no
+// intermediate snapshot and nothing waits on a reader
+class SharedStatePublisher {
+private:
+	SharedStateConfig config;
+	SharedMemoryRegion region;
+	SharedStateLayout::RegionHeader* header = nullptr;
+	SharedStateLayout::FrameColumns columns{ 0, 0 };
+	uint64_t frameNumber = 0;
+
+	// signal sources of the network as of networkRevision, read each tick for their light states
+	struct SignalSource {
+		std::shared_ptr<TrafficLightJunction> junction;
+		std::shared_ptr<RoadSegment> road;
+		int32_t roadIndex;
+	};
+	std::vector<SignalSource> signalSources;
+	uint32_t networkRevision = 0;
+	bool networkCaptured = false;
+
+	void captureSignals(const RoadNetwork& network);
+
+
+public:
+	explicit SharedStatePublisher(const SharedStateConfig& config = SharedStateConfig()) : config(config) {}
+
+	bool open(const std::string& name);
+	void close();
+	bool isOpen() const { return header != nullptr; }
+
+	// call after every model update
+	void publish(const SimulationModel& model);
+
+	uint64_t getFrameNumber() const { return frameNumber; }
+};
@@ -0,0 +1,82 @@
+#include "sharedStateReader.h"
+
+#include <algorithm>
+#include <iostream>
+
+
+bool SharedStateReader::open(const std::string& name) {
+	close();
+
+	if (!region.open(name)) {
+		return false;
+	}
+
+	const auto* candidate = static_cast<const SharedStateLayout::RegionHeader*>(region.getData());
+	if (region.getSize() < sizeof(SharedStateLayout::RegionHeader) || candidate->magic != SharedStateLayout::magic || candidate->version != SharedStateLayout::version) {
+		std::cerr << name << " is not a shared state region of version " << SharedStateLayout::version << std::endl;
+		region.close();
+		return false;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	uint32_t format = candidate->vehicleFormat;
+	columns = SharedStateLayout::FrameColumns(candidate->vehicleCapacity, candidate->signalCapacity, format);
+	if (format > SharedStateLayout::COMPACT || columns.stride != candidate->frameStride
+		|| region.getSize() < SharedStateLayout::getRegionSize(candidate->frameCount, candidate->vehicleCapacity, candidate->signalCapacity, format)) {
+		std::cerr << name << " has an inconsistent layout" << std::endl;
+		region.close();
+		return false;
+	}
+
+	header = candidate;
+	return true;
+}
+
+
+void SharedStateReader::close() {
+	region.close();
+	header = nullptr;
+}
+
+
+bool SharedStateReader::acquire(SharedStateFrame& frame, uint64_t newerThan) const {
+	if (!header) return false;
+
+	// only fails to settle if the publisher laps the ring while the header is read, so a few tries do
+	for (int attempt = 0; attempt < 8; attempt++) {
+		uint64_t number = header->latestFrame.load(std::memory_order_acquire);
+		if (number == 0 || number <= newerThan) return false;
+
+		const uint8_t* slot = static_cast<const uint8_t*>(region.getData()) + SharedStateLayout::alignUp(sizeof(SharedStateLayout::RegionHeader)) + (number % header->frameCount) * columns.stride;
+		const auto* frameHeader = reinterpret_cast<const SharedStateLayout::FrameHeader*>(slot);
+
+		uint64_t expected = number * 2 + 2;
+		if (frameHeader->sequence.load(std::memory_order_acquire) != expected) continue;
+
+		frame.number = number;
+		frame.tick = frameHeader->tick;
+		frame.simulationTime = frameHeader->simulationTime;
+		frame.networkRevision = frameHeader->networkRevision;
+		frame.vehicleCount = std::min(frameHeader->vehicleCount, header->vehicleCapacity);
+		frame.signalCount = std::min(frameHeader->signalCount, header->signalCapacity);
+		frame.truncated = frameHeader->truncated != 0;
+		frame.clampedVehicles = frameHeader->clampedVehicles;
+
+		if (header->vehicleFormat == SharedStateLayout::COMPACT) {
+			frame.compactStates = reinterpret_cast<const CompactVehicleState*>(slot + columns.states);
+		} else {
+			frame.ids = reinterpret_cast<const uint32_t*>(slot + columns.ids);
+			frame.segments = reinterpret_cast<const int32_t*>(slot + columns.segments);
+			frame.lanes = reinterpret_cast<const int32_t*>(slot + columns.lanes);
+			frame.directions = slot + columns.directions;
+			frame.distances = reinterpret_cast<const float*>(slot + columns.distances);
+			frame.speeds = reinterpret_cast<const float*>(slot + columns.speeds);
+		}
+		frame.signalRoads = reinterpret_cast<const int32_t*>(slot + columns.signalRoads);
+		frame.signalStates = slot + columns.signalStates;
+		frame.sequence = &frameHeader->sequence;
+
+		if (frame.isValid()) return true;
+	}
+	return false;
+}
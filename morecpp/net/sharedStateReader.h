@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "sharedMemory.h"
+#include "sharedStateLayout.h"
+#include "../traffic/compactVehicleState.h"
+
+
+// one published tick, read in place. the columns point into shared memory and stay untouched
+// until the publisher comes round the ring to the same slot, check isValid after reading them
+struct SharedStateFrame {
+	uint64_t number = 0;
+	uint64_t tick = 0;
+	float simulationTime = 0.0f;
+	uint32_t networkRevision = 0;
+	uint32_t vehicleCount = 0;
+	uint32_t signalCount = 0;
+	bool truncated = false;
+	uint32_t clampedVehicles = 0;
+
+	// set for the columns format
+	const uint32_t* ids = nullptr;
+	const int32_t* segments = nullptr;
+	const int32_t* lanes = nullptr;
+
+	// TravelDirection of each vehicle
+	const uint8_t* directions = nullptr;
+	const float* distances = nullptr;
+	const float* speeds = nullptr;
+
+	// set instead of the columns for the compact format
+	const CompactVehicleState* compactStates = nullptr;
+
+	// LightState of each signal, for the road it faces
+	const int32_t* signalRoads = nullptr;
+	const uint8_t* signalStates = nullptr;
+
+	const std::atomic<uint64_t>* sequence = nullptr;
+
+	// false once the publisher started overwriting the slot, whatever was read since acquire may be torn
+	bool isValid() const {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return sequence && sequence->load(std::memory_order_relaxed) == number * 2 + 2;
+	}
+};
+
+
+// maps a SharedStatePublisher's region read only. readers never write to it, so any number of
+// them can follow the simulation without it knowing
+class SharedStateReader {
+private:
+	SharedMemoryRegion region;
+	const SharedStateLayout::RegionHeader* header = nullptr;
+	SharedStateLayout::FrameColumns columns{ 0, 0 };
+
+
+public:
+	// false if there is no such region or it is not a shared state region of this version
+	bool open(const std::string& name);
+	void close();
+	bool isOpen() const { return header != nullptr; }
+
+	// number of the newest complete frame, 0 before the first
+	uint64_t getLatestFrame() const { return header ? header->latestFrame.load(std::memory_order_acquire) : 0; }
+
+	// the newest frame if it is newer than newerThan, false if there is none yet
+	bool acquire(SharedStateFrame& frame, uint64_t newerThan = 0) const;
+
+	uint32_t getVehicleCapacity() const { return header ? header->vehicleCapacity : 0; }
+	uint32_t getFrameCount() const { return header ? header->frameCount : 0; }
+	bool isCompact() const { return header && header->vehicleFormat == SharedStateLayout::COMPACT; }
+};
@@ -0,0 +1,275 @@
+#include "socketEndpoint.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#include <afunix.h>
+#include <io.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+
+
+#ifdef _WIN32
+
+bool initSockets() {
+	static bool initialized = false;
+	if (!initialized) {
+		WSADATA data;
+		initialized = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}
+	return initialized;
+}
+
+void closeSocket(int socket) { closesocket(static_cast<SOCKET>(socket)); }
+
+bool setNonBlocking(int socket) {
+	u_long enable = 1;
+	return ioctlsocket(static_cast<SOCKET>(socket), FIONBIO, &enable) == 0;
+}
+
+bool socketWouldBlock() {
+	int error = WSAGetLastError();
+	return error == WSAEWOULDBLOCK || error == WSAEINTR;
+}
+
+static std::string socketError() { return "error " + std::to_string(WSAGetLastError()); }
+void removeSocketFile(const std::string& path) { _unlink(path.c_str()); }
+
+int pollSockets(pollfd* descriptors, size_t count, int timeoutMs) { return WSAPoll(descriptors, static_cast<ULONG>(count), timeoutMs); }
+long sendSocket(int socket, const void* data, size_t size) { return send(static_cast<SOCKET>(socket), static_cast<const char*>(data), static_cast<int>(size), 0); }
+long receiveSocket(int socket, void* data, size_t size) { return recv(static_cast<SOCKET>(socket), static_cast<char*>(data), static_cast<int>(size), 0); }
+
+#else
+
+bool initSockets() { return true; }
+
+void closeSocket(int socket) { close(socket); }
+
+bool setNonBlocking(int socket) {
+	int flags = fcntl(socket, F_GETFL, 0);
+	return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool socketWouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+
+static std::string socketError() { return std::strerror(errno); }
+void removeSocketFile(const std::string& path) { unlink(path.c_str()); }
+
+int pollSockets(pollfd* descriptors, size_t count, int timeoutMs) { return poll(descriptors, count, timeoutMs); }
+
+// a viewer that went away must not kill the simulation with SIGPIPE
+#ifdef MSG_NOSIGNAL
+long sendSocket(int socket, const void* data, size_t size) { return send(socket, data, size, MSG_NOSIGNAL); }
+#else
+long sendSocket(int socket, const void* data, size_t size) { return send(socket, data, size, 0); }
+#endif
+
+long receiveSocket(int socket, void* data, size_t size) { return recv(socket, data, size, 0); }
+
+#endif
+
+
+// socket options every telemetry connection gets
+static void configureStream(int socket, bool isUnix) {
+#ifdef SO_NOSIGPIPE
+	int noSignal = 1;
+	setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &noSignal, sizeof(noSignal));
+#endif
+	if (!isUnix) {
+		int noDelay = 1;
+		setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+	}
+}
+
+
+bool createSocketPair(int sockets[2]) {
+	sockets[0] = sockets[1] = -1;
+
+	// a loopback connection works everywhere, posix has the cheaper socketpair
+#ifdef _WIN32
+	SocketEndpoint loopback;
+	int listener = -1;
+	for (int port = 49152; port < 49152 + 64 && listener < 0; port++) {
+		loopback.port = port;
+		listener = loopback.listen();
+	}
+	if (listener < 0) return false;
+
+	sockets[0] = loopback.connect();
+	sockaddr_storage address;
+	int length = sizeof(address);
+	for (int attempt = 0; attempt < 100 && sockets[0] >= 0 && sockets[1] < 0; attempt++) {
+		SOCKET accepted = accept(static_cast<SOCKET>(listener), reinterpret_cast<sockaddr*>(&address), &length);
+		if (accepted != INVALID_SOCKET) sockets[1] = static_cast<int>(accepted);
+		else Sleep(1);
+	}
+	closeSocket(listener);
+#else
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+		sockets[0] = sockets[1] = -1;
+	}
+#endif
+
+	if (sockets[0] < 0 || sockets[1] < 0 || !setNonBlocking(sockets[0]) || !setNonBlocking(sockets[1])) {
+		if (sockets[0] >= 0) closeSocket(sockets[0]);
+		if (sockets[1] >= 0) closeSocket(sockets[1]);
+		sockets[0] = sockets[1] = -1;
+		return false;
+	}
+	return true;
+}
+
+
+bool SocketEndpoint::parse(const std::string& text, SocketEndpoint& endpoint) {
+	endpoint = SocketEndpoint();
+
+	if (text.rfind("unix:", 0) == 0) {
+		endpoint.isUnix = true;
+		endpoint.path = text.substr(5);
+		if (endpoint.path.empty() || endpoint.path.size() >= sizeof(sockaddr_un::sun_path)) {
+			std::cerr << "Invalid unix socket path: " << text << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// tcp:<host>:<port>, or tcp:<port> on loopback
+	std::string address = text.rfind("tcp:", 0) == 0 ? text.substr(4) : text;
+	size_t colon = address.rfind(':');
+	if (colon != std::string::npos) {
+		endpoint.host = address.substr(0, colon);
+		address = address.substr(colon + 1);
+	}
+
+	endpoint.port = std::atoi(address.c_str());
+	if (endpoint.port <= 0 || endpoint.port > 65535 || endpoint.host.empty()) {
+		std::cerr << "Invalid endpoint: " << text << std::endl;
+		return false;
+	}
+	return true;
+}
+
+
+std::string SocketEndpoint::toString() const {
+	return isUnix ? "unix:" + path : "tcp:" + host + ":" + std::to_string(port);
+}
+
+
+// resolves the endpoint into a socket address, false if the host is unknown
+static bool resolve(const SocketEndpoint& endpoint, sockaddr_storage& address, socklen_t& length) {
+	std::memset(&address, 0, sizeof(address));
+
+	if (endpoint.isUnix) {
+		sockaddr_un* unixAddress = reinterpret_cast<sockaddr_un*>(&address);
+		unixAddress->sun_family = AF_UNIX;
+		std::strncpy(unixAddress->sun_path, endpoint.path.c_str(), sizeof(unixAddress->sun_path) - 1);
+		length = sizeof(sockaddr_un);
+		return true;
+	}
+
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* result = nullptr;
+	if (getaddrinfo(endpoint.host.c_str(), std::to_string(endpoint.port).c_str(), &hints, &result) != 0 || !result) {
+		std::cerr << "Could not resolve " << endpoint.host << std::endl;
+		return false;
+	}
+
+	std::memcpy(&address, result->ai_addr, result->ai_addrlen);
+	length = static_cast<socklen_t>(result->ai_addrlen);
+	freeaddrinfo(result);
+	return true;
+}
+
+
+// a stream socket for the endpoint, -1 on failure
+static int openSocket(const SocketEndpoint& endpoint) {
+	if (!initSockets()) {
+		std::cerr << "Could not initialize sockets" << std::endl;
+		return -1;
+	}
+
+	int socket = static_cast<int>(::socket(endpoint.isUnix ? AF_UNIX : AF_INET, SOCK_STREAM, 0));
+	if (socket < 0) {
+		std::cerr << "Could not create socket: " << socketError() << std::endl;
+	}
+	return socket;
+}
+
+
+int SocketEndpoint::listen() const {
+	sockaddr_storage address;
+	socklen_t length;
+	if (!resolve(*this, address, length)) return -1;
+
+	int socket = openSocket(*this);
+	if (socket < 0) return -1;
+
+	if (isUnix) {
+		// a socket file left behind by an earlier run would fail the bind
+		removeSocketFile(path);
+	} else {
+		int reuse = 1;
+		setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+	}
+
+	if (bind(socket, reinterpret_cast<sockaddr*>(&address), length) != 0 || ::listen(socket, 16) != 0 || !setNonBlocking(socket)) {
+		std::cerr << "Could not listen on " << toString() << ": " << socketError() << std::endl;
+		closeSocket(socket);
+		return -1;
+	}
+	return socket;
+}
+
+
+int SocketEndpoint::connect() const {
+	sockaddr_storage address;
+	socklen_t length;
+	if (!resolve(*this, address, length)) return -1;
+
+	int socket = openSocket(*this);
+	if (socket < 0) return -1;
+
+	// connect blocking, the stream itself is read without blocking
+	if (::connect(socket, reinterpret_cast<sockaddr*>(&address), length) != 0 || !setNonBlocking(socket)) {
+		std::cerr << "Could not connect to " << toString() << ": " << socketError() << std::endl;
+		closeSocket(socket);
+		return -1;
+	}
+
+	configureStream(socket, isUnix);
+	return socket;
+}
+
+
+int acceptSocket(int listener, bool isUnix) {
+	int socket = static_cast<int>(accept(listener, nullptr, nullptr));
+	if (socket < 0) return -1;
+
+	if (!setNonBlocking(socket)) {
+		closeSocket(socket);
+		return -1;
+	}
+	configureStream(socket, isUnix);
+	return socket;
+}
+
+
+bool setSendBufferSize(int socket, int bytes) {
+	return setsockopt(socket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&bytes), sizeof(bytes)) == 0;
+}
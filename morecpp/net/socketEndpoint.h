@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+
+// where a telemetry server listens or a client connects, written "tcp:<host>:<port>" or "unix:<path>"
+struct SocketEndpoint {
+	bool isUnix = false;
+	std::string host = "127.0.0.1";
+	int port = 0;
+	std::string path;
+
+	// false and a message on cerr if the text is not an endpoint
+	static bool parse(const std::string& text, SocketEndpoint& endpoint);
+	std::string toString() const;
+
+	// non blocking sockets, -1 on failure
+	int listen() const;
+	int connect() const;
+};
+
+
+// the little the telemetry code needs from the platform. sockets are kept as ints,
+// winsock handles fit in one in practice
+bool initSockets();
+void closeSocket(int socket);
+
+// deletes the file a unix socket was bound to
+void removeSocketFile(const std::string& path);
+
+// returns false on anything but success or would block
+bool setNonBlocking(int socket);
+
+// true if the last failed call only failed because it would have blocked
+bool socketWouldBlock();
+
+// accepts one pending connection as a non blocking socket, -1 if there is none
+int acceptSocket(int listener, bool isUnix);
+
+// caps the kernel's send buffer for a socket, false if the platform refused
+bool setSendBufferSize(int socket, int bytes);
+
+// connected pair of non blocking sockets, used to cut a poll short from another thread
+bool createSocketPair(int sockets[2]);
+
+int pollSockets(pollfd* descriptors, size_t count, int timeoutMs);
+
+// -1 on error, 0 once the peer closed
+long sendSocket(int socket, const void* data, size_t size);
+long receiveSocket(int socket, void* data, size_t size);
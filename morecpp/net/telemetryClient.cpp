@@ -0,0 +1,61 @@
+#include "telemetryClient.h"
+
+#include <iostream>
+
+
+TelemetryClient::~TelemetryClient() {
+	disconnect();
+}
+
+
+bool TelemetryClient::connect(const SocketEndpoint& endpoint) {
+	disconnect();
+
+	socket = endpoint.connect();
+	return socket >= 0;
+}
+
+
+void TelemetryClient::disconnect() {
+	if (socket >= 0) {
+		closeSocket(socket);
+	}
+	socket = -1;
+	buffer.clear();
+	state = TelemetryState();
+}
+
+
+bool TelemetryClient::poll() {
+	if (socket < 0) return false;
+
+	uint8_t chunk[64 * 1024];
+	while (true) {
+		long received = receiveSocket(socket, chunk, sizeof(chunk));
+
+		if (received > 0) {
+			buffer.insert(buffer.end(), chunk, chunk + received);
+			bytesReceived += received;
+			continue;
+		}
+
+		if (received < 0 && socketWouldBlock()) {
+			break;
+		}
+
+		// closed by the server, or a socket error
+		std::cerr << "Telemetry stream closed" << std::endl;
+		closeSocket(socket);
+		socket = -1;
+		break;
+	}
+
+	if (!TelemetryCodec::decode(buffer, state)) {
+		std::cerr << "Malformed telemetry stream" << std::endl;
+		closeSocket(socket);
+		socket = -1;
+		return false;
+	}
+
+	return socket >= 0;
+}
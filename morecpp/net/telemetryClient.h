@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "socketEndpoint.h"
+#include "telemetryProtocol.h"
+
+
+// rebuilds the simulation's visible state from a telemetry server
+class TelemetryClient {
+private:
+	int socket = -1;
+	std::vector<uint8_t> buffer;
+	TelemetryState state;
+	uint64_t bytesReceived = 0;
+
+
+public:
+	TelemetryClient() = default;
+	~TelemetryClient();
+
+	TelemetryClient(const TelemetryClient&) = delete;
+	TelemetryClient& operator=(const TelemetryClient&) = delete;
+
+	bool connect(const SocketEndpoint& endpoint);
+	void disconnect();
+	bool isConnected() const { return socket >= 0; }
+
+	// reads whatever has arrived without blocking and applies every whole message,
+	// false once the server closed the stream or sent something malformed
+	bool poll();
+
+	const TelemetryState& getState() const { return state; }
+	uint64_t getBytesReceived() const { return bytesReceived; }
+};
@@ -0,0 +1,413 @@
+#include "telemetryProtocol.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+// messages larger than this are taken as a corrupt stream
+static constexpr uint32_t maxMessageSize = 256 * 1024 * 1024;
+
+
+TelemetryWriter::TelemetryWriter(std::vector<uint8_t>& out, TelemetryMessage type) : out(out), messageStart(out.size()) {
+	writeU32(0);
+	writeU8(static_cast<uint8_t>(type));
+}
+
+
+void TelemetryWriter::finish() {
+	uint32_t length = static_cast<uint32_t>(out.size() - messageStart - 5);
+	for (int i = 0; i < 4; i++) {
+		out[messageStart + i] = static_cast<uint8_t>(length >> (8 * i));
+	}
+}
+
+
+void TelemetryWriter::writeU32(uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+}
+
+
+void TelemetryWriter::writeU64(uint64_t value) {
+	for (int i = 0; i < 8; i++) {
+		out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+}
+
+
+void TelemetryWriter::writeFloat(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	writeU32(bits);
+}
+
+
+void TelemetryWriter::writeVarint(uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+
+void TelemetryWriter::writeString(const std::string& value) {
+	writeVarint(value.size());
+	out.insert(out.end(), value.begin(), value.end());
+}
+
+
+uint8_t TelemetryReader::readU8() {
+	if (failed || offset + 1 > size) {
+		failed = true;
+		return 0;
+	}
+	return data[offset++];
+}
+
+
+uint32_t TelemetryReader::readU32() {
+	if (failed || offset + 4 > size) {
+		failed = true;
+		return 0;
+	}
+
+	uint32_t value = 0;
+	for (int i = 0; i < 4; i++) {
+		value |= static_cast<uint32_t>(data[offset++]) << (8 * i);
+	}
+	return value;
+}
+
+
+uint64_t TelemetryReader::readU64() {
+	uint64_t low = readU32();
+	uint64_t high = readU32();
+	return low | (high << 32);
+}
+
+
+float TelemetryReader::readFloat() {
+	uint32_t bits = readU32();
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+
+uint64_t TelemetryReader::readVarint() {
+	uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte = readU8();
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) return value;
+	}
+
+	failed = true;
+	return 0;
+}
+
+
+std::string TelemetryReader::readString() {
+	uint64_t length = readVarint();
+	if (failed || length > size - offset) {
+		failed = true;
+		return "";
+	}
+
+	std::string value(reinterpret_cast<const char*>(data + offset), length);
+	offset += length;
+	return value;
+}
+
+
+void TelemetryCodec::encodeNetwork(const TelemetryState& state, std::vector<uint8_t>& out) {
+	TelemetryWriter writer(out, TelemetryMessage::NETWORK);
+	writer.writeU32(state.revision);
+
+	writer.writeVarint(state.roads.size());
+	for (const auto& road : state.roads) {
+		writer.writeSignedVarint(road.index);
+		writer.writeString(road.id);
+		writer.writeFloat(road.startX);
+		writer.writeFloat(road.startZ);
+		writer.writeFloat(road.endX);
+		writer.writeFloat(road.endZ);
+		writer.writeFloat(road.width);
+		writer.writeU8(road.forwardLanes);
+		writer.writeU8(road.reverseLanes);
+	}
+
+	writer.writeVarint(state.junctions.size());
+	for (const auto& junction : state.junctions) {
+		writer.writeString(junction.id);
+		writer.writeFloat(junction.x);
+		writer.writeFloat(junction.z);
+		writer.writeFloat(junction.radius);
+		writer.writeVarint(junction.signalRoads.size());
+		for (int32_t road : junction.signalRoads) {
+			writer.writeSignedVarint(road);
+		}
+	}
+
+	writer.finish();
+}
+
+
+static void writeVehicle(TelemetryWriter& writer, const TelemetryVehicle& vehicle) {
+	writer.writeSignedVarint(vehicle.x);
+	writer.writeSignedVarint(vehicle.z);
+	writer.writeU8(vehicle.heading);
+	writer.writeU8(vehicle.speed);
+	writer.writeU8(vehicle.length);
+	writer.writeU8(vehicle.width);
+	writer.writeU8(vehicle.r);
+	writer.writeU8(vehicle.g);
+	writer.writeU8(vehicle.b);
+}
+
+
+// bits of a changed vehicle's entry saying which fields follow
+static constexpr uint8_t changedPosition = 1;
+static constexpr uint8_t changedHeading = 2;
+static constexpr uint8_t changedSpeed = 4;
+
+
+void TelemetryCodec::encodeDelta(const TelemetryState& previous, const TelemetryState& current, TelemetryMessage type, std::vector<uint8_t>& out) {
+	TelemetryWriter writer(out, type);
+	writer.writeU64(current.tick);
+	writer.writeFloat(current.simulationTime);
+
+	// both lists are sorted by id, one merge finds what left, arrived and changed.
+	// ids are written as the gap to the previous one in the same section
+	const auto& before = previous.vehicles;
+	const auto& after = current.vehicles;
+
+	size_t removed = 0, added = 0, changed = 0;
+	for (size_t i = 0, j = 0; i < before.size() || j < after.size();) {
+		if (j == after.size() || (i < before.size() && before[i].id < after[j].id)) { removed++; i++; }
+		else if (i == before.size() || after[j].id < before[i].id) { added++; j++; }
+		else {
+			const TelemetryVehicle& a = before[i++];
+			const TelemetryVehicle& b = after[j++];
+			if (a.x != b.x || a.z != b.z || a.heading != b.heading || a.speed != b.speed) changed++;
+		}
+	}
+
+	writer.writeVarint(removed);
+	uint32_t lastId = 0;
+	for (size_t i = 0, j = 0; i < before.size(); i++) {
+		while (j < after.size() && after[j].id < before[i].id) j++;
+		if (j < after.size() && after[j].id == before[i].id) continue;
+
+		writer.writeVarint(before[i].id - lastId);
+		lastId = before[i].id;
+	}
+
+	writer.writeVarint(added);
+	lastId = 0;
+	for (size_t i = 0, j = 0; j < after.size(); j++) {
+		while (i < before.size() && before[i].id < after[j].id) i++;
+		if (i < before.size() && before[i].id == after[j].id) continue;
+
+		writer.writeVarint(after[j].id - lastId);
+		lastId = after[j].id;
+		writeVehicle(writer, after[j]);
+	}
+
+	writer.writeVarint(changed);
+	lastId = 0;
+	for (size_t i = 0, j = 0; j < after.size(); j++) {
+		while (i < before.size() && before[i].id < after[j].id) i++;
+		if (i == before.size() || before[i].id != after[j].id) continue;
+
+		const TelemetryVehicle& a = before[i];
+		const TelemetryVehicle& b = after[j];
+		uint8_t flags = (a.x != b.x || a.z != b.z ? changedPosition : 0) | (a.heading != b.heading ? changedHeading : 0) | (a.speed != b.speed ? changedSpeed : 0);
+		if (!flags) continue;
+
+		writer.writeVarint(b.id - lastId);
+		lastId = b.id;
+		writer.writeU8(flags);
+		if (flags & changedPosition) {
+			writer.writeSignedVarint(static_cast<int64_t>(b.x) - a.x);
+			writer.writeSignedVarint(static_cast<int64_t>(b.z) - a.z);
+		}
+		if (flags & changedHeading) writer.writeU8(b.heading);
+		if (flags & changedSpeed) writer.writeU8(b.speed);
+	}
+
+	// signals that changed, all of them when the signal layout changed with the network
+	bool sameLayout = previous.signals.size() == current.signals.size();
+	size_t signalChanges = 0;
+	for (size_t i = 0; i < current.signals.size(); i++) {
+		if (!sameLayout || previous.signals[i] != current.signals[i]) signalChanges++;
+	}
+
+	writer.writeVarint(current.signals.size());
+	writer.writeVarint(signalChanges);
+	for (size_t i = 0; i < current.signals.size(); i++) {
+		if (sameLayout && previous.signals[i] == current.signals[i]) continue;
+		writer.writeVarint(i);
+		writer.writeU8(current.signals[i]);
+	}
+
+	writer.finish();
+}
+
+
+bool TelemetryCodec::decodeNetwork(TelemetryReader& reader, TelemetryState& state) {
+	state.revision = reader.readU32();
+
+	state.roads.clear();
+	uint64_t roadCount = reader.readVarint();
+	for (uint64_t i = 0; i < roadCount && reader.isValid(); i++) {
+		TelemetryRoad road;
+		road.index = static_cast<int32_t>(reader.readSignedVarint());
+		road.id = reader.readString();
+		road.startX = reader.readFloat();
+		road.startZ = reader.readFloat();
+		road.endX = reader.readFloat();
+		road.endZ = reader.readFloat();
+		road.width = reader.readFloat();
+		road.forwardLanes = reader.readU8();
+		road.reverseLanes = reader.readU8();
+		state.roads.push_back(std::move(road));
+	}
+
+	state.junctions.clear();
+	uint64_t junctionCount = reader.readVarint();
+	for (uint64_t i = 0; i < junctionCount && reader.isValid(); i++) {
+		TelemetryJunction junction;
+		junction.id = reader.readString();
+		junction.x = reader.readFloat();
+		junction.z = reader.readFloat();
+		junction.radius = reader.readFloat();
+
+		uint64_t signalCount = reader.readVarint();
+		for (uint64_t s = 0; s < signalCount && reader.isValid(); s++) {
+			junction.signalRoads.push_back(static_cast<int32_t>(reader.readSignedVarint()));
+		}
+		state.junctions.push_back(std::move(junction));
+	}
+
+	state.hasNetwork = reader.isValid();
+	return reader.isValid();
+}
+
+
+static TelemetryVehicle readVehicle(TelemetryReader& reader, uint32_t id) {
+	TelemetryVehicle vehicle;
+	vehicle.id = id;
+	vehicle.x = static_cast<int32_t>(reader.readSignedVarint());
+	vehicle.z = static_cast<int32_t>(reader.readSignedVarint());
+	vehicle.heading = reader.readU8();
+	vehicle.speed = reader.readU8();
+	vehicle.length = reader.readU8();
+	vehicle.width = reader.readU8();
+	vehicle.r = reader.readU8();
+	vehicle.g = reader.readU8();
+	vehicle.b = reader.readU8();
+	return vehicle;
+}
+
+
+bool TelemetryCodec::decodeDelta(TelemetryReader& reader, TelemetryState& state, bool keyframe) {
+	if (keyframe) {
+		state.vehicles.clear();
+		state.signals.clear();
+	}
+
+	state.tick = reader.readU64();
+	state.simulationTime = reader.readFloat();
+
+	auto& vehicles = state.vehicles;
+	auto findVehicle = [&](uint32_t id) {
+		return std::lower_bound(vehicles.begin(), vehicles.end(), id, [](const TelemetryVehicle& vehicle, uint32_t id) { return vehicle.id < id; });
+	};
+
+	// removals come sorted, they are dropped in one pass
+	uint64_t removed = reader.readVarint();
+	if (removed > vehicles.size()) return false;
+
+	std::vector<uint32_t> removedIds;
+	uint32_t id = 0;
+	for (uint64_t i = 0; i < removed && reader.isValid(); i++) {
+		id += static_cast<uint32_t>(reader.readVarint());
+		removedIds.push_back(id);
+	}
+	if (!removedIds.empty()) {
+		vehicles.erase(std::remove_if(vehicles.begin(), vehicles.end(), [&](const TelemetryVehicle& vehicle) {
+			return std::binary_search(removedIds.begin(), removedIds.end(), vehicle.id);
+		}), vehicles.end());
+	}
+
+	// arrivals come sorted, merged in behind the others
+	uint64_t added = reader.readVarint();
+	size_t existing = vehicles.size();
+	id = 0;
+	for (uint64_t i = 0; i < added && reader.isValid(); i++) {
+		id += static_cast<uint32_t>(reader.readVarint());
+		vehicles.push_back(readVehicle(reader, id));
+	}
+	std::inplace_merge(vehicles.begin(), vehicles.begin() + existing, vehicles.end(), [](const TelemetryVehicle& a, const TelemetryVehicle& b) { return a.id < b.id; });
+
+	uint64_t changed = reader.readVarint();
+	id = 0;
+	for (uint64_t i = 0; i < changed && reader.isValid(); i++) {
+		id += static_cast<uint32_t>(reader.readVarint());
+		auto it = findVehicle(id);
+		if (it == vehicles.end() || it->id != id) return false;
+
+		uint8_t flags = reader.readU8();
+		if (flags & changedPosition) {
+			it->x += static_cast<int32_t>(reader.readSignedVarint());
+			it->z += static_cast<int32_t>(reader.readSignedVarint());
+		}
+		if (flags & changedHeading) it->heading = reader.readU8();
+		if (flags & changedSpeed) it->speed = reader.readU8();
+	}
+
+	uint64_t signalCount = reader.readVarint();
+	if (signalCount > maxMessageSize) return false;
+	state.signals.resize(signalCount, 0);
+
+	uint64_t signalChanges = reader.readVarint();
+	for (uint64_t i = 0; i < signalChanges && reader.isValid(); i++) {
+		uint64_t index = reader.readVarint();
+		uint8_t value = reader.readU8();
+		if (index >= state.signals.size()) return false;
+		state.signals[index] = value;
+	}
+
+	return reader.isValid();
+}
+
+
+bool TelemetryCodec::decode(std::vector<uint8_t>& buffer, TelemetryState& state) {
+	size_t offset = 0;
+
+	while (buffer.size() - offset >= 5) {
+		TelemetryReader header(buffer.data() + offset, 5);
+		uint32_t length = header.readU32();
+		TelemetryMessage type = static_cast<TelemetryMessage>(header.readU8());
+
+		if (length > maxMessageSize) return false;
+		if (buffer.size() - offset - 5 < length) break;
+
+		TelemetryReader reader(buffer.data() + offset + 5, length);
+		bool decoded = false;
+		switch (type) {
+		case TelemetryMessage::NETWORK: decoded = decodeNetwork(reader, state); break;
+		case TelemetryMessage::KEYFRAME: decoded = decodeDelta(reader, state, true); break;
+		case TelemetryMessage::DELTA: decoded = decodeDelta(reader, state, false); break;
+		}
+		if (!decoded || !reader.atEnd()) return false;
+
+		offset += 5 + length;
+	}
+
+	buffer.erase(buffer.begin(), buffer.begin() + offset);
+	return true;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+// wire format of the telemetry stream. every message is a little endian u32 payload length,
+// a u8 message type and the payload. a client first gets the network and a keyframe, then one
+// delta per published tick against the tick before it
+enum class TelemetryMessage : uint8_t {
+	NETWORK = 1,
+	KEYFRAME = 2,
+	DELTA = 3
+};
+
+
+// quantization of vehicle state on the wire
+struct TelemetryQuantization {
+	// 1/16 m positions, 256 headings per turn, 1/4 m/s speeds, 1/10 m dimensions
+	static constexpr float positionScale = 16.0f;
+	static constexpr float headingSteps = 256.0f;
+	static constexpr float speedScale = 4.0f;
+	static constexpr float dimensionScale = 10.0f;
+};
+
+
+struct TelemetryRoad {
+	int32_t index;
+	std::string id;
+	float startX, startZ, endX, endZ;
+	float width;
+	uint8_t forwardLanes, reverseLanes;
+};
+
+
+struct TelemetryJunction {
+	std::string id;
+	float x, z, radius;
+
+	// roads with a signal at this junction, by road index. empty for junctions without lights
+	std::vector<int32_t> signalRoads;
+};
+
+
+// vehicle as it goes over the wire, kept quantized on both ends so deltas are exact
+struct TelemetryVehicle {
+	uint32_t id;
+	int32_t x, z;
+	uint8_t heading;
+	uint8_t speed;
+	uint8_t length, width;
+	uint8_t r, g, b;
+
+	float getX() const { return x / TelemetryQuantization::positionScale; }
+	float getZ() const { return z / TelemetryQuantization::positionScale; }
+	float getHeading() const { return heading * 6.2831853f / TelemetryQuantization::headingSteps; }
+	float getSpeed() const { return speed / TelemetryQuantization::speedScale; }
+	float getLength() const { return length / TelemetryQuantization::dimensionScale; }
+	float getWidth() const { return width / TelemetryQuantization::dimensionScale; }
+};
+
+
+// one side's view of the stream: the server keeps what it last sent, the client what it rebuilt
+struct TelemetryState {
+	uint32_t revision = 0;
+	bool hasNetwork = false;
+	std::vector<TelemetryRoad> roads;
+	std::vector<TelemetryJunction> junctions;
+
+	uint64_t tick = 0;
+	float simulationTime = 0.0f;
+
+	// sorted by id
+	std::vector<TelemetryVehicle> vehicles;
+
+	// light states (see LightState) of every junction's signal roads, junction by junction
+	std::vector<uint8_t> signals;
+};
+
+
+class TelemetryWriter {
+private:
+	std::vector<uint8_t>& out;
+	size_t messageStart;
+
+
+public:
+	// starts a message, its length is filled in by finish
+	TelemetryWriter(std::vector<uint8_t>& out, TelemetryMessage type);
+	void finish();
+
+	void writeU8(uint8_t value) { out.push_back(value); }
+	void writeU32(uint32_t value);
+	void writeU64(uint64_t value);
+	void writeFloat(float value);
+	void writeVarint(uint64_t value);
+	void writeSignedVarint(int64_t value) { writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+	void writeString(const std::string& value);
+};
+
+
+// bounds checked, a failed read leaves the reader in error and every later read returns zero
+class TelemetryReader {
+private:
+	const uint8_t* data;
+	size_t size;
+	size_t offset = 0;
+	bool failed = false;
+
+
+public:
+	TelemetryReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+	bool isValid() const { return !failed; }
+	bool atEnd() const { return offset == size; }
+
+	uint8_t readU8();
+	uint32_t readU32();
+	uint64_t readU64();
+	float readFloat();
+	uint64_t readVarint();
+	int64_t readSignedVarint() { uint64_t value = readVarint(); return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+	std::string readString();
+};
+
+
+class TelemetryCodec {
+private:
+	static bool decodeNetwork(TelemetryReader& reader, TelemetryState& state);
+	static bool decodeDelta(TelemetryReader& reader, TelemetryState& state, bool keyframe);
+
+
+public:
+	static void encodeNetwork(const TelemetryState& state, std::vector<uint8_t>& out);
+
+	// previous to current, a keyframe is the delta from an empty state
+	static void encodeDelta(const TelemetryState& previous, const TelemetryState& current, TelemetryMessage type, std::vector<uint8_t>& out);
+
+	// splits whole messages off the front of buffer and applies them, a partial message stays.
+	// false if the stream is malformed
+	static bool decode(std::vector<uint8_t>& buffer, TelemetryState& state);
+};
@@ -0,0 +1,327 @@
+#include "telemetryServer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+#include "../road/trafficLightJunction.h"
+#include "../traffic/vehicle.h"
+
+
+TelemetryServer::~TelemetryServer() {
+	stop();
+}
+
+
+bool TelemetryServer::start(const SocketEndpoint& newEndpoint) {
+	if (listenSocket >= 0) return true;
+
+	endpoint = newEndpoint;
+	listenSocket = endpoint.listen();
+	if (listenSocket < 0) {
+		return false;
+	}
+
+	if (!createSocketPair(wakeSockets)) {
+		std::cerr << "Could not create telemetry wake sockets" << std::endl;
+		closeSocket(listenSocket);
+		listenSocket = -1;
+		return false;
+	}
+
+	stopping = false;
+	ioThread = std::thread(&TelemetryServer::ioLoop, this);
+	std::cout << "Serving telemetry on " << endpoint.toString() << std::endl;
+	return true;
+}
+
+
+void TelemetryServer::stop() {
+	if (listenSocket < 0) return;
+
+	stopping = true;
+	wake();
+	if (ioThread.joinable()) {
+		ioThread.join();
+	}
+
+	for (auto& client : clients) {
+		closeSocket(client->socket);
+	}
+	clients.clear();
+
+	closeSocket(listenSocket);
+	closeSocket(wakeSockets[0]);
+	closeSocket(wakeSockets[1]);
+	listenSocket = -1;
+	wakeSockets[0] = wakeSockets[1] = -1;
+
+	if (endpoint.isUnix) {
+		removeSocketFile(endpoint.path);
+	}
+}
+
+
+void TelemetryServer::wake() {
+	char byte = 0;
+	sendSocket(wakeSockets[1], &byte, 1);
+}
+
+
+size_t TelemetryServer::getClientCount() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return clients.size();
+}
+
+
+void TelemetryServer::captureNetwork(const RoadNetwork& network) {
+	current.revision = network.getRevision();
+	current.hasNetwork = true;
+	current.roads.clear();
+	current.junctions.clear();
+	signalSources.clear();
+
+	network.forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& road) {
+		if (road->getIndex() < 0) return;
+
+		Vector3 start = road->getStartPosition();
+		Vector3 end = road->getEndPosition();
+		current.roads.push_back({ road->getIndex(), road->getId(), start.x, start.z, end.x, end.z, road->getDimensions().z,
+			static_cast<uint8_t>(road->getLaneCount(TravelDirection::FORWARD)), static_cast<uint8_t>(road->getLaneCount(TravelDirection::REVERSE)) });
+	});
+	std::sort(current.roads.begin(), current.roads.end(), [](const TelemetryRoad& a, const TelemetryRoad& b) { return a.index < b.index; });
+
+	// junctions by id so the layout of the signal array does not depend on hash order
+	std::vector<std::shared_ptr<Junction>> junctions;
+	network.forEachJunction([&](const std::shared_ptr<Junction>& junction) { junctions.push_back(junction); });
+	std::sort(junctions.begin(), junctions.end(), [](const std::shared_ptr<Junction>& a, const std::shared_ptr<Junction>& b) { return a->getId() < b->getId(); });
+
+	for (const auto& junction : junctions) {
+		TelemetryJunction entry{ junction->getId(), junction->getPosition().x, junction->getPosition().z, junction->getRadius(), {} };
+
+		if (auto lights = std::dynamic_pointer_cast<TrafficLightJunction>(junction)) {
+			SignalSource source{ lights, {} };
+			for (const auto& road : junction->getConnectedRoads()) {
+				if (!road || road->getIndex() < 0) continue;
+				entry.signalRoads.push_back(road->getIndex());
+				source.roads.push_back(road);
+			}
+			signalSources.push_back(std::move(source));
+		}
+		current.junctions.push_back(std::move(entry));
+	}
+
+	networkRevision = current.revision;
+	networkCaptured = true;
+}
+
+
+void TelemetryServer::captureTick(const SimulationModel& model) {
+	current.tick = model.getTick();
+	current.simulationTime = static_cast<float>(model.getSimulationTime());
+	current.vehicles.clear();
+
+	model.getGridNetwork().forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& road) {
+		for (const auto& vehicle : road->getVehicles()) {
+			const Vector3& position = vehicle->getPosition();
+			Vector3 heading = road->getTravelVector(vehicle->getTravelDirection());
+			float angle = std::atan2(heading.z, heading.x);
+			Color color = vehicle->getColor();
+
+			TelemetryVehicle entry;
+			entry.id = vehicle->getId();
+			entry.x = static_cast<int32_t>(std::lround(position.x * TelemetryQuantization::positionScale));
+			entry.z = static_cast<int32_t>(std::lround(position.z * TelemetryQuantization::positionScale));
+			entry.heading = static_cast<uint8_t>(static_cast<int>(std::lround(angle / 6.2831853f * TelemetryQuantization::headingSteps)) & 0xff);
+			entry.speed = static_cast<uint8_t>(std::min(255.0f, std::round(vehicle->getCurrentSpeed() * TelemetryQuantization::speedScale)));
+			entry.length = static_cast<uint8_t>(std::min(255.0f, std::round(vehicle->getDimensions().x * TelemetryQuantization::dimensionScale)));
+			entry.width = static_cast<uint8_t>(std::min(255.0f, std::round(vehicle->getDimensions().z * TelemetryQuantization::dimensionScale)));
+			entry.r = color.r;
+			entry.g = color.g;
+			entry.b = color.b;
+			current.vehicles.push_back(entry);
+		}
+	});
+	std::sort(current.vehicles.begin(), current.vehicles.end(), [](const TelemetryVehicle& a, const TelemetryVehicle& b) { return a.id < b.id; });
+
+	current.signals.clear();
+	for (const auto& source : signalSources) {
+		for (const auto& road : source.roads) {
+			current.signals.push_back(static_cast<uint8_t>(source.junction->getLightState(road)));
+		}
+	}
+}
+
+
+void TelemetryServer::enqueue(Client& client, const Message& message) {
+	if (client.dropped) return;
+
+	client.queue.push_back(message);
+	client.queuedBytes += message->size();
+
+	if (client.queuedBytes > config.maxQueuedBytes) {
+		client.dropped = true;
+	}
+}
+
+
+void TelemetryServer::publish(const SimulationModel& model) {
+	if (listenSocket < 0) return;
+	if (++publishCount % std::max(1, config.publishInterval) != 0) return;
+
+	const RoadNetwork& network = model.getGridNetwork();
+	bool networkChanged = !networkCaptured || networkRevision != network.getRevision();
+
+	// network geometry is kept from the last capture unless it changed
+	current.revision = sent.revision;
+	current.hasNetwork = sent.hasNetwork;
+	current.roads.swap(sent.roads);
+	current.junctions.swap(sent.junctions);
+	if (networkChanged) {
+		captureNetwork(network);
+	}
+	captureTick(model);
+
+	bool anyCurrent = false, anyNew = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const auto& client : clients) {
+			if (client->dropped) continue;
+			(client->needsKeyframe ? anyNew : anyCurrent) = true;
+		}
+	}
+
+	// each message is encoded once and shared by every client it goes to
+	Message networkMessage, delta, keyframe;
+	if (networkChanged || anyNew) {
+		auto bytes = std::make_shared<std::vector<uint8_t>>();
+		TelemetryCodec::encodeNetwork(current, *bytes);
+		networkMessage = bytes;
+	}
+	if (anyCurrent) {
+		auto bytes = std::make_shared<std::vector<uint8_t>>();
+		TelemetryCodec::encodeDelta(sent, current, TelemetryMessage::DELTA, *bytes);
+		delta = bytes;
+	}
+	if (anyNew) {
+		auto bytes = std::make_shared<std::vector<uint8_t>>();
+		TelemetryCodec::encodeDelta(TelemetryState(), current, TelemetryMessage::KEYFRAME, *bytes);
+		keyframe = bytes;
+	}
+
+	if (anyCurrent || anyNew) {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& client : clients) {
+
+			// clients that connected after the check above start next tick
+			if (client->needsKeyframe) {
+				if (!keyframe) continue;
+				enqueue(*client, networkMessage);
+				enqueue(*client, keyframe);
+				client->needsKeyframe = false;
+				continue;
+			}
+
+			if (!delta) continue;
+			if (networkChanged) enqueue(*client, networkMessage);
+			enqueue(*client, delta);
+		}
+
+		bytesPublished += (delta ? delta->size() : 0) + (keyframe ? keyframe->size() : 0);
+
+		wake();
+	}
+
+	std::swap(sent, current);
+}
+
+
+bool TelemetryServer::sendQueued(Client& client) {
+	while (!client.queue.empty()) {
+		const Message& message = client.queue.front();
+		long written = sendSocket(client.socket, message->data() + client.sentOffset, message->size() - client.sentOffset);
+
+		if (written < 0) {
+			return socketWouldBlock();
+		}
+
+		client.sentOffset += written;
+		if (client.sentOffset == message->size()) {
+			client.queuedBytes -= message->size();
+			client.queue.pop_front();
+			client.sentOffset = 0;
+		}
+	}
+	return true;
+}
+
+
+void TelemetryServer::ioLoop() {
+	std::vector<pollfd> descriptors;
+	char scratch[256];
+
+	while (!stopping) {
+		descriptors.clear();
+		descriptors.push_back({ wakeSockets[0], POLLIN, 0 });
+		descriptors.push_back({ listenSocket, POLLIN, 0 });
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const auto& client : clients) {
+				descriptors.push_back({ client->socket, static_cast<short>(POLLIN | (client->queue.empty() ? 0 : POLLOUT)), 0 });
+			}
+		}
+
+		if (pollSockets(descriptors.data(), descriptors.size(), 100) < 0 && !socketWouldBlock()) {
+			std::cerr << "Telemetry poll failed" << std::endl;
+			break;
+		}
+
+		// drain wake ups, they only exist to cut the poll short
+		while (receiveSocket(wakeSockets[0], scratch, sizeof(scratch)) > 0) {}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// clients are only added and removed here, so descriptors still line up with them
+		for (size_t i = 0; i < clients.size(); i++) {
+			Client& client = *clients[i];
+			short events = descriptors[i + 2].revents;
+
+			// viewers send nothing, readable means closed or an error
+			if (events & (POLLERR | POLLHUP | POLLNVAL)) client.dropped = true;
+			if (events & POLLIN) {
+				long received = receiveSocket(client.socket, scratch, sizeof(scratch));
+				if (received == 0 || (received < 0 && !socketWouldBlock())) client.dropped = true;
+			}
+
+			if (!client.dropped && !sendQueued(client)) client.dropped = true;
+		}
+
+		for (auto it = clients.begin(); it != clients.end();) {
+			if (!(*it)->dropped) {
+				++it;
+				continue;
+			}
+
+			// a drop with data still queued is a slow client rather than a closed one
+			if ((*it)->queuedBytes > config.maxQueuedBytes) {
+				std::cerr << "Dropped telemetry client, " << (*it)->queuedBytes << " bytes behind" << std::endl;
+				droppedClients++;
+			}
+			closeSocket((*it)->socket);
+			it = clients.erase(it);
+		}
+
+		if (descriptors[1].revents & POLLIN) {
+			int socket;
+			while ((socket = acceptSocket(listenSocket, endpoint.isUnix)) >= 0) {
+				if (config.sendBufferBytes > 0) {
+					setSendBufferSize(socket, config.sendBufferBytes);
+				}
+
+				auto client = std::make_unique<Client>();
+				client->socket = socket;
+				clients.push_back(std::move(client));
+			}
+		}
+	}
+}
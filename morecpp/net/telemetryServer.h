@@ -0,0 +1,105 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include "socketEndpoint.h"
+#include "telemetryProtocol.h"
+#include "../framework/simulationModel.h"
+
+
+class TrafficLightJunction;
+
+
+struct TelemetryConfig {
+	// bytes waiting for one client before it is dropped, it can reconnect for a fresh keyframe
+	size_t maxQueuedBytes = 8 * 1024 * 1024;
+
+	// publish every nth tick
+	int publishInterval = 1;
+
+	// kernel send buffer for each client socket, 0 keeps the system default. what the kernel
+	// buffers does not count towards maxQueuedBytes
+	int sendBufferBytes = 0;
+};
+
+
+// serves the simulation to remote viewers. publish encodes each tick once on the simulation thread
+// and queues the bytes for every client, a background thread does all socket work. a client that
+// falls behind by more than maxQueuedBytes is disconnected instead of holding the simulation up
+class TelemetryServer {
+private:
+	typedef std::shared_ptr<const std::vector<uint8_t>> Message;
+
+	struct Client {
+		int socket;
+		std::deque<Message> queue;
+		size_t queuedBytes = 0;
+
+		// bytes of the front message already sent
+		size_t sentOffset = 0;
+
+		bool needsKeyframe = true;
+		bool dropped = false;
+	};
+
+	TelemetryConfig config;
+	SocketEndpoint endpoint;
+	int listenSocket = -1;
+
+	// written to wake the io thread when there is something new to send
+	int wakeSockets[2] = { -1, -1 };
+	std::thread ioThread;
+	std::atomic<bool> stopping{ false };
+
+	// the io thread adds and removes clients, the simulation thread only queues and marks drops
+	std::mutex mutex;
+	std::vector<std::unique_ptr<Client>> clients;
+	std::atomic<uint64_t> droppedClients{ 0 };
+
+	// simulation thread only: what clients were last sent, and this tick
+	TelemetryState sent;
+	TelemetryState current;
+	uint32_t networkRevision = 0;
+	bool networkCaptured = false;
+	int publishCount = 0;
+	uint64_t bytesPublished = 0;
+
+	// signal sources of the captured network, so each tick only reads light states
+	struct SignalSource {
+		std::shared_ptr<TrafficLightJunction> junction;
+		std::vector<std::shared_ptr<RoadSegment>> roads;
+	};
+	std::vector<SignalSource> signalSources;
+
+	void captureNetwork(const RoadNetwork& network);
+	void captureTick(const SimulationModel& model);
+	void wake();
+	void enqueue(Client& client, const Message& message);
+	void ioLoop();
+	bool sendQueued(Client& client);
+
+
+public:
+	explicit TelemetryServer(const TelemetryConfig& config = TelemetryConfig()) : config(config) {}
+	~TelemetryServer();
+
+	bool start(const SocketEndpoint& endpoint);
+	void stop();
+	bool isRunning() const { return listenSocket >= 0; }
+
+	// call after every model update, never blocks on clients
+	void publish(const SimulationModel& model);
+
+	// what the last publish sent, a client that caught up holds exactly this
+	const TelemetryState& getPublishedState() const { return sent; }
+
+	size_t getClientCount();
+	uint64_t getDroppedClientCount() const { return droppedClients; }
+	uint64_t getBytesPublished() const { return bytesPublished; }
+};
@@ -0,0 +1,212 @@
+// python bindings over the simulation core, built with pybind11 against the same sources as the
+// application minus the window and renderers:
+//
+//   c++ -O2 -shared -std=c++17 -fPIC $(python3 -m pybind11 --includes) python/morecppModule.cpp
+//       core/*.cpp framework/simulationModel.cpp framework/stateColumns.cpp framework/vectorEnvironment.cpp
+//       navigation/*.cpp road/*.cpp traffic/*.cpp -o morecpp$(python3-config --extension-suffix)
+//
+// or python3 python/setup.py build_ext --inplace, then python3 python/smokeTest.py to check it
+//
+// state comes out as numpy arrays that view the C++ columns in place. the columns are sized once,
+// so a view stays valid for the life of its model or environment and shows the newest step
+//
+//   env = morecpp.VectorEnvironment(64, grid_width=4, grid_height=4)
+//   env.reset(seed=1)
+//   actions = np.full((64, env.junction_capacity), -1, dtype=np.int32)
+//   env.step(actions)
+//   env.queued_vehicles[:, :env.junction_counts.max()]
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "../framework/simulationModel.h"
+#include "../framework/stateColumns.h"
+#include "../framework/vectorEnvironment.h"
+#include "../road/trafficLightJunction.h"
+
+namespace py = pybind11;
+
+
+// read only numpy view of a column, kept alive through owner
+template <typename T>
+static py::array columnView(const std::vector<T>& column, std::vector<py::ssize_t> shape, py::handle owner) {
+	py::array_t<T> view(shape, column.data(), owner);
+	view.attr("setflags")(py::arg("write") = false);
+	return view;
+}
+
+
+// one model with its own columns, what SimulationModel is on the python side
+struct PythonModel {
+	SimulationModel model;
+	SignalIndex signals;
+	StateColumns columns;
+
+	PythonModel(uint64_t seed, size_t vehicleCapacity, size_t junctionCapacity) : columns(1, vehicleCapacity, junctionCapacity) {
+		model.setSeed(seed);
+	}
+
+	void gather() { columns.gather(0, model, signals); }
+
+	std::shared_ptr<TrafficLightJunction> getJunction(size_t index) {
+		const auto& junctions = signals.get(model.getGridNetwork());
+		if (index >= junctions.size()) throw py::index_error("no traffic light junction " + std::to_string(index));
+		return junctions[index];
+	}
+};
+
+
+// views of the vehicle columns, shaped as the caller asks
+static py::dict vehicleViews(const StateColumns& columns, std::vector<py::ssize_t> shape, py::handle owner) {
+	py::dict views;
+	views["id"] = columnView(columns.ids, shape, owner);
+	views["segment"] = columnView(columns.segments, shape, owner);
+	views["lane"] = columnView(columns.lanes, shape, owner);
+	views["direction"] = columnView(columns.directions, shape, owner);
+	views["distance"] = columnView(columns.distances, shape, owner);
+	views["speed"] = columnView(columns.speeds, shape, owner);
+	views["x"] = columnView(columns.x, shape, owner);
+	views["z"] = columnView(columns.z, shape, owner);
+	return views;
+}
+
+
+static py::dict junctionViews(const StateColumns& columns, std::vector<py::ssize_t> shape, py::handle owner) {
+	py::dict views;
+	views["phase"] = columnView(columns.phases, shape, owner);
+	views["phase_count"] = columnView(columns.phaseCounts, shape, owner);
+	views["phase_timer"] = columnView(columns.phaseTimers, shape, owner);
+	views["queued_vehicles"] = columnView(columns.queuedVehicles, shape, owner);
+	return views;
+}
+
+
+PYBIND11_MODULE(morecpp, module) {
+	module.doc() = "Traffic simulation core with batched environments for control experiments";
+
+	py::class_<PythonModel>(module, "SimulationModel")
+		.def(py::init<uint64_t, size_t, size_t>(), py::arg("seed") = 1, py::arg("vehicle_capacity") = 65536, py::arg("junction_capacity") = 1024)
+
+		.def("build_grid", [](PythonModel& self, int width, int height, int numLanes, float roadLength, float roadWidth, float speedLimit, bool twoWay, bool signalized) {
+			self.model.buildGridNetwork(width, height, numLanes, roadLength, roadWidth, speedLimit, twoWay, signalized);
+			self.gather();
+		}, py::arg("width"), py::arg("height"), py::arg("num_lanes") = 3, py::arg("road_length") = 400.0f, py::arg("road_width") = 32.0f,
+			py::arg("speed_limit") = 10.0f, py::arg("two_way") = true, py::arg("signalized") = true)
+
+		.def("build_custom", [](PythonModel& self) { self.model.buildCustomNetwork(); self.gather(); })
+		.def("build_highway", [](PythonModel& self) { self.model.buildHighwayCorridor(HighwayCorridorConfig()); self.gather(); })
+
+		// steps run without the GIL, the views are refreshed before it is taken back
+		.def("update", [](PythonModel& self, float deltaTime, int count) {
+			for (int i = 0; i < count; i++) self.model.update(deltaTime);
+			self.gather();
+		}, py::arg("delta_time"), py::arg("count") = 1, py::call_guard<py::gil_scoped_release>())
+
+		.def("step", [](PythonModel& self, int count) {
+			for (int i = 0; i < count; i++) self.model.step();
+			self.gather();
+		}, py::arg("count") = 1, py::call_guard<py::gil_scoped_release>())
+
+		.def_property_readonly("tick", [](const PythonModel& self) { return self.model.getTick(); })
+		.def_property_readonly("simulation_time", [](const PythonModel& self) { return self.model.getSimulationTime(); })
+		.def_property_readonly("vehicle_count", [](const PythonModel& self) { return self.columns.vehicleCounts[0]; })
+		.def_property_readonly("junction_count", [](const PythonModel& self) { return self.columns.junctionCounts[0]; })
+		.def("state_hash", [](const PythonModel& self) { return self.model.getGridNetwork().hashState(); })
+
+		// views over the whole capacity, the first vehicle_count / junction_count entries are live
+		.def("vehicles", [](py::object self) {
+			const StateColumns& columns = self.cast<PythonModel&>().columns;
+			return vehicleViews(columns, { static_cast<py::ssize_t>(columns.vehicleCapacity) }, self);
+		})
+		.def("junctions", [](py::object self) {
+			const StateColumns& columns = self.cast<PythonModel&>().columns;
+			return junctionViews(columns, { static_cast<py::ssize_t>(columns.junctionCapacity) }, self);
+		})
+
+		// traffic light junctions by index, in the order of the junction views
+		.def("junction_ids", [](PythonModel& self) {
+			std::vector<std::string> ids;
+			for (const auto& junction : self.signals.get(self.model.getGridNetwork())) ids.push_back(junction->getId());
+			return ids;
+		})
+		.def("set_phase", [](PythonModel& self, size_t junction, int phase) {
+			if (!self.getJunction(junction)->setPhase(phase)) throw py::value_error("no phase " + std::to_string(phase));
+		}, py::arg("junction"), py::arg("phase"))
+		.def("set_auto_advance", [](PythonModel& self, bool enabled) {
+			for (const auto& junction : self.signals.get(self.model.getGridNetwork())) junction->setAutoAdvance(enabled);
+		}, py::arg("enabled"));
+
+
+	py::class_<VectorEnvironment>(module, "VectorEnvironment")
+		.def(py::init([](size_t count, int gridWidth, int gridHeight, int numLanes, float deltaTime, int updatesPerStep,
+				bool externalSignalControl, size_t vehicleCapacity, size_t junctionCapacity, int threads) {
+			VectorEnvironmentConfig config;
+			config.gridWidth = gridWidth;
+			config.gridHeight = gridHeight;
+			config.numLanes = numLanes;
+			config.deltaTime = deltaTime;
+			config.updatesPerStep = updatesPerStep;
+			config.externalSignalControl = externalSignalControl;
+			config.vehicleCapacity = vehicleCapacity;
+			config.junctionCapacity = junctionCapacity;
+			config.threads = threads;
+			return std::make_unique<VectorEnvironment>(count, config);
+		}), py::arg("count"), py::arg("grid_width") = 4, py::arg("grid_height") = 4, py::arg("num_lanes") = 3, py::arg("delta_time") = 0.1f,
+			py::arg("updates_per_step") = 1, py::arg("external_signal_control") = true, py::arg("vehicle_capacity") = 8192,
+			py::arg("junction_capacity") = 256, py::arg("threads") = 0)
+
+		.def("reset", &VectorEnvironment::reset, py::arg("seed") = 1, py::call_guard<py::gil_scoped_release>())
+
+		// actions is count x junction_capacity phases, -1 leaves a junction alone
+		.def("step", [](VectorEnvironment& self, py::object actions) {
+			if (actions.is_none()) {
+				py::gil_scoped_release release;
+				self.step(nullptr);
+				return;
+			}
+
+			auto phases = py::array_t<int32_t, py::array::c_style | py::array::forcecast>::ensure(actions);
+			if (!phases || phases.ndim() != 2 || static_cast<size_t>(phases.shape(0)) != self.getCount()
+				|| static_cast<size_t>(phases.shape(1)) != self.getConfig().junctionCapacity) {
+				throw py::value_error("actions must be an int32 array of shape (count, junction_capacity)");
+			}
+
+			py::gil_scoped_release release;
+			self.step(phases.data());
+		}, py::arg("actions") = py::none())
+
+		.def_property_readonly("count", &VectorEnvironment::getCount)
+		.def_property_readonly("vehicle_capacity", [](const VectorEnvironment& self) { return self.getConfig().vehicleCapacity; })
+		.def_property_readonly("junction_capacity", [](const VectorEnvironment& self) { return self.getConfig().junctionCapacity; })
+
+		// count long views, and count x capacity views of every environment's columns
+		.def_property_readonly("ticks", [](py::object self) {
+			const StateColumns& columns = self.cast<VectorEnvironment&>().getColumns();
+			return columnView(columns.ticks, { static_cast<py::ssize_t>(columns.rows) }, self);
+		})
+		.def_property_readonly("vehicle_counts", [](py::object self) {
+			const StateColumns& columns = self.cast<VectorEnvironment&>().getColumns();
+			return columnView(columns.vehicleCounts, { static_cast<py::ssize_t>(columns.rows) }, self);
+		})
+		.def_property_readonly("junction_counts", [](py::object self) {
+			const StateColumns& columns = self.cast<VectorEnvironment&>().getColumns();
+			return columnView(columns.junctionCounts, { static_cast<py::ssize_t>(columns.rows) }, self);
+		})
+		.def_property_readonly("queued_vehicles", [](py::object self) {
+			const StateColumns& columns = self.cast<VectorEnvironment&>().getColumns();
+			return columnView(columns.queuedVehicles, { static_cast<py::ssize_t>(columns.rows), static_cast<py::ssize_t>(columns.junctionCapacity) }, self);
+		})
+		.def("vehicles", [](py::object self) {
+			const StateColumns& columns = self.cast<VectorEnvironment&>().getColumns();
+			return vehicleViews(columns, { static_cast<py::ssize_t>(columns.rows), static_cast<py::ssize_t>(columns.vehicleCapacity) }, self);
+		})
+		.def("junctions", [](py::object self) {
+			const StateColumns& columns = self.cast<VectorEnvironment&>().getColumns();
+			return junctionViews(columns, { static_cast<py::ssize_t>(columns.rows), static_cast<py::ssize_t>(columns.junctionCapacity) }, self);
+		});
+}
@@ -0,0 +1,41 @@
+# builds the morecpp extension from the simulation core, without the window and renderers
+#
+#   pip install pybind11 numpy
+#   python3 python/setup.py build_ext --inplace
+#   python3 python/smokeTest.py
+
+import glob
+import os
+import sys
+
+from setuptools import setup
+from pybind11.setup_helpers import Pybind11Extension
+
+
+root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def sources(*patterns):
+    return sorted(path for pattern in patterns for path in glob.glob(os.path.join(root, pattern)))
+
+
+extension = Pybind11Extension(
+    "morecpp",
+    sources(
+        "python/morecppModule.cpp",
+        "core/*.cpp",
+        "framework/simulationModel.cpp",
+        "framework/stateColumns.cpp",
+        "framework/vectorEnvironment.cpp",
+        "navigation/*.cpp",
+        "road/*.cpp",
+        "traffic/*.cpp",
+    ),
+    cxx_std=17,
+    extra_link_args=[] if sys.platform == "win32" else ["-pthread"],
+)
+
+
+# run from anywhere, the built module lands next to this file
+os.chdir(os.path.dirname(os.path.abspath(__file__)))
+setup(name="morecpp", version="0.1", ext_modules=[extension])
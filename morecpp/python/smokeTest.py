@@ -0,0 +1,83 @@
+# quick check of the bindings: build, step and read the views of a model and a batch of environments.
+# exits non zero on the first failure
+#
+#   python3 python/setup.py build_ext --inplace && python3 python/smokeTest.py
+
+import os
+import sys
+
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import morecpp
+
+
+def check(condition, message):
+    if not condition:
+        print("smoke test failed: " + message)
+        sys.exit(1)
+
+
+def replay_of(seed):
+    model = morecpp.SimulationModel(seed=seed)
+    model.build_grid(4, 4)
+    model.update(1.0 / 30.0, 600)
+    return model
+
+
+def check_model():
+    model = morecpp.SimulationModel(seed=1)
+    model.build_grid(4, 4)
+    check(model.junction_count > 0, "signalized grid has no traffic light junctions")
+    check(len(model.junction_ids()) == model.junction_count, "junction ids and views disagree")
+
+    # views are taken once and show the newest step
+    vehicles = model.vehicles()
+    junctions = model.junctions()
+    model.update(1.0 / 30.0, 600)
+
+    count = model.vehicle_count
+    check(model.tick == 600, "expected tick 600, got %d" % model.tick)
+    check(count > 0, "no vehicles after 600 ticks")
+
+    ids = vehicles["id"][:count]
+    check(len(np.unique(ids)) == count, "vehicle ids repeat")
+    check(np.all(vehicles["speed"][:count] >= 0.0), "negative speed")
+    check(np.all(vehicles["distance"][:count] >= 0.0), "negative distance")
+    check(np.all(junctions["phase"][:model.junction_count] < junctions["phase_count"][:model.junction_count]), "phase out of range")
+    check(not vehicles["x"].flags.writeable, "views must be read only")
+
+    model.set_auto_advance(False)
+    model.set_phase(0, 0)
+    model.step()
+    check(junctions["phase"][0] == 0, "set_phase did not hold")
+
+    # the same seed replays the same run
+    check(replay_of(1).state_hash() == replay_of(1).state_hash(), "runs from one seed differ")
+    print("model: %d vehicles over %d junctions after %d ticks" % (count, model.junction_count, model.tick))
+
+
+def check_environment():
+    environment = morecpp.VectorEnvironment(4, grid_width=3, grid_height=3)
+    environment.reset(seed=1)
+
+    actions = np.full((environment.count, environment.junction_capacity), -1, dtype=np.int32)
+    for _ in range(100):
+        environment.step(actions)
+
+    check(np.all(environment.ticks == environment.ticks[0]), "environments stepped unevenly")
+    check(environment.ticks[0] > 0, "environments did not step")
+    check(environment.queued_vehicles.shape == (environment.count, environment.junction_capacity), "queued view has the wrong shape")
+    check(environment.vehicles()["speed"].shape == (environment.count, environment.vehicle_capacity), "vehicle views have the wrong shape")
+
+    try:
+        environment.step(np.zeros((1, 1), dtype=np.int32))
+        check(False, "misshaped actions were accepted")
+    except ValueError:
+        pass
+    print("environment: %d environments at tick %d, %s vehicles" % (environment.count, environment.ticks[0], environment.vehicle_counts.tolist()))
+
+
+check_model()
+check_environment()
+print("smoke test passed")
@@ -0,0 +1,267 @@
+#include "frameWriter.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+
+
+// deflate streams are packed least significant bit first, huffman codes most significant first
+struct BitWriter {
+	std::vector<uint8_t>& out;
+	uint32_t buffer = 0;
+	int count = 0;
+
+	BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+	void write(uint32_t bits, int length) {
+		buffer |= bits << count;
+		count += length;
+		while (count >= 8) {
+			out.push_back(static_cast<uint8_t>(buffer & 0xff));
+			buffer >>= 8;
+			count -= 8;
+		}
+	}
+
+	void writeCode(uint32_t code, int length) {
+		uint32_t reversed = 0;
+		for (int i = 0; i < length; i++) {
+			reversed = (reversed << 1) | ((code >> i) & 1);
+		}
+		write(reversed, length);
+	}
+
+	void flush() {
+		if (count > 0) {
+			out.push_back(static_cast<uint8_t>(buffer & 0xff));
+		}
+		buffer = 0;
+		count = 0;
+	}
+};
+
+
+// fixed huffman table from the deflate spec
+static void writeSymbol(BitWriter& bits, int symbol) {
+	if (symbol < 144) bits.writeCode(0x30 + symbol, 8);
+	else if (symbol < 256) bits.writeCode(0x190 + symbol - 144, 9);
+	else if (symbol < 280) bits.writeCode(symbol - 256, 7);
+	else bits.writeCode(0xc0 + symbol - 280, 8);
+}
+
+
+static void writeLength(BitWriter& bits, int length) {
+	static const int base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const int extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+	int code = 28;
+	while (base[code] > length) code--;
+
+	writeSymbol(bits, 257 + code);
+	bits.write(length - base[code], extra[code]);
+}
+
+
+static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+	static uint32_t table[256];
+	static bool tableReady = [] {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; bit++) {
+				value = value & 1 ? 0xedb88320u ^ (value >> 1) : value >> 1;
+			}
+			table[i] = value;
+		}
+		return true;
+	}();
+	(void)tableReady;
+
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++) {
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+
+static void writeUint32(std::vector<uint8_t>& out, uint32_t value) {
+	out.push_back(static_cast<uint8_t>(value >> 24));
+	out.push_back(static_cast<uint8_t>(value >> 16));
+	out.push_back(static_cast<uint8_t>(value >> 8));
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+
+static void writeChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+	writeUint32(out, static_cast<uint32_t>(data.size()));
+
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+
+	writeUint32(out, crc32(&out[start], out.size() - start));
+}
+
+
+void FrameWriter::encodePng(const uint8_t* pixels, int width, int height, std::vector<uint8_t>& out) {
+	size_t stride = static_cast<size_t>(width) * 3;
+
+	// filter rows: "up" for a row identical to the one above, "sub" otherwise,
+	// so flat areas of the frame turn into long runs of zeros
+	std::vector<uint8_t> filtered;
+	filtered.reserve((stride + 1) * height);
+
+	for (int y = 0; y < height; y++) {
+		const uint8_t* row = pixels + y * stride;
+		bool sameAsAbove = y > 0 && std::equal(row, row + stride, row - stride);
+
+		filtered.push_back(sameAsAbove ? 2 : 1);
+		for (size_t x = 0; x < stride; x++) {
+			if (sameAsAbove) filtered.push_back(0);
+			else filtered.push_back(static_cast<uint8_t>(row[x] - (x >= 3 ? row[x - 3] : 0)));
+		}
+	}
+
+	// zlib stream with a single fixed huffman block, repeats become distance 1 matches
+	std::vector<uint8_t> compressed = { 0x78, 0x01 };
+	BitWriter bits(compressed);
+	bits.write(1, 1);
+	bits.write(1, 2);
+
+	size_t size = filtered.size();
+	size_t i = 0;
+	while (i < size) {
+		uint8_t value = filtered[i++];
+		writeSymbol(bits, value);
+
+		while (true) {
+			int run = 0;
+			while (run < 258 && i + run < size && filtered[i + run] == value) run++;
+			if (run < 3) break;
+
+			writeLength(bits, run);
+			bits.writeCode(0, 5);
+			i += run;
+		}
+	}
+	writeSymbol(bits, 256);
+	bits.flush();
+
+	uint32_t a = 1, b = 0;
+	for (uint8_t value : filtered) {
+		a = (a + value) % 65521;
+		b = (b + a) % 65521;
+	}
+	writeUint32(compressed, (b << 16) | a);
+
+	// png container
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a };
+	out.assign(signature, signature + 8);
+
+	std::vector<uint8_t> header;
+	writeUint32(header, static_cast<uint32_t>(width));
+	writeUint32(header, static_cast<uint32_t>(height));
+	header.insert(header.end(), { 8, 2, 0, 0, 0 });
+
+	writeChunk(out, "IHDR", header);
+	writeChunk(out, "IDAT", compressed);
+	writeChunk(out, "IEND", {});
+}
+
+
+FrameWriter::FrameWriter(const FrameExportConfig& config) : config(config) {
+	int threads = 1;
+
+	if (config.format == FrameFormat::RAW) {
+		std::string path = config.path + ".rgb";
+		rawFile.open(path, std::ios::binary);
+		if (!rawFile.is_open()) {
+			std::cerr << "Failed to open " << path << " for writing" << std::endl;
+			return;
+		}
+		std::cout << "Writing raw rgb24 " << config.width << "x" << config.height << " frames to " << path << std::endl;
+
+	} else {
+		threads = config.encoderThreads > 0 ? config.encoderThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	for (int i = 0; i < threads; i++) {
+		encoders.emplace_back(&FrameWriter::encoderLoop, this);
+	}
+}
+
+
+FrameWriter::~FrameWriter() {
+	close();
+}
+
+
+void FrameWriter::submit(const std::vector<uint8_t>& pixels) {
+	if (encoders.empty()) return;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	frameTaken.wait(lock, [this] { return queue.size() < std::max<size_t>(1, config.maxQueuedFrames); });
+
+	queue.push_back({ nextFrameNumber++, pixels });
+	frameQueued.notify_one();
+}
+
+
+void FrameWriter::close() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+	}
+	frameQueued.notify_all();
+
+	for (auto& encoder : encoders) {
+		if (encoder.joinable()) {
+			encoder.join();
+		}
+	}
+	encoders.clear();
+
+	if (rawFile.is_open()) {
+		rawFile.close();
+	}
+}
+
+
+void FrameWriter::encoderLoop() {
+	while (true) {
+		PendingFrame frame;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			frameQueued.wait(lock, [this] { return closing || !queue.empty(); });
+			if (queue.empty()) return;
+
+			frame = std::move(queue.front());
+			queue.pop_front();
+		}
+		frameTaken.notify_one();
+
+		writeFrame(frame);
+	}
+}
+
+
+void FrameWriter::writeFrame(const PendingFrame& frame) {
+	if (config.format == FrameFormat::RAW) {
+		rawFile.write(reinterpret_cast<const char*>(frame.pixels.data()), frame.pixels.size());
+		return;
+	}
+
+	char number[16];
+	std::snprintf(number, sizeof(number), "_%06d.png", frame.number);
+	std::string path = config.path + number;
+
+	std::vector<uint8_t> png;
+	encodePng(frame.pixels.data(), config.width, config.height, png);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cerr << "Failed to write frame " << path << std::endl;
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(png.data()), png.size());
+}
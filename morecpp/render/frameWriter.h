@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <cstdint>
+
+
+enum class FrameFormat {
+	PNG,
+	RAW
+};
+
+
+struct FrameExportConfig {
+	// png frames are written as <path>_000000.png, raw video as <path>.rgb
+	std::string path = "frame";
+	FrameFormat format = FrameFormat::PNG;
+	int width = 1920;
+	int height = 1080;
+
+	// 0 uses every hardware thread
+	int renderThreads = 0;
+	int encoderThreads = 0;
+
+	// frames waiting for an encoder before submit blocks the simulation
+	size_t maxQueuedFrames = 8;
+};
+
+
+// encodes and writes frames on background threads so rendering never waits on disk.
+// png frames are independent and encoded in parallel, raw video is written in order by one thread
+class FrameWriter {
+private:
+	struct PendingFrame {
+		int number;
+		std::vector<uint8_t> pixels;
+	};
+
+	FrameExportConfig config;
+	std::ofstream rawFile;
+
+	std::deque<PendingFrame> queue;
+	std::vector<std::thread> encoders;
+	std::mutex mutex;
+	std::condition_variable frameQueued;
+	std::condition_variable frameTaken;
+	bool closing = false;
+	int nextFrameNumber = 0;
+
+	void encoderLoop();
+	void writeFrame(const PendingFrame& frame);
+
+
+public:
+	FrameWriter(const FrameExportConfig& config);
+	~FrameWriter();
+
+	bool isOpen() const { return config.format != FrameFormat::RAW || rawFile.is_open(); }
+
+	// copies the rgb pixels (width * height * 3, top row first)
+	void submit(const std::vector<uint8_t>& pixels);
+
+	// waits for every queued frame to be written
+	void close();
+
+	int getFrameCount() const { return nextFrameNumber; }
+
+	// png with every row filtered and compressed with run length matches, no zlib needed
+	static void encodePng(const uint8_t* pixels, int width, int height, std::vector<uint8_t>& out);
+};
@@ -0,0 +1,99 @@
+#include "glRenderBackend.h"
+
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../shaders/shaderLoader.h"
+
+
+GLRenderBackend::GLRenderBackend() {
+    shaderProgram = ShaderLoader::loadShaders("shaders/default.vert", "shaders/default.frag");
+    modelLoc = glGetUniformLocation(shaderProgram, "model");
+    colorLoc = glGetUniformLocation(shaderProgram, "objectColor");
+
+    setupRectangleVerticies();
+}
+
+
+GLRenderBackend::~GLRenderBackend() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteProgram(shaderProgram);
+}
+
+
+void GLRenderBackend::setupRectangleVerticies() {
+    float vertices[] = {
+        0.5f, 0.0f,  0.5f,  // top right
+        0.5f, 0.0f, -0.5f,  // bottom right
+       -0.5f, 0.0f,  0.5f,  // top left
+
+        0.5f, 0.0f, -0.5f,  // bottom right
+       -0.5f, 0.0f, -0.5f,  // bottom left
+       -0.5f, 0.0f,  0.5f   // top left
+    };
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+
+glm::mat4 GLRenderBackend::getViewMatrix(const RenderView& view) {
+    return glm::lookAt(
+        glm::vec3(view.centerX, 100.0f, view.centerZ),
+        glm::vec3(view.centerX, 0.0f, view.centerZ),
+        glm::vec3(0.0f, 0.0f, -1.0f)
+    );
+}
+
+
+glm::mat4 GLRenderBackend::getProjectionMatrix(const RenderView& view) {
+    return glm::ortho(
+        view.left, view.right,
+        view.bottom, view.top,
+        0.1f, 200.0f
+    );
+}
+
+
+void GLRenderBackend::beginFrame(const RenderView& view) {
+    glUseProgram(shaderProgram);
+
+    glm::mat4 viewMatrix = getViewMatrix(view);
+    glm::mat4 projection = getProjectionMatrix(view);
+
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+
+    glBindVertexArray(VAO);
+}
+
+
+void GLRenderBackend::drawRect(const RenderRect& rect) {
+    // negated so local z lines up with the perpendicular of the direction
+    float angle = -std::atan2(rect.dirZ, rect.dirX);
+
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(rect.x, rect.height, rect.z));
+    model = glm::rotate(model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(rect.length, 1.0f, rect.width));
+
+    glm::vec3 color(rect.r, rect.g, rect.b);
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform3fv(colorLoc, 1, glm::value_ptr(color));
+
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+}
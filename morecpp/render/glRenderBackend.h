@@ -0,0 +1,30 @@
+#pragma once
+
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+#include "renderBackend.h"
+
+
+// draws each rectangle as a transformed unit quad, needs a current GL context
+class GLRenderBackend : public RenderBackend {
+private:
+	GLuint shaderProgram;
+	GLuint VAO, VBO;
+	GLint modelLoc, colorLoc;
+
+	void setupRectangleVerticies();
+
+
+public:
+	GLRenderBackend();
+	~GLRenderBackend();
+
+	void beginFrame(const RenderView& view) override;
+	void drawRect(const RenderRect& rect) override;
+	void endFrame() override { glBindVertexArray(0); }
+
+	// camera looking straight down at the view, shared with other GL passes
+	static glm::mat4 getViewMatrix(const RenderView& view);
+	static glm::mat4 getProjectionMatrix(const RenderView& view);
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+
+// oriented rectangle on the ground plane, everything the view draws is one of these
+struct RenderRect {
+	float x, z;
+	float dirX, dirZ;
+
+	// along and across the direction
+	float length, width;
+
+	// stacking order, higher rectangles cover lower ones (ties keep the first drawn)
+	float height;
+
+	float r, g, b;
+};
+
+
+// visible part of the ground plane, in the same terms as the view's orthographic camera.
+// screen right is +x and screen up is -z
+struct RenderView {
+	float centerX = 0.0f;
+	float centerZ = 0.0f;
+	float left = -120.0f;
+	float right = 120.0f;
+	float bottom = -60.0f;
+	float top = 60.0f;
+
+	float getMinX() const { return centerX + left; }
+	float getMaxX() const { return centerX + right; }
+	float getMinZ() const { return centerZ - top; }
+	float getMaxZ() const { return centerZ - bottom; }
+
+	// world units across the view per 200, as the view controller measures zoom
+	float getZoomLevel() const { return (right - left) / 200.0f; }
+
+	// point on the ground under a screen position given as 0 to 1 from the top left corner
+	float getWorldX(float screenX) const { return getMinX() + screenX * (right - left); }
+	float getWorldZ(float screenY) const { return getMinZ() + screenY * (top - bottom); }
+};
+
+
+class RenderBackend {
+public:
+	virtual ~RenderBackend() = default;
+
+	virtual void beginFrame(const RenderView& view) = 0;
+	virtual void drawRect(const RenderRect& rect) = 0;
+	virtual void endFrame() = 0;
+};
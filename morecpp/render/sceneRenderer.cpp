@@ -0,0 +1,408 @@
+#include "sceneRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "../traffic/vehicle.h"
+
+
+void SceneRenderer::render(const SimulationModel& model, const RenderView& frameView, RenderBackend& backend) {
+	AllocationScope allocations(AllocationSubsystem::RENDER);
+
+	view = frameView;
+	updateDetail();
+
+	const RoadNetwork& roadNetwork = model.getGridNetwork();
+	const CompiledNetwork& compiled = roadNetwork.getCompiledNetwork();
+	if (!indexValid || network != &compiled || indexRevision != compiled.getRevision()) {
+		rebuildIndex(compiled);
+	}
+	if (gridColumns == 0) {
+		return;
+	}
+
+	// visible cells only, the zoom limit keeps their number bounded however large the network is
+	int minColumn = std::max(0, static_cast<int>(std::floor((view.getMinX() - gridMinX) / cellSize)));
+	int maxColumn = std::min(gridColumns - 1, static_cast<int>(std::floor((view.getMaxX() - gridMinX) / cellSize)));
+	int minRow = std::max(0, static_cast<int>(std::floor((view.getMinZ() - gridMinZ) / cellSize)));
+	int maxRow = std::min(gridRows - 1, static_cast<int>(std::floor((view.getMaxZ() - gridMinZ) / cellSize)));
+
+	const auto& traffic = roadNetwork.getSegmentTraffic();
+	visitStamp++;
+
+	for (int row = minRow; row <= maxRow; row++) {
+		for (int column = minColumn; column <= maxColumn; column++) {
+			for (uint32_t index : roadCells[row * gridColumns + column]) {
+				if (roadVisited[index] == visitStamp) continue;
+				roadVisited[index] = visitStamp;
+
+				if (detail == RenderDetail::OVERVIEW) {
+					renderRoadOverview(index, traffic, backend);
+				} else {
+					renderRoadSegment(index, backend);
+				}
+			}
+		}
+	}
+
+	if (detail == RenderDetail::OVERVIEW) {
+		return;
+	}
+
+	// junctions sit in the cell of their centre
+	for (int row = std::max(0, minRow - 1); row <= std::min(gridRows - 1, maxRow + 1); row++) {
+		for (int column = std::max(0, minColumn - 1); column <= std::min(gridColumns - 1, maxColumn + 1); column++) {
+			for (uint32_t index : junctionCells[row * gridColumns + column]) {
+				renderJunction(index, backend);
+			}
+		}
+	}
+}
+
+
+void SceneRenderer::updateDetail() {
+	float zoomLevel = view.getZoomLevel();
+
+	switch (detail) {
+	case RenderDetail::FULL:
+		if (zoomLevel > overviewZoomOut) detail = RenderDetail::OVERVIEW;
+		else if (zoomLevel > surfacesZoomOut) detail = RenderDetail::SURFACES;
+		break;
+
+	case RenderDetail::SURFACES:
+		if (zoomLevel > overviewZoomOut) detail = RenderDetail::OVERVIEW;
+		else if (zoomLevel < surfacesZoomIn) detail = RenderDetail::FULL;
+		break;
+
+	case RenderDetail::OVERVIEW:
+		if (zoomLevel < surfacesZoomIn) detail = RenderDetail::FULL;
+		else if (zoomLevel < overviewZoomIn) detail = RenderDetail::SURFACES;
+		break;
+	}
+}
+
+
+void SceneRenderer::rebuildIndex(const CompiledNetwork& compiled) {
+	network = &compiled;
+	indexRevision = compiled.getRevision();
+	indexValid = true;
+
+	const auto& segments = compiled.getSegments();
+	size_t junctionCount = compiled.isCompiled() ? compiled.getJunctions().size() : 0;
+
+	roadCells.clear();
+	junctionCells.clear();
+	roadVisited.assign(segments.size(), 0);
+	visitStamp = 0;
+	gridColumns = 0;
+	gridRows = 0;
+
+	if (junctionCount == 0) {
+		return;
+	}
+
+	// roads end at junctions, so the junctions bound the whole network
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxZ = std::numeric_limits<float>::lowest();
+	gridMinX = std::numeric_limits<float>::max();
+	gridMinZ = std::numeric_limits<float>::max();
+	for (uint32_t i = 0; i < junctionCount; i++) {
+		const Vector3& position = compiled.getJunctionPosition(i);
+		gridMinX = std::min(gridMinX, position.x);
+		gridMinZ = std::min(gridMinZ, position.z);
+		maxX = std::max(maxX, position.x);
+		maxZ = std::max(maxZ, position.z);
+	}
+
+	gridColumns = static_cast<int>((maxX - gridMinX) / cellSize) + 1;
+	gridRows = static_cast<int>((maxZ - gridMinZ) / cellSize) + 1;
+	roadCells.resize(static_cast<size_t>(gridColumns) * gridRows);
+	junctionCells.resize(static_cast<size_t>(gridColumns) * gridRows);
+
+	auto cellColumn = [&](float x) { return std::min(gridColumns - 1, std::max(0, static_cast<int>((x - gridMinX) / cellSize))); };
+	auto cellRow = [&](float z) { return std::min(gridRows - 1, std::max(0, static_cast<int>((z - gridMinZ) / cellSize))); };
+
+	for (uint32_t i = 0; i < junctionCount; i++) {
+		const Vector3& position = compiled.getJunctionPosition(i);
+		junctionCells[cellRow(position.z) * gridColumns + cellColumn(position.x)].push_back(i);
+	}
+
+	for (uint32_t i = 0; i < segments.size(); i++) {
+		int start = compiled.getSegmentStart(i);
+		int end = compiled.getSegmentEnd(i);
+		if (start < 0 || end < 0) continue;
+
+		// every cell the road's bounds touch, widened by the road so edges are not culled early
+		float margin = segments[i]->getDimensions().z;
+		const Vector3& a = compiled.getJunctionPosition(start);
+		const Vector3& b = compiled.getJunctionPosition(end);
+		for (int row = cellRow(std::min(a.z, b.z) - margin); row <= cellRow(std::max(a.z, b.z) + margin); row++) {
+			for (int column = cellColumn(std::min(a.x, b.x) - margin); column <= cellColumn(std::max(a.x, b.x) + margin); column++) {
+				roadCells[row * gridColumns + column].push_back(i);
+			}
+		}
+	}
+}
+
+
+RenderView SceneRenderer::fitView(const SimulationModel& model, float aspect) {
+	float minX = std::numeric_limits<float>::max();
+	float minZ = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxZ = std::numeric_limits<float>::lowest();
+
+	for (const auto& junction : model.getAllJunctions()) {
+		const Vector3& position = junction->getPosition();
+		float radius = junction->getRadius();
+		minX = std::min(minX, position.x - radius);
+		minZ = std::min(minZ, position.z - radius);
+		maxX = std::max(maxX, position.x + radius);
+		maxZ = std::max(maxZ, position.z + radius);
+	}
+
+	RenderView fitted;
+	if (minX > maxX) {
+		return fitted;
+	}
+
+	// pad the network and widen whichever side is short of the aspect ratio
+	float halfWidth = (maxX - minX) / 2.0f * 1.05f + 10.0f;
+	float halfHeight = (maxZ - minZ) / 2.0f * 1.05f + 10.0f;
+	if (halfWidth / halfHeight < aspect) {
+		halfWidth = halfHeight * aspect;
+	} else {
+		halfHeight = halfWidth / aspect;
+	}
+
+	fitted.centerX = (minX + maxX) / 2.0f;
+	fitted.centerZ = (minZ + maxZ) / 2.0f;
+	fitted.left = -halfWidth;
+	fitted.right = halfWidth;
+	fitted.bottom = -halfHeight;
+	fitted.top = halfHeight;
+	return fitted;
+}
+
+
+bool SceneRenderer::isVisible(float minX, float minZ, float maxX, float maxZ) const {
+	return maxX >= view.getMinX() && minX <= view.getMaxX() && maxZ >= view.getMinZ() && minZ <= view.getMaxZ();
+}
+
+
+void SceneRenderer::renderJunction(uint32_t slot, RenderBackend& backend) {
+	const Vector3& junctionPos = network->getJunctionPosition(slot);
+	float radius = network->getJunctionRadius(slot);
+
+	if (!isVisible(junctionPos.x - radius, junctionPos.z - radius, junctionPos.x + radius, junctionPos.z + radius)) {
+		return;
+	}
+
+	// color for traffic light
+	const TrafficLightJunction* trafficJunction = dynamic_cast<const TrafficLightJunction*>(network->getJunction(slot));
+	float shade = trafficJunction ? 0.5f : 0.4f;
+	float blue = trafficJunction ? 0.6f : 0.4f;
+
+	backend.drawRect({ junctionPos.x, junctionPos.z, 1.0f, 0.0f, radius * 2, radius * 2, 0.01f, shade, shade, blue });
+
+	// render traffic lights
+	if (trafficJunction && detail == RenderDetail::FULL) {
+		renderTrafficLights(*trafficJunction, backend);
+	}
+}
+
+
+void SceneRenderer::renderTrafficLights(const TrafficLightJunction& junction, RenderBackend& backend) {
+	junction.forEachConnectedRoad([&](const std::shared_ptr<RoadSegment>& road) {
+		Vector3 entryPoint = junction.getEntryPoint(road);
+
+		float r = 0.0f, g = 0.0f;
+		switch (junction.getLightState(road)) {
+		case LightState::GREEN:
+			g = 1.0f;
+			break;
+		case LightState::YELLOW:
+			r = 1.0f;
+			g = 1.0f;
+			break;
+		case LightState::RED:
+			r = 1.0f;
+			break;
+		}
+
+		backend.drawRect({ entryPoint.x, entryPoint.z, 1.0f, 0.0f, 2.0f, 2.0f, 0.5f, r, g, 0.0f });
+	});
+}
+
+
+void SceneRenderer::renderRoadSegment(uint32_t slot, RenderBackend& backend) {
+	float zoomFactor = (view.right - view.left) / 240.0f;
+	float minLineWidth = 0.5f * zoomFactor;
+
+	const RoadSegment& road = *network->getSegments()[slot];
+	int startJunction = network->getSegmentStart(slot);
+	int endJunction = network->getSegmentEnd(slot);
+
+	// return if no start or end junction
+	if (startJunction < 0 || endJunction < 0) {
+		return;
+	}
+
+	const Vector3& startPos = network->getJunctionPosition(startJunction);
+	const Vector3& endPos = network->getJunctionPosition(endJunction);
+	float roadWidth = road.getDimensions().z;
+
+	if (!isVisible(std::min(startPos.x, endPos.x) - roadWidth, std::min(startPos.z, endPos.z) - roadWidth,
+		std::max(startPos.x, endPos.x) + roadWidth, std::max(startPos.z, endPos.z) + roadWidth)) {
+		return;
+	}
+
+	// trim the road back to the junction edges
+	Vector3 roadDir = (endPos - startPos).normalized();
+	Vector3 adjustedStartPos = startPos + roadDir * network->getJunctionRadius(startJunction);
+	Vector3 adjustedEndPos = endPos - roadDir * network->getJunctionRadius(startJunction);
+	float adjustedLength = (adjustedEndPos - adjustedStartPos).length();
+
+	if (adjustedLength <= 0.001f) {
+		return;
+	}
+
+	float centerX = (adjustedStartPos.x + adjustedEndPos.x) / 2.0f;
+	float centerZ = (adjustedStartPos.z + adjustedEndPos.z) / 2.0f;
+	float perpX = -roadDir.z;
+	float perpZ = roadDir.x;
+
+	backend.drawRect({ centerX, centerZ, roadDir.x, roadDir.z, adjustedLength, roadWidth, 0.01f, 0.3f, 0.3f, 0.3f });
+
+	// collect lane markings of both directions (reverse offsets are mirrored)
+	markings.clear();
+	for (TravelDirection direction : { TravelDirection::FORWARD, TravelDirection::REVERSE }) {
+		Span<const LaneType> lanes = network->getLaneTypes(CompiledNetwork::toNode(road.getIndex(), direction));
+		if (lanes.empty()) continue;
+
+		const LaneInterval& layout = road.getLaneProfile(direction).at(0.0f);
+		float side = direction == TravelDirection::FORWARD ? 1.0f : -1.0f;
+
+		for (size_t i = 1; i < lanes.size(); i++) {
+			bool isShoulderBoundary = (lanes[i - 1] != lanes[i]);
+			float lanePosition = side * (layout.getLaneOffset(static_cast<int>(i)) - layout.laneWidth / 2.0f);
+			markings.push_back({ lanePosition, isShoulderBoundary, 1.0f, 1.0f, 1.0f });
+		}
+	}
+
+	// centre line between opposing lane groups
+	if (road.isBidirectional()) {
+		const LaneInterval& layout = road.getLaneProfile().at(0.0f);
+		markings.push_back({ layout.firstLaneOffset - layout.laneWidth / 2.0f, true, 0.9f, 0.8f, 0.1f });
+	}
+
+	// markings are below a pixel once zoomed out
+	if (detail != RenderDetail::FULL) {
+		markings.clear();
+	}
+
+	for (const auto& marking : markings) {
+		float lineX = centerX + perpX * marking.position;
+		float lineZ = centerZ + perpZ * marking.position;
+
+		if (marking.solid) {
+			// solid line (shoulder)
+			float width = std::max(0.2f, minLineWidth);
+			backend.drawRect({ lineX, lineZ, roadDir.x, roadDir.z, adjustedLength, width, 0.05f, marking.r, marking.g, marking.b });
+
+		} else {
+			// dashed line (regular)
+			float dashLength = 3.0f;
+			float gapLength = 7.0f;
+			float spacing = dashLength + gapLength;
+			float width = std::max(0.5f, minLineWidth);
+
+			int dashCount = static_cast<int>(adjustedLength / spacing) + 1;
+			for (int dashIdx = 0; dashIdx < dashCount; dashIdx++) {
+				float dashOffset = -adjustedLength / 2 + dashIdx * spacing + dashLength / 2;
+				backend.drawRect({ lineX + roadDir.x * dashOffset, lineZ + roadDir.z * dashOffset, roadDir.x, roadDir.z,
+					dashLength, width, 0.05f, marking.r, marking.g, marking.b });
+			}
+		}
+	}
+
+	// draw vehicles
+	for (const auto& vehicle : road.getVehicles()) {
+		if (vehicle) {
+			renderVehicle(*vehicle, backend);
+		}
+	}
+}
+
+
+void SceneRenderer::renderVehicle(const Vehicle& vehicle, RenderBackend& backend) {
+	// position is already resolved against the lane profile during the update
+	const Vector3& vehiclePos = vehicle.getPosition();
+	const Vector3& vehicleDim = vehicle.getDimensions();
+	const Color& vehicleColor = vehicle.getColor();
+
+	Vector3 heading = vehicle.getCurrentRoad() ? vehicle.getCurrentRoad()->getTravelVector(vehicle.getTravelDirection()) : Vector3(1.0f, 0.0f, 0.0f);
+
+	backend.drawRect({ vehiclePos.x, vehiclePos.z, heading.x, heading.z, vehicleDim.x, vehicleDim.z, 0.02f,
+		vehicleColor.r / 255.0f, vehicleColor.g / 255.0f, vehicleColor.b / 255.0f });
+}
+
+
+void SceneRenderer::renderRoadOverview(uint32_t slot, const std::vector<SegmentTraffic>& traffic, RenderBackend& backend) {
+	float zoomFactor = (view.right - view.left) / 240.0f;
+
+	const RoadSegment& road = *network->getSegments()[slot];
+	int startJunction = network->getSegmentStart(slot);
+	int endJunction = network->getSegmentEnd(slot);
+	if (startJunction < 0 || endJunction < 0) {
+		return;
+	}
+
+	const Vector3& startPos = network->getJunctionPosition(startJunction);
+	const Vector3& endPos = network->getJunctionPosition(endJunction);
+	float roadWidth = road.getDimensions().z;
+
+	if (!isVisible(std::min(startPos.x, endPos.x) - roadWidth, std::min(startPos.z, endPos.z) - roadWidth,
+		std::max(startPos.x, endPos.x) + roadWidth, std::max(startPos.z, endPos.z) + roadWidth)) {
+		return;
+	}
+
+	Vector3 roadDir = endPos - startPos;
+	float length = roadDir.length();
+	if (length <= 0.001f) {
+		return;
+	}
+	roadDir = roadDir * (1.0f / length);
+
+	// centre line, kept at least a pixel or so wide
+	float lineWidth = std::max(roadWidth * 0.25f, 0.3f * zoomFactor);
+	backend.drawRect({ (startPos.x + endPos.x) / 2.0f, (startPos.z + endPos.z) / 2.0f, roadDir.x, roadDir.z,
+		length, lineWidth, 0.01f, 0.45f, 0.45f, 0.45f });
+
+	// traffic bar from the start of the segment, its length the density and its colour the heatmap ramp,
+	// so the cost stays one rectangle per segment however many vehicles are on it
+	int index = road.getIndex();
+	if (index < 0 || index >= static_cast<int>(traffic.size())) {
+		return;
+	}
+
+	float density = std::min(1.0f, std::max(0.0f, traffic[index].density));
+	float heat = std::min(1.0f, std::max(density, 1.0f - traffic[index].speedRatio));
+	if (density <= 0.0f) {
+		return;
+	}
+
+	// same green, yellow, red ramp as the heatmap shader
+	static const float green[3] = { 0.1f, 0.8f, 0.2f };
+	static const float yellow[3] = { 0.95f, 0.85f, 0.1f };
+	static const float red[3] = { 0.9f, 0.1f, 0.1f };
+	const float* from = heat < 0.5f ? green : yellow;
+	const float* to = heat < 0.5f ? yellow : red;
+	float t = heat < 0.5f ? heat * 2.0f : heat * 2.0f - 1.0f;
+
+	float barLength = length * density;
+	backend.drawRect({ startPos.x + roadDir.x * barLength / 2.0f, startPos.z + roadDir.z * barLength / 2.0f, roadDir.x, roadDir.z,
+		barLength, std::max(lineWidth, 0.6f * zoomFactor), 0.02f,
+		from[0] + (to[0] - from[0]) * t, from[1] + (to[1] - from[1]) * t, from[2] + (to[2] - from[2]) * t });
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "renderBackend.h"
+#include "../framework/simulationModel.h"
+#include "../road/trafficLightJunction.h"
+
+
+// how much of the scene is drawn, picked from the zoom level
+enum class RenderDetail {
+	FULL,		// surfaces, markings, lights and vehicles
+	SURFACES,	// surfaces and vehicles
+	OVERVIEW	// centre lines and per segment traffic bars
+};
+
+
+// turns the simulation into rectangles for any render backend
+class SceneRenderer {
+private:
+	RenderView view;
+	RenderDetail detail = RenderDetail::FULL;
+
+	// zoom levels where detail drops, and the lower ones where it comes back,
+	// so a view sitting on a boundary does not flicker between tiers
+	static constexpr float surfacesZoomOut = 5.0f;
+	static constexpr float surfacesZoomIn = 4.0f;
+	static constexpr float overviewZoomOut = 12.0f;
+	static constexpr float overviewZoomIn = 10.0f;
+
+	// the network's compiled arrays, cells hold their segment and junction slots
+	const CompiledNetwork* network = nullptr;
+
+	// uniform grid over the network so a frame only visits what is on screen,
+	// rebuilt when the network is compiled again
+	static constexpr float cellSize = 500.0f;
+	std::vector<std::vector<uint32_t>> roadCells;
+	std::vector<std::vector<uint32_t>> junctionCells;
+	float gridMinX = 0.0f, gridMinZ = 0.0f;
+	int gridColumns = 0, gridRows = 0;
+	uint32_t indexRevision = 0;
+	bool indexValid = false;
+
+	// roads spanning several cells are drawn once per frame
+	std::vector<uint32_t> roadVisited;
+	uint32_t visitStamp = 0;
+
+	// lane markings of the road being drawn, kept between roads so frames do not allocate
+	struct LaneMarking {
+		float position;
+		bool solid;
+		float r, g, b;
+	};
+	std::vector<LaneMarking> markings;
+
+	void rebuildIndex(const CompiledNetwork& compiled);
+	void updateDetail();
+	bool isVisible(float minX, float minZ, float maxX, float maxZ) const;
+
+	// by slot in the compiled network
+	void renderRoadSegment(uint32_t slot, RenderBackend& backend);
+	void renderRoadOverview(uint32_t slot, const std::vector<SegmentTraffic>& traffic, RenderBackend& backend);
+	void renderJunction(uint32_t slot, RenderBackend& backend);
+	void renderTrafficLights(const TrafficLightJunction& junction, RenderBackend& backend);
+	void renderVehicle(const Vehicle& vehicle, RenderBackend& backend);
+
+
+public:
+	// draws one frame, beginFrame and endFrame are left to the caller
+	void render(const SimulationModel& model, const RenderView& frameView, RenderBackend& backend);
+
+	RenderDetail getDetail() const { return detail; }
+
+	// view covering the whole network at the given width / height ratio
+	static RenderView fitView(const SimulationModel& model, float aspect);
+};
@@ -0,0 +1,234 @@
+#include "softwareRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, int threads)
+	:	width(std::max(1, width)),
+		height(std::max(1, height)),
+		clearColor{ 26, 26, 26 },
+		pixelsPerUnitX(1.0f),
+		pixelsPerUnitY(1.0f),
+		nextTile(0) {
+	tilesX = (this->width + tileSize - 1) / tileSize;
+	tilesY = (this->height + tileSize - 1) / tileSize;
+	colorBuffer.resize(static_cast<size_t>(this->width) * this->height * 3);
+	depthBuffer.resize(static_cast<size_t>(this->width) * this->height);
+	tileBins.resize(tilesX * tilesY);
+
+	if (threads <= 0) {
+		threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	// the calling thread rasterizes as well
+	for (int i = 1; i < threads; i++) {
+		workers.emplace_back(&SoftwareRasterizer::workerLoop, this);
+	}
+}
+
+
+SoftwareRasterizer::~SoftwareRasterizer() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	frameReady.notify_all();
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+
+void SoftwareRasterizer::setClearColor(float r, float g, float b) {
+	clearColor[0] = static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, r)) * 255.0f + 0.5f);
+	clearColor[1] = static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, g)) * 255.0f + 0.5f);
+	clearColor[2] = static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, b)) * 255.0f + 0.5f);
+}
+
+
+void SoftwareRasterizer::beginFrame(const RenderView& frameView) {
+	view = frameView;
+	pixelsPerUnitX = width / std::max(0.001f, view.right - view.left);
+	pixelsPerUnitY = height / std::max(0.001f, view.top - view.bottom);
+
+	rects.clear();
+	for (auto& bin : tileBins) {
+		bin.clear();
+	}
+}
+
+
+void SoftwareRasterizer::drawRect(const RenderRect& rect) {
+	float halfLength = rect.length / 2.0f;
+	float halfWidth = rect.width / 2.0f;
+	float perpX = -rect.dirZ;
+	float perpZ = rect.dirX;
+
+	// corners in order around the rectangle
+	const float along[4] = { halfLength, halfLength, -halfLength, -halfLength };
+	const float across[4] = { halfWidth, -halfWidth, -halfWidth, halfWidth };
+
+	ScreenRect screen;
+	float minX = std::numeric_limits<float>::max(), maxX = std::numeric_limits<float>::lowest();
+	float minY = std::numeric_limits<float>::max(), maxY = std::numeric_limits<float>::lowest();
+
+	for (int i = 0; i < 4; i++) {
+		float worldX = rect.x + rect.dirX * along[i] + perpX * across[i];
+		float worldZ = rect.z + rect.dirZ * along[i] + perpZ * across[i];
+
+		// screen right is +x, screen down is +z
+		screen.cornerX[i] = (worldX - view.getMinX()) * pixelsPerUnitX;
+		screen.cornerY[i] = (worldZ - view.getMinZ()) * pixelsPerUnitY;
+
+		minX = std::min(minX, screen.cornerX[i]);
+		maxX = std::max(maxX, screen.cornerX[i]);
+		minY = std::min(minY, screen.cornerY[i]);
+		maxY = std::max(maxY, screen.cornerY[i]);
+	}
+
+	// pixels are sampled at their centres
+	screen.minX = std::max(0, static_cast<int>(std::ceil(minX - 0.5f)));
+	screen.minY = std::max(0, static_cast<int>(std::ceil(minY - 0.5f)));
+	screen.maxX = std::min(width - 1, static_cast<int>(std::floor(maxX - 0.5f)));
+	screen.maxY = std::min(height - 1, static_cast<int>(std::floor(maxY - 0.5f)));
+	if (screen.minX > screen.maxX || screen.minY > screen.maxY) {
+		return;
+	}
+
+	screen.height = rect.height;
+	screen.color[0] = static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, rect.r)) * 255.0f + 0.5f);
+	screen.color[1] = static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, rect.g)) * 255.0f + 0.5f);
+	screen.color[2] = static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, rect.b)) * 255.0f + 0.5f);
+
+	uint32_t index = static_cast<uint32_t>(rects.size());
+	rects.push_back(screen);
+
+	// bins keep submission order, which decides ties in height
+	for (int tileY = screen.minY / tileSize; tileY <= screen.maxY / tileSize; tileY++) {
+		for (int tileX = screen.minX / tileSize; tileX <= screen.maxX / tileSize; tileX++) {
+			tileBins[tileY * tilesX + tileX].push_back(index);
+		}
+	}
+}
+
+
+void SoftwareRasterizer::endFrame() {
+	rasterizeTiles();
+}
+
+
+void SoftwareRasterizer::rasterizeTiles() {
+	nextTile = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		frameNumber++;
+		busyWorkers = static_cast<int>(workers.size());
+	}
+	frameReady.notify_all();
+
+	int tileCount = tilesX * tilesY;
+	for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+		rasterizeTile(tile);
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	frameDone.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+
+void SoftwareRasterizer::workerLoop() {
+	uint64_t seenFrame = 0;
+	int tileCount = tilesX * tilesY;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			frameReady.wait(lock, [&] { return stopping || frameNumber != seenFrame; });
+			if (stopping) return;
+			seenFrame = frameNumber;
+		}
+
+		for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+			rasterizeTile(tile);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busyWorkers == 0) {
+			frameDone.notify_one();
+		}
+	}
+}
+
+
+void SoftwareRasterizer::rasterizeTile(int tile) {
+	int tileMinX = (tile % tilesX) * tileSize;
+	int tileMinY = (tile / tilesX) * tileSize;
+	int tileMaxX = std::min(width, tileMinX + tileSize) - 1;
+	int tileMaxY = std::min(height, tileMinY + tileSize) - 1;
+
+	// clear
+	for (int y = tileMinY; y <= tileMaxY; y++) {
+		size_t row = static_cast<size_t>(y) * width;
+		for (int x = tileMinX; x <= tileMaxX; x++) {
+			uint8_t* pixel = &colorBuffer[(row + x) * 3];
+			pixel[0] = clearColor[0];
+			pixel[1] = clearColor[1];
+			pixel[2] = clearColor[2];
+			depthBuffer[row + x] = std::numeric_limits<float>::lowest();
+		}
+	}
+
+	for (uint32_t index : tileBins[tile]) {
+		const ScreenRect& rect = rects[index];
+
+		int minX = std::max(rect.minX, tileMinX);
+		int maxX = std::min(rect.maxX, tileMaxX);
+		int minY = std::max(rect.minY, tileMinY);
+		int maxY = std::min(rect.maxY, tileMaxY);
+
+		// edge functions, flipped so the inside is positive whatever the winding
+		float edgeA[4], edgeB[4], edgeC[4];
+		float area = 0.0f;
+		for (int i = 0; i < 4; i++) {
+			int j = (i + 1) % 4;
+			area += rect.cornerX[i] * rect.cornerY[j] - rect.cornerX[j] * rect.cornerY[i];
+		}
+		float sign = area < 0.0f ? -1.0f : 1.0f;
+
+		for (int i = 0; i < 4; i++) {
+			int j = (i + 1) % 4;
+			edgeA[i] = sign * (rect.cornerY[i] - rect.cornerY[j]);
+			edgeB[i] = sign * (rect.cornerX[j] - rect.cornerX[i]);
+			edgeC[i] = sign * (rect.cornerX[i] * rect.cornerY[j] - rect.cornerX[j] * rect.cornerY[i]);
+		}
+
+		for (int y = minY; y <= maxY; y++) {
+			float sampleY = y + 0.5f;
+			float sampleX = minX + 0.5f;
+
+			// step the edge functions along the row
+			float edge[4];
+			for (int i = 0; i < 4; i++) {
+				edge[i] = edgeA[i] * sampleX + edgeB[i] * sampleY + edgeC[i];
+			}
+
+			size_t row = static_cast<size_t>(y) * width;
+			for (int x = minX; x <= maxX; x++) {
+				if (edge[0] >= 0.0f && edge[1] >= 0.0f && edge[2] >= 0.0f && edge[3] >= 0.0f && rect.height > depthBuffer[row + x]) {
+					depthBuffer[row + x] = rect.height;
+					uint8_t* pixel = &colorBuffer[(row + x) * 3];
+					pixel[0] = rect.color[0];
+					pixel[1] = rect.color[1];
+					pixel[2] = rect.color[2];
+				}
+
+				for (int i = 0; i < 4; i++) {
+					edge[i] += edgeA[i];
+				}
+			}
+		}
+	}
+}
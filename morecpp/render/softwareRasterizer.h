@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+
+#include "renderBackend.h"
+
+
+// cpu backend for machines without a gpu. rectangles are collected during the frame,
+// binned into screen tiles and rasterized tile by tile on a pool of worker threads,
+// so no two threads ever touch the same pixel
+class SoftwareRasterizer : public RenderBackend {
+private:
+	// rectangle in pixel space, four corners in winding order
+	struct ScreenRect {
+		float cornerX[4];
+		float cornerY[4];
+		int minX, minY, maxX, maxY;
+		float height;
+		uint8_t color[3];
+	};
+
+	static constexpr int tileSize = 64;
+
+	int width, height;
+	int tilesX, tilesY;
+	std::vector<uint8_t> colorBuffer;
+	std::vector<float> depthBuffer;
+	uint8_t clearColor[3];
+
+	RenderView view;
+	float pixelsPerUnitX, pixelsPerUnitY;
+
+	std::vector<ScreenRect> rects;
+	std::vector<std::vector<uint32_t>> tileBins;
+
+	// workers wait for a new frame number, then claim tiles until none are left
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable frameReady;
+	std::condition_variable frameDone;
+	uint64_t frameNumber = 0;
+	int busyWorkers = 0;
+	bool stopping = false;
+	std::atomic<int> nextTile;
+
+	void workerLoop();
+	void rasterizeTiles();
+	void rasterizeTile(int tile);
+
+
+public:
+	// threads 0 uses every hardware thread
+	SoftwareRasterizer(int width, int height, int threads = 0);
+	~SoftwareRasterizer();
+
+	void setClearColor(float r, float g, float b);
+
+	void beginFrame(const RenderView& frameView) override;
+	void drawRect(const RenderRect& rect) override;
+	void endFrame() override;
+
+	// tightly packed rgb rows, top row first
+	const std::vector<uint8_t>& getPixels() const { return colorBuffer; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+};
@@ -0,0 +1,153 @@
+#include "telemetryRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "../road/trafficLightJunction.h"
+
+
+bool TelemetryRenderer::isVisible(float minX, float minZ, float maxX, float maxZ) const {
+	return maxX >= view.getMinX() && minX <= view.getMaxX() && maxZ >= view.getMinZ() && minZ <= view.getMaxZ();
+}
+
+
+void TelemetryRenderer::render(const TelemetryState& state, const RenderView& frameView, RenderBackend& backend) {
+	view = frameView;
+	if (!state.hasNetwork) return;
+
+	for (const auto& road : state.roads) {
+		renderRoad(road, backend);
+	}
+
+	// signals are listed junction by junction in the same order as the junctions
+	size_t signal = 0;
+	for (const auto& junction : state.junctions) {
+		renderJunction(state, junction, signal, backend);
+	}
+
+	for (const auto& vehicle : state.vehicles) {
+		renderVehicle(vehicle, backend);
+	}
+}
+
+
+void TelemetryRenderer::renderRoad(const TelemetryRoad& road, RenderBackend& backend) {
+	float halfWidth = road.width / 2.0f;
+	if (!isVisible(std::min(road.startX, road.endX) - halfWidth, std::min(road.startZ, road.endZ) - halfWidth, std::max(road.startX, road.endX) + halfWidth, std::max(road.startZ, road.endZ) + halfWidth)) {
+		return;
+	}
+
+	float dirX = road.endX - road.startX;
+	float dirZ = road.endZ - road.startZ;
+	float length = std::sqrt(dirX * dirX + dirZ * dirZ);
+	if (length <= 0.0f) return;
+
+	float centerX = (road.startX + road.endX) / 2.0f;
+	float centerZ = (road.startZ + road.endZ) / 2.0f;
+	dirX /= length;
+	dirZ /= length;
+
+	backend.drawRect({ centerX, centerZ, dirX, dirZ, length, road.width, 0.01f, 0.3f, 0.3f, 0.3f });
+
+	// no lane geometry on the wire, only the line between opposing directions
+	if (road.forwardLanes > 0 && road.reverseLanes > 0) {
+		float lineWidth = std::max(0.3f, 0.5f * (view.right - view.left) / 240.0f);
+		float offset = road.width * (static_cast<float>(road.forwardLanes) / (road.forwardLanes + road.reverseLanes) - 0.5f);
+		backend.drawRect({ centerX - dirZ * offset, centerZ + dirX * offset, dirX, dirZ, length, lineWidth, 0.011f, 0.9f, 0.8f, 0.1f });
+	}
+}
+
+
+void TelemetryRenderer::renderJunction(const TelemetryState& state, const TelemetryJunction& junction, size_t& signal, RenderBackend& backend) {
+	size_t firstSignal = signal;
+	signal += junction.signalRoads.size();
+
+	if (!isVisible(junction.x - junction.radius, junction.z - junction.radius, junction.x + junction.radius, junction.z + junction.radius)) {
+		return;
+	}
+
+	bool hasLights = !junction.signalRoads.empty();
+	float shade = hasLights ? 0.5f : 0.4f;
+	float blue = hasLights ? 0.6f : 0.4f;
+	backend.drawRect({ junction.x, junction.z, 1.0f, 0.0f, junction.radius * 2, junction.radius * 2, 0.01f, shade, shade, blue });
+
+	// each light sits on the junction's edge towards its road
+	for (size_t i = 0; i < junction.signalRoads.size() && firstSignal + i < state.signals.size(); i++) {
+		auto road = std::lower_bound(state.roads.begin(), state.roads.end(), junction.signalRoads[i], [](const TelemetryRoad& road, int32_t index) { return road.index < index; });
+		if (road == state.roads.end() || road->index != junction.signalRoads[i]) continue;
+
+		float midX = (road->startX + road->endX) / 2.0f - junction.x;
+		float midZ = (road->startZ + road->endZ) / 2.0f - junction.z;
+		float distance = std::sqrt(midX * midX + midZ * midZ);
+		if (distance <= 0.0f) continue;
+
+		float r = 0.0f, g = 0.0f;
+		switch (state.signals[firstSignal + i]) {
+		case LightState::GREEN:
+			g = 1.0f;
+			break;
+		case LightState::YELLOW:
+			r = 1.0f;
+			g = 1.0f;
+			break;
+		default:
+			r = 1.0f;
+			break;
+		}
+
+		float x = junction.x + midX / distance * junction.radius;
+		float z = junction.z + midZ / distance * junction.radius;
+		backend.drawRect({ x, z, 1.0f, 0.0f, 2.0f, 2.0f, 0.5f, r, g, 0.0f });
+	}
+}
+
+
+void TelemetryRenderer::renderVehicle(const TelemetryVehicle& vehicle, RenderBackend& backend) {
+	float x = vehicle.getX();
+	float z = vehicle.getZ();
+	float reach = vehicle.getLength();
+	if (!isVisible(x - reach, z - reach, x + reach, z + reach)) {
+		return;
+	}
+
+	float heading = vehicle.getHeading();
+	backend.drawRect({ x, z, std::cos(heading), std::sin(heading), vehicle.getLength(), vehicle.getWidth(), 0.02f,
+		vehicle.r / 255.0f, vehicle.g / 255.0f, vehicle.b / 255.0f });
+}
+
+
+RenderView TelemetryRenderer::fitView(const TelemetryState& state, float aspect) {
+	float minX = std::numeric_limits<float>::max();
+	float minZ = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxZ = std::numeric_limits<float>::lowest();
+
+	for (const auto& junction : state.junctions) {
+		minX = std::min(minX, junction.x - junction.radius);
+		minZ = std::min(minZ, junction.z - junction.radius);
+		maxX = std::max(maxX, junction.x + junction.radius);
+		maxZ = std::max(maxZ, junction.z + junction.radius);
+	}
+
+	RenderView fitted;
+	if (minX > maxX) {
+		return fitted;
+	}
+
+	float halfWidth = (maxX - minX) / 2.0f * 1.05f + 10.0f;
+	float halfHeight = (maxZ - minZ) / 2.0f * 1.05f + 10.0f;
+	if (halfWidth / halfHeight < aspect) {
+		halfWidth = halfHeight * aspect;
+	} else {
+		halfHeight = halfWidth / aspect;
+	}
+
+	fitted.centerX = (minX + maxX) / 2.0f;
+	fitted.centerZ = (minZ + maxZ) / 2.0f;
+	fitted.left = -halfWidth;
+	fitted.right = halfWidth;
+	fitted.bottom = -halfHeight;
+	fitted.top = halfHeight;
+	return fitted;
+}
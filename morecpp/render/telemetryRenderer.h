@@ -0,0 +1,24 @@
+#pragma once
+
+#include "renderBackend.h"
+#include "../net/telemetryProtocol.h"
+
+
+// draws a telemetry client's state, the remote counterpart of SceneRenderer
+class TelemetryRenderer {
+private:
+	RenderView view;
+
+	bool isVisible(float minX, float minZ, float maxX, float maxZ) const;
+	void renderRoad(const TelemetryRoad& road, RenderBackend& backend);
+	void renderJunction(const TelemetryState& state, const TelemetryJunction& junction, size_t& signal, RenderBackend& backend);
+	void renderVehicle(const TelemetryVehicle& vehicle, RenderBackend& backend);
+
+
+public:
+	// draws one frame, beginFrame and endFrame are left to the caller
+	void render(const TelemetryState& state, const RenderView& frameView, RenderBackend& backend);
+
+	// view covering the whole network at the given width / height ratio
+	static RenderView fitView(const TelemetryState& state, float aspect);
+};
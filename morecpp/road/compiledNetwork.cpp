@@ -0,0 +1,164 @@
+#include "compiledNetwork.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+
+uint32_t CompiledNetwork::hilbertKey(float x, float z, float minX, float minZ, float extent) {
+	const uint32_t side = 1u << 16;
+	float scale = extent > 0.0f ? (side - 1) / extent : 0.0f;
+	uint32_t cellX = static_cast<uint32_t>(std::min(std::max((x - minX) * scale, 0.0f), static_cast<float>(side - 1)));
+	uint32_t cellZ = static_cast<uint32_t>(std::min(std::max((z - minZ) * scale, 0.0f), static_cast<float>(side - 1)));
+
+	// walk the quadrants from the largest down, rotating so each sub curve joins the next
+	uint64_t key = 0;
+	for (uint32_t half = side / 2; half > 0; half /= 2) {
+		uint32_t right = (cellX & half) ? 1 : 0;
+		uint32_t up = (cellZ & half) ? 1 : 0;
+		key += static_cast<uint64_t>(half) * half * ((3 * right) ^ up);
+
+		if (up == 0) {
+			if (right == 1) {
+				cellX = side - 1 - cellX;
+				cellZ = side - 1 - cellZ;
+			}
+			std::swap(cellX, cellZ);
+		}
+	}
+	return static_cast<uint32_t>(key);
+}
+
+
+void CompiledNetwork::clear() {
+	junctions.clear();
+	segments.clear();
+	junctionPositions.clear();
+	junctionRadii.clear();
+	segmentStarts.clear();
+	segmentEnds.clear();
+	nodeEntries.clear();
+	nodeExits.clear();
+	departures.clear();
+	arrivals.clear();
+	laneOffsets.clear();
+	laneTypes.clear();
+	compiled = false;
+}
+
+
+void CompiledNetwork::compile(const std::unordered_map<std::string, std::shared_ptr<Junction>>& junctionMap,
+	const std::unordered_map<std::string, std::shared_ptr<RoadSegment>>& segmentMap, uint32_t networkRevision) {
+	clear();
+
+	// the curve spans the square around every junction and segment end
+	float minX = std::numeric_limits<float>::max();
+	float minZ = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxZ = std::numeric_limits<float>::lowest();
+	auto include = [&](const Vector3& position) {
+		minX = std::min(minX, position.x);
+		minZ = std::min(minZ, position.z);
+		maxX = std::max(maxX, position.x);
+		maxZ = std::max(maxZ, position.z);
+	};
+
+	for (const auto& [id, junction] : junctionMap) {
+		include(junction->getPosition());
+	}
+	for (const auto& [id, segment] : segmentMap) {
+		include(segment->getStartPosition());
+		include(segment->getEndPosition());
+	}
+	float extent = std::max(maxX - minX, maxZ - minZ);
+
+	// sorted by curve position, ids break ties so the layout does not depend on hash order
+	std::vector<std::pair<uint32_t, const std::string*>> order;
+	order.reserve(std::max(junctionMap.size(), segmentMap.size()));
+
+	for (const auto& [id, junction] : junctionMap) {
+		const Vector3& position = junction->getPosition();
+		order.push_back({ hilbertKey(position.x, position.z, minX, minZ, extent), &id });
+	}
+	std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first != b.first ? a.first < b.first : *a.second < *b.second; });
+
+	std::unordered_map<const Junction*, int> junctionSlots;
+	junctions.reserve(order.size());
+	for (const auto& [key, id] : order) {
+		const auto& junction = junctionMap.at(*id);
+		junctionSlots[junction.get()] = static_cast<int>(junctions.size());
+		junctions.push_back(junction);
+		junctionPositions.push_back(junction->getPosition());
+		junctionRadii.push_back(junction->getRadius());
+	}
+
+	auto junctionSlot = [&](const std::shared_ptr<Junction>& junction) {
+		auto found = junction ? junctionSlots.find(junction.get()) : junctionSlots.end();
+		return found != junctionSlots.end() ? found->second : -1;
+	};
+
+	// segments by their midpoint, so a road sits between the junctions it joins
+	order.clear();
+	for (const auto& [id, segment] : segmentMap) {
+		Vector3 middle = (segment->getStartPosition() + segment->getEndPosition()) * 0.5f;
+		order.push_back({ hilbertKey(middle.x, middle.z, minX, minZ, extent), &id });
+	}
+	std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first != b.first ? a.first < b.first : *a.second < *b.second; });
+
+	segments.reserve(order.size());
+	for (const auto& [key, id] : order) {
+		const auto& segment = segmentMap.at(*id);
+		segments.push_back(segment);
+		segmentStarts.push_back(junctionSlot(segment->getStartJunction()));
+		segmentEnds.push_back(junctionSlot(segment->getEndJunction()));
+	}
+
+	revision = networkRevision;
+	compiled = true;
+}
+
+
+void CompiledNetwork::linkNodes() {
+	int indexCount = 0;
+	for (const auto& segment : segments) {
+		indexCount = std::max(indexCount, segment->getIndex() + 1);
+	}
+
+	// slots by segment index, so every row comes out in node order as routing expects
+	std::vector<int> slotOfIndex(indexCount, -1);
+	for (size_t slot = 0; slot < segments.size(); slot++) {
+		if (segments[slot]->getIndex() >= 0) slotOfIndex[segments[slot]->getIndex()] = static_cast<int>(slot);
+	}
+
+	size_t nodeCount = static_cast<size_t>(indexCount) * 2;
+	nodeEntries.assign(nodeCount, -1);
+	nodeExits.assign(nodeCount, -1);
+	laneOffsets.assign(1, 0);
+	laneTypes.clear();
+
+	std::vector<std::vector<int>> leaving(junctions.size());
+	std::vector<std::vector<int>> arriving(junctions.size());
+
+	for (int node = 0; node < static_cast<int>(nodeCount); node++) {
+		int slot = slotOfIndex[node / 2];
+		TravelDirection direction = node % 2 ? TravelDirection::REVERSE : TravelDirection::FORWARD;
+
+		if (slot >= 0 && segments[slot]->hasDirection(direction)) {
+			const RoadSegment& segment = *segments[slot];
+			bool forward = direction == TravelDirection::FORWARD;
+			nodeEntries[node] = forward ? segmentStarts[slot] : segmentEnds[slot];
+			nodeExits[node] = forward ? segmentEnds[slot] : segmentStarts[slot];
+
+			if (nodeEntries[node] >= 0) leaving[nodeEntries[node]].push_back(node);
+			if (nodeExits[node] >= 0) arriving[nodeExits[node]].push_back(node);
+
+			for (const Lane& lane : segment.getLanes(direction)) {
+				laneTypes.push_back(lane.getType());
+			}
+		}
+		laneOffsets.push_back(static_cast<uint32_t>(laneTypes.size()));
+	}
+
+	departures.assign(leaving);
+	arrivals.assign(arriving);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <string>
+#include <cstdint>
+
+#include "../core/csr.h"
+#include "../core/vec3.h"
+#include "junction.h"
+#include "roadSegment.h"
+#include "lane.h"
+
+
+// the built object graph flattened into arrays. junctions and segments are laid out along a hilbert
+// curve over the junction positions, so roads that are close on the map are close in memory, and the
+// first compile also sets segment indices in that order. directed roads are the routing nodes,
+// segment index * 2 + direction, with their junctions, lanes and the junction adjacency in flat
+// rows that routing, the update and the renderer read instead of the objects. a compile describes
+// one network revision and is stale once that moves on
+class CompiledNetwork {
+private:
+	std::vector<std::shared_ptr<Junction>> junctions;
+	std::vector<std::shared_ptr<RoadSegment>> segments;
+
+	// per junction slot
+	std::vector<Vector3> junctionPositions;
+	std::vector<float> junctionRadii;
+
+	// per segment slot, -1 where the segment has no junction at that end
+	std::vector<int> segmentStarts;
+	std::vector<int> segmentEnds;
+
+	// per node, so by segment index rather than slot. -1 for a missing junction or node
+	std::vector<int> nodeEntries;
+	std::vector<int> nodeExits;
+
+	// junction slot to the nodes leaving and arriving at it, in node order
+	CsrAdjacency departures;
+	CsrAdjacency arrivals;
+
+	// lane layout per node, lanes of node n are laneTypes[laneOffsets[n], laneOffsets[n + 1])
+	std::vector<uint32_t> laneOffsets;
+	std::vector<LaneType> laneTypes;
+
+	uint32_t revision = 0;
+	bool compiled = false;
+
+
+public:
+	// position on a 2^16 by 2^16 hilbert curve of a point inside the bounds
+	static uint32_t hilbertKey(float x, float z, float minX, float minZ, float extent);
+
+	// the same numbering routing uses
+	static int toNode(int segmentIndex, TravelDirection direction) { return segmentIndex * 2 + (direction == TravelDirection::REVERSE ? 1 : 0); }
+
+	// lays out junctions and segments, then linkNodes builds the node rows from the segment indices,
+	// so the network can renumber its segments to the new layout in between
+	void compile(const std::unordered_map<std::string, std::shared_ptr<Junction>>& junctionMap,
+		const std::unordered_map<std::string, std::shared_ptr<RoadSegment>>& segmentMap, uint32_t networkRevision);
+	void linkNodes();
+	void clear();
+
+	bool isCompiled() const { return compiled; }
+	bool isStale(uint32_t networkRevision) const { return !compiled || revision != networkRevision; }
+	uint32_t getRevision() const { return revision; }
+
+	// in curve order
+	const std::vector<std::shared_ptr<Junction>>& getJunctions() const { return junctions; }
+	const std::vector<std::shared_ptr<RoadSegment>>& getSegments() const { return segments; }
+
+	Junction* getJunction(int slot) const { return slot >= 0 && slot < static_cast<int>(junctions.size()) ? junctions[slot].get() : nullptr; }
+	const Vector3& getJunctionPosition(int slot) const { return junctionPositions[slot]; }
+	float getJunctionRadius(int slot) const { return junctionRadii[slot]; }
+	int getSegmentStart(size_t slot) const { return segmentStarts[slot]; }
+	int getSegmentEnd(size_t slot) const { return segmentEnds[slot]; }
+
+	// node rows, empty or -1 for nodes compiled after this one
+	size_t getNodeCount() const { return nodeExits.size(); }
+	int getEntry(int node) const { return node >= 0 && node < static_cast<int>(nodeEntries.size()) ? nodeEntries[node] : -1; }
+	int getExit(int node) const { return node >= 0 && node < static_cast<int>(nodeExits.size()) ? nodeExits[node] : -1; }
+	Span<const int> getDepartures(int slot) const { return slot >= 0 ? departures.row(slot) : Span<const int>(); }
+	Span<const int> getArrivals(int slot) const { return slot >= 0 ? arrivals.row(slot) : Span<const int>(); }
+	Span<const LaneType> getLaneTypes(int node) const {
+		if (node < 0 || node + 1 >= static_cast<int>(laneOffsets.size())) return {};
+		return Span<const LaneType>(laneTypes.data() + laneOffsets[node], laneOffsets[node + 1] - laneOffsets[node]);
+	}
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "roadNetwork.h"
+#include "highwayRamp.h"
+#include "simpleJunction.h"
+
+
+struct HighwayCorridorConfig {
+	std::string id = "highway";
+	Vector3 origin = Vector3(0.0f, 0.0f, 0.0f);
+
+	// main line
+	int sections = 8;
+	float sectionLength = 400.0f;
+	int numLanes = 3;
+	float laneWidth = 4.0f;
+	float speedLimit = 30.0f;
+
+	// ramps every n sections (0 disables), exits are offset from entrances
+	int entranceSpacing = 2;
+	int exitSpacing = 2;
+	int exitOffset = 1;
+	float rampLength = 200.0f;
+	float rampOffset = 30.0f;
+	float rampSpeedLimit = 15.0f;
+	float mergeLength = 120.0f;
+
+	// sections whose rightmost lane ends
+	std::vector<int> laneDropSections;
+	float laneDropLength = 150.0f;
+
+	// demand (vehicles per minute)
+	float mainlineDemand = 40.0f;
+	float rampDemand = 10.0f;
+};
+
+
+class HighwayCorridor {
+public:
+	static void create(RoadNetwork& network, const HighwayCorridorConfig& config) {
+		std::vector<std::shared_ptr<Junction>> mainJunctions;
+
+		// main line junctions along +x
+		for (int i = 0; i <= config.sections; i++) {
+			Vector3 position(config.origin.x + i * config.sectionLength, config.origin.y, config.origin.z);
+			auto junction = std::make_shared<SimpleJunction>(config.id + "_j" + std::to_string(i), position, 5.0f);
+			network.addJunction(junction);
+			mainJunctions.push_back(junction);
+		}
+
+		int laneCount = config.numLanes;
+
+		for (int i = 0; i < config.sections; i++) {
+			bool dropsLane = std::find(config.laneDropSections.begin(), config.laneDropSections.end(), i) != config.laneDropSections.end()
+				&& laneCount > 1;
+
+			auto start = mainJunctions[i];
+			auto end = mainJunctions[i + 1];
+
+			auto section = std::make_shared<RoadSegment>(
+				config.id + "_main_" + std::to_string(i),
+				start->getPosition(),
+				Vector3(config.sectionLength, 0, config.laneWidth * (laneCount + 1)),
+				config.speedLimit
+			);
+
+			// inner shoulder then regular lanes, the ramps join the outermost lane
+			section->addLane(Lane(0, LaneType::SHOULDER, config.laneWidth));
+			for (int lane = 1; lane <= laneCount; lane++) {
+				section->addLane(Lane(lane, LaneType::REGULAR, config.laneWidth));
+			}
+
+			if (dropsLane) {
+				float dropEnd = config.sectionLength * 0.8f;
+				float dropStart = std::max(0.0f, dropEnd - config.laneDropLength);
+				section->addLaneTransition(dropStart, dropEnd, laneCount + 1, laneCount, { { laneCount, laneCount - 1 } });
+			}
+
+			section->setJunctions(start, end);
+			start->connectRoad(section);
+			end->connectRoad(section);
+			network.addRoadSegment(section);
+
+			if (i == 0) {
+				network.addSpawnPoint(std::make_shared<SpawnPoint>(section, 0.0f, config.mainlineDemand));
+			}
+
+			// entrance ramps merge into the start of this section
+			if (config.entranceSpacing > 0 && i > 0 && i % config.entranceSpacing == 0) {
+				addEntranceRamp(network, config, section, start, laneCount);
+			}
+
+			// exit ramps leave from the junction at the start of this section
+			if (config.exitSpacing > 0 && i > 0 && i % config.exitSpacing == config.exitOffset % config.exitSpacing) {
+				addExitRamp(network, config, start);
+			}
+
+			if (dropsLane) {
+				laneCount--;
+			}
+		}
+
+		network.addDestination(std::make_shared<Destination>(mainJunctions.back()->getPosition(), config.id + " end"));
+	}
+
+
+private:
+	static std::shared_ptr<HighwayRamp> createRamp(const HighwayCorridorConfig& config, const std::string& id, const Vector3& position, RampType type) {
+		auto ramp = std::make_shared<HighwayRamp>(id, position, Vector3(config.rampLength, 0, config.laneWidth * 2), config.rampSpeedLimit, type);
+		ramp->addLane(Lane(0, LaneType::REGULAR, config.laneWidth));
+		ramp->addLane(Lane(1, LaneType::SHOULDER, config.laneWidth));
+		return ramp;
+	}
+
+
+	static void addEntranceRamp(RoadNetwork& network, const HighwayCorridorConfig& config,
+		std::shared_ptr<RoadSegment> section, std::shared_ptr<Junction> mergeJunction, int laneCount) {
+		std::string id = section->getId() + "_on";
+
+		// ramp runs in from the outside so its length matches the configured ramp length
+		float along = std::sqrt(std::max(0.0f, config.rampLength * config.rampLength - config.rampOffset * config.rampOffset));
+		Vector3 startPos = mergeJunction->getPosition() + Vector3(-along, 0.0f, config.rampOffset);
+		auto rampStart = std::make_shared<SimpleJunction>(id + "_start", startPos, 5.0f);
+
+		auto ramp = createRamp(config, id, startPos, RampType::ENTRANCE);
+		ramp->setJunctions(rampStart, mergeJunction);
+		ramp->setMainRoad(section, 0.0f, std::min(config.mergeLength, config.sectionLength), laneCount);
+		rampStart->connectRoad(ramp);
+		mergeJunction->connectRoad(ramp);
+
+		network.addJunction(rampStart);
+		network.addRoadSegment(ramp);
+		network.addSpawnPoint(std::make_shared<SpawnPoint>(ramp, 0.0f, config.rampDemand));
+	}
+
+
+	static void addExitRamp(RoadNetwork& network, const HighwayCorridorConfig& config,
+		std::shared_ptr<Junction> divergeJunction) {
+		std::string id = divergeJunction->getId() + "_off";
+
+		float along = std::sqrt(std::max(0.0f, config.rampLength * config.rampLength - config.rampOffset * config.rampOffset));
+		Vector3 endPos = divergeJunction->getPosition() + Vector3(along, 0.0f, config.rampOffset);
+		auto rampEnd = std::make_shared<SimpleJunction>(id + "_end", endPos, 5.0f);
+
+		auto ramp = createRamp(config, id, divergeJunction->getPosition(), RampType::EXIT);
+		ramp->setJunctions(divergeJunction, rampEnd);
+		divergeJunction->connectRoad(ramp);
+		rampEnd->connectRoad(ramp);
+
+		network.addJunction(rampEnd);
+		network.addRoadSegment(ramp);
+		network.addDestination(std::make_shared<Destination>(endPos, id));
+	}
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <limits>
+
 #include "roadSegment.h"
 
 enum class RampType {
@@ -11,6 +13,7 @@ enum class RampType {
 struct MergeInfo {
 	float mergeStartDistance;
 	float mergeEndDistance;
+	float mergePoint;
 	int targetLane;
 	float mergeAngle;
 };
@@ -20,41 +23,45 @@ class HighwayRamp : public RoadSegment {
 private:
 	RampType type;
 	std::weak_ptr<RoadSegment> mainRoad;
-	float mergeStartDistance;
-	float mergeEndDistance;
-	int targetLane;
+	MergeInfo mergeInfo;
 
 
 public:
+	// fraction of the ramp where entrance vehicles start looking for a gap
+	static constexpr float mergeZoneStart = 0.75f;
+
+	// fraction of the ramp where exit vehicles slow down to the ramp speed
+	static constexpr float exitDecelerationEnd = 0.3f;
+
 	HighwayRamp(const std::string& id, const Vector3& pos, const Vector3& dim, float speedLimit, RampType type)
 	  :	RoadSegment(id, pos, dim, speedLimit),
 		type(type),
-		mergeStartDistance(0),
-		mergeEndDistance(0),
-		targetLane(0) {
+		mergeInfo{ 0.0f, 0.0f, 0.0f, 0, 15.0f } {
+		kind = SegmentKind::RAMP;
+
+		// vehicles held at the end of an entrance ramp keep looking for a gap
+		if (type == RampType::ENTRANCE) {
+			addZone({ length * mergeZoneStart, std::numeric_limits<float>::max(), ZoneType::MERGE });
+		} else {
+			addZone({ 0.0f, length * exitDecelerationEnd, ZoneType::EXIT_DECELERATION });
+		}
 	}
 
 	void setMainRoad(std::shared_ptr<RoadSegment> road, float startDist, float endDist, int lane) {
 		mainRoad = road;
-		mergeStartDistance = startDist;
-		mergeEndDistance = endDist;
-		targetLane = lane;
+		mergeInfo.mergeStartDistance = startDist;
+		mergeInfo.mergeEndDistance = endDist;
+		mergeInfo.mergePoint = (startDist + endDist) / 2;
+		mergeInfo.targetLane = lane;
 	}
 
 	RampType getType() const { return type; }
 	std::weak_ptr<RoadSegment> getMainRoad() const { return mainRoad; }
 
-	MergeInfo getMergeParameters() const {
-		MergeInfo info;
-		info.mergeStartDistance = mergeStartDistance;
-		info.mergeEndDistance = mergeEndDistance;
-		info.targetLane = targetLane;
-		info.mergeAngle = 15.0f;
-		return info;
-	}
+	const MergeInfo& getMergeParameters() const { return mergeInfo; }
 
-	float getMergeAngle() const { return 15.0f; }
-	int getTargetLane() const { return targetLane; }
-	float getMergeStartDistance() const { return mergeStartDistance; }
-	float getMergeEndDistance() const { return mergeEndDistance; }
-};
\ No newline at end of file
+	float getMergeAngle() const { return mergeInfo.mergeAngle; }
+	int getTargetLane() const { return mergeInfo.targetLane; }
+	float getMergeStartDistance() const { return mergeInfo.mergeStartDistance; }
+	float getMergeEndDistance() const { return mergeInfo.mergeEndDistance; }
+};
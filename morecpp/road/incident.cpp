@@ -0,0 +1,24 @@
+#include "incident.h"
+
+
+int IncidentSchedule::schedule(const Incident& incident) {
+	int id = static_cast<int>(incidents.size());
+	incidents.push_back(incident);
+
+	events.push({ incident.startTime, id, true });
+	if (incident.duration > 0.0f) {
+		events.push({ incident.startTime + incident.duration, id, false });
+	}
+
+	return id;
+}
+
+
+void IncidentSchedule::advance(float deltaTime, std::vector<IncidentEvent>& due) {
+	clock += deltaTime;
+
+	while (!events.empty() && events.top().time <= clock) {
+		due.push_back(events.top());
+		events.pop();
+	}
+}
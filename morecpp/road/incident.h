@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <string>
+#include <functional>
+
+#include "roadSegment.h"
+
+
+enum class IncidentType {
+	LANE_CLOSURE,
+	SEGMENT_CLOSURE,
+	SPEED_REDUCTION
+};
+
+
+// crash, work zone or closure that takes effect for a while on one segment
+struct Incident {
+	std::string roadId;
+	IncidentType type = IncidentType::LANE_CLOSURE;
+	double startTime = 0.0;
+	float duration = 0.0f;
+
+	// lane closures and segment closures apply to one direction of travel
+	TravelDirection direction = TravelDirection::FORWARD;
+	int laneIndex = 0;
+
+	// speed reductions scale the segment's speed limit
+	float speedFactor = 1.0f;
+};
+
+
+// an incident starting or ending
+struct IncidentEvent {
+	double time;
+	int incident;
+	bool starting;
+
+	bool operator>(const IncidentEvent& other) const { return time > other.time; }
+};
+
+
+// incidents scheduled on simulation time, released in time order
+class IncidentSchedule {
+private:
+	std::vector<Incident> incidents;
+	std::priority_queue<IncidentEvent, std::vector<IncidentEvent>, std::greater<IncidentEvent>> events;
+	double clock = 0.0;
+
+
+public:
+	// returns the incident's id, incidents with no duration never end
+	int schedule(const Incident& incident);
+
+	// advance the clock and collect the starts and ends that fell in the step
+	void advance(float deltaTime, std::vector<IncidentEvent>& due);
+
+	const Incident& getIncident(int id) const { return incidents[id]; }
+	const std::vector<Incident>& getIncidents() const { return incidents; }
+	double getClock() const { return clock; }
+};
@@ -17,6 +17,15 @@ void Junction::connectRoad(std::shared_ptr<RoadSegment> road) {
 }
 
 
+void Junction::disconnectRoad(std::shared_ptr<RoadSegment> road) {
+	int index = getRoadIndex(road);
+	if (index < 0) return;
+
+	connectedRoads.erase(connectedRoads.begin() + index);
+	roadAngles.erase(road->getId());
+}
+
+
 std::vector<std::shared_ptr<RoadSegment>> Junction::getConnectedRoads() const {
 	std::vector<std::shared_ptr<RoadSegment>> roads;
 	for (const auto& weakRoad : connectedRoads) {
@@ -28,6 +37,32 @@ std::vector<std::shared_ptr<RoadSegment>> Junction::getConnectedRoads() const {
 }
 
 
+std::vector<DirectedRoad> Junction::getApproaches() const {
+	std::vector<DirectedRoad> approaches;
+	forEachConnectedRoad([&](const std::shared_ptr<RoadSegment>& road) {
+		for (TravelDirection direction : { TravelDirection::FORWARD, TravelDirection::REVERSE }) {
+			if (road->hasDirection(direction) && road->getExitJunction(direction).get() == this) {
+				approaches.push_back({ road, direction });
+			}
+		}
+	});
+	return approaches;
+}
+
+
+std::vector<DirectedRoad> Junction::getDepartures() const {
+	std::vector<DirectedRoad> departures;
+	forEachConnectedRoad([&](const std::shared_ptr<RoadSegment>& road) {
+		for (TravelDirection direction : { TravelDirection::FORWARD, TravelDirection::REVERSE }) {
+			if (road->hasDirection(direction) && road->getEntryJunction(direction).get() == this) {
+				departures.push_back({ road, direction });
+			}
+		}
+	});
+	return departures;
+}
+
+
 float Junction::getAngleBetweenRoads(std::shared_ptr<RoadSegment> fromRoad, std::shared_ptr<RoadSegment> toRoad) const {
 	if (roadAngles.find(fromRoad->getId()) == roadAngles.end() || roadAngles.find(toRoad->getId()) == roadAngles.end()) {
 		return 0.0f;
@@ -57,14 +92,11 @@ int Junction::getRoadIndex(std::shared_ptr<RoadSegment> road) const {
 }
 
 
-std::vector<std::shared_ptr<RoadSegment>> Junction::getExitRoads(std::shared_ptr<RoadSegment> entryRoad) const {
-	std::vector<std::shared_ptr<RoadSegment>> exits;
-	for (const auto& weakRoad : connectedRoads) {
-		if (auto road = weakRoad.lock()) {
-			if (road != entryRoad) {
-				exits.push_back(road);
-			}
+bool Junction::isDepartureOf(const RoadSegment& road) const {
+	for (TravelDirection direction : { TravelDirection::FORWARD, TravelDirection::REVERSE }) {
+		if (road.hasDirection(direction) && road.getEntryJunction(direction).get() == this) {
+			return true;
 		}
 	}
-	return exits;
+	return false;
 }
\ No newline at end of file
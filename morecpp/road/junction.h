@@ -6,11 +6,20 @@
 #include <unordered_map>
 
 #include "../core/vec3.h"
+#include "../core/stateHash.h"
 
 
 // forward declaration
 class RoadSegment;
 class Vehicle;
+enum class TravelDirection;
+
+
+// one direction of travel on a connected road
+struct DirectedRoad {
+	std::shared_ptr<RoadSegment> road;
+	TravelDirection direction;
+};
 
 
 class Junction {
@@ -27,6 +36,7 @@ public:
 
 	// connect road
 	virtual void connectRoad(std::shared_ptr<RoadSegment> road);
+	virtual void disconnectRoad(std::shared_ptr<RoadSegment> road);
 
 
 	// getters
@@ -35,12 +45,39 @@ public:
 	const std::string& getId() const { return id; }
 	const Vector3& getPosition() const { return position; }
 	std::vector<std::shared_ptr<RoadSegment>> getConnectedRoads() const;
+
+	// connected roads without building a list, for paths that run every tick or frame
+	template <typename Visitor>
+	void forEachConnectedRoad(Visitor&& visit) const {
+		for (const auto& weakRoad : connectedRoads) {
+			if (auto road = weakRoad.lock()) visit(road);
+		}
+	}
+
+	// roads a vehicle arriving on entryRoad can leave by
+	template <typename Visitor>
+	void forEachExitRoad(const std::shared_ptr<RoadSegment>& entryRoad, Visitor&& visit) const {
+		forEachConnectedRoad([&](const std::shared_ptr<RoadSegment>& road) {
+			if (road != entryRoad && isDepartureOf(*road)) visit(road);
+		});
+	}
+
+	// connected roads by the direction that arrives at / leaves this junction
+	std::vector<DirectedRoad> getApproaches() const;
+	std::vector<DirectedRoad> getDepartures() const;
+	bool isDepartureOf(const RoadSegment& road) const;
 	float getAngleBetweenRoads(std::shared_ptr<RoadSegment> fromRoad, std::shared_ptr<RoadSegment> toRoad) const;
 
 
 	// virtual declarations
 	virtual ~Junction() = default;
-	virtual std::vector<std::shared_ptr<RoadSegment>> getExitRoads(std::shared_ptr<RoadSegment> entryRoad) const;
 	virtual bool canNavigate(std::shared_ptr<RoadSegment> fromRoad, std::shared_ptr<RoadSegment> toRoad, Vehicle* vehicle) = 0;
 	virtual void update(float deltaTime) {}
+
+	// junctions whose state runs on the clock (signal plans) update every tick, the rest only react
+	// to vehicles and are never visited by the network update
+	virtual bool isTimed() const { return false; }
+
+	// junctions with their own state (signal phases) add it to the state hash
+	virtual void hashState(StateHasher& hasher) const { hasher.add(id); }
 };
\ No newline at end of file
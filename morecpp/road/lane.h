@@ -26,9 +26,12 @@ private:
     float width;
     bool isReversible;
 
+    // overlapping incidents each hold the lane closed until they end
+    int closures;
+
 
 public:
-    Lane(int idx, LaneType type, float width) : index(idx), type(type), width(width), isReversible(false) {}
+    Lane(int idx, LaneType type, float width) : index(idx), type(type), width(width), isReversible(false), closures(0) {}
 
     int getIndex() const { return index; }
     LaneType getType() const { return type; }
@@ -36,5 +39,11 @@ public:
     bool getIsReversible() const { return isReversible; }
     void setReversible(bool reversible) { isReversible = reversible; }
     
-    bool canAcceptVehicle(const Vehicle* vehicle) const { return true; }
+    void close() { closures++; }
+    void reopen() { if (closures > 0) closures--; }
+    bool isClosed() const { return closures > 0; }
+
+    // traffic only drives in regular lanes, shoulders and special lanes never count as open
+    bool isTravelLane() const { return type == LaneType::REGULAR; }
+    bool canAcceptVehicle() const { return isTravelLane() && !isClosed(); }
 };
\ No newline at end of file
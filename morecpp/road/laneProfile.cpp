@@ -0,0 +1,146 @@
+#include "laneProfile.h"
+
+#include <algorithm>
+#include <limits>
+
+
+LaneProfile::LaneProfile() : centreOffset(0.0f) {
+	compile(0.0f, 1);
+}
+
+
+void LaneProfile::addTransition(const LaneTransition& transition) {
+	auto it = std::upper_bound(transitions.begin(), transitions.end(), transition, [](const LaneTransition& a, const LaneTransition& b) {
+		return a.startDistance < b.startDistance;
+		});
+	transitions.insert(it, transition);
+}
+
+
+void LaneProfile::pushInterval(float start, float end, int laneCount, float width, int transition) {
+	if (end <= start) return;
+
+	// merge with the previous interval if nothing changes
+	if (!intervals.empty()) {
+		LaneInterval& last = intervals.back();
+		if (last.laneCount == laneCount && last.transition == transition) {
+			last.endDistance = end;
+			return;
+		}
+	}
+
+	LaneInterval interval;
+	interval.startDistance = start;
+	interval.endDistance = end;
+	interval.laneCount = std::max(1, laneCount);
+	interval.laneWidth = width / interval.laneCount;
+	interval.firstLaneOffset = centreOffset - (interval.laneCount - 1) / 2.0f * interval.laneWidth;
+	interval.transition = transition;
+	intervals.push_back(interval);
+}
+
+
+void LaneProfile::compile(float width, int laneCount, float groupOffset) {
+	const float lowest = std::numeric_limits<float>::lowest();
+	const float highest = std::numeric_limits<float>::max();
+
+	intervals.clear();
+	centreOffset = groupOffset;
+
+	float position = lowest;
+	int currentCount = laneCount;
+
+	for (size_t i = 0; i < transitions.size(); i++) {
+		const LaneTransition& transition = transitions[i];
+		int index = static_cast<int>(i);
+
+		// overlapping transitions are clipped to where the previous one ended
+		float start = std::max(transition.startDistance, position);
+		float end = transition.endDistance;
+		if (end <= start) continue;
+
+		pushInterval(position, start, currentCount, width, -1);
+
+		// lane count is rounded from a linear blend, so it steps at every half lane
+		int from = transition.startLaneCount;
+		int to = transition.endLaneCount;
+		float span = transition.endDistance - transition.startDistance;
+		int step = to > from ? 1 : -1;
+
+		float segmentStart = start;
+		for (int count = from; count != to; count += step) {
+			float half = count + step * 0.5f;
+			float boundary = transition.startDistance + (half - from) / (to - from) * span;
+			boundary = std::min(std::max(boundary, segmentStart), end);
+
+			pushInterval(segmentStart, boundary, count, width, index);
+			segmentStart = boundary;
+		}
+		pushInterval(segmentStart, end, to, width, index);
+
+		// the lane count after a transition holds until the next one
+		position = end;
+		currentCount = to;
+	}
+
+	pushInterval(position, highest, currentCount, width, -1);
+
+	// a profile always covers every distance
+	if (intervals.empty()) {
+		pushInterval(lowest, highest, laneCount, width, -1);
+	}
+}
+
+
+const LaneInterval& LaneProfile::at(float distance) const {
+	auto it = std::upper_bound(intervals.begin(), intervals.end(), distance, [](float value, const LaneInterval& interval) {
+		return value < interval.endDistance;
+		});
+
+	if (it == intervals.end()) {
+		return intervals.back();
+	}
+	return *it;
+}
+
+
+const LaneInterval& LaneProfile::at(float distance, size_t& cursor) const {
+
+	// a stale cursor (other segment or moved backwards) falls back to a search
+	if (cursor >= intervals.size() || distance < intervals[cursor].startDistance) {
+		cursor = &at(distance) - intervals.data();
+		return intervals[cursor];
+	}
+
+	while (cursor + 1 < intervals.size() && distance >= intervals[cursor].endDistance) {
+		cursor++;
+	}
+
+	return intervals[cursor];
+}
+
+
+int LaneProfile::getTargetLane(int currentLane, float currentDistance, float targetDistance, size_t& cursor) const {
+	at(currentDistance, cursor);
+
+	// first transition overlapping the look ahead decides
+	for (size_t i = cursor; i < intervals.size() && intervals[i].startDistance <= targetDistance; i++) {
+		if (intervals[i].transition < 0) continue;
+
+		const LaneTransition& transition = transitions[intervals[i].transition];
+
+		// current lane still exists
+		if (currentLane < transition.endLaneCount) {
+			return currentLane;
+		}
+
+		auto it = transition.laneMapping.find(currentLane);
+		if (it != transition.laneMapping.end()) {
+			return it->second;
+		}
+		return transition.endLaneCount - 1;
+	}
+
+	// stay in current lane
+	return currentLane;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+
+struct LaneTransition {
+	float startDistance;
+	float endDistance;
+	int startLaneCount;
+	int endLaneCount;
+	std::unordered_map<int, int> laneMapping;
+};
+
+
+// stretch of road with a fixed lane layout
+struct LaneInterval {
+	float startDistance;
+	float endDistance;
+	int laneCount;
+	float laneWidth;
+
+	// lateral offset of lane 0 from the road centre line
+	float firstLaneOffset;
+
+	// transition this interval belongs to, -1 outside transitions
+	int transition;
+
+	float getLaneOffset(int laneIndex) const { return firstLaneOffset + laneIndex * laneWidth; }
+};
+
+
+// lane layout of a segment compiled into sorted, non overlapping intervals.
+// lookups with a cursor only move forward, so a vehicle driving down the
+// segment pays O(1) per tick however many transitions there are
+class LaneProfile {
+private:
+	std::vector<LaneTransition> transitions;
+	std::vector<LaneInterval> intervals;
+
+	// lateral offset of the lane group's centre from the road centre line
+	float centreOffset;
+
+	void pushInterval(float start, float end, int laneCount, float width, int transition);
+
+
+public:
+	LaneProfile();
+
+	// transitions are kept sorted by start distance
+	void addTransition(const LaneTransition& transition);
+	void compile(float width, int laneCount, float groupOffset = 0.0f);
+
+	// binary search, for callers without a cursor
+	const LaneInterval& at(float distance) const;
+	const LaneInterval& at(float distance, size_t& cursor) const;
+
+	// lane to aim for so the vehicle is not left in a lane that ends within the look ahead
+	int getTargetLane(int currentLane, float currentDistance, float targetDistance, size_t& cursor) const;
+
+	const std::vector<LaneInterval>& getIntervals() const { return intervals; }
+	const std::vector<LaneTransition>& getTransitions() const { return transitions; }
+};
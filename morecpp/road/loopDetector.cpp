@@ -0,0 +1,212 @@
+#include "loopDetector.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+
+DetectorBank::DetectorBank() {
+	setConfig(DetectorConfig());
+}
+
+
+void DetectorBank::setConfig(const DetectorConfig& newConfig) {
+	config = newConfig;
+
+	const float binSeconds[] = { 1.0f, 60.0f, 900.0f };
+	const uint32_t capacities[] = { config.secondBins, config.minuteBins, config.quarterHourBins };
+	for (int i = 0; i < static_cast<int>(DetectorResolution::COUNT); i++) {
+		rings[i].binSeconds = binSeconds[i];
+		rings[i].capacity = capacities[i];
+		rings[i].closed = 0;
+		rings[i].open.clear();
+		rings[i].bins.clear();
+	}
+	resizeRings();
+
+	// recording starts over, bin times count from the change
+	std::fill(occupiedTick.begin(), occupiedTick.end(), 0);
+	clock = 0.0;
+}
+
+
+void DetectorBank::resizeRings() {
+	for (auto& resolution : rings) {
+		resolution.open.resize(detectors.size());
+		resolution.bins.resize(detectors.size() * resolution.capacity);
+	}
+}
+
+
+int DetectorBank::add(const LoopDetector& detector) {
+	detectors.push_back(detector);
+	occupiedTick.push_back(0);
+	resizeRings();
+	return static_cast<int>(detectors.size()) - 1;
+}
+
+
+void DetectorBank::clear() {
+	detectors.clear();
+	occupiedTick.clear();
+	for (auto& resolution : rings) {
+		resolution.closed = 0;
+		resolution.open.clear();
+		resolution.bins.clear();
+	}
+	clock = 0.0;
+}
+
+
+void DetectorBank::closeBins(int resolution) {
+	Ring& closing = rings[resolution];
+	size_t slot = closing.capacity > 0 ? closing.closed % closing.capacity : 0;
+
+	for (size_t d = 0; d < detectors.size(); d++) {
+		DetectorBin& bin = closing.open[d];
+		if (closing.capacity > 0) {
+			closing.bins[d * closing.capacity + slot] = bin;
+		}
+		if (resolution + 1 < static_cast<int>(DetectorResolution::COUNT)) {
+			rings[resolution + 1].open[d].add(bin);
+		}
+		bin = DetectorBin();
+	}
+	closing.closed++;
+}
+
+
+void DetectorBank::advance(float deltaTime) {
+	clock += deltaTime;
+	tick++;
+
+	// the coarser bins are whole multiples of the finer ones, so they close on the same boundary
+	Ring& seconds = ring(DetectorResolution::SECOND);
+	while (clock >= static_cast<double>(seconds.closed + 1)) {
+		closeBins(static_cast<int>(DetectorResolution::SECOND));
+		for (int i = 1; i < static_cast<int>(DetectorResolution::COUNT); i++) {
+			uint64_t perBin = static_cast<uint64_t>(rings[i].binSeconds / rings[i - 1].binSeconds);
+			if (rings[i - 1].closed % perBin != 0) break;
+			closeBins(i);
+		}
+	}
+}
+
+
+size_t DetectorBank::getBinCount(DetectorResolution resolution) const {
+	const Ring& held = ring(resolution);
+	return static_cast<size_t>(std::min<uint64_t>(held.closed, held.capacity));
+}
+
+
+const DetectorBin& DetectorBank::getBin(int detector, DetectorResolution resolution, size_t index) const {
+	const Ring& held = ring(resolution);
+	uint64_t bin = held.closed - getBinCount(resolution) + index;
+	return held.bins[detector * held.capacity + bin % held.capacity];
+}
+
+
+double DetectorBank::getBinStart(DetectorResolution resolution, size_t index) const {
+	const Ring& held = ring(resolution);
+	return static_cast<double>(held.closed - getBinCount(resolution) + index) * held.binSeconds;
+}
+
+
+bool DetectorBank::writeCsv(const std::string& path) const {
+	std::ofstream file(path);
+	if (!file.is_open()) return false;
+
+	const char* names[] = { "second", "minute", "quarter_hour" };
+	file << "detector,resolution,start,count,flow,occupancy,speed\n";
+
+	for (int r = 0; r < static_cast<int>(DetectorResolution::COUNT); r++) {
+		DetectorResolution resolution = static_cast<DetectorResolution>(r);
+		float binSeconds = getBinSeconds(resolution);
+
+		for (size_t d = 0; d < detectors.size(); d++) {
+			for (size_t i = 0; i < getBinCount(resolution); i++) {
+				const DetectorBin& bin = getBin(static_cast<int>(d), resolution, i);
+				file << detectors[d].id << ',' << names[r] << ',' << getBinStart(resolution, i) << ',' << bin.count << ','
+					<< bin.getFlow(binSeconds) << ',' << bin.getOccupancy(binSeconds) << ',' << bin.getMeanSpeed() << '\n';
+			}
+		}
+	}
+	return file.good();
+}
+
+
+struct DetectorByteWriter {
+	std::vector<uint8_t>& bytes;
+
+	void u8(uint8_t value) { bytes.push_back(value); }
+
+	void u32(uint32_t value) {
+		for (int i = 0; i < 4; i++) bytes.push_back(static_cast<uint8_t>(value >> (i * 8)));
+	}
+
+	void u64(uint64_t value) {
+		u32(static_cast<uint32_t>(value));
+		u32(static_cast<uint32_t>(value >> 32));
+	}
+
+	void i32(int32_t value) { u32(static_cast<uint32_t>(value)); }
+
+	void f32(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		u32(bits);
+	}
+
+	void string(const std::string& value) {
+		u32(static_cast<uint32_t>(value.size()));
+		bytes.insert(bytes.end(), value.begin(), value.end());
+	}
+};
+
+
+void DetectorBank::writeBinary(std::vector<uint8_t>& bytes) const {
+	bytes.clear();
+	DetectorByteWriter out{ bytes };
+	for (char letter : magic) out.u8(static_cast<uint8_t>(letter));
+	out.u32(version);
+
+	out.u32(static_cast<uint32_t>(detectors.size()));
+	for (const auto& detector : detectors) {
+		out.string(detector.id);
+		out.string(detector.roadId);
+		out.u8(static_cast<uint8_t>(detector.direction));
+		out.f32(detector.distance);
+		out.i32(detector.lane);
+	}
+
+	// each resolution: bin length, index of the first bin held, bins held, then count, occupied
+	// seconds and speed sum for every bin of detector 0, detector 1 and so on
+	out.u32(static_cast<uint32_t>(DetectorResolution::COUNT));
+	for (int r = 0; r < static_cast<int>(DetectorResolution::COUNT); r++) {
+		DetectorResolution resolution = static_cast<DetectorResolution>(r);
+		size_t held = getBinCount(resolution);
+
+		out.f32(getBinSeconds(resolution));
+		out.u64(ring(resolution).closed - held);
+		out.u32(static_cast<uint32_t>(held));
+		for (size_t d = 0; d < detectors.size(); d++) {
+			for (size_t i = 0; i < held; i++) {
+				const DetectorBin& bin = getBin(static_cast<int>(d), resolution, i);
+				out.u32(bin.count);
+				out.f32(bin.occupiedTime);
+				out.f32(bin.speedSum);
+			}
+		}
+	}
+}
+
+
+bool DetectorBank::writeBinaryFile(const std::string& path) const {
+	std::vector<uint8_t> bytes;
+	writeBinary(bytes);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) return false;
+	file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	return file.good();
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "roadSegment.h"
+
+
+// a virtual induction loop across one lane, or across every lane of a direction when lane is -1.
+// distance is measured from where the direction of travel enters the segment
+struct LoopDetector {
+	std::string id;
+	std::string roadId;
+	TravelDirection direction = TravelDirection::FORWARD;
+	float distance = 0.0f;
+	int lane = -1;
+};
+
+
+enum class DetectorResolution {
+	SECOND,
+	MINUTE,
+	QUARTER_HOUR,
+	COUNT
+};
+
+
+// what one detector saw over one bin
+struct DetectorBin {
+	uint32_t count = 0;
+
+	// seconds with a vehicle over the loop, and the sum of spot speeds at each crossing
+	float occupiedTime = 0.0f;
+	float speedSum = 0.0f;
+
+	void add(const DetectorBin& other) {
+		count += other.count;
+		occupiedTime += other.occupiedTime;
+		speedSum += other.speedSum;
+	}
+
+	float getFlow(float binSeconds) const { return count * 3600.0f / binSeconds; }
+	float getOccupancy(float binSeconds) const { return occupiedTime / binSeconds; }
+	float getMeanSpeed() const { return count > 0 ? speedSum / count : 0.0f; }
+};
+
+
+// closed bins kept per resolution, memory is fixed once the detectors are placed. the defaults
+// keep 5 minutes of seconds, 2 hours of minutes and a day of quarter hours, about 6 kB a detector
+struct DetectorConfig {
+	uint32_t secondBins = 300;
+	uint32_t minuteBins = 120;
+	uint32_t quarterHourBins = 96;
+};
+
+
+// every detector's counters and ring buffers. segments record crossings and occupancy into the
+// open second bin, and each closed bin is folded into the open bin of the next resolution, so the
+// minute and quarter hour series are exact sums of the seconds. bins close on the tick that reaches
+// their end, so a bin can hold up to one step of the next one
+class DetectorBank {
+private:
+	struct Ring {
+		float binSeconds = 1.0f;
+		uint32_t capacity = 0;
+
+		// bins closed so far, the newest is at (closed - 1) % capacity
+		uint64_t closed = 0;
+
+		// detector d's open bin is open[d], its ring is bins[d * capacity, (d + 1) * capacity)
+		std::vector<DetectorBin> open;
+		std::vector<DetectorBin> bins;
+	};
+
+	DetectorConfig config;
+	std::vector<LoopDetector> detectors;
+	Ring rings[static_cast<int>(DetectorResolution::COUNT)];
+	double clock = 0.0;
+
+	// the tick each detector last counted as occupied, several vehicles over one loop count once
+	std::vector<uint64_t> occupiedTick;
+	uint64_t tick = 1;
+
+	Ring& ring(DetectorResolution resolution) { return rings[static_cast<int>(resolution)]; }
+	const Ring& ring(DetectorResolution resolution) const { return rings[static_cast<int>(resolution)]; }
+	void resizeRings();
+	void closeBins(int resolution);
+
+
+public:
+	DetectorBank();
+
+	// capacities apply to detectors already placed too. what they recorded is dropped and the bank
+	// clock restarts, so bin times afterwards count from the change
+	void setConfig(const DetectorConfig& newConfig);
+	const DetectorConfig& getConfig() const { return config; }
+
+	// returns the detector's index, placement is checked by the network
+	int add(const LoopDetector& detector);
+	void clear();
+
+	// called by segments during the tick
+	void recordCrossing(int detector, float speed) {
+		DetectorBin& bin = rings[0].open[detector];
+		bin.count++;
+		bin.speedSum += speed;
+	}
+	void recordOccupancy(int detector, float deltaTime) {
+		if (occupiedTick[detector] == tick) return;
+		occupiedTick[detector] = tick;
+		rings[0].open[detector].occupiedTime += deltaTime;
+	}
+
+	// called once at the end of each tick, closes every bin the clock has passed
+	void advance(float deltaTime);
+
+	size_t getDetectorCount() const { return detectors.size(); }
+	const LoopDetector& getDetector(int detector) const { return detectors[detector]; }
+	double getClock() const { return clock; }
+
+	// closed bins still held at a resolution, index 0 is the oldest
+	size_t getBinCount(DetectorResolution resolution) const;
+	const DetectorBin& getBin(int detector, DetectorResolution resolution, size_t index) const;
+	double getBinStart(DetectorResolution resolution, size_t index) const;
+	float getBinSeconds(DetectorResolution resolution) const { return ring(resolution).binSeconds; }
+
+	// one row per detector and closed bin: detector, resolution, start, count, flow, occupancy, speed
+	bool writeCsv(const std::string& path) const;
+
+	// the same series as a flat little endian file, detector descriptions first and then each
+	// resolution's bins detector by detector
+	static constexpr char magic[4] = { 'M', 'C', 'L', 'D' };
+	static constexpr uint32_t version = 1;
+	void writeBinary(std::vector<uint8_t>& bytes) const;
+	bool writeBinaryFile(const std::string& path) const;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+
+#include "junction.h"
+#include "roadSegment.h"
+
+
+enum class EditType {
+	ADD_JUNCTION,
+	REMOVE_JUNCTION,
+	ADD_ROAD,
+	REMOVE_ROAD,
+	SET_SPEED_LIMIT
+};
+
+
+// batch of structural changes applied to a running network between ticks,
+// operations run in the order they were recorded
+class NetworkEdit {
+public:
+	struct Operation {
+		EditType type = EditType::ADD_JUNCTION;
+		std::shared_ptr<Junction> junction = nullptr;
+		std::shared_ptr<RoadSegment> road = nullptr;
+		std::string id = "";
+		std::string startJunctionId = "";
+		std::string endJunctionId = "";
+		float speedLimit = 0.0f;
+	};
+
+
+private:
+	std::vector<Operation> operations;
+
+
+public:
+	NetworkEdit& addJunction(std::shared_ptr<Junction> junction) {
+		operations.push_back({ EditType::ADD_JUNCTION, junction, nullptr, junction ? junction->getId() : "" });
+		return *this;
+	}
+
+	// also removes every road connected to the junction
+	NetworkEdit& removeJunction(const std::string& id) {
+		operations.push_back({ EditType::REMOVE_JUNCTION, nullptr, nullptr, id });
+		return *this;
+	}
+
+	// lanes must be added before the road is submitted
+	NetworkEdit& addRoad(std::shared_ptr<RoadSegment> road, const std::string& startJunctionId, const std::string& endJunctionId) {
+		operations.push_back({ EditType::ADD_ROAD, nullptr, road, road ? road->getId() : "", startJunctionId, endJunctionId });
+		return *this;
+	}
+
+	// vehicles on the road leave the network, vehicles routed over it re-plan at their next junction
+	NetworkEdit& removeRoad(const std::string& id) {
+		operations.push_back({ EditType::REMOVE_ROAD, nullptr, nullptr, id });
+		return *this;
+	}
+
+	NetworkEdit& setSpeedLimit(const std::string& roadId, float speedLimit) {
+		Operation operation = { EditType::SET_SPEED_LIMIT, nullptr, nullptr, roadId };
+		operation.speedLimit = speedLimit;
+		operations.push_back(operation);
+		return *this;
+	}
+
+	const std::vector<Operation>& getOperations() const { return operations; }
+	bool empty() const { return operations.empty(); }
+};
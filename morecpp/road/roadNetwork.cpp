@@ -1,15 +1,22 @@
 #include "roadNetwork.h"
 
 #include <random>
+#include <algorithm>
 #include <iostream>
 
 #include "simpleJunction.h"
+#include "trafficLightJunction.h"
 #include "../traffic/car.h"
 
 
+RoadNetwork::RoadNetwork() : routeManager(std::make_shared<RouteManager>()), random(std::random_device{}()) {}
+
+
 void RoadNetwork::addJunction(std::shared_ptr<Junction> junction) {
     if (junction) {
         junctions[junction->getId()] = junction;
+        routeManager->addJunction(junction);
+        revision++;
     }
 }
 
@@ -17,6 +24,13 @@ void RoadNetwork::addJunction(std::shared_ptr<Junction> junction) {
 void RoadNetwork::addRoadSegment(std::shared_ptr<RoadSegment> roadSegment) {
     if (roadSegment) {
         roadSegments[roadSegment->getId()] = roadSegment;
+        routeManager->addRoadSegment(roadSegment);
+
+        // room for every segment, so segments joining mid tick never move the list
+        activeSegments.reserve(roadSegments.size());
+        roadSegment->setActiveList(&activeSegments);
+        roadSegment->setCompiledNetwork(&compiled);
+        revision++;
     }
 }
 
@@ -24,6 +38,7 @@ void RoadNetwork::addRoadSegment(std::shared_ptr<RoadSegment> roadSegment) {
 void RoadNetwork::addSpawnPoint(std::shared_ptr<SpawnPoint> spawnPoint) {
     if (spawnPoint) {
         spawnPoints.push_back(spawnPoint);
+        demandDirty = true;
     }
 }
 
@@ -31,6 +46,7 @@ void RoadNetwork::addSpawnPoint(std::shared_ptr<SpawnPoint> spawnPoint) {
 void RoadNetwork::addDestination(std::shared_ptr<Destination> destination) {
     if (destination) {
         destinations.push_back(destination);
+        demandDirty = true;
     }
 }
 
@@ -54,84 +70,525 @@ std::shared_ptr<RoadSegment> RoadNetwork::getRoadSegment(const std::string& id)
 
 
 void RoadNetwork::update(float deltaTime) {
-    for (auto& [id, roadSegment] : roadSegments) {
-        roadSegment->update(deltaTime);
+    frameArena.reset();
+    FrameArena::Binding arenaBinding(frameArena);
+    decisions.advance(deltaTime);
+
+    {
+        AllocationScope allocations(AllocationSubsystem::EDITS);
+        for (const auto& edit : pendingEdits) {
+            applyEdit(edit);
+        }
+        pendingEdits.clear();
+    }
+
+    {
+        AllocationScope allocations(AllocationSubsystem::INCIDENTS);
+        updateIncidents(deltaTime);
+    }
+
+    if (compiled.isStale(revision)) {
+        AllocationScope allocations(AllocationSubsystem::EDITS);
+        compile();
+    }
+
+    if (fullSweep) {
+        for (const auto& roadSegment : compiled.getSegments()) {
+            roadSegment->markActive();
+        }
+    }
+
+    // segments are visited in index order, which follows the curve for networks compiled before they ran
+    if (!std::is_sorted(activeSegments.begin(), activeSegments.end(), [](RoadSegment* a, RoadSegment* b) { return a->getIndex() < b->getIndex(); })) {
+        std::sort(activeSegments.begin(), activeSegments.end(), [](RoadSegment* a, RoadSegment* b) { return a->getIndex() < b->getIndex(); });
+    }
+
+    // a changed route tree may send a queued vehicle somewhere its signal already lets it go
+    if (routeManager->getRevision() != wokenRouteRevision) {
+        wokenRouteRevision = routeManager->getRevision();
+        for (RoadSegment* roadSegment : activeSegments) {
+            roadSegment->wakeVehicles();
+        }
+    }
+
+    {
+        AllocationScope allocations(AllocationSubsystem::SEGMENTS);
+
+        // segments handed their first vehicle during the loop join behind it and wait for the commit
+        size_t updating = activeSegments.size();
+        for (size_t i = 0; i < updating; i++) {
+            activeSegments[i]->update(deltaTime);
+        }
+
+        // vehicles that changed segment this tick join their new segment
+        stepLimits = StepLimits();
+        for (RoadSegment* roadSegment : activeSegments) {
+            roadSegment->commitIncomingVehicles();
+            roadSegment->rebuildLaneIndex();
+            roadSegment->sampleDetectors(deltaTime);
+            roadSegment->releaseArrivedVehicles(vehiclePool);
+
+            stepLimits.maxSpeed = std::max(stepLimits.maxSpeed, roadSegment->getMaxVehicleSpeed());
+            stepLimits.closingTime = std::min(stepLimits.closingTime, roadSegment->getClosingTime());
+
+            int index = roadSegment->getIndex();
+            if (index < 0) continue;
+            if (index >= static_cast<int>(segmentTraffic.size())) {
+                segmentTraffic.resize(index + 1, { 0.0f, 1.0f });
+            }
+
+            float speedLimit = roadSegment->getSpeedLimit();
+            float speedRatio = roadSegment->getVehicles().empty() || speedLimit <= 0.0f ? 1.0f : roadSegment->getMeanSpeed() / speedLimit;
+            segmentTraffic[index] = { roadSegment->getDensity(), std::min(speedRatio, 1.0f) };
+        }
+
+        // segments left empty have written their empty traffic and drop out until a vehicle enters
+        activeSegments.erase(std::remove_if(activeSegments.begin(), activeSegments.end(), [](RoadSegment* roadSegment) {
+            if (!roadSegment->isIdle()) return false;
+            roadSegment->deactivate();
+            return true;
+        }), activeSegments.end());
+
+        detectors.advance(deltaTime);
     }
 
-    for (auto& [id, junction] : junctions) {
-        junction->update(deltaTime);
+    {
+        AllocationScope allocations(AllocationSubsystem::JUNCTIONS);
+        if (fullSweep) {
+            for (const auto& junction : compiled.getJunctions()) {
+                junction->update(deltaTime);
+            }
+        } else {
+            for (Junction* junction : timedJunctions) {
+                junction->update(deltaTime);
+            }
+        }
     }
 
-    generateTraffic(deltaTime);
+    {
+        AllocationScope allocations(AllocationSubsystem::DEMAND);
+        generateTraffic(deltaTime);
+    }
 }
 
 
-void RoadNetwork::generateTraffic(float deltaTime) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> spawnTimeDist(2.0f, 8.0f);
-    static std::uniform_real_distribution<> speedDist(3.0f, 12.0f);
-    static std::uniform_real_distribution<> colorDist(55, 255);
-
-    for (auto& spawnPoint : spawnPoints) {
-        spawnPoint->timeToNextSpawn -= deltaTime;
-        
-        if (spawnPoint->timeToNextSpawn <= 0) {
-            spawnPoint->timeToNextSpawn = spawnTimeDist(gen);
-
-            auto roadSegment = spawnPoint->roadSegment.lock();
-            if (!roadSegment) continue;
-
-            std::vector<int> validLanes;
-            for (const auto& lane : roadSegment->getLanes()) {
-                if (lane.getType() == LaneType::REGULAR) {
-                    validLanes.push_back(lane.getIndex());
-                }
+void RoadNetwork::buildDefaultDemand() {
+    demand.clearOrigins();
+
+    for (size_t i = 0; i < spawnPoints.size(); i++) {
+        auto roadSegment = spawnPoints[i]->roadSegment.lock();
+        if (!roadSegment) continue;
+
+        // only destinations the origin can reach get demand
+        int originNode = RouteManager::toNode(roadSegment->getIndex(), spawnPoints[i]->direction);
+        std::vector<float> destinationWeights(destinations.size(), 0.0f);
+        bool reachable = destinations.empty();
+        for (size_t j = 0; j < destinations.size(); j++) {
+            if (routeManager->planRoute(originNode, destinations[j]) != RoutePool::invalidRoute) {
+                destinationWeights[j] = 1.0f;
+                reachable = true;
+            }
+        }
+
+        std::vector<int> laneIndices;
+        for (const auto& lane : roadSegment->getLanes(spawnPoints[i]->direction)) {
+            if (lane.getType() == LaneType::REGULAR) {
+                laneIndices.push_back(lane.getIndex());
             }
+        }
+
+        if (!reachable || laneIndices.empty()) continue;
+
+        demand.setOrigin(static_cast<int>(i), spawnPoints[i]->spawnRate, destinationWeights, laneIndices, {});
+    }
+
+    demandDirty = false;
+}
+
+
+bool RoadNetwork::spawnVehicle(const TripRequest& trip) {
+    std::uniform_real_distribution<> speedDist(3.0f, 12.0f);
+    std::uniform_real_distribution<> colorDist(55, 255);
 
-            if (validLanes.empty()) continue;
+    if (trip.origin < 0 || trip.origin >= static_cast<int>(spawnPoints.size())) return true;
 
-            std::uniform_int_distribution<> laneDist(0, validLanes.size() - 1);
-            int laneIndex = validLanes[laneDist(gen)];
+    const auto& spawnPoint = spawnPoints[trip.origin];
+    auto roadSegment = spawnPoint->roadSegment.lock();
+    TravelDirection direction = spawnPoint->direction;
+    if (!roadSegment || trip.lane >= roadSegment->getLaneCount(direction) || roadSegment->getLaneCount(direction) == 0) return true;
 
-            Vector3 spawnPosition = roadSegment->getLanePositionAt(laneIndex, spawnPoint->distanceAlongRoad);
+    // trips that name no lane (demand files may leave it out) start from a random one
+    int preferredLane = trip.lane;
+    if (preferredLane < 0) {
+        std::uniform_int_distribution<> laneDist(0, roadSegment->getLaneCount(direction) - 1);
+        preferredLane = laneDist(random);
+    }
 
-            auto car = std::make_shared<Car>(
-                spawnPosition,
-                Vector3(4.0f, 0.2f, 2.0f),
-                Color(colorDist(gen), colorDist(gen), colorDist(gen)),
-                speedDist(gen)
-            );
+    // trips wait while an incident closes the spawn road, otherwise shift to an open lane
+    int lane = roadSegment->findOpenLane(preferredLane, direction);
+    if (lane < 0) return false;
 
-            roadSegment->addVehicle(car);
+    // wait while the last vehicle to enter is still on top of the spawn point
+    LaneNeighbors neighbors = roadSegment->findNeighbors(lane, spawnPoint->distanceAlongRoad, nullptr, direction);
+    if (neighbors.leader && neighbors.leader->getDistanceAlongRoad() - spawnPoint->distanceAlongRoad < minSpawnSpacing) {
+        return false;
+    }
 
-            if (!destinations.empty()) {
-                std::uniform_int_distribution<> destDist(0, destinations.size() - 1);
-                car->setDestination(destinations[destDist(gen)]);
+    Vector3 spawnPosition = roadSegment->getLanePositionAt(lane, spawnPoint->distanceAlongRoad, direction);
+
+    // drawn one by one, argument evaluation order would differ between compilers
+    unsigned char red = static_cast<unsigned char>(colorDist(random));
+    unsigned char green = static_cast<unsigned char>(colorDist(random));
+    unsigned char blue = static_cast<unsigned char>(colorDist(random));
+    float preferredSpeed = static_cast<float>(speedDist(random));
+
+    // reuse a vehicle that has arrived once nothing else refers to it
+    std::shared_ptr<Vehicle> car;
+    if (!vehiclePool.empty() && vehiclePool.back().use_count() == 1) {
+        car = std::move(vehiclePool.back());
+        vehiclePool.pop_back();
+        car->reset(spawnPosition, Vector3(4.0f, 0.2f, 2.0f), Color(red, green, blue));
+        car->setPreferredSpeed(preferredSpeed);
+    } else {
+        car = std::make_shared<Car>(spawnPosition, Vector3(4.0f, 0.2f, 2.0f), Color(red, green, blue), preferredSpeed);
+    }
+    car->setId(nextVehicleId++);
+    car->seedRandom(random());
+    car->setDecisionSchedule(&decisions);
+
+    roadSegment->addVehicle(car, spawnPoint->distanceAlongRoad, lane, direction);
+
+    if (trip.destination >= 0 && trip.destination < static_cast<int>(destinations.size())) {
+        auto destination = destinations[trip.destination];
+        car->setDestination(destination);
+        car->setRoute(routeManager.get(), routeManager->planRoute(RouteManager::toNode(roadSegment->getIndex(), direction), destination));
+    }
+
+    return true;
+}
+
+
+void RoadNetwork::generateTraffic(float deltaTime) {
+    if (demandDirty) {
+        buildDefaultDemand();
+    }
+
+    demand.advance(deltaTime, dueTrips);
+
+    // keep blocked trips queued at their origin, in order
+    AllocationScope allocations(AllocationSubsystem::SPAWNING);
+    size_t waiting = 0;
+    for (const auto& trip : dueTrips) {
+        if (!spawnVehicle(trip)) {
+            dueTrips[waiting++] = trip;
+        }
+    }
+    dueTrips.resize(waiting);
+}
+
+
+void RoadNetwork::setSeed(uint64_t seed) {
+    random.seed(seed);
+
+    // a separate stream for arrivals so demand does not shift when spawning draws more
+    demand.setSeed(StateHasher::mix(seed + 1));
+}
+
+
+void RoadNetwork::reserveVehicles(size_t count) {
+    vehiclePool.reserve(count);
+    // room for a backlog of trips at every blocked spawn point
+    dueTrips.reserve(spawnPoints.size() * 16);
+
+    while (vehiclePool.size() < count) {
+        vehiclePool.push_back(std::make_shared<Car>(Vector3(0.0f, 0.0f, 0.0f), Vector3(4.0f, 0.2f, 2.0f), Color(255, 255, 255), 0.0f));
+    }
+}
+
+
+uint64_t RoadNetwork::hashState(std::vector<EntityDigest>* entities) const {
+    StateHasher global;
+    global.add(random.getState());
+    global.add(nextVehicleId);
+    global.add(revision);
+    global.add(demand.getClock(), 0.001);
+    global.add(demand.getRandomState());
+    global.add(static_cast<uint64_t>(dueTrips.size()));
+    global.add(incidents.getClock(), 0.001);
+    global.add(decisions.getTick());
+
+    size_t firstEntity = entities ? entities->size() : 0;
+    if (entities) {
+        entities->push_back({ "network", global.get() });
+    }
+
+    // summed so the result does not depend on the order the maps or segments are visited in
+    uint64_t total = global.get();
+    std::vector<std::pair<uint32_t, uint64_t>> vehicleHashes;
+
+    for (const auto& [id, roadSegment] : roadSegments) {
+        StateHasher segmentHasher;
+        segmentHasher.add(roadSegment->getIndex());
+        segmentHasher.add(roadSegment->getSpeedLimit(), 0.001);
+        segmentHasher.add(roadSegment->getOpenLaneCount(TravelDirection::FORWARD));
+        segmentHasher.add(roadSegment->getOpenLaneCount(TravelDirection::REVERSE));
+        segmentHasher.add(static_cast<uint64_t>(roadSegment->getVehicles().size()));
+        total += StateHasher::mix(segmentHasher.get());
+
+        if (entities) {
+            entities->push_back({ "segment " + id, segmentHasher.get() });
+        }
+
+        for (const auto& vehicle : roadSegment->getVehicles()) {
+            if (!vehicle) continue;
+
+            StateHasher vehicleHasher;
+            vehicle->hashState(vehicleHasher);
+            total += StateHasher::mix(vehicleHasher.get());
+
+            if (entities) {
+                vehicleHashes.push_back({ vehicle->getId(), vehicleHasher.get() });
             }
         }
     }
+
+    for (const auto& [id, junction] : junctions) {
+        StateHasher junctionHasher;
+        junction->hashState(junctionHasher);
+        total += StateHasher::mix(junctionHasher.get());
+
+        if (entities) {
+            entities->push_back({ "junction " + id, junctionHasher.get() });
+        }
+    }
+
+    // canonical order for reports: network, segments and junctions by id, vehicles by spawn order
+    if (entities) {
+        std::sort(entities->begin() + firstEntity + 1, entities->end(), [](const EntityDigest& a, const EntityDigest& b) { return a.entity < b.entity; });
+        std::sort(vehicleHashes.begin(), vehicleHashes.end());
+        for (const auto& [vehicleId, hash] : vehicleHashes) {
+            entities->push_back({ "vehicle " + std::to_string(vehicleId), hash });
+        }
+    }
+
+    return total;
 }
 
 
 std::vector<std::shared_ptr<RoadSegment>> RoadNetwork::getAllRoadSegments() const {
     std::vector<std::shared_ptr<RoadSegment>> result;
-    for (const auto& [id, roadSegment] : roadSegments) {
-        result.push_back(roadSegment);
-    }
+    result.reserve(roadSegments.size());
+    forEachRoadSegment([&](const std::shared_ptr<RoadSegment>& roadSegment) { result.push_back(roadSegment); });
     return result;
 }
 
 
 std::vector<std::shared_ptr<Junction>> RoadNetwork::getAllJunctions() const {
     std::vector<std::shared_ptr<Junction>> result;
-    for (const auto& [id, junction] : junctions) {
-        result.push_back(junction);
-    }
+    result.reserve(junctions.size());
+    forEachJunction([&](const std::shared_ptr<Junction>& junction) { result.push_back(junction); });
     return result;
 }
 
 
+void RoadNetwork::applyEdit(const NetworkEdit& edit) {
+    std::vector<std::shared_ptr<Junction>> touched;
+
+    for (const auto& operation : edit.getOperations()) {
+        switch (operation.type) {
+        case EditType::ADD_JUNCTION: {
+            if (!operation.junction || getJunction(operation.id)) {
+                std::cerr << "Edit: junction " << operation.id << " is invalid or already exists" << std::endl;
+                break;
+            }
+            addJunction(operation.junction);
+            break;
+        }
+
+        case EditType::REMOVE_JUNCTION: {
+            auto junction = getJunction(operation.id);
+            if (!junction) {
+                std::cerr << "Edit: no junction " << operation.id << std::endl;
+                break;
+            }
+
+            for (const auto& road : junction->getConnectedRoads()) {
+                detachRoad(road, touched);
+            }
+
+            routeManager->removeJunction(junction);
+            junctions.erase(operation.id);
+            break;
+        }
+
+        case EditType::ADD_ROAD: {
+            auto start = getJunction(operation.startJunctionId);
+            auto end = getJunction(operation.endJunctionId);
+            if (!operation.road || !start || !end || getRoadSegment(operation.id)) {
+                std::cerr << "Edit: cannot add road " << operation.id << std::endl;
+                break;
+            }
+
+            operation.road->setJunctions(start, end);
+            start->connectRoad(operation.road);
+            if (end != start) {
+                end->connectRoad(operation.road);
+            }
+            addRoadSegment(operation.road);
+
+            touched.push_back(start);
+            touched.push_back(end);
+            break;
+        }
+
+        case EditType::REMOVE_ROAD: {
+            auto road = getRoadSegment(operation.id);
+            if (!road) {
+                std::cerr << "Edit: no road " << operation.id << std::endl;
+                break;
+            }
+            detachRoad(road, touched);
+            break;
+        }
+
+        case EditType::SET_SPEED_LIMIT: {
+            auto road = getRoadSegment(operation.id);
+            if (!road || operation.speedLimit <= 0.0f) {
+                std::cerr << "Edit: cannot set speed limit on " << operation.id << std::endl;
+                break;
+            }
+            road->setSpeedLimit(operation.speedLimit);
+            routeManager->updateRoadSegment(road);
+            break;
+        }
+        }
+    }
+
+    // only junctions that gained or lost a road get new signal phases
+    for (const auto& junction : touched) {
+        if (!getJunction(junction->getId())) continue;
+
+        if (auto trafficJunction = std::dynamic_pointer_cast<TrafficLightJunction>(junction)) {
+            trafficJunction->generatePhases();
+        }
+    }
+
+    revision++;
+}
+
+
+void RoadNetwork::updateIncidents(float deltaTime) {
+    dueIncidents.clear();
+    incidents.advance(deltaTime, dueIncidents);
+
+    for (const auto& event : dueIncidents) {
+        const Incident& incident = incidents.getIncident(event.incident);
+
+        // the road may have been removed by an edit since the incident was scheduled
+        auto road = getRoadSegment(incident.roadId);
+        if (!road) continue;
+
+        switch (incident.type) {
+        case IncidentType::LANE_CLOSURE:
+            if (event.starting) road->closeLane(incident.laneIndex, incident.direction);
+            else road->reopenLane(incident.laneIndex, incident.direction);
+            break;
+
+        case IncidentType::SEGMENT_CLOSURE:
+            for (int lane = 0; lane < road->getLaneCount(incident.direction); lane++) {
+                if (event.starting) road->closeLane(lane, incident.direction);
+                else road->reopenLane(lane, incident.direction);
+            }
+            break;
+
+        case IncidentType::SPEED_REDUCTION:
+            if (event.starting) road->addSpeedReduction(incident.speedFactor);
+            else road->removeSpeedReduction(incident.speedFactor);
+            break;
+        }
+
+        // repairs only the route tree entries that ran over this road
+        routeManager->updateRoadSegment(road);
+    }
+}
+
+
+int RoadNetwork::addDetector(const LoopDetector& detector) {
+    // vehicles start a segment at distance 0, so a loop there would never see anyone cross it
+    auto road = getRoadSegment(detector.roadId);
+    if (!road || !road->hasDirection(detector.direction) || detector.distance <= 0.0f || detector.distance > road->getLength()
+        || detector.lane >= road->getLaneCount(detector.direction)) {
+        std::cerr << "Detector: cannot place " << detector.id << " on " << detector.roadId << std::endl;
+        return -1;
+    }
+
+    int index = detectors.add(detector);
+    road->addDetector({ detector.distance, std::max(detector.lane, -1), index }, detector.direction, &detectors);
+    return index;
+}
+
+
+int RoadNetwork::scheduleIncident(const Incident& incident) {
+    if (incident.type == IncidentType::SPEED_REDUCTION && incident.speedFactor <= 0.0f) {
+        std::cerr << "Incident: speed factor must be positive on " << incident.roadId << std::endl;
+        return -1;
+    }
+    return incidents.schedule(incident);
+}
+
+
+void RoadNetwork::detachRoad(const std::shared_ptr<RoadSegment>& road, std::vector<std::shared_ptr<Junction>>& touched) {
+    for (const auto& junction : { road->getStartJunction(), road->getEndJunction() }) {
+        if (junction) {
+            junction->disconnectRoad(road);
+            touched.push_back(junction);
+        }
+    }
+
+    // vehicles on the road leave with it, spawn points on it expire with the road
+    road->clearVehicles();
+    if (road->getIndex() >= 0 && road->getIndex() < static_cast<int>(segmentTraffic.size())) {
+        segmentTraffic[road->getIndex()] = { 0.0f, 1.0f };
+    }
+    routeManager->removeRoadSegment(road);
+
+    auto listed = std::find(activeSegments.begin(), activeSegments.end(), road.get());
+    if (listed != activeSegments.end()) {
+        activeSegments.erase(listed);
+    }
+    road->setActiveList(nullptr);
+    road->setCompiledNetwork(nullptr);
+    roadSegments.erase(road->getId());
+}
+
+
+void RoadNetwork::releaseActiveSegments() {
+    for (auto& [id, roadSegment] : roadSegments) {
+        roadSegment->setActiveList(nullptr);
+        roadSegment->setCompiledNetwork(nullptr);
+    }
+    activeSegments.clear();
+    timedJunctions.clear();
+    compiled.clear();
+}
+
+
+void RoadNetwork::compile() {
+    compiled.compile(junctions, roadSegments, revision);
+
+    if (nextVehicleId == 0 && routeManager->renumberSegments(compiled.getSegments())) {
+        segmentTraffic.clear();
+    }
+    compiled.linkNodes();
+    routeManager->setNetwork(compiled);
+
+    timedJunctions.clear();
+    for (const auto& junction : compiled.getJunctions()) {
+        if (junction->isTimed()) timedJunctions.push_back(junction.get());
+    }
+}
+
+
 bool RoadNetwork::connectRoads(const std::string& roadId1, const std::string& roadId2, const std::string& junctionId) {
     auto road1 = getRoadSegment(roadId1);
     auto road2 = getRoadSegment(roadId2);
@@ -151,14 +608,31 @@ bool RoadNetwork::connectRoads(const std::string& roadId1, const std::string& ro
 }
 
 
-void RoadNetwork::buildNetwork(int gridWidth, int gridHeight, int numLanes, float roadLength, float roadWidth, float speedLimit) {
+void RoadNetwork::buildNetwork(int gridWidth, int gridHeight, int numLanes, float roadLength, float roadWidth, float speedLimit, bool twoWay, bool signalized) {
     std::cout << "Building network with dimensions: " << gridWidth << "x" << gridHeight << std::endl;
     
     // start with clean network
+    releaseActiveSegments();
+    detectors.clear();
     junctions.clear();
     roadSegments.clear();
     spawnPoints.clear();
     destinations.clear();
+    routeManager = std::make_shared<RouteManager>();
+    demandDirty = true;
+
+    // shoulder, regular lanes, shoulder for each direction the roads carry
+    auto addLanes = [&](std::shared_ptr<RoadSegment> road) {
+        for (TravelDirection direction : { TravelDirection::FORWARD, TravelDirection::REVERSE }) {
+            if (direction == TravelDirection::REVERSE && !twoWay) continue;
+
+            road->addLane(Lane(0, LaneType::SHOULDER, 2.0f), direction);
+            for (int i = 0; i < numLanes; i++) {
+                road->addLane(Lane(i + 1, LaneType::REGULAR, 4.0f), direction);
+            }
+            road->addLane(Lane(numLanes + 1, LaneType::SHOULDER, 2.0f), direction);
+        }
+    };
 
 
     // create junction grid
@@ -167,8 +641,14 @@ void RoadNetwork::buildNetwork(int gridWidth, int gridHeight, int numLanes, floa
         for (int y = 0; y <= gridHeight; y++) {
             std::string junctionId = "junction_" + std::to_string(x) + "_" + std::to_string(y);
             Vector3 position(x * roadLength, 0, y * roadLength);
-            auto junction = std::make_shared<SimpleJunction>(junctionId, position);
-            addJunction(junction);
+
+            // signals only where roads cross, edge junctions stay simple
+            bool interior = x > 0 && x < gridWidth && y > 0 && y < gridHeight;
+            if (signalized && interior) {
+                addJunction(std::make_shared<TrafficLightJunction>(junctionId, position));
+            } else {
+                addJunction(std::make_shared<SimpleJunction>(junctionId, position));
+            }
         }
     }
 
@@ -190,11 +670,7 @@ void RoadNetwork::buildNetwork(int gridWidth, int gridHeight, int numLanes, floa
             auto road = std::make_shared<RoadSegment>(roadId, startJunction->getPosition(), Vector3(roadLength, 0, roadWidth), speedLimit);
 
             // add lanes
-            road->addLane(Lane(0, LaneType::SHOULDER, 2.0f));
-            for (int i = 0; i < numLanes; i++) {
-                road->addLane(Lane(i + 1, LaneType::REGULAR, 4.0f));
-            }
-            road->addLane(Lane(numLanes + 1, LaneType::SHOULDER, 2.0f));
+            addLanes(road);
 
             road->setJunctions(startJunction, endJunction);
             startJunction->connectRoad(road);
@@ -207,9 +683,13 @@ void RoadNetwork::buildNetwork(int gridWidth, int gridHeight, int numLanes, floa
                 auto spawnPoint = std::make_shared<SpawnPoint>();
                 spawnPoint->roadSegment = road;
                 spawnPoint->distanceAlongRoad = 0.0f;
-                spawnPoint->timeToNextSpawn = 5.0f;
                 addSpawnPoint(spawnPoint);
             }
+
+            // two way roads also feed traffic in from the east edge
+            if (twoWay && x == gridWidth - 1) {
+                addSpawnPoint(std::make_shared<SpawnPoint>(road, 0.0f, 10.0f, TravelDirection::REVERSE));
+            }
         }
     }
 
@@ -228,11 +708,7 @@ void RoadNetwork::buildNetwork(int gridWidth, int gridHeight, int numLanes, floa
             auto road = std::make_shared<RoadSegment>(roadId, startJunction->getPosition(), Vector3(roadLength, 0, roadWidth), speedLimit);
 
             // add lanes
-            road->addLane(Lane(0, LaneType::SHOULDER, 2.0f));
-            for (int i = 0; i < numLanes; i++) {
-                road->addLane(Lane(i + 1, LaneType::REGULAR, 4.0f));
-            }
-            road->addLane(Lane(numLanes + 1, LaneType::SHOULDER, 2.0f));
+            addLanes(road);
 
             // connect junctions
             road->setJunctions(startJunction, endJunction);
@@ -240,19 +716,33 @@ void RoadNetwork::buildNetwork(int gridWidth, int gridHeight, int numLanes, floa
             endJunction->connectRoad(road);
 
             addRoadSegment(road);
+
+            // and from the top and bottom edges
+            if (twoWay && y == 0) {
+                addSpawnPoint(std::make_shared<SpawnPoint>(road, 0.0f));
+            }
+            if (twoWay && y == gridHeight - 1) {
+                addSpawnPoint(std::make_shared<SpawnPoint>(road, 0.0f, 10.0f, TravelDirection::REVERSE));
+            }
+        }
+    }
+
+    if (signalized) {
+        for (const auto& [id, junction] : junctions) {
+            if (auto trafficJunction = std::dynamic_pointer_cast<TrafficLightJunction>(junction)) {
+                trafficJunction->generatePhases();
+            }
         }
     }
 
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<>widthDist(0, gridWidth);
-    static std::uniform_int_distribution<>heightDist(0, gridHeight);
+    std::uniform_int_distribution<> widthDist(0, gridWidth);
+    std::uniform_int_distribution<> heightDist(0, gridHeight);
 
     std::cout << "adding destinations" << std::endl;
     int numDestinations = std::min(5, gridWidth * gridHeight / 4);
     for (int i = 0; i < numDestinations; i++) {
-        int x = widthDist(gen);
-        int y = heightDist(gen);
+        int x = widthDist(random);
+        int y = heightDist(random);
 
         std::string junctionId = "junction_" + std::to_string(x) + "_" + std::to_string(y);
         auto junction = getJunction(junctionId);
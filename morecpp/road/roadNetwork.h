@@ -4,11 +4,42 @@
 #include <memory>
 #include <unordered_map>
 #include <string>
+#include <limits>
 
 #include "junction.h"
 #include "roadSegment.h"
 #include "spawnPoint.h"
+#include "networkEdit.h"
+#include "incident.h"
+#include "compiledNetwork.h"
+#include "loopDetector.h"
+#include "../core/random.h"
+#include "../core/stateHash.h"
+#include "../core/frameArena.h"
+#include "../core/allocationStats.h"
 #include "../navigation/destination.h"
+#include "../navigation/routeManager.h"
+#include "../traffic/demandModel.h"
+#include "../traffic/decisionSchedule.h"
+
+
+// traffic on one segment, packed for the heatmap overlay
+struct SegmentTraffic {
+	// 0 empty to 1 jammed
+	float density;
+
+	// mean speed over the speed limit, 1 when empty
+	float speedRatio;
+};
+
+
+// what the last tick's traffic allows for the length of the next step
+struct StepLimits {
+	float maxSpeed = 0.0f;
+
+	// shortest time until some vehicle reaches the one ahead, infinite when nobody is closing in
+	float closingTime = std::numeric_limits<float>::infinity();
+};
 
 
 class RoadNetwork {
@@ -17,9 +48,66 @@ private:
 	std::unordered_map<std::string, std::shared_ptr<RoadSegment>> roadSegments;
 	std::vector<std::shared_ptr<SpawnPoint>> spawnPoints;
 	std::vector<std::shared_ptr<Destination>> destinations;
+	std::shared_ptr<RouteManager> routeManager;
+
+	DemandModel demand;
+	// trips waiting to enter the network (kept while their spawn point is blocked)
+	std::vector<TripRequest> dueTrips;
+	bool demandDirty = true;
+
+	static constexpr float minSpawnSpacing = 8.0f;
+
+	// network level draws (spawned vehicle traits, destinations) and the seeds of each vehicle's stream
+	Random random;
+	uint32_t nextVehicleId = 0;
+
+	// arrived vehicles waiting to be respawned, so steady traffic does not allocate vehicles
+	std::vector<std::shared_ptr<Vehicle>> vehiclePool;
+
+	// scratch memory for one tick, bound to the updating thread
+	FrameArena frameArena;
+
+	// edits submitted by tools are applied at the start of the next tick
+	std::vector<NetworkEdit> pendingEdits;
+	uint32_t revision = 0;
+
+	// indexed by segment index, written by each segment as it finishes its tick
+	std::vector<SegmentTraffic> segmentTraffic;
+	StepLimits stepLimits;
+
+	IncidentSchedule incidents;
+	std::vector<IncidentEvent> dueIncidents;
+
+	// route revision parked vehicles were last woken for, they re-plan at the stop line once it moves on
+	uint32_t wokenRouteRevision = 0;
+
+	// which vehicles run their slow decisions this tick
+	DecisionSchedule decisions;
+
+	// per tick work only visits segments holding vehicles and junctions with a clock of their own.
+	// segments add themselves when a vehicle enters, the timed list comes with each compile
+	std::vector<RoadSegment*> activeSegments;
+	std::vector<Junction*> timedJunctions;
+
+	// visits every segment and junction each tick instead, the reference the active set is checked against
+	bool fullSweep = false;
+
+	// junctions and segments in curve order, recompiled when the revision moves on
+	CompiledNetwork compiled;
+
+	// counts, occupancy and speeds at the loop detectors, closed into bins at the end of each tick
+	DetectorBank detectors;
+
+	void buildDefaultDemand();
+	bool spawnVehicle(const TripRequest& trip);
+	void updateIncidents(float deltaTime);
+	void detachRoad(const std::shared_ptr<RoadSegment>& road, std::vector<std::shared_ptr<Junction>>& touched);
+	void releaseActiveSegments();
 
 
 public:
+	RoadNetwork();
+
 	void addJunction(std::shared_ptr<Junction> junction);
 	void addRoadSegment(std::shared_ptr<RoadSegment> roadSegment);
 	void addSpawnPoint(std::shared_ptr<SpawnPoint> spawnPoint);
@@ -29,10 +117,82 @@ public:
 	std::shared_ptr<RoadSegment> getRoadSegment(const std::string& id);
 	std::vector<std::shared_ptr<RoadSegment>> getAllRoadSegments() const;
 	std::vector<std::shared_ptr<Junction>> getAllJunctions() const;
+	const RouteManager& getRouteManager() const { return *routeManager; }
+	const std::vector<SegmentTraffic>& getSegmentTraffic() const { return segmentTraffic; }
+	const StepLimits& getStepLimits() const { return stepLimits; }
+	const FrameArena& getFrameArena() const { return frameArena; }
+	const std::vector<RoadSegment*>& getActiveSegments() const { return activeSegments; }
+	const CompiledNetwork& getCompiledNetwork() const { return compiled; }
+
+	// orders the network for traversal, called by builders once the network is complete and by
+	// update after edits. the first compile before any vehicle spawns also renumbers the segments
+	// along the curve, so routing, the traffic arrays and the per tick visits follow it too
+	void compile();
+
+	// visit without building a vector, in compiled order when the compile is current
+	template <typename Visitor>
+	void forEachRoadSegment(Visitor&& visit) const {
+		if (!compiled.isStale(revision)) {
+			for (const auto& roadSegment : compiled.getSegments()) visit(roadSegment);
+			return;
+		}
+		for (const auto& [id, roadSegment] : roadSegments) visit(roadSegment);
+	}
+
+	template <typename Visitor>
+	void forEachJunction(Visitor&& visit) const {
+		if (!compiled.isStale(revision)) {
+			for (const auto& junction : compiled.getJunctions()) visit(junction);
+			return;
+		}
+		for (const auto& [id, junction] : junctions) visit(junction);
+	}
 
 	void update(float deltaTime);
 	void generateTraffic(float deltaTime);
 
+	// fills the vehicle pool up front so spawning stays off the heap until count vehicles are out
+	void reserveVehicles(size_t count);
+
+	// the same seed, network and inputs replay the same run
+	void setSeed(uint64_t seed);
+
+	// hash of everything that evolves per tick. entities add their hashes order independently,
+	// so engines that visit segments or vehicles in another order still agree.
+	// entities, when given, receives each entity's own hash in a canonical order
+	uint64_t hashState(std::vector<EntityDigest>* entities = nullptr) const;
+
+	// demand defaults to each spawn point's rate with uniform reachable destinations
+	DemandModel& getDemandModel() { if (demandDirty) buildDefaultDemand(); return demand; }
+
+	// live editing, submitEdit is safe at any time, applyEdit only between ticks
+	void submitEdit(NetworkEdit edit) { pendingEdits.push_back(std::move(edit)); }
+	void applyEdit(const NetworkEdit& edit);
+
+	// bumped by every structural change so caches built from the network know to refresh
+	uint32_t getRevision() const { return revision; }
+
+	// incidents run on simulation time, -1 if the incident is invalid
+	int scheduleIncident(const Incident& incident);
+	const IncidentSchedule& getIncidents() const { return incidents; }
+
+	// virtual loop detectors, -1 if the road, direction, distance or lane does not exist.
+	// set the config before placing them, changing it drops what was recorded
+	int addDetector(const LoopDetector& detector);
+	void setDetectorConfig(const DetectorConfig& config) { detectors.setConfig(config); }
+	const DetectorBank& getDetectors() const { return detectors; }
+
+	// lane change, lane drop and merge decision rates, applied from the next tick
+	void setDecisionRates(const DecisionRates& rates) { decisions.setRates(rates); }
+
+	// update every segment and junction each tick rather than only the active ones, same results slower
+	void setFullSweep(bool enabled) { fullSweep = enabled; }
+	const DecisionSchedule& getDecisionSchedule() const { return decisions; }
+
+	// network level stream, for builders that place things at random
+	Random& getRandom() { return random; }
+
 	bool connectRoads(const std::string& roadId1, const std::string& roadId2, const std::string& junctionId);
-	void buildNetwork(int gridWidth, int gridHeight, int numLanes, float roadLength, float roadWidth, float speedLimit);
+	// signalized puts traffic lights on every junction inside the grid
+	void buildNetwork(int gridWidth, int gridHeight, int numLanes, float roadLength, float roadWidth, float speedLimit, bool twoWay = true, bool signalized = false);
 };
\ No newline at end of file
@@ -4,14 +4,20 @@
 
 #include "roadSegment.h"
 #include "junction.h"
+#include "compiledNetwork.h"
+#include "loopDetector.h"
 #include "../traffic/vehicle.h"
 
 
 RoadSegment::RoadSegment(const std::string& id, const Vector3& pos, const Vector3& dim, float speedLimit)
 	:	GameObject(pos, dim, Color(100, 100, 100)),
 		id(id),
+		index(-1),
+		kind(SegmentKind::ROAD),
 		length(dim.x),
-		speedLimit(speedLimit) {}
+		speedLimit(speedLimit) {
+	compileLaneProfiles();
+}
 
 
 void RoadSegment::setJunctions(std::shared_ptr<Junction> start, std::shared_ptr<Junction> end) {
@@ -20,12 +26,57 @@ void RoadSegment::setJunctions(std::shared_ptr<Junction> start, std::shared_ptr<
 }
 
 
-void RoadSegment::addLane(const Lane& lane) {
-	lanes.push_back(lane);
+void RoadSegment::addLane(const Lane& lane, TravelDirection direction) {
+	group(direction).lanes.push_back(lane);
+	compileLaneProfiles();
+	reserveVehicleCapacity();
 }
 
 
-void RoadSegment::addLaneTransition(float startDist, float endDist, int startLanes, int endLanes, const std::map<int, int>& mapping) {
+void RoadSegment::compileLaneProfiles() {
+	int forwardCount = getLaneCount(TravelDirection::FORWARD);
+	int reverseCount = getLaneCount(TravelDirection::REVERSE);
+
+	// one way segments use the full width, otherwise it is shared by lane count
+	if (reverseCount == 0) {
+		laneGroups[0].profile.compile(dimensions.z, forwardCount);
+		return;
+	}
+
+	float totalWidth = dimensions.z;
+	float forwardWidth = totalWidth * forwardCount / (forwardCount + reverseCount);
+	float reverseWidth = totalWidth - forwardWidth;
+
+	// each group sits on the right of the centre line in its own direction of travel
+	laneGroups[0].profile.compile(forwardWidth, forwardCount, reverseWidth / 2.0f);
+	laneGroups[1].profile.compile(reverseWidth, reverseCount, forwardWidth / 2.0f);
+}
+
+
+void RoadSegment::reserveVehicleCapacity() {
+	// sized for a jammed segment, with slack for queues packed tighter than the jam spacing,
+	// so filling up never reallocates mid run
+	size_t laneCapacity = static_cast<size_t>(2.0f * length / jamSpacing) + 1;
+	size_t laneCount = 0;
+
+	for (auto& laneGroup : laneGroups) {
+		laneGroup.sortedVehicles.resize(laneGroup.lanes.size());
+		for (auto& lane : laneGroup.sortedVehicles) {
+			lane.reserve(laneCapacity);
+		}
+		laneCount += laneGroup.lanes.size();
+	}
+
+	vehicles.reserve(laneCount * laneCapacity);
+	compactVehicles.reserve(laneCount * laneCapacity);
+	incomingVehicles.reserve(laneCount * 2);
+	arrivedVehicles.reserve(laneCount * 2);
+	mergeRequests.reserve(laneCapacity);
+	pendingMergeRequests.reserve(laneCapacity);
+}
+
+
+void RoadSegment::addLaneTransition(float startDist, float endDist, int startLanes, int endLanes, const std::map<int, int>& mapping, TravelDirection direction) {
 	LaneTransition transition;
 	transition.startDistance = startDist;
 	transition.endDistance = endDist;
@@ -36,7 +87,22 @@ void RoadSegment::addLaneTransition(float startDist, float endDist, int startLan
 		transition.laneMapping[pair.first] = pair.second;
 	}
 
-	laneTransitions.push_back(transition);
+	group(direction).profile.addTransition(transition);
+	compileLaneProfiles();
+
+	// vehicles only need to look for a target lane around lane drops
+	if (endLanes < startLanes) {
+		addZone({ std::max(0.0f, startDist - laneDropLookAhead), endDist, ZoneType::LANE_DROP }, direction);
+	}
+}
+
+
+void RoadSegment::addZone(const BehaviorZone& zone, TravelDirection direction) {
+	auto& zones = group(direction).zones;
+	auto it = std::upper_bound(zones.begin(), zones.end(), zone, [](const BehaviorZone& a, const BehaviorZone& b) {
+		return a.startDistance < b.startDistance;
+		});
+	zones.insert(it, zone);
 }
 
 
@@ -50,72 +116,499 @@ void RoadSegment::addVehicle(std::shared_ptr<Vehicle> vehicle) {
 	int lane = determineClosestLane(vehicle->getPosition().z);
 
 	vehicle->setCurrentRoad(shared_from_this(), distanceAlongRoad, lane);
-	vehicles.push_back(vehicle);
+	insertAwakeVehicle(vehicle);
+}
+
+
+void RoadSegment::addVehicle(std::shared_ptr<Vehicle> vehicle, float distance, int laneIndex, TravelDirection direction) {
+	vehicle->setCurrentRoad(shared_from_this(), distance, laneIndex, direction);
+	insertAwakeVehicle(vehicle);
 }
 
 
 void RoadSegment::removeVehicle(std::shared_ptr<Vehicle> vehicle) {
-	vehicles.erase(std::remove(vehicles.begin(), vehicles.end(), vehicle), vehicles.end());
+	auto it = std::find(vehicles.begin(), vehicles.end(), vehicle);
+	if (it == vehicles.end()) return;
+
+	if (static_cast<size_t>(it - vehicles.begin()) < awakeVehicles) {
+		awakeVehicles--;
+	}
+	vehicles.erase(it);
+	laneIndexDirty = true;
+}
+
+
+void RoadSegment::clearVehicles() {
+	vehicles.clear();
+	awakeVehicles = 0;
+	laneIndexDirty = true;
+	incomingVehicles.clear();
+	arrivedVehicles.clear();
+	for (auto& laneGroup : laneGroups) {
+		laneGroup.sortedVehicles.clear();
+	}
+	compactVehicles.clear();
+	mergeRequests.clear();
+	pendingMergeRequests.clear();
+}
+
+
+void RoadSegment::setActiveList(std::vector<RoadSegment*>* list) {
+	activeList = list;
+	active = false;
+	if (!isIdle()) {
+		markActive();
+	}
+}
+
+
+void RoadSegment::deactivate() {
+	active = false;
+
+	// answered by nobody once the segment is empty, and would point at vehicles that may be reused
+	mergeRequests.clear();
+}
+
+
+void RoadSegment::commitIncomingVehicles() {
+	for (auto& vehicle : incomingVehicles) {
+		insertAwakeVehicle(std::move(vehicle));
+	}
+	incomingVehicles.clear();
+}
+
+
+void RoadSegment::insertAwakeVehicle(std::shared_ptr<Vehicle> vehicle) {
+	vehicles.push_back(std::move(vehicle));
+	std::swap(vehicles[awakeVehicles], vehicles.back());
+	awakeVehicles++;
+	laneIndexDirty = true;
+	markActive();
+}
+
+
+void RoadSegment::eraseAwakeVehicle(size_t index) {
+	vehicles.erase(vehicles.begin() + index);
+	awakeVehicles--;
+	laneIndexDirty = true;
+}
+
+
+void RoadSegment::parkVehicle(size_t index) {
+	awakeVehicles--;
+	std::swap(vehicles[index], vehicles[awakeVehicles]);
+	vehicles[awakeVehicles]->park(clock);
+}
+
+
+void RoadSegment::wakeVehicle(size_t index) {
+	std::swap(vehicles[index], vehicles[awakeVehicles]);
+	vehicles[awakeVehicles]->wake(clock);
+	awakeVehicles++;
+	laneIndexDirty = true;
+}
+
+
+Junction* RoadSegment::findExitJunction(TravelDirection direction) const {
+	// segments outside the last compile follow their own pointers
+	int node = compiledNetwork && index >= 0 ? CompiledNetwork::toNode(index, direction) : -1;
+	if (node >= 0 && node < static_cast<int>(compiledNetwork->getNodeCount())) {
+		return compiledNetwork->getJunction(compiledNetwork->getExit(node));
+	}
+	return getExitJunction(direction).get();
+}
+
+
+void RoadSegment::wakeVehiclesHeldAt(const Junction* junction) {
+	const Junction* exits[2] = { findExitJunction(TravelDirection::FORWARD), findExitJunction(TravelDirection::REVERSE) };
+
+	// the vehicle swapped into i was parked and already passed over
+	for (size_t i = awakeVehicles; i < vehicles.size(); i++) {
+		if (exits[static_cast<int>(vehicles[i]->getTravelDirection())] == junction) {
+			wakeVehicle(i);
+		}
+	}
+}
+
+
+void RoadSegment::wakeVehicles() {
+	while (awakeVehicles < vehicles.size()) {
+		wakeVehicle(awakeVehicles);
+	}
+}
+
+
+void RoadSegment::releaseArrivedVehicles(std::vector<std::shared_ptr<Vehicle>>& pool) {
+	pool.insert(pool.end(), arrivedVehicles.begin(), arrivedVehicles.end());
+	arrivedVehicles.clear();
+}
+
+
+void RoadSegment::rebuildLaneIndex() {
+	// nothing moved, joined or left, so last tick's index, speeds and closing time still hold
+	if (!laneIndexDirty) {
+		mergeRequests.swap(pendingMergeRequests);
+		pendingMergeRequests.clear();
+		return;
+	}
+	laneIndexDirty = false;
+
+	for (auto& laneGroup : laneGroups) {
+		if (laneGroup.sortedVehicles.size() < laneGroup.lanes.size()) {
+			laneGroup.sortedVehicles.resize(laneGroup.lanes.size());
+		}
+
+		for (auto& lane : laneGroup.sortedVehicles) {
+			lane.clear();
+		}
+	}
+
+	float speedSum = 0.0f;
+	maxVehicleSpeed = 0.0f;
+
+	for (const auto& vehicle : vehicles) {
+		speedSum += vehicle->getCurrentSpeed();
+		maxVehicleSpeed = std::max(maxVehicleSpeed, vehicle->getCurrentSpeed());
+
+		auto& sortedVehicles = group(vehicle->getTravelDirection()).sortedVehicles;
+		int lane = vehicle->getCurrentLane();
+		if (lane >= 0 && lane < static_cast<int>(sortedVehicles.size())) {
+			sortedVehicles[lane].push_back(vehicle.get());
+		}
+	}
+
+	meanSpeed = vehicles.empty() ? 0.0f : speedSum / vehicles.size();
+
+	// lanes are nearly sorted already, insertion sort keeps this cheap
+	for (auto& laneGroup : laneGroups) {
+		for (auto& lane : laneGroup.sortedVehicles) {
+			for (size_t i = 1; i < lane.size(); i++) {
+				Vehicle* vehicle = lane[i];
+				float distance = vehicle->getDistanceAlongRoad();
+
+				size_t j = i;
+				while (j > 0 && lane[j - 1]->getDistanceAlongRoad() > distance) {
+					lane[j] = lane[j - 1];
+					j--;
+				}
+				lane[j] = vehicle;
+			}
+		}
+	}
+
+	compactVehicles.clear();
+	clampedVehicles = 0;
+	for (const auto& laneGroup : laneGroups) {
+		for (const auto& lane : laneGroup.sortedVehicles) {
+			for (Vehicle* vehicle : lane) {
+				compactVehicles.emplace_back();
+				if (!compactVehicles.back().encode(*vehicle, index)) {
+					clampedVehicles++;
+				}
+			}
+		}
+	}
+
+	// bounds the step size, a step longer than this would let a follower drive through its leader.
+	// speeds round to within half a step, so a follower a whole step slower than its leader can't be closing
+	closingTime = std::numeric_limits<float>::infinity();
+	const CompactVehicleState* records = compactVehicles.data();
+	for (const auto& laneGroup : laneGroups) {
+		for (const auto& lane : laneGroup.sortedVehicles) {
+			for (size_t i = 1; i < lane.size(); i++) {
+				if (records[i - 1].speed < records[i].speed) continue;
+
+				const Vehicle* follower = lane[i - 1];
+				const Vehicle* leader = lane[i];
+
+				float closingSpeed = follower->getCurrentSpeed() - leader->getCurrentSpeed();
+				if (closingSpeed <= 0.0f) continue;
+
+				// vehicles already queued on top of each other at a stop line have nothing left to close
+				float gap = leader->getDistanceAlongRoad() - follower->getDistanceAlongRoad() - (leader->getDimensions().x + follower->getDimensions().x) / 2.0f;
+				if (gap <= 0.0f) continue;
+
+				closingTime = std::min(closingTime, gap / closingSpeed);
+			}
+			records += lane.size();
+		}
+	}
+
+	// a parked vehicle stays parked behind a parked leader, or at the front while held at the stop line.
+	// anything else moved in ahead of it or left, so it and everyone parked behind it wake up.
+	// only stopped vehicles park, so a record with any speed is skipped
+	bool woken = false;
+	records = compactVehicles.data();
+	for (const auto& laneGroup : laneGroups) {
+		for (const auto& lane : laneGroup.sortedVehicles) {
+			for (size_t i = lane.size(); i-- > 0;) {
+				if (records[i].speed > 0) continue;
+
+				Vehicle* vehicle = lane[i];
+				if (!vehicle->isDormant()) continue;
+
+				size_t leader = i + 1;
+				while (leader < lane.size() && lane[leader]->getDistanceAlongRoad() <= vehicle->getDistanceAlongRoad()) {
+					leader++;
+				}
+
+				bool held = leader < lane.size() ? lane[leader]->isDormant() : vehicle->isHeldAtJunction() && vehicle->getDistanceAlongRoad() >= length;
+				if (!held) {
+					vehicle->wake(clock);
+					woken = true;
+				}
+			}
+			records += lane.size();
+		}
+	}
+
+	if (woken) {
+		for (size_t i = awakeVehicles; i < vehicles.size(); i++) {
+			if (!vehicles[i]->isDormant()) {
+				std::swap(vehicles[i], vehicles[awakeVehicles]);
+				awakeVehicles++;
+			}
+		}
+		laneIndexDirty = true;
+	}
+
+	mergeRequests.swap(pendingMergeRequests);
+	pendingMergeRequests.clear();
 }
 
 
 void RoadSegment::update(float deltaTime) {
+	clock += deltaTime;
+	if (awakeVehicles > 0) {
+		laneIndexDirty = true;
+	}
 
-	// loop through vehicles in this segment
-	for (auto it = vehicles.begin(); it != vehicles.end();) {
-		auto& vehicle = *it;
+	// loop through the awake vehicles in this segment, parked ones are not visited
+	for (size_t i = 0; i < awakeVehicles;) {
+		auto& vehicle = vehicles[i];
 
 		if (!vehicle) {
-			it = vehicles.erase(it);
+			eraseAwakeVehicle(i);
 			continue;
 		}
 
-		float prevDistance = vehicle->getDistanceAlongRoad();
+		float before = vehicle->getDistanceAlongRoad();
+		int lane = vehicle->getCurrentLane();
+		TravelDirection direction = vehicle->getTravelDirection();
+
 		vehicle->update(deltaTime);
 
-		// remove vehicle if moved to another segment
+		// hand vehicle over if moved to another segment
 		if (vehicle->getCurrentRoad().get() != this) {
-			it = vehicles.erase(it);
+			// through the junction it passed the rest of the segment, a ramp merge leaves from the side.
+			// the vehicle's cursor already belongs to its new road
+			if (detectorBank && vehicle->getCurrentRoad()->getEntryJunction(vehicle->getTravelDirection()).get() == findExitJunction(direction)) {
+				size_t passed = 0;
+				recordCrossings(direction, lane, vehicle->getCurrentSpeed(), before, length, passed);
+			}
+			vehicle->getCurrentRoad()->acceptVehicle(vehicle);
+			eraseAwakeVehicle(i);
+			continue;
+		}
+
+		if (detectorBank) {
+			recordCrossings(direction, vehicle->getCurrentLane(), vehicle->getCurrentSpeed(), before, vehicle->getDistanceAlongRoad(), vehicle->getDetectorCursor());
+		}
+
+		// vehicle reached its destination and leaves the network
+		if (vehicle->hasArrived()) {
+			arrivedVehicles.push_back(vehicle);
+			eraseAwakeVehicle(i);
+			continue;
 		}
 
 		// if vehicle is at the end of this segment
-		else if (vehicle->getDistanceAlongRoad() >= length) {
+		if (vehicle->getDistanceAlongRoad() >= length) {
 
-			// handle junction at end of segment
-			auto junction = endJunction.lock();
+			// handle junction at the end the vehicle is driving towards
+			Junction* junction = findExitJunction(vehicle->getTravelDirection());
 			if (junction) {
 
 				vehicle->handleIntersection(junction);
 
-				// remove vehicle if still on segment
+				// hand vehicle over if it left the segment
 				if (vehicle->getCurrentRoad().get() != this) {
-					it = vehicles.erase(it);
-				} else {
-					++it;
+					vehicle->getCurrentRoad()->acceptVehicle(vehicle);
+					eraseAwakeVehicle(i);
+					continue;
 				}
-			} else {
+			}
+		}
+
+		// stopped in a queue that only a signal change or its leader leaving can release. the leader is
+		// the first vehicle strictly ahead, as in car following, and comes from last tick's index.
+		// rebuildLaneIndex wakes us if that was wrong
+		float ahead = std::nextafter(vehicle->getDistanceAlongRoad(), std::numeric_limits<float>::infinity());
+		LaneNeighbors neighbors = findNeighbors(vehicle->getCurrentLane(), ahead, vehicle.get(), vehicle->getTravelDirection());
+		if (vehicle->canPark(neighbors.leader)) {
+			parkVehicle(i);
+			continue;
+		}
+
+		++i;
+	}
+}
+
+
+void RoadSegment::addDetector(const DetectorSite& site, TravelDirection direction, DetectorBank* bank) {
+	auto& sites = group(direction).detectors;
+	auto at = std::upper_bound(sites.begin(), sites.end(), site.distance, [](float distance, const DetectorSite& other) {
+		return distance < other.distance;
+		});
+	sites.insert(at, site);
+	detectorBank = bank;
+}
+
+
+void RoadSegment::recordCrossings(TravelDirection direction, int lane, float speed, float before, float after, size_t& cursor) {
+	const auto& sites = group(direction).detectors;
+
+	// usually one comparison against the next detector ahead. detectors behind where the vehicle
+	// joined the road, as after a spawn or a merge, are stepped over without counting
+	for (; cursor < sites.size() && sites[cursor].distance <= after; cursor++) {
+		const DetectorSite& site = sites[cursor];
+		if (site.distance > before && (site.lane < 0 || site.lane == lane)) {
+			detectorBank->recordCrossing(site.detector, speed);
+		}
+	}
+}
+
 
-				// no junctions at the end
-				++it;
+void RoadSegment::sampleDetectors(float deltaTime) {
+	if (!detectorBank) return;
+
+	// a loop is occupied while some vehicle's body covers it. each vehicle's detector cursor sits
+	// just past its centre, so only the loops either side of it are looked at, and the bank counts
+	// a loop covered by two vehicles once
+	for (auto& laneGroup : laneGroups) {
+		const auto& sites = laneGroup.detectors;
+		if (sites.empty()) continue;
+
+		for (size_t lane = 0; lane < laneGroup.sortedVehicles.size(); lane++) {
+			for (Vehicle* vehicle : laneGroup.sortedVehicles[lane]) {
+				float halfLength = vehicle->getDimensions().x / 2.0f;
+				float rear = vehicle->getDistanceAlongRoad() - halfLength;
+				float front = vehicle->getDistanceAlongRoad() + halfLength;
+				size_t cursor = std::min(vehicle->getDetectorCursor(), sites.size());
+
+				auto sample = [&](const DetectorSite& site) {
+					if (site.lane < 0 || site.lane == static_cast<int>(lane)) {
+						detectorBank->recordOccupancy(site.detector, deltaTime);
+					}
+				};
+
+				for (size_t i = cursor; i > 0 && sites[i - 1].distance >= rear; i--) {
+					sample(sites[i - 1]);
+				}
+				for (size_t i = cursor; i < sites.size() && sites[i].distance <= front; i++) {
+					if (sites[i].distance >= rear) sample(sites[i]);
+				}
 			}
-		} else {
-			++it;
 		}
 	}
 }
 
 
-Vector3 RoadSegment::getLanePositionAt(int laneIndex, float distance) const {
-	Vector3 roadPos = getPositionAlongRoad(distance);
-	Vector3 perpDir = getPerpendicularVector();
+float RoadSegment::getDensity() const {
+	int laneCount = getLaneCount(TravelDirection::FORWARD) + getLaneCount(TravelDirection::REVERSE);
+	if (laneCount == 0 || length <= 0.0f) return 0.0f;
 
-	float totalWidth = dimensions.z;
-	int laneCount = getLaneCountAt(distance);
-	float laneWidth = totalWidth / laneCount;
+	return std::min(1.0f, vehicles.size() * jamSpacing / (length * laneCount));
+}
+
+
+void RoadSegment::closeLane(int laneIndex, TravelDirection direction) {
+	auto& lanes = group(direction).lanes;
+	if (laneIndex >= 0 && laneIndex < static_cast<int>(lanes.size())) {
+		lanes[laneIndex].close();
+		wakeVehicles();
+	}
+}
+
+
+void RoadSegment::reopenLane(int laneIndex, TravelDirection direction) {
+	auto& lanes = group(direction).lanes;
+	if (laneIndex >= 0 && laneIndex < static_cast<int>(lanes.size())) {
+		lanes[laneIndex].reopen();
+		wakeVehicles();
+	}
+}
+
+
+bool RoadSegment::isLaneOpen(int laneIndex, TravelDirection direction) const {
+	const auto& lanes = group(direction).lanes;
+	return laneIndex >= 0 && laneIndex < static_cast<int>(lanes.size()) && lanes[laneIndex].canAcceptVehicle();
+}
+
+
+int RoadSegment::getTravelLaneCount(TravelDirection direction) const {
+	int count = 0;
+	for (const auto& lane : group(direction).lanes) {
+		if (lane.isTravelLane()) count++;
+	}
+	return count;
+}
+
+
+int RoadSegment::getOpenLaneCount(TravelDirection direction) const {
+	int count = 0;
+	for (const auto& lane : group(direction).lanes) {
+		if (lane.canAcceptVehicle()) count++;
+	}
+	return count;
+}
+
+
+int RoadSegment::findOpenLane(int preferredLane, TravelDirection direction) const {
+	int laneCount = getLaneCount(direction);
+	preferredLane = std::max(0, std::min(preferredLane, laneCount - 1));
+
+	// search outwards from the preferred lane, inner side first
+	for (int offset = 0; offset < laneCount; offset++) {
+		if (isLaneOpen(preferredLane - offset, direction)) return preferredLane - offset;
+		if (isLaneOpen(preferredLane + offset, direction)) return preferredLane + offset;
+	}
+	return -1;
+}
+
+
+void RoadSegment::addSpeedReduction(float factor) {
+	speedReductions.push_back(factor);
+	speedFactor *= factor;
+}
 
-	float laneOffset = (laneIndex - (laneCount - 1) / 2.0f) * laneWidth;
 
-	return roadPos + perpDir * laneOffset;
+void RoadSegment::removeSpeedReduction(float factor) {
+	auto it = std::find(speedReductions.begin(), speedReductions.end(), factor);
+	if (it == speedReductions.end()) return;
+	speedReductions.erase(it);
+
+	// recompute rather than divide so the limit returns exactly to its base value
+	speedFactor = 1.0f;
+	for (float reduction : speedReductions) {
+		speedFactor *= reduction;
+	}
+}
+
+
+Vector3 RoadSegment::getLanePositionAt(int laneIndex, float distance, TravelDirection direction) const {
+	return getLanePositionAlongRoad(laneIndex, distance, direction);
+}
+
+
+Vector3 RoadSegment::getLanePositionAt(int laneIndex, float distance, size_t& laneCursor, TravelDirection direction) const {
+	float laneOffset = group(direction).profile.at(distance, laneCursor).getLaneOffset(laneIndex);
+
+	// reverse distances run back from the end junction, on the other side of the centre line
+	if (direction == TravelDirection::REVERSE) {
+		return getPositionAlongRoad(length - distance) - getPerpendicularVector() * laneOffset;
+	}
+	return getPositionAlongRoad(distance) + getPerpendicularVector() * laneOffset;
 }
 
 
@@ -169,6 +662,12 @@ Vector3 RoadSegment::getPerpendicularVector() const{
 }
 
 
+Vector3 RoadSegment::getTravelVector(TravelDirection direction) const {
+	Vector3 dir = getDirectionVector();
+	return direction == TravelDirection::REVERSE ? dir * -1.0f : dir;
+}
+
+
 Vector3 RoadSegment::getStartPosition() const {
 	if (auto start = startJunction.lock()) {
 		return start->getPosition();
@@ -194,17 +693,13 @@ Vector3 RoadSegment::getPositionAlongRoad(float distance) const {
 }
 
 
-Vector3 RoadSegment::getLanePositionAlongRoad(int laneIndex, float distance) const {
-	Vector3 roadPos = getPositionAlongRoad(distance);
-	Vector3 perpDir = getPerpendicularVector();
-
-	float roadWidth = dimensions.z;
-	int laneCount = getLaneCountAt(distance);
-	float laneWidth = roadWidth / laneCount;
-
-	float laneOffset = (laneIndex - (laneCount - 1) / 2.0f) * laneWidth;
+Vector3 RoadSegment::getLanePositionAlongRoad(int laneIndex, float distance, TravelDirection direction) const {
+	float laneOffset = group(direction).profile.at(distance).getLaneOffset(laneIndex);
 
-	return roadPos + perpDir * laneOffset;
+	if (direction == TravelDirection::REVERSE) {
+		return getPositionAlongRoad(length - distance) - getPerpendicularVector() * laneOffset;
+	}
+	return getPositionAlongRoad(distance) + getPerpendicularVector() * laneOffset;
 }
 
 
@@ -229,63 +724,20 @@ Vector3 RoadSegment::getWorldPositionAt(int laneIndex, float distance) const {
 
 	Vector3 basePos = position + roadDir * distance;
 
-	float totalWidth = dimensions.z;
-	int laneCount = getLaneCountAt(distance);
-	float laneWidth = totalWidth / laneCount;
-
-	float laneOffset = (laneIndex - (laneCount - 1) / 2.0f) * laneWidth;
-
-	return basePos + perpDir * laneOffset;
-}
-
-
-int RoadSegment::getLaneCountAt(float distance) const {
-	for (const auto& transition : laneTransitions) {
-		if (distance >= transition.startDistance && distance <= transition.endDistance) {
-			float t = (distance - transition.startDistance) / (transition.endDistance - transition.startDistance);
-			return std::round(transition.startLaneCount + t * (transition.endLaneCount - transition.startLaneCount));
-		}
-	}
-
-	return getLaneCount();
+	return basePos + perpDir * laneGroups[0].profile.at(distance).getLaneOffset(laneIndex);
 }
 
 
-int RoadSegment::getTargetLane(int currentLane, float currentDistance, float lookAheadDistance) const {
-	// find distance ahead
-	float targetDistance = currentDistance + lookAheadDistance;
-
-	// limit to road length if target distance is past road length
-	if (targetDistance > length) {
-		targetDistance = length;
-	}
-
-	// check if target point is in a transition zone
-	for (const auto& transition : laneTransitions) {
-		if (currentDistance < transition.endDistance && targetDistance >= transition.startDistance) {
+int RoadSegment::getTargetLane(int currentLane, float currentDistance, float lookAheadDistance, size_t& laneCursor, TravelDirection direction) const {
+	// find distance ahead, limited to the road length
+	float targetDistance = std::min(currentDistance + lookAheadDistance, length);
 
-			// check if current lane will disappear
-			if (currentLane >= transition.endLaneCount) {
-				auto it = transition.laneMapping.find(currentLane);
-				if (it != transition.laneMapping.end()) {
-					return it->second;
-				} else {
-					return transition.endLaneCount - 1;
-				}
-			}
-
-			// current lane still exists
-			return currentLane;
-		}
-	}
-
-	// stay in current lane
-	return currentLane;
+	return group(direction).profile.getTargetLane(currentLane, currentDistance, targetDistance, laneCursor);
 }
 
 
 int RoadSegment::determineClosestLane(float zPosition) const {
-	if (lanes.empty()) {
+	if (laneGroups[0].lanes.empty()) {
 		return 0;
 	}
 
@@ -307,28 +759,73 @@ int RoadSegment::determineClosestLane(float zPosition) const {
 }
 
 
-std::vector<std::shared_ptr<Vehicle>> RoadSegment::getVehiclesInLane(int laneIndex) const {
-	std::vector<std::shared_ptr<Vehicle>> result;
+Span<Vehicle*> RoadSegment::getVehiclesInLane(int laneIndex, TravelDirection direction, FrameArena& arena) const {
+	Vehicle** result = arena.allocateArray<Vehicle*>(vehicles.size());
+	size_t count = 0;
 
 	for (const auto& vehicle : vehicles) {
-		if (vehicle->getCurrentLane() == laneIndex) {
-			result.push_back(vehicle);
+		if (vehicle->getCurrentLane() == laneIndex && vehicle->getTravelDirection() == direction) {
+			result[count++] = vehicle.get();
 		}
 	}
 
-	return result;
+	return Span<Vehicle*>(result, count);
 }
 
 
-std::vector<std::shared_ptr<Vehicle>> RoadSegment::getVehiclesInLaneSection(int laneIndex, float startDist, float endDist) const {
-	std::vector<std::shared_ptr<Vehicle>> result;
+Span<Vehicle*> RoadSegment::getVehiclesInLaneSection(int laneIndex, float startDist, float endDist, TravelDirection direction, FrameArena& arena) const {
+	Vehicle** result = arena.allocateArray<Vehicle*>(vehicles.size());
+	size_t count = 0;
 
 	for (const auto& vehicle : vehicles) {
 		float vehicleDist = vehicle->getDistanceAlongRoad();
-		if (vehicle->getCurrentLane() == laneIndex && vehicleDist >= startDist && vehicleDist <= endDist) {
-			result.push_back(vehicle);
+		if (vehicle->getCurrentLane() == laneIndex && vehicle->getTravelDirection() == direction && vehicleDist >= startDist && vehicleDist <= endDist) {
+			result[count++] = vehicle.get();
 		}
 	}
 
-	return result;
+	return Span<Vehicle*>(result, count);
 }
+
+
+
+LaneNeighbors RoadSegment::findNeighbors(int laneIndex, float distance, const Vehicle* exclude, TravelDirection direction) const {
+	LaneNeighbors neighbors;
+	const auto& sortedVehicles = group(direction).sortedVehicles;
+	if (laneIndex < 0 || laneIndex >= static_cast<int>(sortedVehicles.size())) {
+		return neighbors;
+	}
+
+	const auto& lane = sortedVehicles[laneIndex];
+	auto it = std::lower_bound(lane.begin(), lane.end(), distance, [](const Vehicle* vehicle, float value) {
+		return vehicle->getDistanceAlongRoad() < value;
+		});
+
+	// first vehicle at or past the point leads, the one before follows
+	for (auto ahead = it; ahead != lane.end(); ++ahead) {
+		if (*ahead != exclude) {
+			neighbors.leader = *ahead;
+			break;
+		}
+	}
+
+	for (auto behind = it; behind != lane.begin();) {
+		--behind;
+		if (*behind != exclude) {
+			neighbors.follower = *behind;
+			break;
+		}
+	}
+
+	return neighbors;
+}
+
+
+const MergeRequest* RoadSegment::findMergeRequest(const Vehicle* yielder) const {
+	for (const auto& request : mergeRequests) {
+		if (request.yielder == yielder) {
+			return &request;
+		}
+	}
+	return nullptr;
+}
\ No newline at end of file
@@ -5,82 +5,291 @@
 #include <map>
 #include <unordered_map>
 #include <memory>
+#include <limits>
 
 #include "../core/gameobject.h"
 #include "../core/vec3.h"
+#include "../core/frameArena.h"
 #include "lane.h"
+#include "laneProfile.h"
+#include "../traffic/compactVehicleState.h"
 
 
 // forward declaration
 class Junction;
 class Vehicle;
+class DetectorBank;
+class CompiledNetwork;
+
+
+enum class SegmentKind {
+	ROAD,
+	RAMP
+};
+
+
+// direction of travel along a segment, reverse runs from the end junction to the start
+enum class TravelDirection {
+	FORWARD,
+	REVERSE
+};
+
+
+enum class ZoneType {
+	MERGE,
+	EXIT_DECELERATION,
+	LANE_DROP
+};
+
+
+// distance interval along a segment where vehicles run extra behaviour
+struct BehaviorZone {
+	float startDistance;
+	float endDistance;
+	ZoneType type;
+};
+
+
+// closest vehicles ahead of and behind a point in a lane
+struct LaneNeighbors {
+	Vehicle* leader = nullptr;
+	Vehicle* follower = nullptr;
+};
+
+
+// where a loop detector sits on a segment, lane -1 covers every lane of the direction
+struct DetectorSite {
+	float distance;
+	int lane;
+	int detector;
+};
+
+
+// a ramp vehicle asking a main line vehicle to open a gap
+struct MergeRequest {
+	Vehicle* merger;
+	Vehicle* yielder;
+	float position;
+	float speed;
+};
 
 
 class RoadSegment : public GameObject, public std::enable_shared_from_this<RoadSegment> {
 protected:
 	std::string id;
+	int index;
+	SegmentKind kind;
 	float length;
 	float speedLimit;
-	std::vector<Lane> lanes;
+
+	// active incident speed reductions, the limit is scaled by their product
+	std::vector<float> speedReductions;
+	float speedFactor = 1.0f;
 	std::weak_ptr<Junction> startJunction;
 	std::weak_ptr<Junction> endJunction;
 
-	struct LaneTransition {
-		float startDistance;
-		float endDistance;
-		int startLaneCount;
-		int endLaneCount;
-		std::unordered_map<int, int> laneMapping;
+	// lanes of one direction of travel, distances are measured from where that direction enters
+	struct LaneGroup {
+		std::vector<Lane> lanes;
+		LaneProfile profile;
+		std::vector<BehaviorZone> zones;
+
+		// vehicles per lane sorted by distance, rebuilt once per tick
+		std::vector<std::vector<Vehicle*>> sortedVehicles;
+
+		// loop detectors sorted by distance
+		std::vector<DetectorSite> detectors;
 	};
 
-	std::vector<LaneTransition> laneTransitions;
+	// both directions share the geometry and the vehicle list. vehicles before awakeVehicles update
+	// every tick, the ones after are parked in a queue and skipped until something wakes them
+	LaneGroup laneGroups[2];
 	std::vector<std::shared_ptr<Vehicle>> vehicles;
+	size_t awakeVehicles = 0;
+	std::vector<std::shared_ptr<Vehicle>> incomingVehicles;
+
+	// vehicles that reached their destination this tick, handed back to the network for reuse
+	std::vector<std::shared_ptr<Vehicle>> arrivedVehicles;
+
+	// traffic state gathered while rebuilding the lane index
+	float meanSpeed = 0.0f;
+	float maxVehicleSpeed = 0.0f;
+
+	// shortest time for any vehicle to close the gap to the one ahead of it in its lane
+	float closingTime = std::numeric_limits<float>::infinity();
+
+	// the lane index again as 16 byte records, lane after lane and forward lanes first, written when
+	// it is rebuilt. scans over the index read these and only go to a Vehicle when a record can't decide
+	std::vector<CompactVehicleState> compactVehicles;
+	uint32_t clampedVehicles = 0;
+
+	// requests posted this tick are answered next tick
+	std::vector<MergeRequest> mergeRequests;
+	std::vector<MergeRequest> pendingMergeRequests;
+
+	// time this segment has been updated for, parked vehicles catch up their timers from it
+	double clock = 0.0;
+
+	// set by anything that moves, adds, removes or wakes a vehicle, a segment whose vehicles are
+	// all parked keeps last tick's lane index
+	bool laneIndexDirty = true;
+
+	// the network's list of segments to visit each tick. a segment joins it when a vehicle enters
+	// and the network drops it again once it is empty, so idle segments cost nothing
+	std::vector<RoadSegment*>* activeList = nullptr;
+	bool active = false;
+
+	// the network's detector counters, set once a detector is placed on this segment
+	DetectorBank* detectorBank = nullptr;
+
+	// the network's flat arrays, junctions are looked up there during the update rather than
+	// through the weak pointers
+	const CompiledNetwork* compiledNetwork = nullptr;
+	Junction* findExitJunction(TravelDirection direction) const;
+
+	LaneGroup& group(TravelDirection direction) { return laneGroups[static_cast<int>(direction)]; }
+	const LaneGroup& group(TravelDirection direction) const { return laneGroups[static_cast<int>(direction)]; }
+	void compileLaneProfiles();
+	void reserveVehicleCapacity();
+
+	// keep vehicles partitioned, awake before parked
+	void insertAwakeVehicle(std::shared_ptr<Vehicle> vehicle);
+	void eraseAwakeVehicle(size_t index);
+	void parkVehicle(size_t index);
+	void wakeVehicle(size_t index);
+
+	// counts the detectors in (before, after] a vehicle passed this tick. the cursor starts at the
+	// first detector not yet passed and is left there for the next tick
+	void recordCrossings(TravelDirection direction, int lane, float speed, float before, float after, size_t& cursor);
 
 
 public:
+	// how far ahead of a lane drop vehicles start moving over
+	static constexpr float laneDropLookAhead = 30.0f;
+
+	// space per vehicle in a stopped queue, density 1 means jammed
+	static constexpr float jamSpacing = 7.5f;
+
 	RoadSegment(const std::string& id, const Vector3& pos, const Vector3& dim, float speedLimit);
 
 	void setJunctions(std::shared_ptr<Junction> start, std::shared_ptr<Junction> end);
-	void addLane(const Lane& lane);
-	void addLaneTransition(float startDist, float endDist, int startLanes, int endLanes, const std::map<int, int>& mapping);
+	void addLane(const Lane& lane, TravelDirection direction = TravelDirection::FORWARD);
+	void addLaneTransition(float startDist, float endDist, int startLanes, int endLanes, const std::map<int, int>& mapping, TravelDirection direction = TravelDirection::FORWARD);
+	void addZone(const BehaviorZone& zone, TravelDirection direction = TravelDirection::FORWARD);
 
 	void addVehicle(std::shared_ptr<Vehicle> vehicle);
+	void addVehicle(std::shared_ptr<Vehicle> vehicle, float distance, int laneIndex, TravelDirection direction);
 	void removeVehicle(std::shared_ptr<Vehicle> vehicle);
+	void clearVehicles();
+
+	// vehicles handed over from other segments join after every segment has updated
+	void acceptVehicle(std::shared_ptr<Vehicle> vehicle) { incomingVehicles.push_back(vehicle); markActive(); }
+	void commitIncomingVehicles();
+	void rebuildLaneIndex();
+	void releaseArrivedVehicles(std::vector<std::shared_ptr<Vehicle>>& pool);
+
+	// a signal changing phase wakes the vehicles queued towards it, edits and incidents wake everyone
+	void wakeVehiclesHeldAt(const Junction* junction);
+	void wakeVehicles();
+	size_t getAwakeVehicleCount() const { return awakeVehicles; }
+
+	// active set membership, see activeList
+	void setActiveList(std::vector<RoadSegment*>* list);
+	void markActive() { if (!active && activeList) { active = true; activeList->push_back(this); } }
+	bool isActive() const { return active; }
+	void setCompiledNetwork(const CompiledNetwork* network) { compiledNetwork = network; }
+	bool isIdle() const { return vehicles.empty() && incomingVehicles.empty() && arrivedVehicles.empty() && pendingMergeRequests.empty(); }
+	void deactivate();
 
 	void update(float deltaTime) override;
 
+	// loop detectors count crossings during update, occupancy is sampled from the lane index after it
+	void addDetector(const DetectorSite& site, TravelDirection direction, DetectorBank* bank);
+	bool hasDetectors() const { return detectorBank != nullptr; }
+	void sampleDetectors(float deltaTime);
+	const std::vector<DetectorSite>& getDetectors(TravelDirection direction = TravelDirection::FORWARD) const { return group(direction).detectors; }
+
 	// get position and path
 	Vector3 getPositionAt(float distance) const { return Vector3(position.x + distance, position.y, position.z); }
 	Vector3 getDirectionAt(float distance) const { return Vector3(1.0f, 0.0f, 0.0f); }
-	Vector3 getLanePositionAt(int laneIndex, float distance) const;
+	Vector3 getLanePositionAt(int laneIndex, float distance, TravelDirection direction = TravelDirection::FORWARD) const;
+	Vector3 getLanePositionAt(int laneIndex, float distance, size_t& laneCursor, TravelDirection direction = TravelDirection::FORWARD) const;
 	Vector3 getDirection() const;
 	Vector3 getPerpendicular() const;
 	Vector3 getDirectionVector() const;
 	Vector3 getPerpendicularVector() const;
+	Vector3 getTravelVector(TravelDirection direction) const;
 	Vector3 getStartPosition() const;
 	Vector3 getEndPosition() const;
 	Vector3 getPositionAlongRoad(float distance) const;
-	Vector3 getLanePositionAlongRoad(int laneIndex, float distance) const;
+	Vector3 getLanePositionAlongRoad(int laneIndex, float distance, TravelDirection direction = TravelDirection::FORWARD) const;
 	float getActualLength() const;
 
 	// get lanes
-	const std::vector<Lane>& getLanes() const { return lanes; }
-	int getLaneCount() const { return lanes.size(); }
-	int getLaneCountAt(float distance) const;
-	bool isValidLane(int laneIndex, float distance) const { return laneIndex >= 0 && laneIndex < getLaneCountAt(distance); }
-	int getTargetLane(int currentLane, float currentDistance, float lookAheadDistance) const;
+	const std::vector<Lane>& getLanes(TravelDirection direction = TravelDirection::FORWARD) const { return group(direction).lanes; }
+	int getLaneCount(TravelDirection direction = TravelDirection::FORWARD) const { return group(direction).lanes.size(); }
+	bool isBidirectional() const { return !laneGroups[1].lanes.empty(); }
+	bool hasDirection(TravelDirection direction) const { return !group(direction).lanes.empty(); }
+	const LaneProfile& getLaneProfile(TravelDirection direction = TravelDirection::FORWARD) const { return group(direction).profile; }
+	int getLaneCountAt(float distance, TravelDirection direction = TravelDirection::FORWARD) const { return group(direction).profile.at(distance).laneCount; }
+	int getLaneCountAt(float distance, size_t& laneCursor, TravelDirection direction = TravelDirection::FORWARD) const { return group(direction).profile.at(distance, laneCursor).laneCount; }
+	bool isValidLane(int laneIndex, float distance, TravelDirection direction = TravelDirection::FORWARD) const { return laneIndex >= 0 && laneIndex < getLaneCountAt(distance, direction); }
+	bool isValidLane(int laneIndex, float distance, size_t& laneCursor, TravelDirection direction = TravelDirection::FORWARD) const { return laneIndex >= 0 && laneIndex < getLaneCountAt(distance, laneCursor, direction); }
+	int getTargetLane(int currentLane, float currentDistance, float lookAheadDistance, size_t& laneCursor, TravelDirection direction = TravelDirection::FORWARD) const;
 	int determineClosestLane(float yPosition) const;
+
+	// incidents close lanes for a while, a direction with every regular lane closed takes no vehicles.
+	// open lanes are regular lanes not closed, shoulders are never open
+	void closeLane(int laneIndex, TravelDirection direction = TravelDirection::FORWARD);
+	void reopenLane(int laneIndex, TravelDirection direction = TravelDirection::FORWARD);
+	bool isLaneOpen(int laneIndex, TravelDirection direction = TravelDirection::FORWARD) const;
+	int getTravelLaneCount(TravelDirection direction = TravelDirection::FORWARD) const;
+	int getOpenLaneCount(TravelDirection direction = TravelDirection::FORWARD) const;
+	bool isClosed(TravelDirection direction = TravelDirection::FORWARD) const { return getOpenLaneCount(direction) == 0; }
+
+	// open lane nearest to the preferred one, -1 if the direction is closed
+	int findOpenLane(int preferredLane, TravelDirection direction = TravelDirection::FORWARD) const;
 	Vector3 getWorldPositionAt(int laneIndex, float distance) const;
 
+	// get zones (sorted by start distance)
+	const std::vector<BehaviorZone>& getZones(TravelDirection direction = TravelDirection::FORWARD) const { return group(direction).zones; }
+
 	// get vehicles
 	const std::vector<std::shared_ptr<Vehicle>>& getVehicles() const { return vehicles; }
-	std::vector<std::shared_ptr<Vehicle>> getVehiclesInLane(int laneIndex) const;
-	std::vector<std::shared_ptr<Vehicle>> getVehiclesInLaneSection(int laneIndex, float startDist, float endDist) const;
+
+	// scratch lists in the arena, valid until the arena is rewound or reset
+	Span<Vehicle*> getVehiclesInLane(int laneIndex, TravelDirection direction, FrameArena& arena) const;
+	Span<Vehicle*> getVehiclesInLaneSection(int laneIndex, float startDist, float endDist, TravelDirection direction, FrameArena& arena) const;
+	float getMeanSpeed() const { return meanSpeed; }
+	float getMaxVehicleSpeed() const { return maxVehicleSpeed; }
+	float getClosingTime() const { return closingTime; }
+
+	// compact records of the indexed vehicles as of the last lane index rebuild. they cover every
+	// vehicle only while the index is current, and the segment field is the index the segment had then
+	bool isLaneIndexCurrent() const { return !laneIndexDirty; }
+	Span<const CompactVehicleState> getCompactVehicles() const { return Span<const CompactVehicleState>(compactVehicles.data(), compactVehicles.size()); }
+	uint32_t getClampedVehicleCount() const { return clampedVehicles; }
+	float getDensity() const;
+	LaneNeighbors findNeighbors(int laneIndex, float distance, const Vehicle* exclude = nullptr, TravelDirection direction = TravelDirection::FORWARD) const;
+
+	// cooperative merging
+	void postMergeRequest(const MergeRequest& request) { pendingMergeRequests.push_back(request); }
+	const MergeRequest* findMergeRequest(const Vehicle* yielder) const;
 
 	const std::string& getId() const { return id; }
+	int getIndex() const { return index; }
+	void setIndex(int newIndex) { index = newIndex; }
+	SegmentKind getKind() const { return kind; }
 	float getLength() const { return length; }
-	float getSpeedLimit() const { return speedLimit; }
+	float getSpeedLimit() const { return speedLimit * speedFactor; }
+	void addSpeedReduction(float factor);
+	void removeSpeedReduction(float factor);
+	void setSpeedLimit(float limit) { speedLimit = limit; }
 	std::shared_ptr<Junction> getStartJunction() const { return startJunction.lock(); }
 	std::shared_ptr<Junction> getEndJunction() const { return endJunction.lock(); }
+
+	// junctions seen by a vehicle travelling in a direction
+	std::shared_ptr<Junction> getEntryJunction(TravelDirection direction) const { return direction == TravelDirection::FORWARD ? getStartJunction() : getEndJunction(); }
+	std::shared_ptr<Junction> getExitJunction(TravelDirection direction) const { return direction == TravelDirection::FORWARD ? getEndJunction() : getStartJunction(); }
 	virtual bool isCurved() const { return false; }
 };
\ No newline at end of file
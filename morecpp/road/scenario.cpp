@@ -0,0 +1,146 @@
+#include "scenario.h"
+
+#include <memory>
+
+#include "roadNetwork.h"
+#include "simpleJunction.h"
+#include "trafficLightJunction.h"
+#include "../navigation/destination.h"
+
+
+void ScenarioBuilder::build(const ScenarioDescription& scenario, RoadNetwork& network) {
+	std::vector<std::shared_ptr<Junction>> junctions;
+	junctions.reserve(scenario.junctions.size());
+
+	for (const auto& spec : scenario.junctions) {
+		Vector3 position(spec.x, 0.0f, spec.z);
+		std::shared_ptr<Junction> junction;
+		if (spec.type == ScenarioDescription::JunctionType::TRAFFIC_LIGHT) {
+			junction = std::make_shared<TrafficLightJunction>(spec.id, position, spec.radius);
+		} else {
+			junction = std::make_shared<SimpleJunction>(spec.id, position, spec.radius);
+		}
+		network.addJunction(junction);
+		junctions.push_back(junction);
+	}
+
+	std::vector<std::shared_ptr<RoadSegment>> segments;
+	segments.reserve(scenario.segments.size());
+
+	for (const auto& spec : scenario.segments) {
+		auto start = junctions[spec.from];
+		auto end = junctions[spec.to];
+		Vector3 dimensions((end->getPosition() - start->getPosition()).length(), 0.0f, spec.width);
+
+		std::shared_ptr<RoadSegment> segment;
+		if (spec.isRamp) {
+			auto ramp = std::make_shared<HighwayRamp>(spec.id, start->getPosition(), dimensions, spec.speedLimit, spec.rampType);
+			if (spec.mainRoad >= 0) {
+				ramp->setMainRoad(segments[spec.mainRoad], spec.mergeStart, spec.mergeEnd, spec.targetLane);
+			}
+			segment = ramp;
+		} else {
+			segment = std::make_shared<RoadSegment>(spec.id, start->getPosition(), dimensions, spec.speedLimit);
+		}
+
+		if (spec.lanes.empty()) {
+			// same layout as the grid builder, shoulder, regular lanes, shoulder
+			for (TravelDirection direction : { TravelDirection::FORWARD, TravelDirection::REVERSE }) {
+				if (direction == TravelDirection::REVERSE && !spec.twoWay) continue;
+
+				segment->addLane(Lane(0, LaneType::SHOULDER, 2.0f), direction);
+				for (int i = 0; i < spec.autoLanes; i++) {
+					segment->addLane(Lane(i + 1, LaneType::REGULAR, 4.0f), direction);
+				}
+				segment->addLane(Lane(spec.autoLanes + 1, LaneType::SHOULDER, 2.0f), direction);
+			}
+		}
+
+		// lanes are numbered per direction in the order they are listed
+		int laneCounts[2] = { 0, 0 };
+		for (const auto& lane : spec.lanes) {
+			int& count = laneCounts[static_cast<int>(lane.direction)];
+			segment->addLane(Lane(count++, lane.type, lane.width), lane.direction);
+		}
+
+		for (const auto& transition : spec.transitions) {
+			std::map<int, int> mapping(transition.mapping.begin(), transition.mapping.end());
+			segment->addLaneTransition(transition.startDistance, transition.endDistance, transition.startLanes, transition.endLanes, mapping, transition.direction);
+		}
+
+		segment->setJunctions(start, end);
+		start->connectRoad(segment);
+		end->connectRoad(segment);
+		network.addRoadSegment(segment);
+		segments.push_back(segment);
+	}
+
+	// signal plans, in the order the phases were listed
+	std::vector<bool> planned(junctions.size(), false);
+	for (const auto& phase : scenario.phases) {
+		auto lights = std::dynamic_pointer_cast<TrafficLightJunction>(junctions[phase.junction]);
+		if (!lights) continue;
+
+		if (!planned[phase.junction]) {
+			lights->clearPhases();
+			planned[phase.junction] = true;
+		}
+
+		std::vector<std::pair<std::string, std::string>> movements;
+		for (const auto& [from, to] : phase.movements) {
+			movements.push_back({ scenario.segments[from].id, scenario.segments[to].id });
+		}
+		lights->addPhase(phase.duration, movements);
+	}
+
+	for (size_t i = 0; i < junctions.size(); i++) {
+		auto lights = std::dynamic_pointer_cast<TrafficLightJunction>(junctions[i]);
+		if (lights && !planned[i]) {
+			lights->generatePhases();
+		}
+	}
+
+	for (const auto& spec : scenario.spawns) {
+		network.addSpawnPoint(std::make_shared<SpawnPoint>(segments[spec.segment], spec.distance, spec.rate, spec.direction));
+	}
+
+	for (const auto& spec : scenario.destinations) {
+		network.addDestination(std::make_shared<Destination>(Vector3(spec.x, 0.0f, spec.z), spec.id, spec.radius));
+	}
+
+	for (const auto& spec : scenario.detectors) {
+		network.addDetector({ spec.id, segments[spec.segment]->getId(), spec.direction, spec.distance, spec.lane });
+	}
+
+	if (scenario.demand.empty()) {
+		return;
+	}
+
+	// explicit rows replace the default demand, spawns without a row release nothing
+	DemandModel& demand = network.getDemandModel();
+	demand.clearOrigins();
+
+	std::vector<int> profiles;
+	for (const auto& spec : scenario.profiles) {
+		profiles.push_back(demand.addProfile(DemandProfile(spec.points, spec.period)));
+	}
+
+	for (const auto& row : scenario.demand) {
+		const auto& spawn = scenario.spawns[row.origin];
+
+		std::vector<float> weights(scenario.destinations.size(), 0.0f);
+		for (const auto& [destination, weight] : row.weights) {
+			weights[destination] = weight;
+		}
+
+		std::vector<int> laneIndices;
+		for (const auto& lane : segments[spawn.segment]->getLanes(spawn.direction)) {
+			if (lane.getType() == LaneType::REGULAR) {
+				laneIndices.push_back(lane.getIndex());
+			}
+		}
+		if (laneIndices.empty()) continue;
+
+		demand.setOrigin(row.origin, row.vehiclesPerMinute, weights, laneIndices, {}, row.profile >= 0 ? profiles[row.profile] : 0);
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "lane.h"
+#include "roadSegment.h"
+#include "highwayRamp.h"
+
+
+class RoadNetwork;
+
+
+// a network with its signals and demand as plain data, what scenario files parse and compile to.
+// entities refer to each other by index into their list, in the order they were declared
+struct ScenarioDescription {
+	enum class JunctionType : uint8_t {
+		SIMPLE,
+		TRAFFIC_LIGHT
+	};
+
+	struct JunctionSpec {
+		std::string id;
+		JunctionType type = JunctionType::SIMPLE;
+		float x = 0.0f, z = 0.0f;
+		float radius = 10.0f;
+	};
+
+	struct LaneSpec {
+		LaneType type = LaneType::REGULAR;
+		float width = 4.0f;
+		TravelDirection direction = TravelDirection::FORWARD;
+	};
+
+	struct TransitionSpec {
+		TravelDirection direction = TravelDirection::FORWARD;
+		float startDistance = 0.0f, endDistance = 0.0f;
+		int startLanes = 0, endLanes = 0;
+		std::vector<std::pair<int, int>> mapping;
+	};
+
+	// roads and ramps alike, ramps only use the ramp fields
+	struct SegmentSpec {
+		std::string id;
+		int from = -1, to = -1;
+		float speedLimit = 10.0f;
+		float width = 32.0f;
+
+		// lanes of each direction when no explicit lanes are given, a shoulder on either side
+		int autoLanes = 2;
+		bool twoWay = true;
+
+		std::vector<LaneSpec> lanes;
+		std::vector<TransitionSpec> transitions;
+
+		bool isRamp = false;
+		RampType rampType = RampType::ENTRANCE;
+		int mainRoad = -1;
+		float mergeStart = 0.0f, mergeEnd = 0.0f;
+		int targetLane = 0;
+	};
+
+	struct PhaseSpec {
+		int junction = -1;
+		float duration = 5.0f;
+
+		// segment indices
+		std::vector<std::pair<int, int>> movements;
+	};
+
+	struct SpawnSpec {
+		std::string id;
+		int segment = -1;
+		TravelDirection direction = TravelDirection::FORWARD;
+		float distance = 0.0f;
+		float rate = 10.0f;
+	};
+
+	// lane -1 covers every lane of the direction
+	struct DetectorSpec {
+		std::string id;
+		int segment = -1;
+		TravelDirection direction = TravelDirection::FORWARD;
+		float distance = 0.0f;
+		int lane = -1;
+	};
+
+	struct DestinationSpec {
+		std::string id;
+		float x = 0.0f, z = 0.0f;
+		float radius = 10.0f;
+	};
+
+	struct ProfileSpec {
+		std::string id;
+		float period = 86400.0f;
+		std::vector<std::pair<float, float>> points;
+	};
+
+	// one od matrix row, origin is a spawn and weights are (destination, weight)
+	struct DemandSpec {
+		int origin = -1;
+		float vehiclesPerMinute = 0.0f;
+		int profile = -1;
+		std::vector<std::pair<int, float>> weights;
+	};
+
+	std::vector<JunctionSpec> junctions;
+	std::vector<SegmentSpec> segments;
+	std::vector<PhaseSpec> phases;
+	std::vector<SpawnSpec> spawns;
+	std::vector<DestinationSpec> destinations;
+	std::vector<ProfileSpec> profiles;
+	std::vector<DemandSpec> demand;
+	std::vector<DetectorSpec> detectors;
+
+	void clear() { *this = ScenarioDescription(); }
+};
+
+
+class ScenarioBuilder {
+public:
+	// adds everything in the description to an empty network. junctions with lights and no
+	// phases get generated ones, and demand rows replace the default demand when there are any
+	static void build(const ScenarioDescription& scenario, RoadNetwork& network);
+};
@@ -0,0 +1,353 @@
+#include "scenarioBinary.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+
+struct ScenarioByteWriter {
+	std::vector<uint8_t>& bytes;
+
+	void u8(uint8_t value) { bytes.push_back(value); }
+
+	void u32(uint32_t value) {
+		for (int i = 0; i < 4; i++) bytes.push_back(static_cast<uint8_t>(value >> (i * 8)));
+	}
+
+	void i32(int32_t value) { u32(static_cast<uint32_t>(value)); }
+
+	void f32(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		u32(bits);
+	}
+
+	void string(const std::string& value) {
+		u32(static_cast<uint32_t>(value.size()));
+		bytes.insert(bytes.end(), value.begin(), value.end());
+	}
+};
+
+
+// every read checks the remaining size, a short or corrupt file fails instead of reading past the end
+struct ScenarioByteReader {
+	const uint8_t* data;
+	size_t size;
+	size_t offset = 0;
+
+	bool u8(uint8_t& value) {
+		if (size - offset < 1) return false;
+		value = data[offset++];
+		return true;
+	}
+
+	bool u32(uint32_t& value) {
+		if (size - offset < 4) return false;
+		value = 0;
+		for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(data[offset++]) << (i * 8);
+		return true;
+	}
+
+	bool i32(int& value) {
+		uint32_t bits;
+		if (!u32(bits)) return false;
+		value = static_cast<int32_t>(bits);
+		return true;
+	}
+
+	bool f32(float& value) {
+		uint32_t bits;
+		if (!u32(bits)) return false;
+		std::memcpy(&value, &bits, sizeof(value));
+		return true;
+	}
+
+	bool string(std::string& value) {
+		uint32_t length;
+		if (!u32(length) || size - offset < length) return false;
+		value.assign(reinterpret_cast<const char*>(data + offset), length);
+		offset += length;
+		return true;
+	}
+
+	// list lengths are checked against the bytes left so a bad count can not reserve gigabytes
+	template <typename T>
+	bool count(std::vector<T>& list, size_t minimumBytes) {
+		uint32_t length;
+		if (!u32(length) || length > (size - offset) / minimumBytes) return false;
+		list.resize(length);
+		return true;
+	}
+
+	template <typename Enum>
+	bool enumeration(Enum& value, int limit) {
+		uint8_t raw;
+		if (!u8(raw) || raw >= limit) return false;
+		value = static_cast<Enum>(raw);
+		return true;
+	}
+};
+
+
+void ScenarioBinary::write(const ScenarioDescription& scenario, std::vector<uint8_t>& bytes) {
+	bytes.clear();
+	ScenarioByteWriter out{ bytes };
+
+	bytes.insert(bytes.end(), magic, magic + 4);
+	out.u32(version);
+
+	out.u32(static_cast<uint32_t>(scenario.junctions.size()));
+	for (const auto& junction : scenario.junctions) {
+		out.string(junction.id);
+		out.u8(static_cast<uint8_t>(junction.type));
+		out.f32(junction.x);
+		out.f32(junction.z);
+		out.f32(junction.radius);
+	}
+
+	out.u32(static_cast<uint32_t>(scenario.segments.size()));
+	for (const auto& segment : scenario.segments) {
+		out.string(segment.id);
+		out.i32(segment.from);
+		out.i32(segment.to);
+		out.f32(segment.speedLimit);
+		out.f32(segment.width);
+		out.i32(segment.autoLanes);
+		out.u8(segment.twoWay ? 1 : 0);
+
+		out.u32(static_cast<uint32_t>(segment.lanes.size()));
+		for (const auto& lane : segment.lanes) {
+			out.u8(static_cast<uint8_t>(lane.type));
+			out.f32(lane.width);
+			out.u8(static_cast<uint8_t>(lane.direction));
+		}
+
+		out.u32(static_cast<uint32_t>(segment.transitions.size()));
+		for (const auto& transition : segment.transitions) {
+			out.u8(static_cast<uint8_t>(transition.direction));
+			out.f32(transition.startDistance);
+			out.f32(transition.endDistance);
+			out.i32(transition.startLanes);
+			out.i32(transition.endLanes);
+			out.u32(static_cast<uint32_t>(transition.mapping.size()));
+			for (const auto& [from, to] : transition.mapping) {
+				out.i32(from);
+				out.i32(to);
+			}
+		}
+
+		out.u8(segment.isRamp ? 1 : 0);
+		out.u8(static_cast<uint8_t>(segment.rampType));
+		out.i32(segment.mainRoad);
+		out.f32(segment.mergeStart);
+		out.f32(segment.mergeEnd);
+		out.i32(segment.targetLane);
+	}
+
+	out.u32(static_cast<uint32_t>(scenario.phases.size()));
+	for (const auto& phase : scenario.phases) {
+		out.i32(phase.junction);
+		out.f32(phase.duration);
+		out.u32(static_cast<uint32_t>(phase.movements.size()));
+		for (const auto& [from, to] : phase.movements) {
+			out.i32(from);
+			out.i32(to);
+		}
+	}
+
+	out.u32(static_cast<uint32_t>(scenario.spawns.size()));
+	for (const auto& spawn : scenario.spawns) {
+		out.string(spawn.id);
+		out.i32(spawn.segment);
+		out.u8(static_cast<uint8_t>(spawn.direction));
+		out.f32(spawn.distance);
+		out.f32(spawn.rate);
+	}
+
+	out.u32(static_cast<uint32_t>(scenario.destinations.size()));
+	for (const auto& destination : scenario.destinations) {
+		out.string(destination.id);
+		out.f32(destination.x);
+		out.f32(destination.z);
+		out.f32(destination.radius);
+	}
+
+	out.u32(static_cast<uint32_t>(scenario.profiles.size()));
+	for (const auto& profile : scenario.profiles) {
+		out.string(profile.id);
+		out.f32(profile.period);
+		out.u32(static_cast<uint32_t>(profile.points.size()));
+		for (const auto& [time, factor] : profile.points) {
+			out.f32(time);
+			out.f32(factor);
+		}
+	}
+
+	out.u32(static_cast<uint32_t>(scenario.demand.size()));
+	for (const auto& row : scenario.demand) {
+		out.i32(row.origin);
+		out.f32(row.vehiclesPerMinute);
+		out.i32(row.profile);
+		out.u32(static_cast<uint32_t>(row.weights.size()));
+		for (const auto& [destination, weight] : row.weights) {
+			out.i32(destination);
+			out.f32(weight);
+		}
+	}
+
+	out.u32(static_cast<uint32_t>(scenario.detectors.size()));
+	for (const auto& detector : scenario.detectors) {
+		out.string(detector.id);
+		out.i32(detector.segment);
+		out.u8(static_cast<uint8_t>(detector.direction));
+		out.f32(detector.distance);
+		out.i32(detector.lane);
+	}
+}
+
+
+static bool inRange(int index, size_t count) {
+	return index >= 0 && static_cast<size_t>(index) < count;
+}
+
+
+bool ScenarioBinary::read(const uint8_t* data, size_t size, ScenarioDescription& scenario, std::string& error) {
+	scenario.clear();
+	ScenarioByteReader in{ data, size };
+
+	uint32_t fileVersion = 0;
+	if (size < 4 || std::memcmp(data, magic, 4) != 0) {
+		error = "not a compiled scenario";
+		return false;
+	}
+	in.offset = 4;
+	if (!in.u32(fileVersion) || fileVersion != version) {
+		error = "compiled scenario version " + std::to_string(fileVersion) + ", expected " + std::to_string(version);
+		return false;
+	}
+
+	auto truncated = [&]() {
+		error = "compiled scenario is truncated or corrupt at byte " + std::to_string(in.offset);
+		return false;
+	};
+
+	if (!in.count(scenario.junctions, 17)) return truncated();
+	for (auto& junction : scenario.junctions) {
+		if (!in.string(junction.id) || !in.enumeration(junction.type, 2) || !in.f32(junction.x) || !in.f32(junction.z) || !in.f32(junction.radius)) return truncated();
+	}
+
+	size_t junctionCount = scenario.junctions.size();
+	if (!in.count(scenario.segments, 40)) return truncated();
+	for (size_t i = 0; i < scenario.segments.size(); i++) {
+		auto& segment = scenario.segments[i];
+		uint8_t twoWay, isRamp;
+		if (!in.string(segment.id) || !in.i32(segment.from) || !in.i32(segment.to) || !in.f32(segment.speedLimit) || !in.f32(segment.width)
+			|| !in.i32(segment.autoLanes) || !in.u8(twoWay)) return truncated();
+		segment.twoWay = twoWay != 0;
+
+		if (!in.count(segment.lanes, 6)) return truncated();
+		for (auto& lane : segment.lanes) {
+			if (!in.enumeration(lane.type, 7) || !in.f32(lane.width) || !in.enumeration(lane.direction, 2)) return truncated();
+		}
+
+		if (!in.count(segment.transitions, 21)) return truncated();
+		for (auto& transition : segment.transitions) {
+			if (!in.enumeration(transition.direction, 2) || !in.f32(transition.startDistance) || !in.f32(transition.endDistance)
+				|| !in.i32(transition.startLanes) || !in.i32(transition.endLanes) || !in.count(transition.mapping, 8)) return truncated();
+			for (auto& [from, to] : transition.mapping) {
+				if (!in.i32(from) || !in.i32(to)) return truncated();
+			}
+		}
+
+		if (!in.u8(isRamp) || !in.enumeration(segment.rampType, 2) || !in.i32(segment.mainRoad) || !in.f32(segment.mergeStart)
+			|| !in.f32(segment.mergeEnd) || !in.i32(segment.targetLane)) return truncated();
+		segment.isRamp = isRamp != 0;
+
+		// the builder indexes with these, a ramp's main road must come before it
+		if (!inRange(segment.from, junctionCount) || !inRange(segment.to, junctionCount)
+			|| (segment.mainRoad >= 0 && static_cast<size_t>(segment.mainRoad) >= i)) {
+			error = "compiled scenario road " + segment.id + " refers to a missing junction or road";
+			return false;
+		}
+	}
+
+	size_t segmentCount = scenario.segments.size();
+	if (!in.count(scenario.phases, 12)) return truncated();
+	for (auto& phase : scenario.phases) {
+		if (!in.i32(phase.junction) || !in.f32(phase.duration) || !in.count(phase.movements, 8)) return truncated();
+		if (!inRange(phase.junction, junctionCount)) return truncated();
+		for (auto& [from, to] : phase.movements) {
+			if (!in.i32(from) || !in.i32(to) || !inRange(from, segmentCount) || !inRange(to, segmentCount)) return truncated();
+		}
+	}
+
+	if (!in.count(scenario.spawns, 17)) return truncated();
+	for (auto& spawn : scenario.spawns) {
+		if (!in.string(spawn.id) || !in.i32(spawn.segment) || !in.enumeration(spawn.direction, 2) || !in.f32(spawn.distance) || !in.f32(spawn.rate)) return truncated();
+		if (!inRange(spawn.segment, segmentCount)) return truncated();
+	}
+
+	if (!in.count(scenario.destinations, 16)) return truncated();
+	for (auto& destination : scenario.destinations) {
+		if (!in.string(destination.id) || !in.f32(destination.x) || !in.f32(destination.z) || !in.f32(destination.radius)) return truncated();
+	}
+
+	if (!in.count(scenario.profiles, 12)) return truncated();
+	for (auto& profile : scenario.profiles) {
+		if (!in.string(profile.id) || !in.f32(profile.period) || !in.count(profile.points, 8)) return truncated();
+		for (auto& [time, factor] : profile.points) {
+			if (!in.f32(time) || !in.f32(factor)) return truncated();
+		}
+	}
+
+	if (!in.count(scenario.demand, 16)) return truncated();
+	for (auto& row : scenario.demand) {
+		if (!in.i32(row.origin) || !in.f32(row.vehiclesPerMinute) || !in.i32(row.profile) || !in.count(row.weights, 8)) return truncated();
+		if (!inRange(row.origin, scenario.spawns.size()) || row.profile >= static_cast<int>(scenario.profiles.size())) return truncated();
+		for (auto& [destination, weight] : row.weights) {
+			if (!in.i32(destination) || !in.f32(weight) || !inRange(destination, scenario.destinations.size())) return truncated();
+		}
+	}
+
+	if (!in.count(scenario.detectors, 17)) return truncated();
+	for (auto& detector : scenario.detectors) {
+		if (!in.string(detector.id) || !in.i32(detector.segment) || !in.enumeration(detector.direction, 2) || !in.f32(detector.distance) || !in.i32(detector.lane)) return truncated();
+		if (!inRange(detector.segment, segmentCount)) return truncated();
+	}
+
+	return true;
+}
+
+
+bool ScenarioBinary::writeFile(const ScenarioDescription& scenario, const std::string& path) {
+	std::vector<uint8_t> bytes;
+	write(scenario, bytes);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) return false;
+	file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	return file.good();
+}
+
+
+bool ScenarioBinary::readFile(const std::string& path, ScenarioDescription& scenario, std::string& error) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		error = "failed to open scenario file: " + path;
+		return false;
+	}
+
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (!read(bytes.data(), bytes.size(), scenario, error)) {
+		error = path + " " + error;
+		return false;
+	}
+	return true;
+}
+
+
+bool ScenarioBinary::isBinaryFile(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	char start[4] = {};
+	return file.read(start, 4) && std::memcmp(start, magic, 4) == 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "scenario.h"
+
+
+// parsed scenarios compiled to a flat little endian file that loads without any text handling.
+// the layout follows ScenarioDescription field by field, strings and lists are length prefixed
+class ScenarioBinary {
+public:
+	static constexpr char magic[4] = { 'M', 'C', 'S', 'C' };
+	static constexpr uint32_t version = 2;
+
+	static void write(const ScenarioDescription& scenario, std::vector<uint8_t>& bytes);
+	static bool read(const uint8_t* data, size_t size, ScenarioDescription& scenario, std::string& error);
+
+	static bool writeFile(const ScenarioDescription& scenario, const std::string& path);
+	static bool readFile(const std::string& path, ScenarioDescription& scenario, std::string& error);
+
+	// true when the file starts with the magic, so loaders can take either format
+	static bool isBinaryFile(const std::string& path);
+};
@@ -0,0 +1,459 @@
+#include "scenarioParser.h"
+
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+
+// one pass over the text, names are looked up as views into it so nothing is copied until an entity is stored
+struct ScenarioReader {
+	ScenarioDescription& scenario;
+	std::string message;
+
+	std::unordered_map<std::string_view, int> junctions;
+	std::unordered_map<std::string_view, int> segments;
+	std::unordered_map<std::string_view, int> spawns;
+	std::unordered_map<std::string_view, int> destinations;
+	std::unordered_map<std::string_view, int> profiles;
+	std::unordered_map<std::string_view, int> detectors;
+
+	// the current line, keyword and name first
+	std::vector<std::string_view> words;
+
+	ScenarioReader(ScenarioDescription& scenario) : scenario(scenario) {}
+
+	bool fail(std::string text) { message = std::move(text); return false; }
+
+
+	static bool toFloat(std::string_view text, float& value) {
+		auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+		return result.ec == std::errc() && result.ptr == text.data() + text.size();
+	}
+
+	static bool toInt(std::string_view text, int& value) {
+		auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+		return result.ec == std::errc() && result.ptr == text.data() + text.size();
+	}
+
+	static bool split(std::string_view text, char separator, std::string_view& first, std::string_view& second) {
+		size_t at = text.find(separator);
+		if (at == std::string_view::npos) return false;
+		first = text.substr(0, at);
+		second = text.substr(at + 1);
+		return true;
+	}
+
+	// calls item on each comma separated entry, stops at the first it rejects
+	template <typename Item>
+	static bool forEachItem(std::string_view list, Item item) {
+		while (!list.empty()) {
+			size_t at = list.find(',');
+			if (!item(list.substr(0, at))) return false;
+			if (at == std::string_view::npos) break;
+			list.remove_prefix(at + 1);
+		}
+		return true;
+	}
+
+
+	bool number(std::string_view key, std::string_view value, float& out) {
+		return toFloat(value, out) || fail(std::string(key) + " is not a number: " + std::string(value));
+	}
+
+	bool integer(std::string_view key, std::string_view value, int& out) {
+		return toInt(value, out) || fail(std::string(key) + " is not an integer: " + std::string(value));
+	}
+
+	bool lookup(const std::unordered_map<std::string_view, int>& names, const char* kind, std::string_view name, int& out) {
+		auto it = names.find(name);
+		if (it == names.end()) return fail(std::string("unknown ") + kind + ": " + std::string(name));
+		out = it->second;
+		return true;
+	}
+
+	bool declare(std::unordered_map<std::string_view, int>& names, const char* kind, std::string_view name, size_t index) {
+		if (!names.emplace(name, static_cast<int>(index)).second) return fail(std::string("duplicate ") + kind + ": " + std::string(name));
+		return true;
+	}
+
+	bool direction(std::string_view value, TravelDirection& out) {
+		if (value == "forward") out = TravelDirection::FORWARD;
+		else if (value == "reverse") out = TravelDirection::REVERSE;
+		else return fail("direction must be forward or reverse: " + std::string(value));
+		return true;
+	}
+
+	// calls attribute with each key and value after the name, flags come through with an empty value
+	template <typename Attribute>
+	bool forEachAttribute(Attribute attribute) {
+		for (size_t i = 2; i < words.size(); i++) {
+			std::string_view key = words[i], value;
+			split(words[i], '=', key, value);
+			if (!attribute(key, value)) return false;
+		}
+		return true;
+	}
+
+	bool unknown(std::string_view key) {
+		return fail("unknown attribute " + std::string(key) + " for " + std::string(words[0]));
+	}
+
+
+	bool readJunction() {
+		ScenarioDescription::JunctionSpec spec;
+		spec.id = words[1];
+		bool radiusSet = false;
+
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "type") {
+				if (value == "simple") spec.type = ScenarioDescription::JunctionType::SIMPLE;
+				else if (value == "lights") spec.type = ScenarioDescription::JunctionType::TRAFFIC_LIGHT;
+				else return fail("junction type must be simple or lights: " + std::string(value));
+				return true;
+			}
+			if (key == "x") return number(key, value, spec.x);
+			if (key == "z") return number(key, value, spec.z);
+			if (key == "radius") {
+				radiusSet = true;
+				return number(key, value, spec.radius);
+			}
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		// the same defaults as the junction classes
+		if (!radiusSet && spec.type == ScenarioDescription::JunctionType::TRAFFIC_LIGHT) spec.radius = 15.0f;
+
+		if (!declare(junctions, "junction", words[1], scenario.junctions.size())) return false;
+		scenario.junctions.push_back(std::move(spec));
+		return true;
+	}
+
+
+	bool readSegment(bool ramp) {
+		ScenarioDescription::SegmentSpec spec;
+		spec.id = words[1];
+		spec.isRamp = ramp;
+
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "from") return lookup(junctions, "junction", value, spec.from);
+			if (key == "to") return lookup(junctions, "junction", value, spec.to);
+			if (key == "speed") return number(key, value, spec.speedLimit);
+			if (key == "width") return number(key, value, spec.width);
+			if (key == "lanes") return integer(key, value, spec.autoLanes);
+			if (key == "oneway" && value.empty()) {
+				spec.twoWay = false;
+				return true;
+			}
+
+			if (ramp) {
+				if (key == "main") return lookup(segments, "road", value, spec.mainRoad);
+				if (key == "lane") return integer(key, value, spec.targetLane);
+				if (key == "type") {
+					if (value == "entrance") spec.rampType = RampType::ENTRANCE;
+					else if (value == "exit") spec.rampType = RampType::EXIT;
+					else return fail("ramp type must be entrance or exit: " + std::string(value));
+					return true;
+				}
+				if (key == "merge") {
+					std::string_view start, end;
+					if (!split(value, ':', start, end)) return fail("merge must be start:end");
+					return number(key, start, spec.mergeStart) && number(key, end, spec.mergeEnd);
+				}
+			}
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		if (spec.from < 0 || spec.to < 0) return fail(std::string(words[0]) + " needs from= and to=");
+		if (spec.from == spec.to) return fail(std::string(words[0]) + " starts and ends at the same junction");
+
+		// ramps are one way onto or off their main road
+		if (ramp) spec.twoWay = false;
+
+		if (!declare(segments, "road", words[1], scenario.segments.size())) return false;
+		scenario.segments.push_back(std::move(spec));
+		return true;
+	}
+
+
+	bool readLane() {
+		int segment;
+		if (!lookup(segments, "road", words[1], segment)) return false;
+
+		ScenarioDescription::LaneSpec spec;
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "dir") return direction(value, spec.direction);
+			if (key == "width") return number(key, value, spec.width);
+			if (key == "type") {
+				if (value == "regular") spec.type = LaneType::REGULAR;
+				else if (value == "exit") spec.type = LaneType::EXIT_ONLY;
+				else if (value == "entrance") spec.type = LaneType::ENTRANCE_ONLY;
+				else if (value == "hov") spec.type = LaneType::HOV;
+				else if (value == "shoulder") spec.type = LaneType::SHOULDER;
+				else if (value == "left") spec.type = LaneType::TURN_LEFT;
+				else if (value == "right") spec.type = LaneType::TURN_RIGHT;
+				else return fail("unknown lane type: " + std::string(value));
+				return true;
+			}
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		scenario.segments[segment].lanes.push_back(spec);
+		return true;
+	}
+
+
+	bool readTransition() {
+		int segment;
+		if (!lookup(segments, "road", words[1], segment)) return false;
+
+		ScenarioDescription::TransitionSpec spec;
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "dir") return direction(value, spec.direction);
+			if (key == "start") return number(key, value, spec.startDistance);
+			if (key == "end") return number(key, value, spec.endDistance);
+			if (key == "from") return integer(key, value, spec.startLanes);
+			if (key == "to") return integer(key, value, spec.endLanes);
+			if (key == "map") {
+				return forEachItem(value, [&](std::string_view item) {
+					std::string_view from, to;
+					std::pair<int, int> lanes;
+					if (!split(item, ':', from, to)) return fail("map entries must be lane:lane");
+					if (!integer(key, from, lanes.first) || !integer(key, to, lanes.second)) return false;
+					spec.mapping.push_back(lanes);
+					return true;
+				});
+			}
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		scenario.segments[segment].transitions.push_back(std::move(spec));
+		return true;
+	}
+
+
+	bool readPhase() {
+		ScenarioDescription::PhaseSpec spec;
+		if (!lookup(junctions, "junction", words[1], spec.junction)) return false;
+		if (scenario.junctions[spec.junction].type != ScenarioDescription::JunctionType::TRAFFIC_LIGHT) {
+			return fail("phase for a junction without lights: " + std::string(words[1]));
+		}
+
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "duration") return number(key, value, spec.duration);
+			if (key == "moves") {
+				return forEachItem(value, [&](std::string_view item) {
+					std::string_view from, to;
+					std::pair<int, int> movement;
+					if (!split(item, '>', from, to)) return fail("moves must be road>road");
+					if (!lookup(segments, "road", from, movement.first) || !lookup(segments, "road", to, movement.second)) return false;
+					spec.movements.push_back(movement);
+					return true;
+				});
+			}
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		scenario.phases.push_back(std::move(spec));
+		return true;
+	}
+
+
+	bool readSpawn() {
+		ScenarioDescription::SpawnSpec spec;
+		spec.id = words[1];
+
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "road") return lookup(segments, "road", value, spec.segment);
+			if (key == "dir") return direction(value, spec.direction);
+			if (key == "distance") return number(key, value, spec.distance);
+			if (key == "rate") return number(key, value, spec.rate);
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		if (spec.segment < 0) return fail("spawn needs road=");
+		if (!declare(spawns, "spawn", words[1], scenario.spawns.size())) return false;
+		scenario.spawns.push_back(std::move(spec));
+		return true;
+	}
+
+
+	bool readDetector() {
+		ScenarioDescription::DetectorSpec spec;
+		spec.id = words[1];
+
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "road") return lookup(segments, "road", value, spec.segment);
+			if (key == "dir") return direction(value, spec.direction);
+			if (key == "distance") return number(key, value, spec.distance);
+			if (key == "lane") return integer(key, value, spec.lane);
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		if (spec.segment < 0) return fail("detector needs road=");
+		if (spec.distance <= 0.0f) return fail("detector needs a distance past the start of the road");
+		if (!declare(detectors, "detector", words[1], scenario.detectors.size())) return false;
+		scenario.detectors.push_back(std::move(spec));
+		return true;
+	}
+
+
+	bool readDestination() {
+		ScenarioDescription::DestinationSpec spec;
+		spec.id = words[1];
+
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "x") return number(key, value, spec.x);
+			if (key == "z") return number(key, value, spec.z);
+			if (key == "radius") return number(key, value, spec.radius);
+			if (key == "at") {
+				int junction;
+				if (!lookup(junctions, "junction", value, junction)) return false;
+				spec.x = scenario.junctions[junction].x;
+				spec.z = scenario.junctions[junction].z;
+				return true;
+			}
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		if (!declare(destinations, "destination", words[1], scenario.destinations.size())) return false;
+		scenario.destinations.push_back(std::move(spec));
+		return true;
+	}
+
+
+	bool readProfile() {
+		ScenarioDescription::ProfileSpec spec;
+		spec.id = words[1];
+
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "period") return number(key, value, spec.period);
+			if (key == "points") {
+				return forEachItem(value, [&](std::string_view item) {
+					std::string_view time, factor;
+					std::pair<float, float> point;
+					if (!split(item, ':', time, factor)) return fail("points must be time:factor");
+					if (!number(key, time, point.first) || !number(key, factor, point.second)) return false;
+					spec.points.push_back(point);
+					return true;
+				});
+			}
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		if (!declare(profiles, "profile", words[1], scenario.profiles.size())) return false;
+		scenario.profiles.push_back(std::move(spec));
+		return true;
+	}
+
+
+	bool readDemand() {
+		ScenarioDescription::DemandSpec spec;
+		if (!lookup(spawns, "spawn", words[1], spec.origin)) return false;
+
+		bool read = forEachAttribute([&](std::string_view key, std::string_view value) {
+			if (key == "vpm") return number(key, value, spec.vehiclesPerMinute);
+			if (key == "profile") return lookup(profiles, "profile", value, spec.profile);
+			if (key == "to") {
+				return forEachItem(value, [&](std::string_view item) {
+					std::string_view name, weight;
+					std::pair<int, float> entry(0, 1.0f);
+					if (!split(item, ':', name, weight)) name = item;
+					else if (!number(key, weight, entry.second)) return false;
+					if (!lookup(destinations, "destination", name, entry.first)) return false;
+					spec.weights.push_back(entry);
+					return true;
+				});
+			}
+			return unknown(key);
+		});
+		if (!read) return false;
+
+		if (spec.weights.empty()) return fail("demand needs to=");
+		scenario.demand.push_back(std::move(spec));
+		return true;
+	}
+
+
+	bool readLine(std::string_view line) {
+		size_t comment = line.find('#');
+		if (comment != std::string_view::npos) line = line.substr(0, comment);
+
+		words.clear();
+		while (true) {
+			size_t start = line.find_first_not_of(" \t\r");
+			if (start == std::string_view::npos) break;
+			size_t end = line.find_first_of(" \t\r", start);
+			words.push_back(line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start));
+			if (end == std::string_view::npos) break;
+			line.remove_prefix(end);
+		}
+
+		if (words.empty()) return true;
+		if (words.size() < 2) return fail(std::string(words[0]) + " needs a name");
+
+		std::string_view keyword = words[0];
+		if (keyword == "junction") return readJunction();
+		if (keyword == "road") return readSegment(false);
+		if (keyword == "ramp") return readSegment(true);
+		if (keyword == "lane") return readLane();
+		if (keyword == "transition") return readTransition();
+		if (keyword == "phase") return readPhase();
+		if (keyword == "spawn") return readSpawn();
+		if (keyword == "detector") return readDetector();
+		if (keyword == "destination") return readDestination();
+		if (keyword == "profile") return readProfile();
+		if (keyword == "demand") return readDemand();
+		return fail("unknown keyword: " + std::string(keyword));
+	}
+};
+
+
+bool ScenarioParser::parse(std::string_view text, ScenarioDescription& scenario, std::string& error) {
+	scenario.clear();
+	ScenarioReader reader(scenario);
+
+	int lineNumber = 0;
+	while (!text.empty()) {
+		lineNumber++;
+		size_t end = text.find('\n');
+		std::string_view line = text.substr(0, end);
+		text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+		if (!reader.readLine(line)) {
+			error = "line " + std::to_string(lineNumber) + ": " + reader.message;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool ScenarioParser::parseFile(const std::string& path, ScenarioDescription& scenario, std::string& error) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		error = "failed to open scenario file: " + path;
+		return false;
+	}
+
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	std::string text = contents.str();
+
+	if (!parse(text, scenario, error)) {
+		error = path + " " + error;
+		return false;
+	}
+	return true;
+}
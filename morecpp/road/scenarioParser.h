@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "scenario.h"
+
+
+// line based scenario files, one entity per line as a keyword, a name and key=value attributes.
+// names must be declared before they are used, # starts a comment
+//
+//   junction a type=lights x=0 z=0 radius=15
+//   junction b x=400 z=0
+//   road ab from=a to=b speed=10 width=32 lanes=3 oneway
+//   lane ab dir=reverse type=regular width=4                  explicit lanes replace lanes=
+//   transition ab dir=forward start=100 end=150 from=3 to=2 map=0:0,1:1,2:1
+//   ramp on from=c to=b main=ab merge=300:380 lane=1 type=entrance speed=8 width=8 lanes=1
+//   phase a duration=20 moves=ab>ac,ac>ab                     replaces the generated plan
+//   spawn s road=ab dir=forward distance=10 rate=10
+//   detector d road=ab dir=forward distance=200 lane=1         no lane covers every lane
+//   destination east x=400 z=0 radius=15                      or at=<junction>
+//   profile rush period=86400 points=0:0.5,28800:2,61200:2.5
+//   demand s vpm=30 profile=rush to=east:1,west:2
+class ScenarioParser {
+public:
+	// false with "line n: ..." in error on the first bad line, the description is left partly filled
+	static bool parse(std::string_view text, ScenarioDescription& scenario, std::string& error);
+	static bool parseFile(const std::string& path, ScenarioDescription& scenario, std::string& error);
+};
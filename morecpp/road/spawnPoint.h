@@ -4,14 +4,16 @@
 class SpawnPoint {
 public:
 	std::weak_ptr<RoadSegment> roadSegment;
+	TravelDirection direction;
 	float distanceAlongRoad;
-	float timeToNextSpawn;
+
+	// vehicles per minute released by the default demand model
 	float spawnRate;
 
-	SpawnPoint() : distanceAlongRoad(0.0f), timeToNextSpawn(0.0f), spawnRate(10.0f) {}
-	SpawnPoint(std::shared_ptr<RoadSegment> road, float distance, float rate = 10.0f) :
+	SpawnPoint() : direction(TravelDirection::FORWARD), distanceAlongRoad(0.0f), spawnRate(10.0f) {}
+	SpawnPoint(std::shared_ptr<RoadSegment> road, float distance, float rate = 10.0f, TravelDirection direction = TravelDirection::FORWARD) :
 		roadSegment(road),
+		direction(direction),
 		distanceAlongRoad(distance),
-		timeToNextSpawn(0.0f),
 		spawnRate(rate) {}
 };
\ No newline at end of file
@@ -33,16 +33,96 @@ public:
 	}
 
 
+	void disconnectRoad(std::shared_ptr<RoadSegment> road) override {
+		int index = getRoadIndex(road);
+		Junction::disconnectRoad(road);
+		if (index < 0 || index >= static_cast<int>(trafficLights.size())) return;
+
+		trafficLights.erase(trafficLights.begin() + index);
+		for (size_t i = index; i < trafficLights.size(); i++) {
+			trafficLights[i].roadIndex = static_cast<int>(i);
+		}
+	}
+
+
 	void update(float deltaTime) override {
 		phaseTimer += deltaTime;
 
-		if (!phases.empty() && phaseTimer >= phases[currentPhase].duration) {
+		if (autoAdvance && !phases.empty() && phaseTimer >= phases[currentPhase].duration) {
 			phaseTimer = 0.0f;
 			currentPhase = (currentPhase + 1) % phases.size();
+			wakeReleasedApproaches();
+		}
+	}
+
+
+	bool isTimed() const override { return true; }
+
+
+	// vehicles park while they wait at red, wake the approaches the current phase lets through.
+	// a new plan, or none, may let anyone through
+	void wakeReleasedApproaches(bool everyApproach = false) {
+		for (const auto& connected : connectedRoads) {
+			auto road = connected.lock();
+			if (!road) continue;
+
+			bool released = everyApproach || phases.empty();
+			for (size_t i = 0; !released && i < phases[currentPhase].allowedMovements.size(); i++) {
+				released = phases[currentPhase].allowedMovements[i].first == road->getId();
+			}
+
+			if (released) {
+				road->wakeVehiclesHeldAt(this);
+			}
 		}
 	}
 
 
+	int getCurrentPhase() const { return currentPhase; }
+	int getPhaseCount() const { return static_cast<int>(phases.size()); }
+	float getPhaseTimer() const { return phaseTimer; }
+	float getPhaseDuration() const { return phases.empty() ? 0.0f : phases[currentPhase].duration; }
+
+	// fixed signal plan in place of generatePhases, movements are (from road id, to road id)
+	void clearPhases() {
+		phases.clear();
+		currentPhase = 0;
+		phaseTimer = 0.0f;
+		wakeReleasedApproaches(true);
+	}
+
+	void addPhase(float duration, const std::vector<std::pair<std::string, std::string>>& movements) {
+		TrafficPhase phase;
+		phase.duration = duration;
+		phase.allowedMovements = movements;
+		phases.push_back(phase);
+		wakeReleasedApproaches(true);
+	}
+
+	// external control: switches to the phase and restarts its timer, false if there is no such phase
+	bool setPhase(int phase) {
+		if (phase < 0 || phase >= static_cast<int>(phases.size())) return false;
+		if (phase == currentPhase) return true;
+
+		phaseTimer = 0.0f;
+		currentPhase = phase;
+		wakeReleasedApproaches();
+		return true;
+	}
+
+	// without auto advance a phase is held until setPhase picks another
+	void setAutoAdvance(bool enabled) { autoAdvance = enabled; }
+	bool isAutoAdvance() const { return autoAdvance; }
+
+
+	void hashState(StateHasher& hasher) const override {
+		Junction::hashState(hasher);
+		hasher.add(currentPhase);
+		hasher.add(phaseTimer, 0.001);
+		hasher.add(static_cast<uint64_t>(phases.size()));
+	}
+
+
 	bool canNavigate(std::shared_ptr<RoadSegment> fromRoad, std::shared_ptr<RoadSegment> toRoad, Vehicle* vehicle) override {
 		if (phases.empty()) return true;
 
@@ -55,7 +135,12 @@ public:
 	}
 
 
+	// the new plan can be shorter than the running one, so it starts over from its first phase
 	void generatePhases() {
+		phases.clear();
+		currentPhase = 0;
+		phaseTimer = 0.0f;
+
 		auto connectedRoadsCopy = getConnectedRoads();
 		if (connectedRoadsCopy.empty()) {
 			return;
@@ -72,7 +157,6 @@ public:
 			}
 		}
 
-		phases.clear();
 		for (const auto& group : phaseGroups) {
 			TrafficPhase phase;
 			phase.duration = 5.0f;
@@ -100,6 +184,8 @@ public:
 			defaultPhase.duration = 5.0f;
 			phases.push_back(defaultPhase);
 		}
+
+		wakeReleasedApproaches(true);
 	}
 
 
@@ -148,6 +234,7 @@ private:
 
 	int currentPhase;
 	float phaseTimer;
+	bool autoAdvance = true;
 
 	int currentGreenLight;
 	float greenDuration;
@@ -0,0 +1,24 @@
+#version 330 core
+out vec4 FragColor;
+flat in int segment;
+uniform sampler2D trafficData;
+uniform int trafficWidth;
+void main() {
+    vec2 traffic = texelFetch(trafficData, ivec2(segment % trafficWidth, segment / trafficWidth), 0).rg;
+    float density = traffic.r;
+    float slowdown = 1.0 - traffic.g;
+
+    // empty roads keep the road colour
+    if (density <= 0.0) {
+        FragColor = vec4(0.3, 0.3, 0.3, 1.0);
+        return;
+    }
+
+    // green (free flow) to yellow to red (jammed)
+    float heat = clamp(max(density, slowdown), 0.0, 1.0);
+    vec3 green = vec3(0.1, 0.8, 0.2);
+    vec3 yellow = vec3(0.95, 0.85, 0.1);
+    vec3 red = vec3(0.9, 0.1, 0.1);
+    vec3 color = heat < 0.5 ? mix(green, yellow, heat * 2.0) : mix(yellow, red, heat * 2.0 - 1.0);
+    FragColor = vec4(color, 1.0);
+}
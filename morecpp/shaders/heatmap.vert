@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aSide;
+layout (location = 2) in float aHalfWidth;
+layout (location = 3) in float aSegment;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float minHalfWidth;
+flat out int segment;
+void main() {
+    // keep roads at least a few pixels wide when zoomed out
+    vec2 offset = aSide * max(aHalfWidth, minHalfWidth);
+    gl_Position = projection * view * vec4(aPos.x + offset.x, aPos.y, aPos.z + offset.y, 1.0);
+    segment = int(aSegment);
+}
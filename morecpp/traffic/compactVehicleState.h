@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+
+// declared here so road segments can keep these records in their lane index
+class Vehicle;
+enum class TravelDirection;
+enum class VehicleState;
+
+
+// quantization of the compact vehicle state. values round to the nearest step, so anything in
+// range comes back within half a step (plus float rounding of the decoded value), out of range
+// values are clamped and reported
+struct CompactQuantization {
+	// 1 cm distances from where the direction of travel enters the segment, 1/256 m/s speeds
+	static constexpr float distanceScale = 100.0f;
+	static constexpr float speedScale = 256.0f;
+
+	static constexpr float maxDistanceError = 0.5f / distanceScale;
+	static constexpr float maxSpeedError = 0.5f / speedScale;
+
+	static constexpr double maxDistance = UINT32_MAX / distanceScale;
+	static constexpr float maxSpeed = UINT16_MAX / speedScale;
+	static constexpr int maxLane = UINT8_MAX;
+};
+
+
+// one vehicle's per tick state in 16 bytes. road segments keep one per vehicle in their lane index
+// and the shared memory ring publishes them as they are. readers rebuild position and heading
+// from segment, lane and distance
+struct CompactVehicleState {
+	uint32_t id;
+	int32_t segment;
+	uint32_t distance;
+	uint16_t speed;
+	uint8_t lane;
+
+	// travel direction in bit 0, VehicleState above it
+	uint8_t flags;
+
+	float getDistance() const { return distance / CompactQuantization::distanceScale; }
+	float getSpeed() const { return speed / CompactQuantization::speedScale; }
+	int getLane() const { return lane; }
+	TravelDirection getDirection() const { return static_cast<TravelDirection>(flags & 1); }
+	VehicleState getState() const { return static_cast<VehicleState>(flags >> 1); }
+
+	// false if a field was out of range and clamped, the rest still round within the bounds
+	bool encode(const Vehicle& vehicle, int32_t segmentIndex);
+};
+
+static_assert(sizeof(CompactVehicleState) == 16, "compact vehicle state is packed into 16 bytes");
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+
+// driver choices that run slower than the kinematics
+enum class DecisionKind {
+	LANE_CHANGE,
+	LANE_DROP,
+	MERGE,
+	COUNT
+};
+
+
+// decisions per second for each kind, 0 decides every tick
+struct DecisionRates {
+	// discretionary lane changes and leaving a closed lane
+	float laneChange = 2.0f;
+
+	// looking ahead for the lane to be in before a lane drop
+	float laneDrop = 2.0f;
+
+	// a merge request only lives for one tick, so gap acceptance on a ramp keeps up by default
+	float merge = 0.0f;
+};
+
+
+// spreads slow decisions over ticks round robin by vehicle id, so each tick carries about the same
+// share of them. a vehicle decides on kind k when (tick + id) is a multiple of k's period in ticks
+class DecisionSchedule {
+private:
+	DecisionRates rates;
+	uint64_t tick = 0;
+	uint32_t periods[static_cast<int>(DecisionKind::COUNT)] = { 1, 1, 1 };
+	float periodStep = 0.0f;
+
+	static uint32_t periodFor(float rate, float deltaTime) {
+		if (rate <= 0.0f || deltaTime <= 0.0f) return 1;
+		return static_cast<uint32_t>(std::max(1.0f, std::round(1.0f / (rate * deltaTime))));
+	}
+
+
+public:
+	void setRates(const DecisionRates& newRates) { rates = newRates; periodStep = 0.0f; }
+	const DecisionRates& getRates() const { return rates; }
+
+	// called once at the start of each tick, periods follow the step length
+	void advance(float deltaTime) {
+		tick++;
+		if (deltaTime != periodStep) {
+			periodStep = deltaTime;
+			periods[static_cast<int>(DecisionKind::LANE_CHANGE)] = periodFor(rates.laneChange, deltaTime);
+			periods[static_cast<int>(DecisionKind::LANE_DROP)] = periodFor(rates.laneDrop, deltaTime);
+			periods[static_cast<int>(DecisionKind::MERGE)] = periodFor(rates.merge, deltaTime);
+		}
+	}
+
+	bool isDue(DecisionKind kind, uint32_t vehicleId) const {
+		uint32_t period = periods[static_cast<int>(kind)];
+		return period == 1 || (tick + vehicleId) % period == 0;
+	}
+
+	uint32_t getPeriod(DecisionKind kind) const { return periods[static_cast<int>(kind)]; }
+	uint64_t getTick() const { return tick; }
+};
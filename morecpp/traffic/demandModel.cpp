@@ -0,0 +1,192 @@
+#include "demandModel.h"
+
+#include <algorithm>
+#include <sstream>
+#include <iostream>
+#include <cmath>
+
+
+DemandProfile::DemandProfile(const std::vector<std::pair<float, float>>& curve, float period)
+	: points(curve), period(period), maxFactor(0.0f) {
+	std::sort(points.begin(), points.end());
+
+	for (const auto& point : points) {
+		maxFactor = std::max(maxFactor, point.second);
+	}
+}
+
+
+float DemandProfile::getFactorAt(double time) const {
+	if (points.empty()) {
+		return 1.0f;
+	}
+
+	float t = static_cast<float>(std::fmod(time, static_cast<double>(period)));
+
+	// wrap between the last and first point
+	if (t <= points.front().first || t >= points.back().first) {
+		float start = points.back().first;
+		float span = points.front().first + period - start;
+		float offset = t >= start ? t - start : t + period - start;
+		float blend = span > 0.0f ? offset / span : 0.0f;
+		return points.back().second + blend * (points.front().second - points.back().second);
+	}
+
+	auto next = std::upper_bound(points.begin(), points.end(), t, [](float value, const std::pair<float, float>& point) {
+		return value < point.first;
+		});
+	auto previous = next - 1;
+
+	float blend = (t - previous->first) / (next->first - previous->first);
+	return previous->second + blend * (next->second - previous->second);
+}
+
+
+DemandProfile DemandProfile::peakOffPeak() {
+	// quiet night, morning and evening peaks, moderate midday
+	return DemandProfile({
+		{ 0.0f * 3600.0f, 0.15f },
+		{ 5.0f * 3600.0f, 0.2f },
+		{ 8.0f * 3600.0f, 1.8f },
+		{ 10.0f * 3600.0f, 0.9f },
+		{ 13.0f * 3600.0f, 1.0f },
+		{ 17.5f * 3600.0f, 2.0f },
+		{ 20.0f * 3600.0f, 0.7f },
+		{ 23.0f * 3600.0f, 0.25f },
+	});
+}
+
+
+DemandFileReader::DemandFileReader(const std::string& path, size_t chunkSize) : file(path), chunkSize(chunkSize) {
+	if (!file.is_open()) {
+		std::cerr << "Failed to open demand file: " << path << std::endl;
+	}
+}
+
+
+bool DemandFileReader::readChunk() {
+	std::string line;
+	size_t read = 0;
+
+	while (read < chunkSize && std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') continue;
+
+		std::replace(line.begin(), line.end(), ',', ' ');
+		std::istringstream fields(line);
+
+		TripRequest trip;
+		trip.lane = -1;
+		if (!(fields >> trip.time >> trip.origin >> trip.destination)) continue;
+		fields >> trip.lane;
+
+		buffer.push_back(trip);
+		read++;
+	}
+
+	return read > 0;
+}
+
+
+void DemandFileReader::collectDue(double time, std::vector<TripRequest>& due) {
+	while (true) {
+		if (buffer.empty() && !readChunk()) {
+			return;
+		}
+
+		if (buffer.front().time > time) {
+			return;
+		}
+
+		due.push_back(buffer.front());
+		buffer.pop_front();
+	}
+}
+
+
+int DemandModel::addProfile(const DemandProfile& profile) {
+	profiles.push_back(profile);
+	return static_cast<int>(profiles.size() - 1);
+}
+
+
+void DemandModel::setOrigin(int origin, float vehiclesPerMinute, const std::vector<float>& destinationWeights,
+	const std::vector<int>& laneIndices, const std::vector<float>& laneWeights, int profile) {
+	if (origin < 0) return;
+
+	if (origin >= static_cast<int>(origins.size())) {
+		origins.resize(origin + 1);
+	}
+
+	Origin& entry = origins[origin];
+	entry.vehiclesPerSecond = vehiclesPerMinute / 60.0f;
+	entry.profile = profile >= 0 && profile < static_cast<int>(profiles.size()) ? profile : 0;
+	entry.destinations.build(destinationWeights);
+	entry.laneIndices = laneIndices;
+	entry.lanes.build(laneWeights.empty() ? std::vector<float>(laneIndices.size(), 1.0f) : laneWeights);
+
+	// arrivals are rescheduled from the current clock on the next step
+	scheduled = false;
+}
+
+
+void DemandModel::clearOrigins() {
+	origins.clear();
+	arrivals = {};
+	scheduled = false;
+}
+
+
+bool DemandModel::openDemandFile(const std::string& path, size_t chunkSize) {
+	demandFile = std::make_unique<DemandFileReader>(path, chunkSize);
+	return demandFile->isOpen();
+}
+
+
+void DemandModel::scheduleNext(int origin, double after) {
+	const Origin& entry = origins[origin];
+
+	// candidates arrive at the profile's peak rate and are thinned when they fire
+	float peakRate = entry.vehiclesPerSecond * profiles[entry.profile].getMaxFactor();
+	if (peakRate <= 0.0f) return;
+
+	std::exponential_distribution<double> gapDist(peakRate);
+	arrivals.push({ after + gapDist(gen), origin });
+}
+
+
+void DemandModel::advance(float deltaTime, std::vector<TripRequest>& due) {
+	if (!scheduled) {
+		arrivals = {};
+		for (size_t i = 0; i < origins.size(); i++) {
+			scheduleNext(static_cast<int>(i), clock);
+		}
+		scheduled = true;
+	}
+
+	clock += deltaTime;
+
+	std::uniform_real_distribution<float> acceptDist(0.0f, 1.0f);
+
+	while (!arrivals.empty() && arrivals.top().time <= clock) {
+		ArrivalEvent event = arrivals.top();
+		arrivals.pop();
+
+		const Origin& entry = origins[event.origin];
+		const DemandProfile& profile = profiles[entry.profile];
+
+		if (acceptDist(gen) * profile.getMaxFactor() <= profile.getFactorAt(event.time)) {
+			TripRequest trip;
+			trip.time = event.time;
+			trip.origin = event.origin;
+			trip.destination = entry.destinations.empty() ? -1 : entry.destinations.sample(gen);
+			trip.lane = entry.lanes.empty() ? -1 : entry.laneIndices[entry.lanes.sample(gen)];
+			due.push_back(trip);
+		}
+
+		scheduleNext(event.origin, event.time);
+	}
+
+	if (demandFile) {
+		demandFile->collectDue(clock, due);
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <fstream>
+#include <utility>
+#include <functional>
+
+#include "../core/aliasTable.h"
+#include "../core/random.h"
+
+
+// one vehicle to release at a spawn point
+struct TripRequest {
+	double time;
+	int origin;
+	int destination;
+
+	// -1 to start in whichever lane is open
+	int lane;
+};
+
+
+// piecewise linear demand multiplier over a repeating day
+class DemandProfile {
+private:
+	std::vector<std::pair<float, float>> points;
+	float period;
+	float maxFactor;
+
+
+public:
+	DemandProfile() : period(86400.0f), maxFactor(1.0f) {}
+
+	// points are (seconds into the period, multiplier)
+	DemandProfile(const std::vector<std::pair<float, float>>& curve, float period = 86400.0f);
+
+	float getFactorAt(double time) const;
+	float getMaxFactor() const { return maxFactor; }
+
+	static DemandProfile constant() { return DemandProfile(); }
+	static DemandProfile peakOffPeak();
+};
+
+
+// reads time sorted trips ("time,origin,destination[,lane]") a chunk at a time. a trip without
+// a lane gets -1 and starts in an open lane picked when it spawns
+class DemandFileReader {
+private:
+	std::ifstream file;
+	std::deque<TripRequest> buffer;
+	size_t chunkSize;
+
+	bool readChunk();
+
+
+public:
+	DemandFileReader(const std::string& path, size_t chunkSize = 4096);
+
+	bool isOpen() const { return file.is_open(); }
+
+	// emit every trip due at or before the given time
+	void collectDue(double time, std::vector<TripRequest>& due);
+};
+
+
+// origin-destination demand with time of day profiles and poisson arrivals
+class DemandModel {
+private:
+	struct Origin {
+		float vehiclesPerSecond = 0.0f;
+		int profile = 0;
+		AliasTable destinations;
+		AliasTable lanes;
+		std::vector<int> laneIndices;
+	};
+
+	// next candidate arrival for an origin (thinned against the profile when popped)
+	struct ArrivalEvent {
+		double time;
+		int origin;
+
+		bool operator>(const ArrivalEvent& other) const { return time > other.time; }
+	};
+
+	std::vector<Origin> origins;
+	std::vector<DemandProfile> profiles;
+	std::priority_queue<ArrivalEvent, std::vector<ArrivalEvent>, std::greater<ArrivalEvent>> arrivals;
+	std::unique_ptr<DemandFileReader> demandFile;
+	Random gen;
+	double clock;
+	bool scheduled;
+
+	void scheduleNext(int origin, double after);
+
+
+public:
+	DemandModel() : profiles{ DemandProfile::constant() }, gen(std::random_device{}()), clock(0.0), scheduled(false) {}
+
+	void setSeed(uint64_t seed) { gen.seed(seed); }
+	uint64_t getRandomState() const { return gen.getState(); }
+	void setClock(double time) { clock = time; scheduled = false; }
+	double getClock() const { return clock; }
+
+	// profiles are shared between origins by index, 0 is the constant profile
+	int addProfile(const DemandProfile& profile);
+
+	// one row of the od matrix plus the lanes trips may start in
+	void setOrigin(int origin, float vehiclesPerMinute, const std::vector<float>& destinationWeights,
+		const std::vector<int>& laneIndices, const std::vector<float>& laneWeights, int profile = 0);
+
+	// drop the od matrix, keeping profiles and any open demand file
+	void clearOrigins();
+	bool openDemandFile(const std::string& path, size_t chunkSize = 4096);
+
+	// advance the clock and collect the trips released during the step
+	void advance(float deltaTime, std::vector<TripRequest>& due);
+};
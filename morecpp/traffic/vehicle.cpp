@@ -4,22 +4,43 @@
 #include <iostream>
 
 #include "vehicle.h"
+#include "compactVehicleState.h"
 #include "../navigation/routeManager.h"
 
 
 Vehicle::Vehicle(VehicleType type, const Vector3& pos, const Vector3& dim, const Color& col)
   : GameObject(pos, dim, col),
+	id(0),
 	type(type),
 	state(VehicleState::CRUISING),
 	velocity(0, 0, 0),
 	currentRoad(nullptr),
 	distanceAlongRoad(0.0f),
 	currentLane(0),
+	travelDirection(TravelDirection::FORWARD),
+	zoneCursor(0),
+	laneCursor(0),
+	detectorCursor(0),
 	destination(nullptr),
+	routeManager(nullptr),
+	routeId(RoutePool::invalidRoute),
+	routeCursor(0),
+	routeRevision(0),
 	maxSpeed(10.0f),
 	preferredSpeed(5.0f),
 	currentSpeed(0.0f),
-	laneChangeTimer(3.0f) {
+	laneChangeTimer(3.0f),
+	minLaneChangeTime(2.0f),
+	decisions(nullptr),
+	mergeTargetSpeed(0.0f),
+	heldAtJunction(false),
+	dormant(false),
+	dormantSince(0.0) {
+}
+
+
+void Vehicle::reset(const Vector3& pos, const Vector3& dim, const Color& col) {
+	*this = Vehicle(type, pos, dim, col);
 }
 
 
@@ -30,8 +51,10 @@ void Vehicle::update(float deltaTime) {
 		return;
 	}
 
-	// get nearby cars
-	std::vector<std::shared_ptr<Vehicle>> nearbyCars = currentRoad->getVehiclesInLane(currentLane);
+	// get nearby cars, the list is scratch and handed back when the update returns
+	FrameArena& arena = FrameArena::current();
+	FrameArena::Scope scratch(arena);
+	Span<Vehicle*> nearbyCars = currentRoad->getVehiclesInLane(currentLane, travelDirection, arena);
 
 
 	// slow down if cars ahead
@@ -39,11 +62,12 @@ void Vehicle::update(float deltaTime) {
 
 
 	// check if we need to change lane
-	if (state == VehicleState::CRUISING && laneChangeTimer > minLaneChangeTime) {
+	bool laneChangeDue = isDecisionDue(DecisionKind::LANE_CHANGE);
+	if (laneChangeDue && state == VehicleState::CRUISING && laneChangeTimer > minLaneChangeTime) {
 		if (shouldChangeLane(nearbyCars)) {
 
 			// check wich lane to change to
-			int laneCount = currentRoad->getLaneCount();
+			int laneCount = currentRoad->getLaneCount(travelDirection);
 			int direction = 0;
 
 
@@ -59,10 +83,8 @@ void Vehicle::update(float deltaTime) {
 
 			// pick random lane 
 			else {
-				std::random_device rd;
-				std::mt19937 gen(rd());
 				std::uniform_int_distribution<> distrib(0, 1);
-				direction = distrib(gen) ? 1 : -1;
+				direction = distrib(random) ? 1 : -1;
 			}
 
 			changeLane(direction);
@@ -70,64 +92,172 @@ void Vehicle::update(float deltaTime) {
 		}
 	}
 
-	// check if on ramp
-	auto ramp = dynamic_cast<HighwayRamp*>(currentRoad.get());
-	if (ramp) {
-		handleRamp(ramp, deltaTime);
+	// move out of a lane closed by an incident
+	if (laneChangeDue && !currentRoad->isLaneOpen(currentLane, travelDirection) && laneChangeTimer > minLaneChangeTime / 2) {
+		int openLane = currentRoad->findOpenLane(currentLane, travelDirection);
+		if (openLane >= 0) {
+			changeLane(openLane > currentLane ? 1 : -1);
+			laneChangeTimer = 0.0f;
+		}
+	}
+
+	// run zone behaviour only while inside one of the segment's zones
+	const auto& zones = currentRoad->getZones(travelDirection);
+	while (zoneCursor < zones.size() && zones[zoneCursor].endDistance < distanceAlongRoad) {
+		zoneCursor++;
 	}
 
+	for (size_t i = zoneCursor; i < zones.size() && zones[i].startDistance <= distanceAlongRoad; i++) {
+		if (zones[i].endDistance < distanceAlongRoad) continue;
 
-	// check for lane transitions
-	float lookAheadDistance = 30;
-	int targetLane = currentRoad->getTargetLane(currentLane, distanceAlongRoad, lookAheadDistance);
+		RoadSegment* road = currentRoad.get();
+		handleZone(zones[i], deltaTime);
 
-	if (targetLane != currentLane && laneChangeTimer > minLaneChangeTime / 2) {
-		int direction = targetLane > currentLane ? 1 : -1;
-		changeLane(direction);
-		laneChangeTimer = 0.0f;
+		// stop if the zone moved us onto another road
+		if (currentRoad.get() != road) break;
 	}
 
 	// update velocity and position
-	Vector3 roadDirection = currentRoad->getDirectionAt(distanceAlongRoad);
+	Vector3 roadDirection = currentRoad->getTravelVector(travelDirection);
 	velocity = roadDirection * currentSpeed;
 
 	distanceAlongRoad += currentSpeed * deltaTime;
 
-	position = currentRoad->getLanePositionAt(currentLane, distanceAlongRoad);
+	position = currentRoad->getLanePositionAt(currentLane, distanceAlongRoad, laneCursor, travelDirection);
 }
 
 
-void Vehicle::setCurrentRoad(std::shared_ptr<RoadSegment> road, float distance, int lane) {
+void Vehicle::setCurrentRoad(std::shared_ptr<RoadSegment> road, float distance, int lane, TravelDirection direction) {
 	currentRoad = road;
 	distanceAlongRoad = distance;
 	currentLane = lane;
+	travelDirection = direction;
+	zoneCursor = 0;
+	laneCursor = 0;
+	detectorCursor = 0;
+	heldAtJunction = false;
+	mergeTargetSpeed = currentSpeed;
 
 	// update position
 	if (road) {
-		position = road->getLanePositionAt(lane, distance);
+		position = road->getLanePositionAt(lane, distance, laneCursor, direction);
 	}
 }
 
 
+bool Vehicle::canPark(const Vehicle* leader) const {
+	if (!currentRoad || currentSpeed > 0.0f) {
+		return false;
+	}
+
+	if (!currentRoad->isLaneOpen(currentLane, travelDirection) || currentRoad->findMergeRequest(this)) {
+		return false;
+	}
+
+	for (const auto& zone : currentRoad->getZones(travelDirection)) {
+		if (zone.startDistance > distanceAlongRoad) break;
+		if (zone.endDistance >= distanceAlongRoad) return false;
+	}
+
+	// a stopped leader close enough to hold us at zero, every following band scales its speed
+	if (leader) {
+		float distance = leader->getDistanceAlongRoad() - distanceAlongRoad;
+		float gap = distance - (dimensions.x + leader->getDimensions().x) / 2;
+		bool changingLane = state == VehicleState::CRUISING && distance < laneChangeLookAhead;
+		return leader->isDormant() && gap < followingDistance * 2 && !changingLane;
+	}
+
+	return heldAtJunction && distanceAlongRoad >= currentRoad->getLength();
+}
+
+
+void Vehicle::park(double clock) {
+	dormant = true;
+	dormantSince = clock;
+}
+
+
+void Vehicle::wake(double clock) {
+	dormant = false;
+	laneChangeTimer += static_cast<float>(clock - dormantSince);
+}
+
+
 void Vehicle::setDestination(std::shared_ptr<Destination> dest) {
 	destination = dest;
+}
+
+
+void Vehicle::setRoute(RouteManager* manager, RouteId route) {
+	routeManager = manager;
+	routeId = route;
+	routeCursor = 0;
+	routeRevision = manager ? manager->getRevision() : 0;
+}
+
+
+void Vehicle::advanceRouteTo(int segmentIndex, TravelDirection direction) {
+	if (!routeManager || routeId == RoutePool::invalidRoute) {
+		return;
+	}
+
+	// skip ahead when we joined the next road of the route without a junction
+	const RoutePool& routes = routeManager->getRoutePool();
+	if (routeCursor + 1 < routes.getLength(routeId) && routes.getSegment(routeId, routeCursor + 1) == RouteManager::toNode(segmentIndex, direction)) {
+		routeCursor++;
+	}
+}
+
 
-	if (dest && currentRoad) {
-		std::cout << "need plan_route() function" << std::endl;
+void Vehicle::hashState(StateHasher& hasher) const {
+	hasher.add(id);
+	hasher.add(currentRoad ? currentRoad->getIndex() : -1);
+	hasher.add(static_cast<int>(travelDirection));
+	hasher.add(currentLane);
+	hasher.add(distanceAlongRoad, 0.001);
+	hasher.add(currentSpeed, 0.001);
+	hasher.add(laneChangeTimer, 0.001);
+	hasher.add(static_cast<int>(state));
+
+	// route by the node we are on and what is left, pool ids depend on planning order
+	if (routeManager && routeId != RoutePool::invalidRoute) {
+		const RoutePool& routes = routeManager->getRoutePool();
+		hasher.add(routes.getSegment(routeId, routeCursor));
+		hasher.add(routes.getLength(routeId) - routeCursor);
+	} else {
+		hasher.add(-1);
 	}
+
+	hasher.add(random.getState());
 }
 
 
-void Vehicle::adjustSpeedForTraffic(const std::vector <std::shared_ptr<Vehicle>>& nearbyCars, float deltaTime) {
+int Vehicle::getRouteSegmentsLeft() const {
+	if (!routeManager || routeId == RoutePool::invalidRoute) {
+		return 0;
+	}
+	return static_cast<int>(routeManager->getRoutePool().getLength(routeId) - routeCursor) - 1;
+}
+
+
+bool Vehicle::hasArrived() const {
+	if (!routeManager || routeId == RoutePool::invalidRoute || !currentRoad) {
+		return false;
+	}
+
+	// on the last segment of the route and past its end
+	return routeCursor + 1 >= routeManager->getRoutePool().getLength(routeId) && distanceAlongRoad >= currentRoad->getLength();
+}
+
+
+void Vehicle::adjustSpeedForTraffic(Span<Vehicle*> nearbyCars, float deltaTime) {
 	float targetSpeed = preferredSpeed;
 	float minDistance = 1000.0f;
-	float safeDistance = 5.0f;
-	float followingDistance = 10.0f;
 
 	float vehicleLength = dimensions.x;
 
 	for (const auto& otherCar : nearbyCars) {
-		if (otherCar.get() == this) continue;
+		if (otherCar == this) continue;
 
 		// check if car is ahead
 		float otherDistance = otherCar->getDistanceAlongRoad();
@@ -156,6 +286,14 @@ void Vehicle::adjustSpeedForTraffic(const std::vector <std::shared_ptr<Vehicle>>
 		}
 	}
 
+	// open a gap for a merging vehicle that picked us as its follower
+	if (const MergeRequest* request = currentRoad->findMergeRequest(this)) {
+		float gap = request->position - distanceAlongRoad - vehicleLength;
+		if (gap < followingDistance * 2) {
+			targetSpeed = std::min(targetSpeed, request->speed * (gap > safeDistance ? 0.9f : 0.6f));
+		}
+	}
+
 	// check speed limit
 	targetSpeed = std::min(targetSpeed, currentRoad->getSpeedLimit());
 
@@ -183,12 +321,12 @@ void Vehicle::adjustSpeedForTraffic(const std::vector <std::shared_ptr<Vehicle>>
 }
 
 
-bool Vehicle::shouldChangeLane(const std::vector<std::shared_ptr<Vehicle>>& nearbyCars) {
+bool Vehicle::shouldChangeLane(Span<Vehicle*> nearbyCars) {
 	bool carAheadTooClose = false;
 	float minDistanceAhead = 1000.0f;
 
 	for (const auto& otherCar : nearbyCars) {
-		if (otherCar.get() == this) continue;
+		if (otherCar == this) continue;
 
 		float otherDistance = otherCar->getDistanceAlongRoad();
 		float distance = otherDistance - distanceAlongRoad;
@@ -196,7 +334,7 @@ bool Vehicle::shouldChangeLane(const std::vector<std::shared_ptr<Vehicle>>& near
 		if (distance > 0 && distance < minDistanceAhead) {
 			minDistanceAhead = distance;
 
-			if (distance < 8.0f && otherCar->getCurrentSpeed() < preferredSpeed * 0.9f) {
+			if (distance < laneChangeLookAhead && otherCar->getCurrentSpeed() < preferredSpeed * 0.9f) {
 				carAheadTooClose = true;
 			}
 		}
@@ -211,7 +349,10 @@ void Vehicle::changeLane(int direction) {
 
 	int targetLane = currentLane + direction;
 
-	if (currentRoad->isValidLane(targetLane, distanceAlongRoad)) {
+	// never move into a closed lane, unless ours is closed too and we are passing through
+	bool targetOpen = currentRoad->isLaneOpen(targetLane, travelDirection) || !currentRoad->isLaneOpen(currentLane, travelDirection);
+
+	if (targetOpen && currentRoad->isValidLane(targetLane, distanceAlongRoad, laneCursor, travelDirection)) {
 		currentLane = targetLane;
 		state = VehicleState::LANE_CHANGING;
 		laneChangeTimer = 0.0f;
@@ -219,42 +360,70 @@ void Vehicle::changeLane(int direction) {
 }
 
 
-void Vehicle::handleIntersection(std::shared_ptr<Junction> junction) {
-	if (!junction || plannedRoute.empty()) {
+void Vehicle::handleIntersection(Junction* junction) {
+	heldAtJunction = false;
+	if (!junction || !routeManager || routeId == RoutePool::invalidRoute) {
 		return;
 	}
 
-	std::shared_ptr<RoadSegment> nextRoad = nullptr;
-
-	if (currentRoad->getId() == plannedRoute.back()->getId()) {
+	// already on the last segment of the route
+	const RoutePool& routes = routeManager->getRoutePool();
+	if (routeCursor + 1 >= routes.getLength(routeId)) {
 		return;
 	}
 
-	auto it = std::find_if(plannedRoute.begin(), plannedRoute.end(), [this](const std::shared_ptr<RoadSegment>& road) {
-		return road->getId() == currentRoad->getId();
-		});
-	 
-	if (it != plannedRoute.end() && it + 1 != plannedRoute.end()) {
-		nextRoad = *(it + 1);
+	// routes step through (segment, direction) nodes
+	int nextNode = routes.getSegment(routeId, routeCursor + 1);
+	std::shared_ptr<RoadSegment> nextRoad = routeManager->getSegment(RouteManager::nodeSegment(nextNode));
+
+	// plan again from here if the road ahead is gone, or an edit or incident changed our
+	// destination's tree so that it no longer leaves this node the way our route does
+	int currentNode = RouteManager::toNode(currentRoad->getIndex(), travelDirection);
+	if (!nextRoad || !destination || !routeManager->isRouteCurrent(currentNode, nextNode, *destination, routeRevision)) {
+		RouteId replanned = routeManager->planRoute(currentNode, destination);
+
+		if (replanned != RoutePool::invalidRoute) {
+			setRoute(routeManager, replanned);
+			if (routes.getLength(routeId) < 2) {
+				return;
+			}
+
+			nextNode = routes.getSegment(routeId, 1);
+			nextRoad = routeManager->getSegment(RouteManager::nodeSegment(nextNode));
+		} else {
+
+			// no way through right now, keep the old route until the network changes again
+			routeRevision = routeManager->getRevision();
+		}
+
+		if (!nextRoad) {
+			return;
+		}
 	}
 
-	if (!nextRoad) {
+	TravelDirection nextDirection = RouteManager::nodeDirection(nextNode);
+
+	// wait at the junction while the road ahead is closed
+	if (nextRoad->isClosed(nextDirection)) {
+		currentSpeed = 0.0f;
+		state = VehicleState::STOPPED;
 		return;
 	}
 
 	// try to navigate to the next road
 	if (junction->canNavigate(currentRoad, nextRoad, this)) {
 
-		// pick random lane on the next road
+		// pick random lane on the next road (skipping the outer shoulders)
 		int nextLane = 0;
-		if (nextRoad->getLaneCount() > 1) {
-			std::random_device rd;
-			std::mt19937 gen(rd());
-			std::uniform_int_distribution<> distrib(1, nextRoad->getLaneCount() - 2);
-			nextLane = distrib(gen);
+		int nextLaneCount = nextRoad->getLaneCount(nextDirection);
+		if (nextLaneCount > 2) {
+			std::uniform_int_distribution<> distrib(1, nextLaneCount - 2);
+			nextLane = distrib(random);
 		}
+		nextLane = nextRoad->findOpenLane(nextLane, nextDirection);
 
-		setCurrentRoad(nextRoad, 0.0f, nextLane);
+		setCurrentRoad(nextRoad, 0.0f, nextLane, nextDirection);
+		routeCursor++;
 
 		state = VehicleState::TURNING;
 
@@ -262,59 +431,130 @@ void Vehicle::handleIntersection(std::shared_ptr<Junction> junction) {
 	} else {
 		currentSpeed = 0.0f;
 		state = VehicleState::STOPPED;
+		heldAtJunction = true;
 	}
 }
 
 
-void Vehicle::handleRamp(HighwayRamp* ramp, float deltaTime) {
-	if (!ramp) return;
+void Vehicle::handleZone(const BehaviorZone& zone, float deltaTime) {
+	switch (zone.type) {
+	case ZoneType::MERGE:
+	case ZoneType::EXIT_DECELERATION:
+		if (currentRoad->getKind() == SegmentKind::RAMP) {
+			handleRamp(static_cast<HighwayRamp*>(currentRoad.get()), zone, deltaTime);
+		}
+		break;
 
-	auto mainRoad = ramp->getMainRoad().lock();
-	if (!mainRoad) return;
+	case ZoneType::LANE_DROP: {
+		if (!isDecisionDue(DecisionKind::LANE_DROP)) break;
 
-	MergeInfo mergeInfo = ramp->getMergeParameters();
+		int targetLane = currentRoad->getTargetLane(currentLane, distanceAlongRoad, RoadSegment::laneDropLookAhead, laneCursor, travelDirection);
 
-	if (ramp->getType() == RampType::ENTRANCE) {
-		float mergePoint = (mergeInfo.mergeStartDistance + mergeInfo.mergeEndDistance) / 2;
+		if (targetLane != currentLane && laneChangeTimer > minLaneChangeTime / 2) {
+			int direction = targetLane > currentLane ? 1 : -1;
+			changeLane(direction);
+			laneChangeTimer = 0.0f;
+		}
+		break;
+	}
+	}
+}
 
-		float rampProgress = distanceAlongRoad / ramp->getLength();
 
-		if (rampProgress > 0.75f) {
-			std::vector<std::shared_ptr<Vehicle>> targetLaneVehicles = mainRoad->getVehiclesInLaneSection(
-				mergeInfo.targetLane,
-				mergeInfo.mergeStartDistance,
-				mergeInfo.mergeEndDistance
-			);
+void Vehicle::handleRamp(HighwayRamp* ramp, const BehaviorZone& zone, float deltaTime) {
+	if (!ramp) return;
 
-			bool canMerge = true;
-			for (const auto& otherVehicle : targetLaneVehicles) {
-				float distance = std::abs(otherVehicle->getDistanceAlongRoad() - mergePoint);
-				if (distance < 10.0f) {
-					canMerge = false;
-					break;
-				}
+	if (zone.type == ZoneType::MERGE) {
+		auto mainRoad = ramp->getMainRoad().lock();
+		if (!mainRoad) return;
+
+		const MergeInfo& mergeInfo = ramp->getMergeParameters();
+		float mainSpeed = std::min(mainRoad->getSpeedLimit(), maxSpeed);
+
+		// where we are along the main road, the ramp's centre line projected onto it. the gap is
+		// looked for at the nearest point of the merge section, but we only move across once this
+		// step would carry us there anyway, so merging never moves us along the main road
+		Vector3 rampPosition = ramp->getPositionAlongRoad(distanceAlongRoad);
+		float projected = (rampPosition - mainRoad->getStartPosition()).dot(mainRoad->getDirectionVector());
+		float joinPoint = std::max(mergeInfo.mergeStartDistance, std::min(projected, mergeInfo.mergeEndDistance));
+		bool alongside = joinPoint - projected <= currentSpeed * deltaTime + mergeHoldGap;
+		float vehicleLength = dimensions.x;
+
+		// between decisions keep closing on the speed chosen last time, alongside the gap is checked every tick
+		if (alongside || isDecisionDue(DecisionKind::MERGE)) {
+			LaneNeighbors gap = mainRoad->findNeighbors(mergeInfo.targetLane, joinPoint, this);
+
+			float leaderSpace = 1000.0f;
+			float followerSpace = 1000.0f;
+			float leaderSpeed = mainSpeed;
+
+			if (gap.leader) {
+				leaderSpace = gap.leader->getDistanceAlongRoad() - joinPoint - (vehicleLength + gap.leader->getDimensions().x) / 2;
+				leaderSpeed = gap.leader->getCurrentSpeed();
 			}
+			if (gap.follower) {
+				followerSpace = joinPoint - gap.follower->getDistanceAlongRoad() - (vehicleLength + gap.follower->getDimensions().x) / 2;
+			}
+
+			// accept the gap when both sides leave a speed dependent headway
+			bool leaderClear = leaderSpace > mergeMinGap + currentSpeed * mergeHeadway * 0.5f;
+			bool followerClear = !gap.follower || followerSpace > mergeMinGap + gap.follower->getCurrentSpeed() * mergeHeadway;
 
-			if (canMerge && rampProgress > 0.9f) {
-				setCurrentRoad(mainRoad, mergePoint, mergeInfo.targetLane);
-				currentSpeed = std::min(mainRoad->getSpeedLimit(), maxSpeed);
+			if (alongside && leaderClear && followerClear) {
+				setCurrentRoad(mainRoad, joinPoint, mergeInfo.targetLane);
+				advanceRouteTo(mainRoad->getIndex(), TravelDirection::FORWARD);
+				currentSpeed = std::min(std::max(currentSpeed, leaderSpeed), mainSpeed);
 				state = VehicleState::MERGING;
-			} else if (rampProgress > 0.95f) {
-				currentSpeed = currentSpeed * 0.8f;
-			} else {
-				float targetSpeed = std::min(mainRoad->getSpeedLimit(), maxSpeed);
-				if (currentSpeed < targetSpeed) {
-					currentSpeed += 3.0f * deltaTime;
-				}
+				return;
 			}
-		}
-	} else if (ramp->getType() == RampType::EXIT) {
-		float rampProgress = distanceAlongRoad / ramp->getLength();
-		if (rampProgress < 0.3f) {
-			float targetSpeed = ramp->getSpeedLimit();
-			if (currentSpeed > targetSpeed) {
-				currentSpeed -= 3.0f * deltaTime;
+
+			// ask the vehicle behind the gap to make room
+			if (gap.follower) {
+				mainRoad->postMergeRequest({ this, gap.follower, joinPoint, currentSpeed });
 			}
+
+			// drop back behind a leader that is too close, otherwise match main line speed
+			mergeTargetSpeed = leaderClear ? mainSpeed : leaderSpeed * 0.8f;
+		}
+
+		float targetSpeed = mergeTargetSpeed;
+
+		// hold just short of the ramp end (and its junction) until a gap opens
+		float holdPoint = ramp->getLength() - mergeHoldGap;
+		if (distanceAlongRoad >= holdPoint) {
+			distanceAlongRoad = holdPoint;
+			targetSpeed = 0.0f;
+		}
+
+		if (currentSpeed < targetSpeed) {
+			currentSpeed = std::min(targetSpeed, currentSpeed + 3.0f * deltaTime);
+		} else {
+			currentSpeed = std::max(targetSpeed, currentSpeed - 6.0f * deltaTime);
+		}
+	} else if (zone.type == ZoneType::EXIT_DECELERATION) {
+		float targetSpeed = ramp->getSpeedLimit();
+		if (currentSpeed > targetSpeed) {
+			currentSpeed -= 3.0f * deltaTime;
 		}
 	}
 }
+
+
+bool CompactVehicleState::encode(const Vehicle& vehicle, int32_t segmentIndex) {
+	// runs for every vehicle in the lane index each tick, so values round half up by truncating
+	// rather than through std::round. both products are exact in double
+	double scaledDistance = static_cast<double>(vehicle.getDistanceAlongRoad()) * CompactQuantization::distanceScale;
+	double scaledSpeed = static_cast<double>(vehicle.getCurrentSpeed()) * CompactQuantization::speedScale;
+	int laneIndex = vehicle.getCurrentLane();
+
+	bool inRange = scaledDistance > -0.5 && scaledDistance < UINT32_MAX + 0.5 && scaledSpeed > -0.5 && scaledSpeed < UINT16_MAX + 0.5
+		&& laneIndex >= 0 && laneIndex <= CompactQuantization::maxLane;
+
+	id = vehicle.getId();
+	segment = segmentIndex;
+	distance = scaledDistance <= 0.0 ? 0 : scaledDistance >= UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(scaledDistance + 0.5);
+	speed = scaledSpeed <= 0.0 ? 0 : scaledSpeed >= UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(scaledSpeed + 0.5);
+	lane = static_cast<uint8_t>(std::min(std::max(laneIndex, 0), CompactQuantization::maxLane));
+	flags = static_cast<uint8_t>((vehicle.getTravelDirection() == TravelDirection::REVERSE ? 1 : 0) | static_cast<int>(vehicle.getState()) << 1);
+	return inRange;
+}
@@ -5,9 +5,13 @@
 
 #include "../core/gameobject.h"
 #include "../core/vec3.h"
+#include "../core/random.h"
+#include "../core/stateHash.h"
 #include "../road/junction.h"
 #include "../road/roadSegment.h"
 #include "../road/highwayRamp.h"
+#include "../navigation/routePool.h"
+#include "decisionSchedule.h"
 
 
 enum class VehicleType {
@@ -30,10 +34,12 @@ enum class VehicleState {
 
 // forward declaration
 class Destination;
+class RouteManager;
 
 
 class Vehicle : public GameObject {
 protected:
+	uint32_t id;
 	VehicleType type;
 	VehicleState state;
 	Vector3 velocity;
@@ -41,9 +47,20 @@ protected:
 	std::shared_ptr<RoadSegment> currentRoad;
 	float distanceAlongRoad;
 	int currentLane;
+	TravelDirection travelDirection;
+	size_t zoneCursor;
+	size_t laneCursor;
+
+	// first loop detector on the current road not yet passed, kept by the road
+	size_t detectorCursor;
 
 	std::shared_ptr<Destination> destination;
-	std::vector<std::shared_ptr<RoadSegment>> plannedRoute;
+
+	// shared route from the route pool and our position along it
+	RouteManager* routeManager;
+	RouteId routeId;
+	uint32_t routeCursor;
+	uint32_t routeRevision;
 
 	float maxSpeed;
 	float preferredSpeed;
@@ -52,21 +69,79 @@ protected:
 	float laneChangeTimer;
 	float minLaneChangeTime;
 
+	// slow decisions run on the ticks the network's schedule gives us, every tick without one
+	const DecisionSchedule* decisions;
+
+	// speed a ramp vehicle holds between merge decisions
+	float mergeTargetSpeed;
+
+	// own stream so a vehicle's choices do not depend on the order others update in
+	Random random;
+
+	// stopped because the junction ahead refused the next road, cleared on every attempt
+	bool heldAtJunction;
+
+	// parked vehicles are skipped by their segment until it wakes them, and catch up their
+	// timers from the segment clock they were parked at
+	bool dormant;
+	double dormantSince;
+
+	// gaps kept to the vehicle ahead, each band follows it a little closer to its speed
+	static constexpr float safeDistance = 5.0f;
+	static constexpr float followingDistance = 10.0f;
+
+	// a slower vehicle this close ahead makes a cruising vehicle look for another lane
+	static constexpr float laneChangeLookAhead = 8.0f;
+
+	// gap acceptance when merging from a ramp
+	static constexpr float mergeMinGap = 4.0f;
+	static constexpr float mergeHeadway = 1.0f;
+
+	// how far short of the ramp end a vehicle waits for its gap, it can merge from there
+	static constexpr float mergeHoldGap = 0.25f;
+
+	void advanceRouteTo(int segmentIndex, TravelDirection direction);
+	bool isDecisionDue(DecisionKind kind) const { return !decisions || decisions->isDue(kind, id); }
+
 
 public:
 	Vehicle(VehicleType type, const Vector3& pos, const Vector3& dim, const Color& col);
 
+	// back to a freshly constructed vehicle of the same type, so the network can reuse arrived vehicles
+	void reset(const Vector3& pos, const Vector3& dim, const Color& col);
+
 	void update(float deltaTime) override;
 
-	void setCurrentRoad(std::shared_ptr<RoadSegment> road, float distance, int lane);
+	void setCurrentRoad(std::shared_ptr<RoadSegment> road, float distance, int lane, TravelDirection direction = TravelDirection::FORWARD);
 	void setDestination(std::shared_ptr<Destination> dest);
+	void setRoute(RouteManager* manager, RouteId route);
 
-	virtual void adjustSpeedForTraffic(const std::vector<std::shared_ptr<Vehicle>>& nearbyCars, float deltaTime);
-	virtual bool shouldChangeLane(const std::vector<std::shared_ptr<Vehicle>>& nearbyCars);
+	virtual void adjustSpeedForTraffic(Span<Vehicle*> nearbyCars, float deltaTime);
+	virtual bool shouldChangeLane(Span<Vehicle*> nearbyCars);
 	virtual void changeLane(int direction);
-	virtual void handleIntersection(std::shared_ptr<Junction> junction);
-	virtual void handleRamp(HighwayRamp* ramp, float deltaTime);
+	virtual void handleIntersection(Junction* junction);
+	virtual void handleZone(const BehaviorZone& zone, float deltaTime);
+	virtual void handleRamp(HighwayRamp* ramp, const BehaviorZone& zone, float deltaTime);
+
+
+	// true when an update could not move us while the leader stays put and the junction ahead keeps
+	// refusing us: stopped, out of every zone, in an open lane and either queued behind a parked
+	// leader or first at the stop line. a cruising vehicle that would still pick a lane change stays awake
+	bool canPark(const Vehicle* leader) const;
+	void park(double clock);
+	void wake(double clock);
+	bool isDormant() const { return dormant; }
+	bool isHeldAtJunction() const { return heldAtJunction; }
+
+
+	// assigned by the network when the vehicle spawns
+	void setId(uint32_t newId) { id = newId; }
+	uint32_t getId() const { return id; }
+	void seedRandom(uint64_t seed) { random.seed(seed); }
+	void setDecisionSchedule(const DecisionSchedule* schedule) { decisions = schedule; }
 
+	// canonical state: road, lane, quantized distance and speed, state, route position and rng position
+	void hashState(StateHasher& hasher) const;
 
 	VehicleType getType() const { return type; }
 	VehicleState getState() const { return state; }
@@ -75,7 +150,13 @@ public:
 	std::shared_ptr<RoadSegment> getCurrentRoad() const { return currentRoad; }
 	float getDistanceAlongRoad() const { return distanceAlongRoad; }
 	int getCurrentLane() const { return currentLane; }
+	TravelDirection getTravelDirection() const { return travelDirection; }
 	std::shared_ptr<Destination> getDestination() const { return destination; }
+	RouteId getRouteId() const { return routeId; }
+	uint32_t getRouteCursor() const { return routeCursor; }
+	size_t& getDetectorCursor() { return detectorCursor; }
+	int getRouteSegmentsLeft() const;
+	bool hasArrived() const;
 	float getCurrentSpeed() const { return currentSpeed; }
 	float getPreferredSpeed() const { return preferredSpeed; }
 